@@ -0,0 +1,249 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: The buffered flash backend (port/ef_port_flash.c) on the models of the MX25L6433F QSPI flash and the
+ *           S32K1 D-Flash. The ENV area is formatted and written by random sets, then a reboot loads it and gets
+ *           every key. Every part runs without and with the read ahead buffer, the flash commands and the
+ *           simulated flash time are counted. The D-Flash needs the EF_WRITE_GRAN 64 build.
+ * Created on: 2026-10-18
+ */
+
+#include <easyflash.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "ef_sim.h"
+#include "ef_port_flash.h"
+#include "bench_util.h"
+
+#define KEYS_NUM                                 64
+#define VALUE_MAX_SIZE                           128
+
+enum phase {
+    PHASE_FORMAT,
+    PHASE_SET,
+    PHASE_BOOT,
+    PHASE_GET,
+    PHASE_NUM,
+};
+
+static const char * const phase_name[PHASE_NUM] = { "format", "set", "boot", "get" };
+
+struct backend_part {
+    const char *name;
+    struct ef_sim_cfg sim;
+    struct ef_port_flash flash;
+    bool mapped;                                 /**< the part is memory mapped, so it's read by the CPU */
+};
+
+struct phase_result {
+    struct ef_sim_stats sim;
+    struct ef_port_flash_stats port;
+};
+
+static struct backend_part *cur_part;
+
+/* the device erase by the sector of the current part */
+static EfErrCode part_erase(uint32_t addr) {
+    return ef_sim_erase(addr, cur_part->flash.sector_size);
+}
+
+static struct backend_part parts[] = {
+    {
+        "MX25L6433F", EF_SIM_CFG_MX25L6433F(ENV_AREA_SIZE),
+        {
+            .size = ENV_AREA_SIZE, .sector_size = 4096, .page_size = 256, .prog_unit = 1,
+            .read = ef_sim_read, .program = ef_sim_program, .erase = part_erase,
+        },
+        false,
+    },
+#if (EF_WRITE_GRAN == 64)
+    {
+        "D-Flash", EF_SIM_CFG_DFLASH(ENV_AREA_SIZE),
+        {
+            .size = ENV_AREA_SIZE, .sector_size = 2048, .page_size = 2048, .prog_unit = 8,
+            .read = ef_sim_read, .program = ef_sim_program, .erase = part_erase,
+        },
+        true,
+    },
+#endif
+};
+
+static size_t set_num = 2000;
+/* the flash image and the results are shared by the processes */
+static uint8_t *image;
+static struct phase_result *results;
+
+static void key_name(char *key, size_t i) {
+    snprintf(key, EF_ENV_NAME_MAX, "backend%02zu", i);
+}
+
+/* the random set sequence, the last value of every key is kept */
+static size_t next_set(uint64_t *seed, uint8_t *value, size_t *len) {
+    size_t key = bench_rand(seed) % KEYS_NUM, i;
+
+    *len = 4 + bench_rand(seed) % (VALUE_MAX_SIZE - 3);
+    for (i = 0; i < *len; i++) {
+        value[i] = (uint8_t) bench_rand(seed);
+    }
+
+    return key;
+}
+
+static void power_on(void) {
+    ef_sim_init(&cur_part->sim);
+    cur_part->flash.mapped = cur_part->mapped ? ef_sim_get_mem() : NULL;
+    ef_port_flash_init(&cur_part->flash);
+}
+
+static void phase_begin(void) {
+    ef_sim_reset_stats();
+    ef_port_flash_reset_stats();
+}
+
+static void phase_end(enum phase phase) {
+    ef_sim_get_stats(&results[phase].sim);
+    ef_port_flash_get_stats(&results[phase].port);
+}
+
+/* format the ENV area and write it by the random sets */
+static int make_image(void) {
+    uint8_t value[VALUE_MAX_SIZE];
+    char key[EF_ENV_NAME_MAX];
+    uint64_t seed = 1;
+    size_t i, len;
+
+    power_on();
+    phase_begin();
+    if (easyflash_init() != EF_NO_ERR) {
+        printf("Error: EasyFlash initialize failed.\n");
+        return 1;
+    }
+    phase_end(PHASE_FORMAT);
+    phase_begin();
+    for (i = 0; i < set_num; i++) {
+        key_name(key, next_set(&seed, value, &len));
+        if (ef_set_env_blob(key, value, len) != EF_NO_ERR) {
+            printf("Error: Set the ENV '%s' failed.\n", key);
+            return 1;
+        }
+    }
+    phase_end(PHASE_SET);
+    memcpy(image, ef_sim_get_mem(), ENV_AREA_SIZE);
+
+    return 0;
+}
+
+/* boot from the image and get every key */
+static int boot_and_get(void) {
+    static uint8_t expect[KEYS_NUM][VALUE_MAX_SIZE];
+    static size_t expect_len[KEYS_NUM];
+    uint8_t value[VALUE_MAX_SIZE];
+    char key[EF_ENV_NAME_MAX];
+    uint64_t seed = 1;
+    size_t i, len, saved_len;
+
+    for (i = 0; i < set_num; i++) {
+        size_t k = next_set(&seed, value, &len);
+
+        memcpy(expect[k], value, len);
+        expect_len[k] = len;
+    }
+
+    power_on();
+    memcpy(ef_sim_get_mem(), image, ENV_AREA_SIZE);
+    phase_begin();
+    if (easyflash_init() != EF_NO_ERR) {
+        printf("Error: EasyFlash initialize failed.\n");
+        return 1;
+    }
+    phase_end(PHASE_BOOT);
+    phase_begin();
+    for (i = 0; i < KEYS_NUM; i++) {
+        key_name(key, i);
+        saved_len = 0;
+        len = ef_get_env_blob(key, value, sizeof(value), &saved_len);
+        if (len != expect_len[i] || saved_len != expect_len[i] || memcmp(value, expect[i], len)) {
+            printf("Error: The ENV '%s' is wrong after boot.\n", key);
+            return 1;
+        }
+    }
+    phase_end(PHASE_GET);
+
+    return 0;
+}
+
+/* run it in a new process, so all RAM state is lost as a real reboot */
+static int run(int (*fn)(void)) {
+    pid_t pid;
+    int status;
+
+    fflush(stdout);
+    pid = fork();
+    if (pid == 0) {
+        exit(fn());
+    }
+
+    return pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+}
+
+static void print_phase(const char *part, const char *read_ahead, enum phase phase) {
+    const struct phase_result *r = &results[phase];
+
+    printf("%-11s %-10s %-7s %9llu %9.1f %9llu %8llu %10.1f %7.1f%%\n", part, read_ahead, phase_name[phase],
+            (unsigned long long) r->sim.reads, r->sim.read_bytes / 1024.0, (unsigned long long) r->sim.programs,
+            (unsigned long long) r->sim.erases, r->sim.busy_ns / 1e6,
+            r->port.reads ? r->port.read_hits * 100.0 / r->port.reads : 0.0);
+}
+
+int main(int argc, char **argv) {
+    size_t i, mode, read_ahead[2] = { 0, EF_PORT_READ_AHEAD_SIZE };
+    char read_ahead_name[16];
+    int opt, phase;
+
+    while ((opt = getopt(argc, argv, "n:Vh")) != -1) {
+        switch (opt) {
+        case 'n': set_num = strtoul(optarg, NULL, 0); break;
+        case 'V': ef_sim_set_verbose(true); break;
+        default:
+            printf("Usage: %s [-n sets, default 2000] [-V]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    image = mmap(NULL, ENV_AREA_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    results = mmap(NULL, sizeof(*results) * PHASE_NUM, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (image == MAP_FAILED || results == MAP_FAILED) {
+        printf("Error: mmap failed.\n");
+        return 1;
+    }
+
+    printf("%d keys, %zu sets, ENV_AREA_SIZE 0x%X, EF_ERASE_MIN_SIZE 0x%X, EF_WRITE_GRAN %d\n", KEYS_NUM, set_num,
+            ENV_AREA_SIZE, EF_ERASE_MIN_SIZE, EF_WRITE_GRAN);
+    printf("%-11s %-10s %-7s %9s %9s %9s %8s %10s %8s\n", "part", "read ahead", "phase", "reads", "read KB",
+            "programs", "erases", "flash ms", "hits");
+    for (i = 0; i < sizeof(parts) / sizeof(parts[0]); i++) {
+        cur_part = &parts[i];
+        /* the memory mapped part has no read ahead */
+        for (mode = 0; mode < (cur_part->mapped ? 1 : 2); mode++) {
+            cur_part->flash.read_ahead = read_ahead[mode];
+            if (cur_part->mapped) {
+                snprintf(read_ahead_name, sizeof(read_ahead_name), "mapped");
+            } else {
+                snprintf(read_ahead_name, sizeof(read_ahead_name), "%zu", read_ahead[mode]);
+            }
+            if (run(make_image) || run(boot_and_get)) {
+                printf("Error: The %s backend failed.\n", cur_part->name);
+                return 1;
+            }
+            for (phase = 0; phase < PHASE_NUM; phase++) {
+                print_phase(cur_part->name, read_ahead_name, phase);
+            }
+        }
+    }
+
+    return 0;
+}
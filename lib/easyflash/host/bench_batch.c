@@ -0,0 +1,136 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Update a group of ENV one by one and by ef_env_batch_commit, compare the flash cost.
+ * Created on: 2026-10-18
+ */
+
+#include <easyflash.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ef_sim.h"
+#include "bench_util.h"
+
+struct bench_result {
+    uint64_t wall_ns;
+    struct ef_sim_stats stats;
+};
+
+static int check_group(char (*keys)[EF_ENV_NAME_MAX], size_t keys_num, uint32_t round) {
+    uint32_t value[4];
+    size_t i, saved_len;
+
+    for (i = 0; i < keys_num; i++) {
+        if (ef_get_env_blob(keys[i], value, sizeof(value), &saved_len) != sizeof(value) || value[0] != round
+                || value[1] != i) {
+            printf("Error: The ENV '%s' is wrong after round %u.\n", keys[i], round);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void print_result(const char *name, size_t rounds, const struct bench_result *r) {
+    printf("%-10s %10.1f %10.1f %12.1f %10.1f %10.2f %12.3f %10.1f\n", name,
+            (double) r->stats.programs / rounds, (double) r->stats.program_bytes / rounds,
+            (double) r->stats.reads / rounds, (double) r->stats.erases / rounds,
+            r->wall_ns / 1e3 / rounds, r->stats.busy_ns / 1e6 / rounds,
+            (double) r->stats.reprograms / rounds);
+}
+
+int main(int argc, char **argv) {
+    struct ef_sim_cfg sim = EF_SIM_CFG_DEFAULT(ENV_AREA_SIZE);
+    struct bench_result single, batched;
+    struct ef_env_batch batch;
+    size_t keys_num = 20, rounds = 200, i;
+    char (*keys)[EF_ENV_NAME_MAX];
+    uint32_t (*values)[4], round;
+    uint64_t start;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "k:n:Vh")) != -1) {
+        switch (opt) {
+        case 'k': keys_num = strtoul(optarg, NULL, 0); break;
+        case 'n': rounds = strtoul(optarg, NULL, 0); break;
+        case 'V': ef_sim_set_verbose(true); break;
+        default:
+            printf("Usage: %s [-k keys per group, max %d] [-n rounds] [-V]\n", argv[0], EF_ENV_BATCH_MAX);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (keys_num == 0 || keys_num > EF_ENV_BATCH_MAX || rounds == 0) {
+        printf("The keys must be 1 to %d and rounds must NOT be 0.\n", EF_ENV_BATCH_MAX);
+        return 1;
+    }
+    keys = calloc(keys_num, sizeof(keys[0]));
+    values = calloc(keys_num, sizeof(values[0]));
+    for (i = 0; i < keys_num; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "calib%03zu", i);
+    }
+
+    printf("update %zu keys (16 bytes value) per round, %zu rounds, ENV_AREA_SIZE 0x%X, sector 0x%X\n",
+            keys_num, rounds, ENV_AREA_SIZE, EF_ERASE_MIN_SIZE);
+    ef_sim_init(&sim);
+    if (easyflash_init() != EF_NO_ERR) {
+        printf("EasyFlash initialize failed.\n");
+        return 1;
+    }
+
+    /* one by one */
+    ef_sim_reset_stats();
+    start = bench_now_ns();
+    for (round = 1; round <= rounds; round++) {
+        for (i = 0; i < keys_num; i++) {
+            values[i][0] = round;
+            values[i][1] = i;
+            if (ef_set_env_blob(keys[i], values[i], sizeof(values[i])) != EF_NO_ERR) {
+                printf("Set failed at round %u key %zu.\n", round, i);
+                return 1;
+            }
+        }
+    }
+    single.wall_ns = bench_now_ns() - start;
+    ef_sim_get_stats(&single.stats);
+    if (check_group(keys, keys_num, rounds)) {
+        return 1;
+    }
+
+    /* batched */
+    ef_sim_reset_stats();
+    start = bench_now_ns();
+    for (round = rounds + 1; round <= rounds * 2; round++) {
+        ef_env_batch_init(&batch);
+        for (i = 0; i < keys_num; i++) {
+            values[i][0] = round;
+            values[i][1] = i;
+            ef_env_batch_set(&batch, keys[i], values[i], sizeof(values[i]));
+        }
+        if (ef_env_batch_commit(&batch) != EF_NO_ERR) {
+            printf("Batch commit failed at round %u.\n", round);
+            return 1;
+        }
+    }
+    batched.wall_ns = bench_now_ns() - start;
+    ef_sim_get_stats(&batched.stats);
+    if (check_group(keys, keys_num, rounds * 2)) {
+        return 1;
+    }
+
+    printf("%-10s %10s %10s %12s %10s %10s %12s %10s\n", "per round", "programs", "prog B", "reads",
+            "erases", "wall us", "flash ms", "reprogs");
+    print_result("single", rounds, &single);
+    print_result("batch", rounds, &batched);
+    printf("saving: programs %.1f%%, flash busy %.1f%%, wall %.1f%%\n",
+            100.0 - 100.0 * batched.stats.programs / single.stats.programs,
+            100.0 - 100.0 * batched.stats.busy_ns / single.stats.busy_ns,
+            100.0 - 100.0 * batched.wall_ns / single.wall_ns);
+
+    free(keys);
+    free(values);
+    ef_sim_deinit();
+
+    return 0;
+}
@@ -0,0 +1,230 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Boot to first get time with the ENV snapshot (EF_ENV_SNAPSHOT_ADDR), the stale snapshot and
+ *           without the snapshot. Every boot is a new process, so all RAM state is lost as a real reboot.
+ * Created on: 2026-10-18
+ */
+
+#include <easyflash.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "ef_sim.h"
+#include "bench_util.h"
+
+#ifndef EF_ENV_INDEX_TABLE_SIZE
+#define EF_ENV_INDEX_TABLE_SIZE                  0
+#endif
+
+/* the snapshot area is placed after the ENV area */
+#ifdef EF_ENV_SNAPSHOT_ADDR
+#define SIM_SIZE                                 (ENV_AREA_SIZE + EF_ENV_SNAPSHOT_SIZE)
+#else
+#define SIM_SIZE                                 ENV_AREA_SIZE
+#endif
+
+/* every key is updated by rounds, the value is the key number and the round */
+#define ROUNDS                                   3
+
+struct boot_result {
+    uint64_t wall_ns;
+    struct ef_sim_stats stats;
+};
+
+static size_t keys_num = 1000;
+/* the flash image and the boot result are shared by the boot processes */
+static uint8_t *image;
+static struct boot_result *result;
+
+static void key_name(char *key, size_t i) {
+    snprintf(key, EF_ENV_NAME_MAX, "key%06zu", i);
+}
+
+static int set_key(size_t i, uint32_t round) {
+    char key[EF_ENV_NAME_MAX];
+    uint32_t value[4] = { (uint32_t) i, round };
+
+    key_name(key, i);
+    if (ef_set_env_blob(key, value, sizeof(value)) != EF_NO_ERR) {
+        printf("Error: Set the ENV '%s' failed.\n", key);
+        return 1;
+    }
+
+    return 0;
+}
+
+static int check_keys(size_t changed_key, uint32_t changed_round) {
+    char key[EF_ENV_NAME_MAX];
+    uint32_t value[4], expect;
+    size_t i;
+
+    for (i = 0; i < keys_num; i++) {
+        key_name(key, i);
+        expect = i == changed_key ? changed_round : ROUNDS;
+        if (ef_get_env_blob(key, value, sizeof(value), NULL) != sizeof(value) || value[0] != i || value[1] != expect) {
+            printf("Error: The ENV '%s' is wrong after boot.\n", key);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static int boot(void) {
+    struct ef_sim_cfg sim = EF_SIM_CFG_DEFAULT(SIM_SIZE);
+
+    ef_sim_init(&sim);
+    memcpy(ef_sim_get_mem(), image, SIM_SIZE);
+    ef_sim_reset_stats();
+    if (easyflash_init() != EF_NO_ERR) {
+        printf("EasyFlash initialize failed.\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+static void save_image(void) {
+    memcpy(image, ef_sim_get_mem(), SIM_SIZE);
+}
+
+/* the first boot, then all keys are written ROUNDS times */
+static int make_image(bool save) {
+    size_t i;
+    uint32_t round;
+
+    memset(image, 0xFF, SIM_SIZE);
+    if (boot()) {
+        return 1;
+    }
+    for (round = 1; round <= ROUNDS; round++) {
+        for (i = 0; i < keys_num; i++) {
+            if (set_key(i, round)) {
+                return 1;
+            }
+        }
+    }
+    if (save && ef_save_env() != EF_NO_ERR) {
+        printf("Error: Save ENV failed.\n");
+        return 1;
+    }
+    save_image();
+
+    return 0;
+}
+
+/* boot, get a key, then check all keys and change a key when change_key < keys_num */
+static int boot_and_get(size_t changed_key, uint32_t changed_round, size_t change_key, uint32_t change_round) {
+    char key[EF_ENV_NAME_MAX];
+    uint32_t value[4];
+    uint64_t start = bench_now_ns();
+
+    if (boot()) {
+        return 1;
+    }
+    key_name(key, keys_num / 2);
+    if (ef_get_env_blob(key, value, sizeof(value), NULL) != sizeof(value)) {
+        printf("Error: The first get failed.\n");
+        return 1;
+    }
+    result->wall_ns = bench_now_ns() - start;
+    ef_sim_get_stats(&result->stats);
+
+    if (check_keys(changed_key, changed_round)) {
+        return 1;
+    }
+    if (change_key < keys_num) {
+        if (set_key(change_key, change_round) || ef_save_env() != EF_NO_ERR) {
+            return 1;
+        }
+        save_image();
+    }
+
+    return 0;
+}
+
+/* run it in a new process */
+#define RUN(expr)                                                       \
+do {                                                                    \
+    pid_t pid;                                                          \
+    int status;                                                         \
+    fflush(stdout);                                                     \
+    pid = fork();                                                       \
+    if (pid == 0) {                                                     \
+        exit(expr);                                                     \
+    }                                                                   \
+    if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status)   \
+            || WEXITSTATUS(status) != 0) {                              \
+        printf("Error: '%s' failed.\n", #expr);                         \
+        return 1;                                                       \
+    }                                                                   \
+} while (0)
+
+static void print_result(const char *name) {
+    printf("%-22s %10.3f %10.3f %10llu %12.1f %10.3f\n", name,
+            (result->stats.busy_ns + result->wall_ns) / 1e6, result->stats.busy_ns / 1e6,
+            (unsigned long long) result->stats.reads, result->stats.read_bytes / 1024.0,
+            result->wall_ns / 1e6);
+}
+
+int main(int argc, char **argv) {
+    size_t none = (size_t) -1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "k:Vh")) != -1) {
+        switch (opt) {
+        case 'k': keys_num = strtoul(optarg, NULL, 0); break;
+        case 'V': ef_sim_set_verbose(true); break;
+        default:
+            printf("Usage: %s [-k keys, default 1000] [-V]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (keys_num < 2) {
+        printf("The keys must be more than 1.\n");
+        return 1;
+    }
+
+    image = mmap(NULL, SIM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    result = mmap(NULL, sizeof(*result), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (image == MAP_FAILED || result == MAP_FAILED) {
+        printf("Error: mmap failed.\n");
+        return 1;
+    }
+
+    printf("%zu keys written %d times, ENV_AREA_SIZE 0x%X, EF_ENV_INDEX_TABLE_SIZE %d, ", keys_num, ROUNDS,
+            ENV_AREA_SIZE, EF_ENV_INDEX_TABLE_SIZE);
+#ifdef EF_ENV_SNAPSHOT_ADDR
+    printf("snapshot area 0x%X\n", EF_ENV_SNAPSHOT_SIZE);
+#else
+    printf("no snapshot\n");
+#endif
+    printf("%-22s %10s %10s %10s %12s %10s\n", "boot to first get", "total ms", "flash ms", "reads", "read KB",
+            "cpu ms");
+
+    /* power off without ef_save_env */
+    RUN(make_image(false));
+    RUN(boot_and_get(none, 0, none, 0));
+    print_result("no snapshot");
+
+#ifdef EF_ENV_SNAPSHOT_ADDR
+    /* clean shutdown by ef_save_env, then change a key and save again on the next boot */
+    RUN(make_image(true));
+    RUN(boot_and_get(none, 0, 0, ROUNDS + 1));
+    print_result("snapshot");
+    RUN(boot_and_get(0, ROUNDS + 1, none, 0));
+    print_result("second snapshot");
+
+    /* the key is changed after the snapshot */
+    RUN(make_image(true));
+    RUN(boot() || set_key(1, ROUNDS + 1) || (save_image(), 0));
+    RUN(boot_and_get(1, ROUNDS + 1, none, 0));
+    print_result("stale snapshot");
+#endif /* EF_ENV_SNAPSHOT_ADDR */
+
+    return 0;
+}
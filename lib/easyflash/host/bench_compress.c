@@ -0,0 +1,200 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Configuration blobs saved with and without the ENV value compression (EF_ENV_USING_COMPRESS).
+ *           The corpus is the JSON text which the types plugin saves by cJSON_PrintUnformatted.
+ * Created on: 2026-10-18
+ */
+
+#include <easyflash.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ef_sim.h"
+#include "bench_util.h"
+
+#define VALUE_MAX                                2048
+
+struct corpus_item {
+    const char *key;
+    char value[VALUE_MAX];
+    size_t len;
+};
+
+static struct corpus_item corpus[8];
+static size_t corpus_num = 0;
+
+static struct corpus_item *corpus_add(const char *key) {
+    struct corpus_item *item = &corpus[corpus_num++];
+
+    item->key = key;
+    item->value[0] = '\0';
+
+    return item;
+}
+
+static void corpus_append(struct corpus_item *item, const char *format, ...) {
+    size_t len = strlen(item->value);
+    va_list args;
+
+    va_start(args, format);
+    vsnprintf(item->value + len, VALUE_MAX - len, format, args);
+    va_end(args);
+    item->len = strlen(item->value);
+}
+
+static void make_corpus(void) {
+    static const char *ssid[] = { "Office-2.4G", "Office-5G", "Guest", "Lab_AP", "Warehouse", "iot-mesh" };
+    static const char *sensor[] = { "temp", "humi", "press", "co2", "lux", "pm25", "noise", "volt" };
+    struct corpus_item *item;
+    uint64_t seed = 1;
+    size_t i;
+
+    item = corpus_add("net_cfg");
+    corpus_append(item, "{\"dhcp\":false,\"ip\":\"192.168.1.100\",\"mask\":\"255.255.255.0\",\"gateway\":\"192.168.1.1\","
+            "\"dns\":[\"8.8.8.8\",\"114.114.114.114\"],\"mac\":\"00:11:22:33:44:55\",\"mtu\":1500}");
+
+    item = corpus_add("device");
+    corpus_append(item, "{\"name\":\"easyflash-node-01\",\"model\":\"STM32F103RB\",\"hw_ver\":3,\"sw_ver\":\"4.1.0\","
+            "\"serial\":\"EF2026101800042\",\"features\":[\"env\",\"iap\",\"log\"],\"uart\":{\"baud\":115200,"
+            "\"bits\":8,\"parity\":\"none\",\"stop\":1},\"log\":{\"level\":3,\"uart\":true,\"flash\":true}}");
+
+    /* ef_set_array with EF_ARRAY_TYPES_INT */
+    item = corpus_add("thresholds");
+    corpus_append(item, "[");
+    for (i = 0; i < 64; i++) {
+        corpus_append(item, "%s%d", i ? "," : "", (int) (100 + (bench_rand(&seed) % 900)));
+    }
+    corpus_append(item, "]");
+
+    /* ef_set_array with EF_ARRAY_TYPES_FLOAT, the float is printed as double */
+    item = corpus_add("calibration");
+    corpus_append(item, "[");
+    for (i = 0; i < 32; i++) {
+        corpus_append(item, "%s%.17g", i ? "," : "", (double) (float) (0.9 + bench_rand_unit(&seed) * 0.2));
+    }
+    corpus_append(item, "]");
+
+    /* ef_set_array with EF_ARRAY_TYPES_BOOL */
+    item = corpus_add("channels");
+    corpus_append(item, "[");
+    for (i = 0; i < 48; i++) {
+        corpus_append(item, "%s%s", i ? "," : "", bench_rand(&seed) % 2 ? "true" : "false");
+    }
+    corpus_append(item, "]");
+
+    /* ef_set_array with EF_ARRAY_TYPES_STRING */
+    item = corpus_add("sensors");
+    corpus_append(item, "[");
+    for (i = 0; i < 16; i++) {
+        corpus_append(item, "%s\"sensor_%s_%zu\"", i ? "," : "", sensor[i % 8], i / 8);
+    }
+    corpus_append(item, "]");
+
+    item = corpus_add("ap_list");
+    corpus_append(item, "[");
+    for (i = 0; i < 8; i++) {
+        corpus_append(item, "%s{\"ssid\":\"%s\",\"bssid\":\"a4:5e:60:%02x:%02x:%02x\",\"rssi\":%d,\"channel\":%d,"
+                "\"secure\":%s}", i ? "," : "", ssid[i % 6], (unsigned) (bench_rand(&seed) & 0xFF),
+                (unsigned) (bench_rand(&seed) & 0xFF), (unsigned) (bench_rand(&seed) & 0xFF),
+                -40 - (int) (bench_rand(&seed) % 50), 1 + (int) (bench_rand(&seed) % 13), i % 3 ? "true" : "false");
+    }
+    corpus_append(item, "]");
+
+    /* the random binary is NOT compressible */
+    item = corpus_add("cert_key");
+    for (i = 0; i < 256; i++) {
+        item->value[i] = (char) bench_rand(&seed);
+    }
+    item->len = 256;
+}
+
+int main(int argc, char **argv) {
+    struct ef_sim_cfg sim = EF_SIM_CFG_DEFAULT(ENV_AREA_SIZE);
+    struct ef_sim_stats stats;
+    struct env_node_obj env;
+    char buf[VALUE_MAX], key[EF_ENV_NAME_MAX];
+    size_t updates = 5000, rounds = 200, i, j, raw_total = 0, node_total = 0, keys;
+    uint64_t start, set_ns, get_ns, seed = 2;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:Vh")) != -1) {
+        switch (opt) {
+        case 'n': updates = strtoul(optarg, NULL, 0); break;
+        case 'V': ef_sim_set_verbose(true); break;
+        default:
+            printf("Usage: %s [-n updates, default 5000] [-V]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+#ifdef EF_ENV_USING_COMPRESS
+    printf("value compression on, ");
+#else
+    printf("value compression off, ");
+#endif
+    printf("ENV_AREA_SIZE 0x%X, sector 0x%X\n", ENV_AREA_SIZE, EF_ERASE_MIN_SIZE);
+    make_corpus();
+    ef_sim_init(&sim);
+    if (easyflash_init() != EF_NO_ERR) {
+        printf("EasyFlash initialize failed.\n");
+        return 1;
+    }
+
+    /* the node size, the set and get time of every item */
+    printf("%-12s %8s %8s %8s %10s %10s\n", "key", "value B", "node B", "ratio", "set us", "get us");
+    for (i = 0; i < corpus_num; i++) {
+        start = bench_now_ns();
+        for (j = 0; j < rounds; j++) {
+            ef_set_env_blob(corpus[i].key, corpus[i].value, corpus[i].len);
+        }
+        set_ns = bench_now_ns() - start;
+        start = bench_now_ns();
+        for (j = 0; j < rounds; j++) {
+            ef_get_env_blob(corpus[i].key, buf, sizeof(buf), NULL);
+        }
+        get_ns = bench_now_ns() - start;
+        if (ef_get_env_blob(corpus[i].key, buf, sizeof(buf), NULL) != corpus[i].len
+                || memcmp(buf, corpus[i].value, corpus[i].len) || !ef_get_env_obj(corpus[i].key, &env)) {
+            printf("Error: The ENV '%s' is wrong.\n", corpus[i].key);
+            return 1;
+        }
+        raw_total += corpus[i].len;
+        node_total += env.len;
+        printf("%-12s %8zu %8u %8.2f %10.2f %10.2f\n", corpus[i].key, corpus[i].len, env.len,
+                (double) corpus[i].len / env.len, set_ns / 1e3 / rounds, get_ns / 1e3 / rounds);
+    }
+    printf("%-12s %8zu %8zu %8.2f\n", "total", raw_total, node_total, (double) raw_total / node_total);
+
+    /* update the random items, the programmed bytes and the GC erases */
+    ef_sim_reset_stats();
+    for (i = 0; i < updates; i++) {
+        j = bench_rand(&seed) % corpus_num;
+        if (ef_set_env_blob(corpus[j].key, corpus[j].value, corpus[j].len) != EF_NO_ERR) {
+            printf("Error: Update the ENV '%s' failed.\n", corpus[j].key);
+            return 1;
+        }
+    }
+    ef_sim_get_stats(&stats);
+    printf("%zu updates: programmed %.1f KB, %llu erases, flash busy %.1f ms\n", updates,
+            stats.program_bytes / 1024.0, (unsigned long long) stats.erases, stats.busy_ns / 1e6);
+
+    /* the device configuration number which the ENV area can hold */
+    if (ef_env_set_default() != EF_NO_ERR) {
+        printf("Error: Set the default ENV failed.\n");
+        return 1;
+    }
+    for (keys = 0; ; keys++) {
+        snprintf(key, sizeof(key), "device%zu", keys);
+        if (ef_set_env_blob(key, corpus[1].value, corpus[1].len) != EF_NO_ERR) {
+            break;
+        }
+    }
+    printf("the ENV area holds %zu '%s' configurations\n", keys, corpus[1].key);
+
+    ef_sim_deinit();
+
+    return 0;
+}
@@ -0,0 +1,118 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: ef_calc_crc32 engines benchmark. The src/ef_utils.c is built once for every EF_CRC32_SLICING.
+ * Created on: 2026-10-18
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench_util.h"
+
+uint32_t ef_calc_crc32_slice1(uint32_t crc, const void *buf, size_t size);
+uint32_t ef_calc_crc32_slice4(uint32_t crc, const void *buf, size_t size);
+uint32_t ef_calc_crc32_slice8(uint32_t crc, const void *buf, size_t size);
+
+static const struct {
+    const char *name;
+    uint32_t (*calc)(uint32_t crc, const void *buf, size_t size);
+} engines[] = {
+    { "byte table", ef_calc_crc32_slice1 },
+    { "slicing-by-4", ef_calc_crc32_slice4 },
+    { "slicing-by-8", ef_calc_crc32_slice8 },
+};
+
+#define ENGINE_NUM                               (sizeof(engines) / sizeof(engines[0]))
+
+/* bit by bit reference */
+static uint32_t crc32_ref(uint32_t crc, const uint8_t *p, size_t size) {
+    int i;
+
+    crc = ~crc;
+    while (size--) {
+        crc ^= *p++;
+        for (i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+
+    return ~crc;
+}
+
+static int check_exact(const uint8_t *buf, size_t buf_size) {
+    uint64_t rnd = 7;
+    size_t i, e, offset, size, split;
+    uint32_t expect, crc;
+
+    for (i = 0; i < 2000; i++) {
+        /* random unaligned offset, size and split point */
+        offset = bench_rand(&rnd) % 64;
+        size = bench_rand(&rnd) % 1024;
+        split = size ? bench_rand(&rnd) % size : 0;
+        expect = crc32_ref(0, buf + offset, size);
+        if (offset + size > buf_size) {
+            continue;
+        }
+        for (e = 0; e < ENGINE_NUM; e++) {
+            crc = engines[e].calc(0, buf + offset, split);
+            crc = engines[e].calc(crc, buf + offset + split, size - split);
+            if (crc != expect) {
+                printf("Error: %s CRC32 0x%08X is NOT same as reference 0x%08X (offset %zu size %zu split %zu).\n",
+                        engines[e].name, crc, expect, offset, size, split);
+                return 1;
+            }
+        }
+    }
+    /* the well known check value */
+    for (e = 0; e < ENGINE_NUM; e++) {
+        if (engines[e].calc(0, "123456789", 9) != 0xCBF43926) {
+            printf("Error: %s check value failed.\n", engines[e].name);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    static const size_t sizes[] = { 8, 24, 32, 64, 256, 1024, 4096, 65536 };
+    const size_t total = 64 * 1024 * 1024, buf_size = 65536 + 64;
+    uint8_t *buf = malloc(buf_size);
+    uint64_t rnd = 1, start, wall;
+    volatile uint32_t sink = 0;
+    size_t i, s, e, loops;
+
+    for (i = 0; i < buf_size; i++) {
+        buf[i] = (uint8_t) bench_rand(&rnd);
+    }
+    if (check_exact(buf, buf_size)) {
+        return 1;
+    }
+    printf("All engines are bit-exact with the reference.\n");
+
+    printf("%8s", "size");
+    for (e = 0; e < ENGINE_NUM; e++) {
+        printf(" %14s", engines[e].name);
+    }
+    printf("   (MB/s)\n");
+    for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        loops = total / sizes[s];
+        printf("%8zu", sizes[s]);
+        for (e = 0; e < ENGINE_NUM; e++) {
+            start = bench_now_ns();
+            for (i = 0; i < loops; i++) {
+                /* odd offset for the unaligned access */
+                sink += engines[e].calc(0, buf + 1 + (i & 31), sizes[s]);
+            }
+            wall = bench_now_ns() - start;
+            printf(" %14.1f", (double) loops * sizes[s] / 1e6 / (wall / 1e9));
+        }
+        printf("\n");
+    }
+    printf("The on-chip CRC module engine (EF_CRC32_USING_HW) only runs on the target.\n");
+    free(buf);
+
+    return 0;
+}
@@ -0,0 +1,208 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: ENV get/set/GC benchmark on the simulated NOR flash.
+ * Created on: 2026-10-18
+ */
+
+#include <easyflash.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ef_sim.h"
+#include "bench_util.h"
+
+struct bench_env_cfg {
+    size_t keys;                                 /**< key count */
+    size_t value_size;                           /**< value size */
+    size_t ops;                                  /**< get and update operation count */
+    double skew;                                 /**< Zipf theta of the updated key, 0: uniform */
+    uint64_t seed;                               /**< random seed */
+    size_t idle_steps;                           /**< max idle GC steps after every set */
+};
+
+static void usage(const char *name) {
+    printf("Usage: %s [-k keys] [-v value_size] [-n ops] [-z skew] [-s seed] [-i idle_steps] [-V]\n", name);
+    printf("  -k  key count (default 64)\n");
+    printf("  -v  value size in bytes (default 16)\n");
+    printf("  -n  get and update operation count (default 20000)\n");
+    printf("  -z  update skew as Zipf theta, 0 is uniform (default 0.99)\n");
+    printf("  -s  random seed (default 1)\n");
+    printf("  -i  max ef_env_gc_step calls after every set, like an idle hook, 0: none (default 2)\n");
+    printf("      it only works with EF_ENV_USING_INCREMENTAL_GC\n");
+    printf("  -V  print the library log\n");
+    printf("ENV_AREA_SIZE is 0x%X and EF_ERASE_MIN_SIZE is 0x%X, rebuild with make ENV_AREA_SIZE=... to change it.\n",
+            ENV_AREA_SIZE, EF_ERASE_MIN_SIZE);
+}
+
+static void fill_value(uint8_t *value, size_t size, uint64_t *seed) {
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        value[i] = 'a' + bench_rand(seed) % 26;
+    }
+}
+
+static void print_stats(const char *phase, size_t ops, uint64_t wall_ns, const struct ef_sim_stats *stats) {
+    printf("%-8s %8zu ops %10.0f ops/s %8.2f us/op | reads/op %7.2f programs/op %6.2f erases %6llu flash busy %9.3f ms\n",
+            phase, ops, ops * 1e9 / (wall_ns ? wall_ns : 1), wall_ns / 1e3 / (ops ? ops : 1),
+            (double) stats->reads / (ops ? ops : 1), (double) stats->programs / (ops ? ops : 1),
+            (unsigned long long) stats->erases, stats->busy_ns / 1e6);
+}
+
+int main(int argc, char **argv) {
+    struct bench_env_cfg cfg = { .keys = 64, .value_size = 16, .ops = 20000, .skew = 0.99, .seed = 1, .idle_steps = 2 };
+    struct ef_sim_cfg sim = EF_SIM_CFG_DEFAULT(ENV_AREA_SIZE);
+    struct ef_sim_stats stats, before;
+    struct bench_zipf zipf;
+    uint64_t start, wall, gc_wall = 0, set_max = 0, rnd, *set_latency;
+    size_t i, gc_count = 0, gc_sectors = 0, misses = 0, idle_steps = 0;
+    uint8_t *value, *read_buf;
+    char key[EF_ENV_NAME_MAX];
+    int opt;
+
+    while ((opt = getopt(argc, argv, "k:v:n:z:s:i:Vh")) != -1) {
+        switch (opt) {
+        case 'k': cfg.keys = strtoul(optarg, NULL, 0); break;
+        case 'v': cfg.value_size = strtoul(optarg, NULL, 0); break;
+        case 'n': cfg.ops = strtoul(optarg, NULL, 0); break;
+        case 'z': cfg.skew = atof(optarg); break;
+        case 's': cfg.seed = strtoull(optarg, NULL, 0); break;
+        case 'i': cfg.idle_steps = strtoul(optarg, NULL, 0); break;
+        case 'V': ef_sim_set_verbose(true); break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (cfg.keys == 0 || cfg.value_size == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    rnd = cfg.seed ? cfg.seed : 1;
+    value = malloc(cfg.value_size);
+    read_buf = malloc(cfg.value_size);
+    set_latency = malloc(cfg.ops * sizeof(uint64_t));
+
+    printf("keys %zu, value %zu bytes, ops %zu, skew %.2f, ENV_AREA_SIZE 0x%X, sector 0x%X\n",
+            cfg.keys, cfg.value_size, cfg.ops, cfg.skew, ENV_AREA_SIZE, EF_ERASE_MIN_SIZE);
+#ifdef EF_ENV_USING_INCREMENTAL_GC
+    printf("incremental GC, %zu idle steps after every set\n", cfg.idle_steps);
+#else
+    printf("full GC\n");
+#endif
+
+    ef_sim_init(&sim);
+    start = bench_now_ns();
+    if (easyflash_init() != EF_NO_ERR) {
+        printf("EasyFlash initialize failed.\n");
+        return 1;
+    }
+    wall = bench_now_ns() - start;
+    ef_sim_get_stats(&stats);
+    print_stats("init", 1, wall, &stats);
+
+    /* populate all keys */
+    ef_sim_reset_stats();
+    start = bench_now_ns();
+    for (i = 0; i < cfg.keys; i++) {
+        snprintf(key, sizeof(key), "key%06zu", i);
+        fill_value(value, cfg.value_size, &rnd);
+        if (ef_set_env_blob(key, value, cfg.value_size) != EF_NO_ERR) {
+            printf("Populate failed at key %zu, the ENV area is full.\n", i);
+            return 1;
+        }
+    }
+    wall = bench_now_ns() - start;
+    ef_sim_get_stats(&stats);
+    print_stats("populate", cfg.keys, wall, &stats);
+
+    /* uniform random lookup */
+    ef_sim_reset_stats();
+    start = bench_now_ns();
+    for (i = 0; i < cfg.ops; i++) {
+        snprintf(key, sizeof(key), "key%06zu", (size_t) (bench_rand(&rnd) % cfg.keys));
+        if (ef_get_env_blob(key, read_buf, cfg.value_size, NULL) != cfg.value_size) {
+            misses++;
+        }
+    }
+    wall = bench_now_ns() - start;
+    ef_sim_get_stats(&stats);
+    print_stats("get", cfg.ops, wall, &stats);
+
+    /* skewed update, the set which erased any sector is counted as a GC, the latency is the simulated flash time */
+    bench_zipf_init(&zipf, cfg.keys, cfg.skew);
+    ef_sim_reset_stats();
+    start = bench_now_ns();
+    for (i = 0; i < cfg.ops; i++) {
+        uint64_t set_start, set_wall;
+
+        snprintf(key, sizeof(key), "key%06zu", bench_zipf_next(&zipf, &rnd));
+        fill_value(value, cfg.value_size, &rnd);
+        ef_sim_get_stats(&before);
+        set_start = bench_now_ns();
+        if (ef_set_env_blob(key, value, cfg.value_size) != EF_NO_ERR) {
+            printf("Update failed at op %zu.\n", i);
+            return 1;
+        }
+        set_wall = bench_now_ns() - set_start;
+        ef_sim_get_stats(&stats);
+        set_latency[i] = stats.busy_ns - before.busy_ns;
+        if (stats.erases != before.erases) {
+            gc_count++;
+            gc_sectors += stats.erases - before.erases;
+            gc_wall += set_wall;
+        }
+        if (set_wall > set_max) {
+            set_max = set_wall;
+        }
+#ifdef EF_ENV_USING_INCREMENTAL_GC
+        {
+            size_t step;
+            /* the idle hook of the control loop */
+            for (step = 0; step < cfg.idle_steps && ef_env_gc_step(); step++) {
+                idle_steps++;
+            }
+        }
+#endif
+    }
+    wall = bench_now_ns() - start;
+    ef_sim_get_stats(&stats);
+    print_stats("set", cfg.ops, wall, &stats);
+    bench_zipf_free(&zipf);
+
+    printf("gc       %8zu runs, %zu sectors collected, %.0f sectors/s, %.2f us/run, max set latency %.2f us\n",
+            gc_count, gc_sectors, gc_sectors * 1e9 / (gc_wall ? gc_wall : 1),
+            gc_wall / 1e3 / (gc_count ? gc_count : 1), set_max / 1e3);
+    if (idle_steps) {
+        printf("idle     %8zu GC steps (not in the set phase numbers above)\n", idle_steps);
+    }
+    bench_print_latency("set (simulated flash time)", set_latency, cfg.ops);
+    {
+        uint32_t wear, wear_min = UINT32_MAX, wear_max = 0;
+        uint64_t wear_sum = 0;
+
+        for (i = 0; i < ef_sim_get_sector_num(); i++) {
+            wear = ef_sim_get_wear(i);
+            wear_sum += wear;
+            if (wear < wear_min) {
+                wear_min = wear;
+            }
+            if (wear > wear_max) {
+                wear_max = wear;
+            }
+        }
+        printf("wear     min %u max %u avg %.2f erases/sector over %zu sectors\n", wear_min, wear_max,
+                (double) wear_sum / ef_sim_get_sector_num(), ef_sim_get_sector_num());
+    }
+    if (misses) {
+        printf("Error: %zu lookup misses.\n", misses);
+        return 1;
+    }
+
+    free(value);
+    free(read_buf);
+    free(set_latency);
+    ef_sim_deinit();
+
+    return 0;
+}
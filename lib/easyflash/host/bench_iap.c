@@ -0,0 +1,205 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: End-to-end firmware update throughput of the IAP writer on the simulated flash with the on-chip
+ *           flash timing. The sender sends one packet after the last one is accepted (like YMODEM or a CAN
+ *           bootloader). The sequential update erases the backup area first, then receives and programs every
+ *           packet by ef_write_data_to_bak. The streaming update puts every packet by ef_iap_stream_put on its
+ *           arrival (the receive interrupt), while ef_iap_stream_poll programs the other buffer and erases ahead.
+ *           The time is the simulated time, so the result is repeatable.
+ * Created on: 2026-10-18
+ */
+
+#include <easyflash.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ef_sim.h"
+#include "bench_util.h"
+
+#define APP_AREA_SIZE                            (256 * 1024)
+
+struct iap_link {
+    const char *name;
+    uint32_t bytes_per_sec;
+    size_t packet_size;
+};
+
+static const struct iap_link links[] = {
+    { "UART 115200",   11520,    128 },
+    { "UART 921600",   92160,    1024 },
+    { "CAN FD 2M",     180000,   64 },
+    { "DMA 10 MB/s",   10000000, 1024 },
+};
+
+static uint8_t *image;
+static size_t image_size = 128 * 1024;
+
+/* the receive time of a packet on the link, in microseconds */
+static uint64_t packet_us(const struct iap_link *link, size_t size) {
+    return ((uint64_t) size * 1000000 + link->bytes_per_sec - 1) / link->bytes_per_sec;
+}
+
+static uint64_t now_us(void) {
+    return ef_port_get_time_us();
+}
+
+static void wait_until_us(uint64_t time) {
+    uint64_t now = now_us();
+
+    if (time > now) {
+        ef_sim_advance_time(time - now);
+    }
+}
+
+static int check_image(void) {
+    if (memcmp(ef_sim_get_mem() + ENV_AREA_SIZE, image, image_size)) {
+        printf("Error: The application in the backup area is wrong.\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+/* erase all, then receive and program every packet */
+static int update_sequential(const struct iap_link *link, uint64_t *time_us) {
+    uint64_t start = now_us();
+    size_t cur_size = 0, size;
+
+    if (ef_erase_bak_app(image_size) != EF_NO_ERR) {
+        return 1;
+    }
+    while (cur_size < image_size) {
+        size = image_size - cur_size < link->packet_size ? image_size - cur_size : link->packet_size;
+        ef_sim_advance_time(packet_us(link, size));
+        if (ef_write_data_to_bak(image + cur_size, size, &cur_size, image_size) != EF_NO_ERR) {
+            return 1;
+        }
+    }
+    *time_us = now_us() - start;
+
+    return check_image();
+}
+
+/* the packet is put at its arrival, it waits when both buffers are full, and the next packet is sent after it */
+static int update_stream(const struct iap_link *link, uint64_t *time_us) {
+    static struct ef_iap_stream stream;
+    uint64_t start = now_us(), arrival, op_start, free_us[2] = { 0, 0 };
+    size_t sent = 0, size, put, done;
+    uint8_t idx;
+
+    ef_iap_stream_init(&stream, image_size);
+    size = link->packet_size < image_size ? link->packet_size : image_size;
+    arrival = start + packet_us(link, size);
+    done = 0;
+    while (sent < image_size) {
+        /* the receive interrupts which are arrived during the last flash operation */
+        while (sent < image_size && arrival <= now_us()) {
+            idx = stream.put_idx;
+            put = ef_iap_stream_put(&stream, image + sent + done, size - done);
+            done += put;
+            if (done < size) {
+                /* both buffers are full, the packet is NOT acknowledged */
+                break;
+            }
+            /* it's accepted when the buffer was released by the consumer */
+            if (free_us[idx] > arrival) {
+                arrival = free_us[idx];
+            }
+            sent += size;
+            done = 0;
+            size = image_size - sent < link->packet_size ? image_size - sent : link->packet_size;
+            arrival += packet_us(link, size);
+        }
+        op_start = now_us();
+        idx = stream.prog_idx;
+        if (ef_iap_stream_poll(&stream) != EF_NO_ERR) {
+            return 1;
+        }
+        if (stream.prog_idx != idx) {
+            free_us[idx] = now_us();
+        }
+        if (now_us() == op_start && sent < image_size) {
+            /* nothing to do, wait for the next packet */
+            wait_until_us(arrival);
+        }
+    }
+    if (ef_iap_stream_finish(&stream) != EF_NO_ERR) {
+        return 1;
+    }
+    *time_us = now_us() - start;
+
+    return check_image();
+}
+
+static void clear_app_area(void) {
+    /* the programmed area is NOT erased, so the strict flash catches a program without erase */
+    memset(ef_sim_get_mem() + ENV_AREA_SIZE, 0, APP_AREA_SIZE);
+}
+
+int main(int argc, char **argv) {
+    struct ef_sim_cfg sim = EF_SIM_CFG_DEFAULT(ENV_AREA_SIZE + APP_AREA_SIZE);
+    struct ef_sim_stats stats;
+    uint64_t seq_us, stream_us, seed = 1;
+    size_t i;
+    int opt;
+
+    /* the typical on-chip flash timing: 4 KB sector erase 12 ms, 36 us per 8 bytes phrase */
+    sim.strict = true;
+    sim.read_ns = 0;
+    sim.read_ns_per_byte = 0;
+    sim.prog_ns = 2000;
+    sim.prog_ns_per_byte = 4500;
+    sim.erase_ns = 12000000;
+    while ((opt = getopt(argc, argv, "s:Vh")) != -1) {
+        switch (opt) {
+        case 's': image_size = strtoul(optarg, NULL, 0); break;
+        case 'V': ef_sim_set_verbose(true); break;
+        default:
+            printf("Usage: %s [-s image size, default 131072] [-V]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (image_size == 0 || image_size > APP_AREA_SIZE) {
+        printf("The image size must be in 1 to %d.\n", APP_AREA_SIZE);
+        return 1;
+    }
+
+    image = malloc(image_size);
+    for (i = 0; i < image_size; i++) {
+        image[i] = (uint8_t) bench_rand(&seed);
+    }
+    ef_sim_init(&sim);
+    if (easyflash_init() != EF_NO_ERR) {
+        printf("EasyFlash initialize failed.\n");
+        return 1;
+    }
+
+    printf("image %zu bytes, buffer 2 x %d bytes, sector 0x%X\n", image_size, EF_IAP_BUF_SIZE, EF_ERASE_MIN_SIZE);
+    printf("%-12s %8s %10s %12s %12s %9s %9s\n", "link", "packet", "link KB/s", "seq KB/s", "stream KB/s", "speedup",
+            "flash %");
+    for (i = 0; i < sizeof(links) / sizeof(links[0]); i++) {
+        clear_app_area();
+        if (update_sequential(&links[i], &seq_us)) {
+            printf("Error: The sequential update failed.\n");
+            return 1;
+        }
+        clear_app_area();
+        ef_sim_reset_stats();
+        if (update_stream(&links[i], &stream_us)) {
+            printf("Error: The streaming update failed.\n");
+            return 1;
+        }
+        ef_sim_get_stats(&stats);
+        printf("%-12s %8zu %10.1f %12.1f %12.1f %8.2fx %8.1f%%\n", links[i].name, links[i].packet_size,
+                links[i].bytes_per_sec / 1024.0, image_size / 1.024 / seq_us * 1000,
+                image_size / 1.024 / stream_us * 1000, (double) seq_us / stream_us,
+                stats.busy_ns / 10.0 / stream_us);
+    }
+
+    ef_sim_deinit();
+    free(image);
+
+    return 0;
+}
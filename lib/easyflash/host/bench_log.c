@@ -0,0 +1,219 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Log record query latency by the ring size. The records are written once a second like a sensor log,
+ *           then the last 10 minutes records and one sequence number are queried by the sector summary
+ *           (ef_log_query_xxx) and by the byte index read of the whole ring (ef_log_read, the only way before).
+ *           The latency is the simulated SPI NOR read time. The last size writes the ring twice, so the oldest
+ *           records are erased.
+ * Created on: 2026-10-18
+ */
+
+#include <easyflash.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ef_sim.h"
+#include "bench_util.h"
+
+#define SEC_DATA_SIZE                            (EF_ERASE_MIN_SIZE - 28)
+#define RECORD_MAX                               96
+#define QUERY_SECONDS                            600
+
+struct query_result {
+    size_t count;
+    uint32_t first_seq;
+    uint32_t last_seq;
+    uint64_t read_ns;
+    uint64_t read_bytes;
+};
+
+/* the time is the seconds since 1970 */
+static uint32_t last_time = 1760745600;
+
+/* the record data is made by the sequence number, so the read data is checked */
+static size_t make_record(uint32_t seq, uint8_t *buf) {
+    uint64_t seed = seq + 1;
+    size_t len = 16 + bench_rand(&seed) % (RECORD_MAX - 16), i;
+
+    for (i = 0; i < len; i++) {
+        buf[i] = (uint8_t) (seq + i);
+    }
+
+    return len;
+}
+
+static bool check_record(uint32_t seq, const uint8_t *data, size_t len) {
+    uint8_t buf[RECORD_MAX];
+
+    return make_record(seq, buf) == len && !memcmp(buf, data, len);
+}
+
+static size_t used_sectors(void) {
+    return (ef_log_get_used_size() + SEC_DATA_SIZE - 1) / SEC_DATA_SIZE;
+}
+
+static void result_begin(struct query_result *result) {
+    memset(result, 0, sizeof(struct query_result));
+    ef_sim_reset_stats();
+}
+
+static void result_end(struct query_result *result) {
+    struct ef_sim_stats stats;
+
+    ef_sim_get_stats(&stats);
+    result->read_ns = stats.busy_ns;
+    result->read_bytes = stats.read_bytes;
+}
+
+static int result_add(struct query_result *result, uint32_t seq, const uint8_t *data, size_t len) {
+    if (!check_record(seq, data, len) || (result->count && seq != result->last_seq + 1)) {
+        printf("Error: The record %u is wrong.\n", seq);
+        return 1;
+    }
+    if (!result->count) {
+        result->first_seq = seq;
+    }
+    result->last_seq = seq;
+    result->count++;
+
+    return 0;
+}
+
+static int query_index(bool by_time, uint32_t from, uint32_t to, struct query_result *result) {
+    struct ef_log_query query;
+    uint8_t data[RECORD_MAX];
+
+    result_begin(result);
+    if (by_time) {
+        ef_log_query_by_time(&query, from, to);
+    } else {
+        ef_log_query_by_seq(&query, from, to);
+    }
+    while (ef_log_query_next(&query, data, sizeof(data))) {
+        if (result_add(result, query.seq, data, query.len)) {
+            return 1;
+        }
+    }
+    result_end(result);
+
+    return 0;
+}
+
+/* read the whole ring by ef_log_read sector by sector, and parse the records of every sector */
+static int query_scan(bool by_time, uint32_t from, uint32_t to, struct query_result *result) {
+    static uint32_t buf[SEC_DATA_SIZE / 4];
+    size_t used = ef_log_get_used_size(), index, size, pos, len;
+    uint8_t *data = (uint8_t *) buf;
+    uint32_t seq, time, key;
+
+    result_begin(result);
+    for (index = 0; index < used; index += SEC_DATA_SIZE) {
+        size = used - index < SEC_DATA_SIZE ? used - index : SEC_DATA_SIZE;
+        ef_log_read(index, buf, size);
+        for (pos = 0; pos + 12 <= size && data[pos] == 0x45 && data[pos + 1] == 0x4C; pos += 12 + ((len + 3) & ~3)) {
+            len = data[pos + 2] | (data[pos + 3] << 8);
+            memcpy(&seq, data + pos + 4, 4);
+            memcpy(&time, data + pos + 8, 4);
+            key = by_time ? time : seq;
+            if (key >= from && key <= to && result_add(result, seq, data + pos + 12, len)) {
+                return 1;
+            }
+        }
+    }
+    result_end(result);
+
+    return 0;
+}
+
+static int write_records(size_t sectors, bool wrap, uint32_t *seq) {
+    uint8_t buf[RECORD_MAX];
+    size_t len, written = 0;
+
+    while (wrap ? written < 2 * LOG_AREA_SIZE : used_sectors() < sectors) {
+        len = make_record(*seq, buf);
+        if (ef_log_write_record(++last_time, buf, len) != EF_NO_ERR) {
+            printf("Error: Write the log record failed.\n");
+            return 1;
+        }
+        written += 12 + ((len + 3) & ~3);
+        (*seq)++;
+    }
+
+    return 0;
+}
+
+/* the records in the log area, from the oldest record */
+static size_t log_records(uint32_t seq) {
+    struct ef_log_query query;
+    uint8_t data[4];
+
+    ef_log_query_by_seq(&query, 0, UINT32_MAX);
+
+    return ef_log_query_next(&query, data, sizeof(data)) ? seq - query.seq : 0;
+}
+
+static bool result_equal(const struct query_result *a, const struct query_result *b) {
+    return a->count == b->count && (!a->count || (a->first_seq == b->first_seq && a->last_seq == b->last_seq));
+}
+
+int main(void) {
+    static const size_t sizes[] = { 16, 32, 128, 512, LOG_AREA_SIZE / EF_ERASE_MIN_SIZE };
+    struct ef_sim_cfg sim = EF_SIM_CFG_DEFAULT(ENV_AREA_SIZE + LOG_AREA_SIZE);
+    struct query_result index_time, scan_time, index_seq, scan_seq, old_seq;
+    uint32_t seq = 0, middle;
+    size_t i, records;
+
+    ef_sim_init(&sim);
+    if (easyflash_init() != EF_NO_ERR) {
+        printf("EasyFlash initialize failed.\n");
+        return 1;
+    }
+    ef_log_clean();
+
+    printf("log area %d sectors, the last %d seconds query and one sequence number query\n",
+            LOG_AREA_SIZE / EF_ERASE_MIN_SIZE, QUERY_SECONDS);
+    printf("%8s %8s %8s | %10s %9s %10s %9s %8s | %10s %9s %8s\n", "sectors", "records", "matched", "index us",
+            "index KB", "scan us", "scan KB", "speedup", "seq us", "seq KB", "speedup");
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        if (write_records(sizes[i], i + 1 == sizeof(sizes) / sizeof(sizes[0]), &seq)) {
+            return 1;
+        }
+        /* the sequence number query is the middle record */
+        records = log_records(seq);
+        middle = seq - records / 2;
+        if (query_index(true, last_time - QUERY_SECONDS + 1, last_time, &index_time)
+                || query_scan(true, last_time - QUERY_SECONDS + 1, last_time, &scan_time)
+                || query_index(false, middle, middle, &index_seq)
+                || query_scan(false, middle, middle, &scan_seq)) {
+            return 1;
+        }
+        if (!result_equal(&index_time, &scan_time) || index_time.count != QUERY_SECONDS
+                || !result_equal(&index_seq, &scan_seq) || index_seq.count != 1) {
+            printf("Error: The query result is wrong.\n");
+            return 1;
+        }
+        printf("%8zu %8zu %8zu | %10.1f %9.1f %10.1f %9.1f %7.1fx | %10.1f %9.1f %7.1fx\n", used_sectors(),
+                records, index_time.count, index_time.read_ns / 1e3,
+                index_time.read_bytes / 1024.0, scan_time.read_ns / 1e3, scan_time.read_bytes / 1024.0,
+                (double) scan_time.read_ns / index_time.read_ns, index_seq.read_ns / 1e3,
+                index_seq.read_bytes / 1024.0, (double) scan_seq.read_ns / index_seq.read_ns);
+    }
+    /* the first records are erased by the ring */
+    if (query_index(false, 0, 0, &old_seq) || old_seq.count) {
+        printf("Error: The erased record is found.\n");
+        return 1;
+    }
+
+    /* the last record is found again after the initialization */
+    if (easyflash_init() != EF_NO_ERR || query_index(false, seq - 1, UINT32_MAX, &index_seq)
+            || index_seq.count != 1 || index_seq.last_seq != seq - 1) {
+        printf("Error: The last record is NOT found after the initialization.\n");
+        return 1;
+    }
+    printf("the erased records are NOT found, the last record is found after the initialization\n");
+
+    ef_sim_deinit();
+
+    return 0;
+}
@@ -0,0 +1,212 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Asynchronous batched log writer against the synchronous ef_log_write. The text logs arrive by the
+ *           simulated time (a steady rate, and a burst). The synchronous producer writes every log (padded to
+ *           a word) by ef_log_write, so it waits for the flash program and the sector erase. The asynchronous
+ *           producer appends the log by ef_log_async_write, and the idle hook calls ef_log_async_flush every
+ *           5 ms (force write every second). The producer latency, the flash operations per log, the write
+ *           amplification (programmed bytes / written log bytes), the drops and the ring high water are shown.
+ *           The flash can NOT erase fast enough for the last workload, so the sync producer falls behind and the
+ *           async producer drops.
+ *           The logs which arrive during a flush are appended after it, so the drops are the worst case.
+ *           The log area is compared with the accepted logs at last.
+ * Created on: 2026-10-18
+ */
+
+#include <easyflash.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ef_sim.h"
+#include "bench_util.h"
+
+#define LOG_MAX                                  128
+#define IDLE_PERIOD_US                           5000
+#define FORCE_PERIOD_US                          1000000
+
+struct workload {
+    const char *name;
+    uint32_t logs_per_sec;
+    uint32_t seconds;
+};
+
+static const struct workload workloads[] = {
+    { "100 logs/s",  100,  60 },
+    { "1000 logs/s", 1000, 10 },
+    { "5000 logs/s", 5000, 2 },
+};
+
+struct result {
+    size_t logs;
+    size_t log_bytes;
+    uint64_t *latency_ns;
+    struct ef_sim_stats stats;
+    struct ef_log_async_stats async;
+};
+
+/* the accepted async logs */
+static uint8_t *stream;
+static size_t stream_len;
+
+static size_t make_log(uint64_t *seed, uint32_t time_us, char *buf) {
+    static const char * const tags[] = { "sensor", "can", "motor", "power", "net" };
+    int len = snprintf(buf, LOG_MAX, "[%c] %10u %s: value=%u state=%u\n", "DIWE"[bench_rand(seed) % 4], time_us,
+            tags[bench_rand(seed) % 5], (unsigned) (bench_rand(seed) % 100000), (unsigned) (bench_rand(seed) % 8));
+    size_t pad = bench_rand(seed) % 64;
+
+    /* some logs have a longer message */
+    memset(buf + len - 1, '.', pad);
+    buf[len - 1 + pad] = '\n';
+
+    return len + pad;
+}
+
+static uint64_t now_us(void) {
+    return ef_port_get_time_us();
+}
+
+static void wait_until_us(uint64_t time) {
+    if (time > now_us()) {
+        ef_sim_advance_time(time - now_us());
+    }
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+
+    return x < y ? -1 : x > y;
+}
+
+static int run_sync(const struct workload *load, struct result *result) {
+    uint32_t buf[LOG_MAX / 4 + 1];
+    uint64_t seed = 1, arrival, start = now_us();
+    size_t i, len;
+
+    for (i = 0; i < result->logs; i++) {
+        arrival = start + (uint64_t) i * 1000000 / load->logs_per_sec;
+        wait_until_us(arrival);
+        len = make_log(&seed, (uint32_t) arrival, (char *) buf);
+        result->log_bytes += len;
+        /* ef_log_write needs the word size */
+        while (len % 4) {
+            ((char *) buf)[len++] = ' ';
+        }
+        if (ef_log_write(buf, len) != EF_NO_ERR) {
+            return 1;
+        }
+        result->latency_ns[i] = (now_us() - arrival) * 1000;
+    }
+
+    return 0;
+}
+
+static int run_async(const struct workload *load, struct result *result) {
+    char buf[LOG_MAX];
+    uint64_t seed = 1, arrival, start = now_us(), next_idle = start, next_force = start + FORCE_PERIOD_US, t;
+    size_t i = 0, len;
+
+    while (i < result->logs) {
+        /* the producer, the logs which are arrived */
+        for (; i < result->logs && (arrival = start + (uint64_t) i * 1000000 / load->logs_per_sec) <= now_us(); i++) {
+            len = make_log(&seed, (uint32_t) arrival, buf);
+            result->log_bytes += len;
+            t = bench_now_ns();
+            if (ef_log_async_write(buf, len)) {
+                result->latency_ns[i] = bench_now_ns() - t;
+                memcpy(stream + stream_len, buf, len);
+                stream_len += len;
+            } else {
+                result->latency_ns[i] = bench_now_ns() - t;
+            }
+        }
+        /* the idle hook */
+        if (now_us() >= next_idle) {
+            if (ef_log_async_flush(now_us() >= next_force) != EF_NO_ERR) {
+                return 1;
+            }
+            if (now_us() >= next_force) {
+                next_force += FORCE_PERIOD_US;
+            }
+            next_idle = now_us() + IDLE_PERIOD_US;
+        }
+        if (i < result->logs) {
+            arrival = start + (uint64_t) i * 1000000 / load->logs_per_sec;
+            wait_until_us(arrival < next_idle ? arrival : next_idle);
+        }
+    }
+
+    return ef_log_async_flush(true) != EF_NO_ERR;
+}
+
+/* the log area is the tail of the accepted logs, except the last bytes which are less than a word */
+static int check_async_log(void) {
+    size_t used = ef_log_get_used_size(), staged = stream_len % 4;
+    uint32_t *buf = malloc(used);
+    int ret = 0;
+
+    if (ef_log_read(0, buf, used) != EF_NO_ERR || used > stream_len
+            || memcmp(buf, stream + stream_len - staged - used, used)) {
+        printf("Error: The log area is NOT same as the accepted logs.\n");
+        ret = 1;
+    }
+    free(buf);
+
+    return ret;
+}
+
+static void print_result(const char *name, const char *mode, struct result *result, bool is_async) {
+    qsort(result->latency_ns, result->logs, sizeof(uint64_t), cmp_u64);
+    printf("%-12s %-6s %10.2f %10.2f %10.1f %8.2f %8.3f %7zu %7u %6zu\n", name, mode,
+            result->latency_ns[result->logs / 2] / 1e3, result->latency_ns[result->logs * 99 / 100] / 1e3,
+            result->latency_ns[result->logs - 1] / 1e3, (double) result->stats.programs / result->logs,
+            (double) result->stats.program_bytes / (is_async ? stream_len : result->log_bytes), (size_t) result->stats.erases,
+            is_async ? result->async.drops : 0, is_async ? result->async.high_water : 0);
+}
+
+int main(void) {
+    struct ef_sim_cfg sim = EF_SIM_CFG_DEFAULT(ENV_AREA_SIZE + LOG_AREA_SIZE);
+    struct result result;
+    size_t i;
+    int async;
+
+    ef_sim_init(&sim);
+    if (easyflash_init() != EF_NO_ERR) {
+        printf("EasyFlash initialize failed.\n");
+        return 1;
+    }
+
+    printf("log area %d sectors, staging ring %d bytes, idle hook every %d ms\n", LOG_AREA_SIZE / EF_ERASE_MIN_SIZE,
+            EF_LOG_ASYNC_BUF_SIZE, IDLE_PERIOD_US / 1000);
+    printf("%-12s %-6s %10s %10s %10s %8s %8s %7s %7s %6s\n", "workload", "mode", "p50 us", "p99 us", "max us",
+            "ops/log", "amplify", "erases", "drops", "high");
+    for (i = 0; i < sizeof(workloads) / sizeof(workloads[0]); i++) {
+        for (async = 0; async < 2; async++) {
+            memset(&result, 0, sizeof(result));
+            result.logs = (size_t) workloads[i].logs_per_sec * workloads[i].seconds;
+            result.latency_ns = malloc(result.logs * sizeof(uint64_t));
+            ef_log_clean();
+            ef_sim_reset_stats();
+            if (async) {
+                stream = malloc(result.logs * LOG_MAX);
+                stream_len = 0;
+                if (run_async(&workloads[i], &result) || check_async_log()) {
+                    printf("Error: The asynchronous log writer failed.\n");
+                    return 1;
+                }
+                free(stream);
+                ef_log_async_get_stats(&result.async);
+            } else if (run_sync(&workloads[i], &result)) {
+                printf("Error: The synchronous log write failed.\n");
+                return 1;
+            }
+            ef_sim_get_stats(&result.stats);
+            print_result(workloads[i].name, async ? "async" : "sync", &result, async);
+            free(result.latency_ns);
+        }
+    }
+
+    ef_sim_deinit();
+
+    return 0;
+}
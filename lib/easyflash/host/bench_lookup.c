@@ -0,0 +1,112 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: ENV lookup cost against key count, build it with and without EF_ENV_INDEX_TABLE_SIZE.
+ * Created on: 2026-10-18
+ */
+
+#include <easyflash.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ef_sim.h"
+#include "bench_util.h"
+
+#ifndef EF_ENV_INDEX_TABLE_SIZE
+#define EF_ENV_INDEX_TABLE_SIZE                  0
+#endif
+
+static int check_value(const char *key, uint32_t expect) {
+    uint32_t value = 0;
+    size_t saved_len = 0;
+
+    ef_get_env_blob(key, &value, sizeof(value), &saved_len);
+    if (saved_len != sizeof(value) || value != expect) {
+        printf("Error: The ENV '%s' is wrong, saved %zu bytes value %u, expect %u.\n", key, saved_len, value, expect);
+        return 1;
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    struct ef_sim_cfg sim = EF_SIM_CFG_DEFAULT(ENV_AREA_SIZE);
+    struct ef_sim_stats stats;
+    size_t max_keys = 1024, ops = 10000, keys = 0, step, i;
+    uint64_t rnd = 1, start, wall;
+    char key[EF_ENV_NAME_MAX];
+    uint32_t value;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "k:n:Vh")) != -1) {
+        switch (opt) {
+        case 'k': max_keys = strtoul(optarg, NULL, 0); break;
+        case 'n': ops = strtoul(optarg, NULL, 0); break;
+        case 'V': ef_sim_set_verbose(true); break;
+        default:
+            printf("Usage: %s [-k max_keys] [-n lookups per step] [-V]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    printf("ENV_AREA_SIZE 0x%X, EF_ENV_INDEX_TABLE_SIZE %d (%zu bytes RAM)\n", ENV_AREA_SIZE,
+            EF_ENV_INDEX_TABLE_SIZE, (size_t) EF_ENV_INDEX_TABLE_SIZE * 8);
+    ef_sim_init(&sim);
+    if (easyflash_init() != EF_NO_ERR) {
+        printf("EasyFlash initialize failed.\n");
+        return 1;
+    }
+
+    printf("%8s %12s %10s %10s %12s\n", "keys", "get ops/s", "us/get", "reads/get", "read B/get");
+    for (step = 16; step <= max_keys; step *= 2) {
+        /* add keys up to this step, the value is the key number */
+        for (; keys < step; keys++) {
+            snprintf(key, sizeof(key), "key%06zu", keys);
+            value = (uint32_t) keys;
+            if (ef_set_env_blob(key, &value, sizeof(value)) != EF_NO_ERR) {
+                printf("Set failed at key %zu, the ENV area is full.\n", keys);
+                return 1;
+            }
+        }
+        ef_sim_reset_stats();
+        start = bench_now_ns();
+        for (i = 0; i < ops; i++) {
+            snprintf(key, sizeof(key), "key%06zu", (size_t) (bench_rand(&rnd) % keys));
+            ef_get_env_blob(key, &value, sizeof(value), NULL);
+        }
+        wall = bench_now_ns() - start;
+        ef_sim_get_stats(&stats);
+        printf("%8zu %12.0f %10.2f %10.2f %12.1f\n", keys, ops * 1e9 / wall, wall / 1e3 / ops,
+                (double) stats.reads / ops, (double) stats.read_bytes / ops);
+    }
+
+    /* check the index is coherent after update and delete */
+    for (i = 0; i < keys; i += 2) {
+        snprintf(key, sizeof(key), "key%06zu", i);
+        value = (uint32_t) (i + 1000000);
+        if (ef_set_env_blob(key, &value, sizeof(value)) != EF_NO_ERR) {
+            printf("Update failed at key %zu.\n", i);
+            return 1;
+        }
+    }
+    for (i = 1; i < keys; i += 4) {
+        snprintf(key, sizeof(key), "key%06zu", i);
+        ef_del_env(key);
+    }
+    for (i = 0; i < keys; i++) {
+        snprintf(key, sizeof(key), "key%06zu", i);
+        if (i % 4 == 1) {
+            if (ef_get_env_blob(key, &value, sizeof(value), NULL) != 0) {
+                printf("Error: The deleted ENV '%s' is found.\n", key);
+                return 1;
+            }
+        } else if (check_value(key, (uint32_t) (i % 2 ? i : i + 1000000))) {
+            return 1;
+        }
+    }
+    printf("Check %zu keys after update and delete OK.\n", keys);
+    ef_sim_deinit();
+
+    return 0;
+}
@@ -0,0 +1,228 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Multi-thread stress of the ENV lock, one writer keeps updating the keys (with GC) while 1 to 8
+ *           readers get them. Every value is checked, and the read throughput is measured with the reader/writer
+ *           lock (EF_ENV_USING_RW_LOCK) and with the exclusive lock. The simulated flash sleeps for the flash
+ *           busy time, like a SPI flash driver which waits the DMA, so the readers can overlap on one CPU too.
+ * Created on: 2026-10-18
+ */
+
+#include <easyflash.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "ef_sim.h"
+#include "bench_util.h"
+
+#define KEYS                                     8
+#define READERS_MAX                              8
+
+/* the value is self-checking, it has the key number, the update sequence and the CRC32 */
+struct mt_value {
+    uint32_t key;
+    uint32_t seq;
+    uint32_t fill[61];
+    uint32_t crc;
+};
+
+/* the sequence before the set is started and after the set is finished */
+static uint32_t started[KEYS], committed[KEYS];
+static bool running;
+static size_t writer_pause_us = 200;
+static uint64_t total_errors = 0;
+
+struct reader_arg {
+    pthread_t thread;
+    uint64_t seed;
+    uint64_t reads;
+    uint64_t errors;
+};
+
+static void key_name(char *key, size_t i) {
+    snprintf(key, EF_ENV_NAME_MAX, "mt_key%zu", i);
+}
+
+static void make_value(struct mt_value *value, uint32_t key, uint32_t seq) {
+    size_t i;
+
+    value->key = key;
+    value->seq = seq;
+    for (i = 0; i < sizeof(value->fill) / sizeof(value->fill[0]); i++) {
+        value->fill[i] = key * 2654435761U + seq * 40503U + (uint32_t) i;
+    }
+    value->crc = ef_calc_crc32(0, value, offsetof(struct mt_value, crc));
+}
+
+static int set_key(uint32_t key, uint32_t seq) {
+    char name[EF_ENV_NAME_MAX];
+    struct mt_value value;
+
+    key_name(name, key);
+    make_value(&value, key, seq);
+    __atomic_store_n(&started[key], seq, __ATOMIC_SEQ_CST);
+    if (ef_set_env_blob(name, &value, sizeof(value)) != EF_NO_ERR) {
+        printf("Error: Set the ENV '%s' failed.\n", name);
+        return 1;
+    }
+    __atomic_store_n(&committed[key], seq, __ATOMIC_SEQ_CST);
+
+    return 0;
+}
+
+/* the value must be a whole update, and it must NOT be older than the last finished set */
+static bool check_value(uint32_t key, const struct mt_value *value, size_t len, uint32_t min_seq, uint32_t max_seq) {
+    return len == sizeof(*value) && value->key == key && value->crc == ef_calc_crc32(0, value,
+            offsetof(struct mt_value, crc)) && value->seq >= min_seq && value->seq <= max_seq;
+}
+
+static void *reader_thread(void *arg) {
+    struct reader_arg *reader = arg;
+    char name[EF_ENV_NAME_MAX];
+    struct mt_value value;
+    uint32_t key, min_seq;
+    size_t len;
+
+    while (__atomic_load_n(&running, __ATOMIC_RELAXED)) {
+        key = (uint32_t) (bench_rand(&reader->seed) % KEYS);
+        key_name(name, key);
+        min_seq = __atomic_load_n(&committed[key], __ATOMIC_SEQ_CST);
+        memset(&value, 0, sizeof(value));
+        len = ef_get_env_blob(name, &value, sizeof(value), NULL);
+        if (!check_value(key, &value, len, min_seq, __atomic_load_n(&started[key], __ATOMIC_SEQ_CST))) {
+            if (reader->errors++ == 0) {
+                printf("Error: The ENV '%s' is wrong, len %zu, seq %u.\n", name, len, value.seq);
+            }
+        }
+        reader->reads++;
+    }
+
+    return NULL;
+}
+
+static void *writer_thread(void *arg) {
+    uint64_t *writes = arg, seed = 7;
+    uint32_t key;
+
+    while (__atomic_load_n(&running, __ATOMIC_RELAXED)) {
+        key = (uint32_t) (bench_rand(&seed) % KEYS);
+        if (set_key(key, started[key] + 1)) {
+            __atomic_fetch_add(&total_errors, 1, __ATOMIC_SEQ_CST);
+            break;
+        }
+        (*writes)++;
+        if (writer_pause_us) {
+            usleep(writer_pause_us);
+        }
+    }
+
+    return NULL;
+}
+
+static int bench_readers(size_t readers_num, size_t run_ms, bool writer, double *base) {
+    struct reader_arg readers[READERS_MAX];
+    pthread_t writer_tid;
+    uint64_t writes = 0, reads = 0, errors = 0, start, wall;
+    size_t i;
+    double rate;
+
+    __atomic_store_n(&running, true, __ATOMIC_RELAXED);
+    start = bench_now_ns();
+    if (writer && pthread_create(&writer_tid, NULL, writer_thread, &writes)) {
+        printf("Error: Create the writer failed.\n");
+        return 1;
+    }
+    for (i = 0; i < readers_num; i++) {
+        readers[i].seed = i + 1;
+        readers[i].reads = 0;
+        readers[i].errors = 0;
+        if (pthread_create(&readers[i].thread, NULL, reader_thread, &readers[i])) {
+            printf("Error: Create the reader failed.\n");
+            return 1;
+        }
+    }
+    usleep(run_ms * 1000);
+    __atomic_store_n(&running, false, __ATOMIC_RELAXED);
+    for (i = 0; i < readers_num; i++) {
+        pthread_join(readers[i].thread, NULL);
+        reads += readers[i].reads;
+        errors += readers[i].errors;
+    }
+    if (writer) {
+        pthread_join(writer_tid, NULL);
+    }
+    wall = bench_now_ns() - start;
+
+    rate = reads / (wall / 1e9);
+    if (*base == 0) {
+        *base = rate;
+    }
+    printf("%-8zu %-7s %12.0f %12.0f %9.2fx %10.0f %8llu\n", readers_num, writer ? "yes" : "no", rate,
+            rate / readers_num, rate / *base, writes / (wall / 1e9), (unsigned long long) errors);
+
+    return errors || total_errors ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+    struct ef_sim_cfg sim = EF_SIM_CFG_DEFAULT(ENV_AREA_SIZE);
+    struct ef_sim_stats stats;
+    size_t run_ms = 500, readers_num;
+    double base = 0, base_writer = 0;
+    uint32_t key;
+    int opt;
+
+    sim.real_time = true;
+    while ((opt = getopt(argc, argv, "t:p:sVh")) != -1) {
+        switch (opt) {
+        case 't': run_ms = strtoul(optarg, NULL, 0); break;
+        case 'p': writer_pause_us = strtoul(optarg, NULL, 0); break;
+        case 's': sim.real_time = false; break;
+        case 'V': ef_sim_set_verbose(true); break;
+        default:
+            printf("Usage: %s [-t run ms, default 500] [-p writer pause us, default 200] [-s no flash sleep] [-V]\n",
+                    argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+#ifdef EF_ENV_USING_RW_LOCK
+    printf("reader/writer lock, ");
+#else
+    printf("exclusive lock, ");
+#endif
+    printf("%s, %d keys, ENV_AREA_SIZE 0x%X, sector 0x%X, %ld CPUs\n", sim.real_time ? "flash sleep" : "no flash sleep",
+            KEYS, ENV_AREA_SIZE, EF_ERASE_MIN_SIZE, sysconf(_SC_NPROCESSORS_ONLN));
+    ef_sim_init(&sim);
+    if (easyflash_init() != EF_NO_ERR) {
+        printf("EasyFlash initialize failed.\n");
+        return 1;
+    }
+    for (key = 0; key < KEYS; key++) {
+        if (set_key(key, 1)) {
+            return 1;
+        }
+    }
+
+    ef_sim_reset_stats();
+    printf("%-8s %-7s %12s %12s %10s %10s %8s\n", "readers", "writer", "reads/s", "per reader", "scaling", "writes/s",
+            "errors");
+    for (readers_num = 1; readers_num <= READERS_MAX; readers_num *= 2) {
+        if (bench_readers(readers_num, run_ms, false, &base)) {
+            return 1;
+        }
+    }
+    for (readers_num = 1; readers_num <= READERS_MAX; readers_num *= 2) {
+        if (bench_readers(readers_num, run_ms, true, &base_writer)) {
+            return 1;
+        }
+    }
+    ef_sim_get_stats(&stats);
+    printf("%llu erases during the writes\n", (unsigned long long) stats.erases);
+
+    ef_sim_deinit();
+
+    return 0;
+}
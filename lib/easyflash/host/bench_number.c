@@ -0,0 +1,238 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Number text format and parse of cJSON. The shortest round-trip formatter (cJSON_PrintDouble,
+ *           cJSON_PrintFloat) and the correctly rounded parser (cJSON_ParseDouble) against the old cJSON number
+ *           code (sprintf "%f"/"%e" and the digit loop with pow) and against printf "%.17g"/strtod. Every number
+ *           of the new code must be read back to the same number.
+ * Created on: 2026-10-18
+ */
+
+#include <cJSON.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <float.h>
+#include <limits.h>
+#include "bench_util.h"
+
+enum number_set {
+    SET_INT,
+    SET_SENSOR,
+    SET_RANDOM,
+    SET_FLOAT,
+    SET_NUM,
+};
+
+static const char * const set_name[SET_NUM] = { "int", "sensor", "random", "float" };
+
+enum number_codec {
+    CODEC_OLD,
+    CODEC_LIBC,
+    CODEC_NEW,
+    CODEC_NUM,
+};
+
+static const char * const codec_name[CODEC_NUM] = { "cjson", "libc", "new" };
+
+/* the print_number of the old cJSON */
+static void old_print(double d, char *str) {
+    if (d == 0) {
+        strcpy(str, "0");
+    } else if (fabs(((double) (int) d) - d) <= DBL_EPSILON && d <= INT_MAX && d >= INT_MIN) {
+        sprintf(str, "%d", (int) d);
+    } else if (fpclassify(d) != FP_ZERO && !isnormal(d)) {
+        sprintf(str, "null");
+    } else if (fabs(floor(d) - d) <= DBL_EPSILON && fabs(d) < 1.0e60) {
+        sprintf(str, "%.0f", d);
+    } else if (fabs(d) < 1.0e-6 || fabs(d) > 1.0e9) {
+        sprintf(str, "%e", d);
+    } else {
+        sprintf(str, "%f", d);
+    }
+}
+
+/* the parse_number of the old cJSON */
+static double old_parse(const char *num) {
+    double n = 0, sign = 1, scale = 0;
+    int subscale = 0, signsubscale = 1;
+
+    if (*num == '-') sign = -1, num++;
+    if (*num == '0') num++;
+    if (*num >= '1' && *num <= '9') do n = (n * 10.0) + (*num++ - '0'); while (*num >= '0' && *num <= '9');
+    if (*num == '.' && num[1] >= '0' && num[1] <= '9') {
+        num++;
+        do n = (n * 10.0) + (*num++ - '0'), scale--; while (*num >= '0' && *num <= '9');
+    }
+    if (*num == 'e' || *num == 'E') {
+        num++;
+        if (*num == '+') num++; else if (*num == '-') signsubscale = -1, num++;
+        while (*num >= '0' && *num <= '9') subscale = (subscale * 10) + (*num++ - '0');
+    }
+
+    return sign * n * pow(10.0, (scale + subscale * signsubscale));
+}
+
+static void make_numbers(enum number_set set, double *numbers, size_t count) {
+    uint64_t seed = 1 + set, bits;
+    size_t i;
+
+    for (i = 0; i < count; i++) {
+        switch (set) {
+        case SET_INT:
+            numbers[i] = (double) (int) (bench_rand(&seed) % 2000001) - 1000000;
+            break;
+        case SET_SENSOR:
+            /* 1 to 6 decimals, like the temperature, the voltage and the calibration */
+            numbers[i] = ((double) (bench_rand(&seed) % 2000001) - 1000000)
+                    / pow(10.0, 1 + (int) (bench_rand(&seed) % 6));
+            break;
+        case SET_RANDOM:
+            do {
+                bits = bench_rand(&seed);
+                memcpy(&numbers[i], &bits, sizeof(double));
+            } while (!isfinite(numbers[i]) || numbers[i] == 0);
+            break;
+        case SET_FLOAT:
+            numbers[i] = (float) ((bench_rand_unit(&seed) - 0.5) * pow(10.0, (int) (bench_rand(&seed) % 13) - 6));
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+static void format_number(enum number_codec codec, bool is_float, double d, char *str) {
+    switch (codec) {
+    case CODEC_OLD:
+        old_print(d, str);
+        break;
+    case CODEC_LIBC:
+        sprintf(str, is_float ? "%.9g" : "%.17g", d);
+        break;
+    default:
+        if (is_float) {
+            cJSON_PrintFloat((float) d, str);
+        } else {
+            cJSON_PrintDouble(d, str);
+        }
+        break;
+    }
+}
+
+static double parse_number(enum number_codec codec, const char *str) {
+    switch (codec) {
+    case CODEC_OLD: return old_parse(str);
+    case CODEC_LIBC: return strtod(str, NULL);
+    default: return cJSON_ParseDouble(str, NULL);
+    }
+}
+
+static bool number_equal(bool is_float, double a, double b) {
+    float fa = (float) a, fb = (float) b;
+
+    return is_float ? !memcmp(&fa, &fb, sizeof(float)) : !memcmp(&a, &b, sizeof(double));
+}
+
+static int bench_number(enum number_set set, enum number_codec codec, const double *numbers, char *texts,
+        size_t count) {
+    bool is_float = set == SET_FLOAT;
+    uint64_t start, format_ns, parse_ns;
+    size_t i, exact = 0, chars = 0;
+    double *parsed = malloc(count * sizeof(double));
+
+    start = bench_now_ns();
+    for (i = 0; i < count; i++) {
+        format_number(codec, is_float, numbers[i], texts + i * cJSON_NumberTextSize);
+    }
+    format_ns = bench_now_ns() - start;
+    start = bench_now_ns();
+    for (i = 0; i < count; i++) {
+        parsed[i] = parse_number(codec, texts + i * cJSON_NumberTextSize);
+    }
+    parse_ns = bench_now_ns() - start;
+    for (i = 0; i < count; i++) {
+        exact += number_equal(is_float, parsed[i], numbers[i]);
+        chars += strlen(texts + i * cJSON_NumberTextSize);
+    }
+    free(parsed);
+
+    printf("%-7s %-6s %12.2f %12.2f %9.3f%% %8.2f\n", set_name[set], codec_name[codec], count / (format_ns / 1e3),
+            count / (parse_ns / 1e3), exact * 100.0 / count, (double) chars / count);
+    if (codec == CODEC_NEW && exact != count) {
+        printf("Error: %zu %s numbers are NOT read back to the same number.\n", count - exact, set_name[set]);
+        return 1;
+    }
+
+    return 0;
+}
+
+/* the new parser must be same as strtod, the number text has up to 25 digits and the exponent is in +/-350 */
+static int check_parse(size_t count) {
+    uint64_t seed = 7;
+    char text[64], *pos;
+    size_t i, j, digits;
+    double a, b;
+
+    for (i = 0; i < count; i++) {
+        pos = text;
+        if (bench_rand(&seed) & 1) {
+            *pos++ = '-';
+        }
+        digits = 1 + bench_rand(&seed) % 25;
+        for (j = 0; j < digits; j++) {
+            *pos++ = (char) (j ? '0' + bench_rand(&seed) % 10 : '1' + bench_rand(&seed) % 9);
+            if (j == 0 && digits > 1 && (bench_rand(&seed) & 1)) {
+                *pos++ = '.';
+            }
+        }
+        sprintf(pos, "e%d", (int) (bench_rand(&seed) % 701) - 350);
+        a = cJSON_ParseDouble(text, NULL);
+        b = strtod(text, NULL);
+        if (memcmp(&a, &b, sizeof(double))) {
+            printf("Error: Parse '%s' is %.17g, strtod is %.17g.\n", text, a, b);
+            return 1;
+        }
+    }
+    printf("%zu random number texts are parsed same as strtod\n", count);
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    size_t count = 100000;
+    double *numbers;
+    char *texts;
+    int opt, set, codec;
+
+    while ((opt = getopt(argc, argv, "n:h")) != -1) {
+        switch (opt) {
+        case 'n': count = strtoul(optarg, NULL, 0); break;
+        default:
+            printf("Usage: %s [-n numbers, default 100000]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (count == 0) {
+        printf("The numbers must NOT be 0.\n");
+        return 1;
+    }
+
+    numbers = malloc(count * sizeof(double));
+    texts = malloc(count * cJSON_NumberTextSize);
+    printf("%-7s %-6s %12s %12s %10s %8s\n", "numbers", "codec", "format M/s", "parse M/s", "exact", "chars");
+    for (set = 0; set < SET_NUM; set++) {
+        make_numbers(set, numbers, count);
+        for (codec = 0; codec < CODEC_NUM; codec++) {
+            if (bench_number(set, codec, numbers, texts, count)) {
+                return 1;
+            }
+        }
+    }
+    free(texts);
+    free(numbers);
+
+    return check_parse(count * 10);
+}
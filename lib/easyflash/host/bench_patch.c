@@ -0,0 +1,331 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Delta update of the IAP module. The patch of every sample image pair is made by ef_diff, then it's
+ *           applied by ef_iap_patch_xxx on the simulated flash in random parts (like the received packets). The
+ *           old application is placed after the backup area. The new application in the backup area must be the
+ *           new image and pass the CRC32 check. The synthetic firmware is made of functions with the literal
+ *           pools which point to other functions, so a moved function changes the pointers after it (the
+ *           relocation). The image files on the command line are compared as the old and new pairs.
+ * Created on: 2026-10-18
+ */
+
+#include <easyflash.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ef_sim.h"
+#include "ef_diff.h"
+#include "bench_util.h"
+
+#define APP_AREA_SIZE                            (512 * 1024)
+#define OLD_APP_ADDR                             (EF_START_ADDR + ENV_AREA_SIZE + APP_AREA_SIZE)
+/* the link speed to show the transfer time, UART 115200 */
+#define LINK_BYTES_PER_SEC                       11520
+/* the synthetic firmware, the function address is 0x410 + offset (the Thumb bit is set) */
+#define FW_FUNCS                                 300
+#define FW_LOAD_ADDR                             0x00000410
+#define FW_POOL_MAX                              4
+
+struct fw_func {
+    uint64_t seed;                               /**< the seed of the instructions */
+    uint16_t ops;                                /**< the 16 bits instructions */
+    uint8_t pool;                                /**< the literal pool words */
+    uint16_t targets[FW_POOL_MAX];               /**< the functions of the literal pool */
+};
+
+struct fw {
+    struct fw_func funcs[FW_FUNCS + 1];
+    size_t num;
+};
+
+static uint16_t fw_vocab[256];
+
+static size_t func_size(const struct fw_func *func) {
+    return ((func->ops * 2 + 3) & ~3) + func->pool * 4;
+}
+
+static void fw_random_func(struct fw_func *func, size_t num, uint64_t *seed) {
+    size_t i;
+
+    func->seed = bench_rand(seed);
+    func->ops = 16 + bench_rand(seed) % 400;
+    func->pool = 1 + bench_rand(seed) % FW_POOL_MAX;
+    for (i = 0; i < FW_POOL_MAX; i++) {
+        func->targets[i] = bench_rand(seed) % num;
+    }
+}
+
+/* the image of the firmware, the literal pools are made by the function offsets of this layout */
+static uint8_t *fw_render(const struct fw *fw, size_t *size) {
+    size_t offs[FW_FUNCS + 1], i, j, pos = 0;
+    uint64_t seed;
+    uint32_t addr;
+    uint16_t op;
+    uint8_t *img;
+
+    for (i = 0; i < fw->num; i++) {
+        offs[i] = pos;
+        pos += func_size(&fw->funcs[i]);
+    }
+    img = malloc(pos);
+    for (i = 0, pos = 0; i < fw->num; i++) {
+        seed = fw->funcs[i].seed;
+        for (j = 0; j < fw->funcs[i].ops; j++, pos += 2) {
+            op = fw_vocab[bench_rand(&seed) & 0xFF];
+            memcpy(img + pos, &op, 2);
+        }
+        if (pos & 3) {
+            /* NOP */
+            img[pos++] = 0x00;
+            img[pos++] = 0xBF;
+        }
+        for (j = 0; j < fw->funcs[i].pool; j++, pos += 4) {
+            addr = (FW_LOAD_ADDR + (uint32_t) offs[fw->funcs[i].targets[j]]) | 1;
+            memcpy(img + pos, &addr, 4);
+        }
+    }
+    *size = pos;
+
+    return img;
+}
+
+struct sample {
+    char name[48];
+    uint8_t *old_img;
+    size_t old_size;
+    uint8_t *new_img;
+    size_t new_size;
+};
+
+static struct sample samples[16];
+static size_t sample_num;
+
+static void add_fw_sample(const char *name, const struct fw *old_fw, const struct fw *new_fw) {
+    struct sample *sample = &samples[sample_num++];
+
+    snprintf(sample->name, sizeof(sample->name), "%s", name);
+    sample->old_img = fw_render(old_fw, &sample->old_size);
+    sample->new_img = fw_render(new_fw, &sample->new_size);
+}
+
+static void make_fw_samples(void) {
+    static struct fw base, fw;
+    uint64_t seed = 1;
+    size_t i;
+    struct sample *sample;
+
+    for (i = 0; i < 256; i++) {
+        fw_vocab[i] = (uint16_t) bench_rand(&seed);
+    }
+    base.num = FW_FUNCS;
+    for (i = 0; i < base.num; i++) {
+        fw_random_func(&base.funcs[i], base.num, &seed);
+    }
+
+    /* a version string at the image end */
+    add_fw_sample("version string", &base, &base);
+    sample = &samples[sample_num - 1];
+    memcpy(sample->new_img + sample->new_size - 16, "v2.1.7 Oct 18 26", 16);
+
+    /* a function is fixed, its size is same */
+    fw = base;
+    fw.funcs[FW_FUNCS / 2].seed++;
+    add_fw_sample("bug fix, same size", &base, &fw);
+
+    /* a function is longer, so the functions after it are moved */
+    fw = base;
+    fw.funcs[FW_FUNCS / 3].ops += 40;
+    add_fw_sample("bug fix, +80 bytes", &base, &fw);
+
+    /* a new function in the middle */
+    fw = base;
+    memmove(&fw.funcs[FW_FUNCS / 2 + 1], &fw.funcs[FW_FUNCS / 2], (FW_FUNCS / 2) * sizeof(struct fw_func));
+    fw_random_func(&fw.funcs[FW_FUNCS / 2], FW_FUNCS, &seed);
+    fw.funcs[FW_FUNCS / 2].ops = 300;
+    fw.num++;
+    add_fw_sample("new function", &base, &fw);
+
+    /* 5% functions are changed */
+    fw = base;
+    for (i = 0; i < FW_FUNCS / 20; i++) {
+        fw_random_func(&fw.funcs[bench_rand(&seed) % FW_FUNCS], FW_FUNCS, &seed);
+    }
+    add_fw_sample("5% functions", &base, &fw);
+
+    /* all functions are changed, only the literal pools are same */
+    fw = base;
+    for (i = 0; i < FW_FUNCS; i++) {
+        fw.funcs[i].seed = bench_rand(&seed);
+    }
+    add_fw_sample("all functions", &base, &fw);
+}
+
+static uint8_t *read_file(const char *name, size_t *size) {
+    FILE *fp = fopen(name, "rb");
+    uint8_t *buf = NULL;
+    long len;
+
+    if (!fp) {
+        return NULL;
+    }
+    if (fseek(fp, 0, SEEK_END) == 0 && (len = ftell(fp)) > 0 && fseek(fp, 0, SEEK_SET) == 0) {
+        buf = malloc(len);
+        if (buf && fread(buf, 1, len, fp) != (size_t) len) {
+            free(buf);
+            buf = NULL;
+        }
+        *size = len;
+    }
+    fclose(fp);
+
+    return buf;
+}
+
+static int add_file_sample(const char *old_name, const char *new_name) {
+    struct sample *sample = &samples[sample_num];
+    const char *base = strrchr(new_name, '/');
+
+    sample->old_img = read_file(old_name, &sample->old_size);
+    sample->new_img = read_file(new_name, &sample->new_size);
+    if (!sample->old_img || !sample->new_img) {
+        printf("Error: Read the image file failed.\n");
+        return 1;
+    }
+    if (sample->old_size > APP_AREA_SIZE || sample->new_size > APP_AREA_SIZE) {
+        printf("Error: The image file is larger than %d bytes.\n", APP_AREA_SIZE);
+        return 1;
+    }
+    snprintf(sample->name, sizeof(sample->name), "file %s", base ? base + 1 : new_name);
+    sample_num++;
+
+    return 0;
+}
+
+/* put the old application and apply the patch in random parts */
+static EfErrCode apply_patch(const uint8_t *old_img, size_t old_size, const uint8_t *patch_data, size_t patch_size,
+        size_t *new_size, uint64_t *seed) {
+    static struct ef_iap_patch patch;
+    EfErrCode result;
+    size_t pos, len;
+
+    memcpy(ef_sim_get_mem() + ENV_AREA_SIZE + APP_AREA_SIZE, old_img, old_size);
+    ef_iap_patch_init(&patch, OLD_APP_ADDR);
+    for (pos = 0, result = EF_NO_ERR; pos < patch_size && result == EF_NO_ERR; pos += len) {
+        len = 1 + bench_rand(seed) % 300;
+        if (len > patch_size - pos) {
+            len = patch_size - pos;
+        }
+        result = ef_iap_patch_put(&patch, patch_data + pos, len);
+    }
+    if (result == EF_NO_ERR) {
+        result = ef_iap_patch_finish(&patch, new_size);
+    }
+
+    return result;
+}
+
+static int bench_sample(const struct sample *sample, uint64_t *seed) {
+    uint64_t start, diff_ns, apply_us;
+    uint8_t *patch;
+    size_t patch_size, new_size = 0;
+
+    start = bench_now_ns();
+    patch = ef_diff(sample->old_img, sample->old_size, sample->new_img, sample->new_size, &patch_size);
+    diff_ns = bench_now_ns() - start;
+    if (!patch) {
+        printf("Error: Make the patch failed.\n");
+        return 1;
+    }
+    start = ef_port_get_time_us();
+    if (apply_patch(sample->old_img, sample->old_size, patch, patch_size, &new_size, seed) != EF_NO_ERR
+            || new_size != sample->new_size
+            || memcmp(ef_sim_get_mem() + ENV_AREA_SIZE, sample->new_img, sample->new_size)) {
+        printf("Error: Apply the patch of '%s' failed.\n", sample->name);
+        return 1;
+    }
+    apply_us = ef_port_get_time_us() - start;
+    printf("%-24s %8zu %8zu %7.1f%% %8zd %9.2f %9.2f %9.1f %8.1f\n", sample->name, sample->new_size, patch_size,
+            patch_size * 100.0 / sample->new_size, (ssize_t) sample->new_size - (ssize_t) patch_size,
+            (double) sample->new_size / LINK_BYTES_PER_SEC, (double) patch_size / LINK_BYTES_PER_SEC,
+            apply_us / 1000.0, diff_ns / 1e6);
+    free(patch);
+
+    return 0;
+}
+
+/* the wrong old application, the incomplete patch and the wrong new CRC32 must be found */
+static int check_bad_patch(const struct sample *sample, uint64_t *seed) {
+    uint8_t *patch, *old_img;
+    size_t patch_size, new_size;
+    EfErrCode wrong_old, part, wrong_crc;
+
+    patch = ef_diff(sample->old_img, sample->old_size, sample->new_img, sample->new_size, &patch_size);
+    old_img = malloc(sample->old_size);
+    memcpy(old_img, sample->old_img, sample->old_size);
+    old_img[sample->old_size / 2] ^= 1;
+    wrong_old = apply_patch(old_img, sample->old_size, patch, patch_size, &new_size, seed);
+    part = apply_patch(sample->old_img, sample->old_size, patch, patch_size - 1, &new_size, seed);
+    patch[16] ^= 1;
+    wrong_crc = apply_patch(sample->old_img, sample->old_size, patch, patch_size, &new_size, seed);
+    free(old_img);
+    free(patch);
+    if (wrong_old != EF_READ_ERR || part != EF_READ_ERR || wrong_crc != EF_WRITE_ERR) {
+        printf("Error: The bad patch is NOT found (%d %d %d).\n", wrong_old, part, wrong_crc);
+        return 1;
+    }
+    printf("the wrong old application, the incomplete patch and the wrong CRC32 are found\n");
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    struct ef_sim_cfg sim = EF_SIM_CFG_DEFAULT(ENV_AREA_SIZE + 2 * APP_AREA_SIZE);
+    uint64_t seed = 1;
+    size_t i;
+    int arg;
+
+    if (argc % 2 == 0) {
+        printf("Usage: %s [old image file, new image file]...\n", argv[0]);
+        return 1;
+    }
+    make_fw_samples();
+    for (arg = 1; arg + 1 < argc; arg += 2) {
+        if (add_file_sample(argv[arg], argv[arg + 1])) {
+            return 1;
+        }
+    }
+
+    /* the typical on-chip flash timing: 4 KB sector erase 12 ms, 36 us per 8 bytes phrase */
+    sim.strict = true;
+    sim.read_ns = 0;
+    sim.read_ns_per_byte = 0;
+    sim.prog_ns = 2000;
+    sim.prog_ns_per_byte = 4500;
+    sim.erase_ns = 12000000;
+    ef_sim_init(&sim);
+    if (easyflash_init() != EF_NO_ERR) {
+        printf("EasyFlash initialize failed.\n");
+        return 1;
+    }
+
+    printf("patch engine RAM %zu bytes, output buffer %d bytes\n", sizeof(struct ef_iap_patch), EF_IAP_PATCH_BUF_SIZE);
+    printf("%-24s %8s %8s %8s %8s %9s %9s %9s %8s\n", "sample", "image", "patch", "ratio", "saved", "full s",
+            "delta s", "apply ms", "diff ms");
+    for (i = 0; i < sample_num; i++) {
+        if (bench_sample(&samples[i], &seed)) {
+            return 1;
+        }
+    }
+    if (check_bad_patch(&samples[1], &seed)) {
+        return 1;
+    }
+
+    ef_sim_deinit();
+    for (i = 0; i < sample_num; i++) {
+        free(samples[i].old_img);
+        free(samples[i].new_img);
+    }
+
+    return 0;
+}
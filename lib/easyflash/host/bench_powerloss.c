@@ -0,0 +1,745 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Power loss fault injection of the ENV, the log and the IAP on the simulated flash. A workload is split
+ *           into the segments, every segment starts with a power on (easyflash_init) from the flash image of the
+ *           last segment end. The power is cut at the Nth program or sector erase of the segment in a forked
+ *           workload process, the cut operation is NOT done or it's torn. Then a new forked process powers on the
+ *           flash with the fresh library RAM (like a reboot), the power is cut again at every operation of this
+ *           recovery, and the last recovery checks the invariants:
+ *           - ENV: every key has the last saved value, the key of the interrupted call has the old or the new value,
+ *             the default ENV is kept, and a new ENV is saved after the recovery. The ENV workload checks it on the
+ *             ENV area which is about 2/3 full, the GC workload on the area which is 3/4 full, so the power is cut
+ *             in the (incremental) GC of the set. All keys of the interrupted batch commit are old or new.
+ *           - log: the log is a tail of the written log stream which ends in the interrupted write, at most one
+ *             sector of the oldest log is lost, and a new log is appended after the recovery.
+ *           - IAP: the application is the old or the new image after the bootloader copy, and it's the new one
+ *             when the power is cut after the copy flag is saved.
+ *           N is swept over all operations of every segment.
+ * Created on: 2026-10-18
+ */
+
+#include <easyflash.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "ef_sim.h"
+#include "bench_util.h"
+
+#define BAK_AREA_SIZE                            (4 * EF_ERASE_MIN_SIZE)
+#define APP_AREA_SIZE                            (4 * EF_ERASE_MIN_SIZE)
+#define APP_ADDR                                 (EF_START_ADDR + ENV_AREA_SIZE + LOG_AREA_SIZE + BAK_AREA_SIZE)
+#define SIM_SIZE                                 (ENV_AREA_SIZE + LOG_AREA_SIZE + BAK_AREA_SIZE + APP_AREA_SIZE)
+
+#define ENV_KEY_NUM                              32
+/* the ENV workload fills half of the area by the cold keys of 300 bytes first, it's about 2/3 full with the random
+   keys, so the random calls collect the sectors with the cold keys, they are deleted at the end. The cut stride of the
+   workload and the recovery is 8 times the stride. */
+#define ENV_FILL_KEYS                            48
+#define ENV_CALLS                                1600
+#define ENV_STRIDE                               8
+/* the GC workload fills 3/4 of the ENV area by the keys of 300 bytes, then updates them. The recovery of it finishes
+   the GC, so the cut stride of the workload and the recovery is 8 times the stride. */
+#define GC_KEY_FIRST                             100
+#define GC_KEY_NUM                               44
+#define GC_VALUE_SIZE                            300
+#define GC_UPDATE_CALLS                          160
+#define GC_STRIDE                                8
+/* the batch workload commits 2 ~ BATCH_SIZE_MAX keys by one batch */
+#define BATCH_KEY_FIRST                          200
+#define BATCH_KEY_NUM                            16
+#define BATCH_SIZE_MAX                           6
+#define BATCH_CALLS                              120
+#define ENV_VALUE_MAX_SIZE                       300
+#define ENV_SEGMENT_CALLS                        40
+#define LOG_CALLS                                600
+#define LOG_SEGMENT_CALLS                        30
+#define LOG_WRITE_MAX_SIZE                       512
+#define IAP_IMAGE_SIZE                           (3 * EF_ERASE_MIN_SIZE + 1024)
+#define IAP_CHUNK_SIZE                           256
+/* a hung child is an assert or a dead loop */
+#define CHILD_TIMEOUT_S                          10
+/* the printed failures */
+#define FAILURE_PRINT_MAX                        10
+
+/* the exit code of the forked process */
+enum child_exit {
+    EXIT_DONE = 0,
+    EXIT_FAIL = 1,
+    EXIT_CUT = 2,
+};
+
+enum call_type {
+    CALL_ENV_SET,
+    CALL_ENV_DEL,
+    CALL_ENV_BATCH,
+    CALL_LOG_WRITE,
+    CALL_IAP_ERASE_BAK,
+    CALL_IAP_WRITE_BAK,
+    CALL_IAP_SET_SIZE,
+    CALL_IAP_SET_FLAG,
+    CALL_IAP_ERASE_APP,
+    CALL_IAP_COPY_APP,
+    CALL_IAP_CLEAR_FLAG,
+};
+
+struct pl_call {
+    uint8_t type;
+    uint16_t key;
+    uint16_t len;
+    uint32_t offset;                             /**< the log stream offset, the IAP image offset or the batch size */
+};
+
+struct pl_workload {
+    const char *name;
+    struct pl_call *calls;
+    size_t call_num;
+    size_t segment_calls;
+    size_t key_first;                            /**< the first ENV key, the keys of the workloads are different */
+    size_t key_num;                              /**< the ENV keys which are checked */
+    uint64_t stride;                             /**< the cut stride of the workload, it's multiplied by the -s, and
+                                                      it's the cut stride of the recovery */
+};
+
+/* the state which is shared by the harness and the forked processes */
+struct pl_shared {
+    size_t call;                                 /**< the current call of the workload process */
+    size_t log_used;                             /**< the used log size before the current call */
+    uint64_t cut;                                /**< the power cut operation of the segment */
+    uint64_t recovery_cut;                       /**< the power cut operation of the recovery, 0: no cut */
+};
+
+struct pl_result {
+    uint64_t points;
+    uint64_t torn;
+    uint64_t recovery_cuts;
+    uint64_t failures;
+};
+
+static struct pl_shared *shared;
+static const struct pl_workload *cur_workload;
+static bool cur_torn;
+static uint8_t *old_image, *new_image;
+static uint64_t failures_printed = 0;
+
+static void cut_callback(void) {
+    fflush(stdout);
+    _exit(EXIT_CUT);
+}
+
+/* the ENV value and the log stream bytes, the log byte is never 0xFF (the erased log end) */
+static uint8_t stream_byte(uint32_t offset) {
+    uint32_t hash = offset * 2654435761u;
+
+    return (uint8_t) ((hash ^ (hash >> 15)) % 255);
+}
+
+static void make_value(size_t call, uint8_t *value, size_t len) {
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        value[i] = stream_byte((uint32_t) (call * ENV_VALUE_MAX_SIZE + i));
+    }
+}
+
+static void key_name(uint16_t key, char *name) {
+    sprintf(name, "pl_key%02u", key);
+}
+
+static EfErrCode run_call(const struct pl_workload *workload, size_t call) {
+    static uint32_t buf[LOG_WRITE_MAX_SIZE / 4];
+    const struct pl_call *c = &workload->calls[call];
+    EfErrCode result = EF_NO_ERR;
+    char name[16], size_str[16], batch_names[BATCH_SIZE_MAX][16];
+    struct ef_env_batch batch;
+    size_t cur_size, i;
+
+    switch (c->type) {
+    case CALL_ENV_SET:
+        key_name(c->key, name);
+        make_value(call, (uint8_t *) buf, c->len);
+        result = ef_set_env_blob(name, buf, c->len);
+        break;
+    case CALL_ENV_DEL:
+        key_name(c->key, name);
+        result = ef_del_env(name);
+        break;
+    case CALL_ENV_BATCH:
+        make_value(call, (uint8_t *) buf, c->len);
+        ef_env_batch_init(&batch);
+        for (i = 0; i < c->offset && result == EF_NO_ERR; i++) {
+            key_name(c->key + i, batch_names[i]);
+            result = ef_env_batch_set(&batch, batch_names[i], buf, c->len);
+        }
+        if (result == EF_NO_ERR) {
+            result = ef_env_batch_commit(&batch);
+        }
+        break;
+    case CALL_LOG_WRITE:
+        for (i = 0; i < c->len; i++) {
+            ((uint8_t *) buf)[i] = stream_byte(c->offset + i);
+        }
+        result = ef_log_write(buf, c->len);
+        break;
+    case CALL_IAP_ERASE_BAK:
+        result = ef_erase_bak_app(IAP_IMAGE_SIZE);
+        break;
+    case CALL_IAP_WRITE_BAK:
+        cur_size = c->offset;
+        result = ef_write_data_to_bak(new_image + c->offset, c->len, &cur_size, IAP_IMAGE_SIZE);
+        break;
+    case CALL_IAP_SET_SIZE:
+        sprintf(size_str, "%d", IAP_IMAGE_SIZE);
+        result = ef_set_env("iap_copy_app_size", size_str);
+        break;
+    case CALL_IAP_SET_FLAG:
+        result = ef_set_env("iap_need_copy_app", "1");
+        break;
+    case CALL_IAP_ERASE_APP:
+        result = ef_erase_user_app(APP_ADDR, IAP_IMAGE_SIZE);
+        break;
+    case CALL_IAP_COPY_APP:
+        result = ef_copy_app_from_bak(APP_ADDR, IAP_IMAGE_SIZE);
+        break;
+    case CALL_IAP_CLEAR_FLAG:
+        result = ef_set_env("iap_need_copy_app", "0");
+        break;
+    }
+
+    return result;
+}
+
+/* the failure is printed by the forked process */
+static int fail(const char *format, const char *detail) {
+    printf("Error: %s: call %zu, cut %" PRIu64 ", recovery cut %" PRIu64 " (%s): ", cur_workload->name, shared->call,
+            shared->cut, shared->recovery_cut, cur_torn ? "torn" : "not done");
+    printf(format, detail);
+    printf("\n");
+
+    return EXIT_FAIL;
+}
+
+/* the batch call changes the keys from the key to the key + batch size - 1 */
+static bool call_changes_key(const struct pl_call *c, uint16_t key) {
+    switch (c->type) {
+    case CALL_ENV_SET:
+    case CALL_ENV_DEL: return c->key == key;
+    case CALL_ENV_BATCH: return key >= c->key && key < c->key + c->offset;
+    default: return false;
+    }
+}
+
+/* the last saved call of the key before the call, -1: it's NOT saved or it's deleted */
+static long env_last_set(uint16_t key, size_t call) {
+    const struct pl_call *calls = cur_workload->calls;
+    long last = -1;
+    size_t i;
+
+    for (i = 0; i < call; i++) {
+        if (call_changes_key(&calls[i], key)) {
+            last = calls[i].type == CALL_ENV_DEL ? -1 : (long) i;
+        }
+    }
+
+    return last;
+}
+
+static bool env_value_is(const char *name, const uint8_t *value, size_t len, long set_call) {
+    uint8_t expect[ENV_VALUE_MAX_SIZE];
+    size_t expect_len;
+
+    if (set_call < 0) {
+        return len == 0;
+    }
+    expect_len = cur_workload->calls[set_call].len;
+    make_value(set_call, expect, expect_len);
+
+    return len == expect_len && !memcmp(value, expect, len);
+}
+
+static int check_env_keys(size_t call) {
+    const struct pl_call *in_flight = call < cur_workload->call_num ? &cur_workload->calls[call] : NULL;
+    uint8_t value[ENV_VALUE_MAX_SIZE];
+    size_t len, saved_len;
+    char name[16];
+    long last;
+    uint16_t key;
+    int batch_done = -1;
+
+    for (key = cur_workload->key_first; key < cur_workload->key_first + cur_workload->key_num; key++) {
+        key_name(key, name);
+        saved_len = 0;
+        len = ef_get_env_blob(name, value, sizeof(value), &saved_len);
+        if (len != saved_len) {
+            return fail("the ENV '%s' is larger than the set value", name);
+        }
+        last = env_last_set(key, call);
+        if (in_flight && in_flight->type == CALL_ENV_BATCH && call_changes_key(in_flight, key)) {
+            /* all keys of the interrupted batch are old or new */
+            if (!env_value_is(name, value, len, last) && !env_value_is(name, value, len, (long) call)) {
+                return fail("the ENV '%s' is wrong", name);
+            }
+            if (batch_done == -1) {
+                batch_done = env_value_is(name, value, len, (long) call);
+            } else if (batch_done != env_value_is(name, value, len, (long) call)) {
+                return fail("the batch is NOT atomic, the ENV '%s' is different", name);
+            }
+            continue;
+        }
+        if (env_value_is(name, value, len, last)) {
+            continue;
+        }
+        /* the interrupted call is done */
+        if (in_flight && call_changes_key(in_flight, key)
+                && env_value_is(name, value, len, in_flight->type == CALL_ENV_SET ? (long) call : -1)) {
+            continue;
+        }
+        return fail("the ENV '%s' is wrong", name);
+    }
+
+    return EXIT_DONE;
+}
+
+static int check_env(size_t call) {
+    static const uint8_t check_value[] = "power loss check";
+    uint8_t value[sizeof(check_value)];
+    char *device_id = ef_get_env("device_id");
+    int result;
+
+    if (!device_id || strcmp(device_id, "1")) {
+        return fail("the default ENV '%s' is lost", "device_id");
+    }
+    if ((result = check_env_keys(call)) != EXIT_DONE) {
+        return result;
+    }
+    /* the recovered ENV area is writable */
+    if (ef_set_env_blob("pl_check", check_value, sizeof(check_value)) != EF_NO_ERR) {
+        return fail("the ENV '%s' save failed after the recovery", "pl_check");
+    }
+    if (ef_get_env_blob("pl_check", value, sizeof(value), NULL) != sizeof(check_value)
+            || memcmp(value, check_value, sizeof(check_value))) {
+        return fail("the ENV '%s' is wrong after the recovery", "pl_check");
+    }
+
+    return check_env_keys(call);
+}
+
+static int check_log(size_t call) {
+    static uint32_t buf[LOG_AREA_SIZE / 4];
+    const struct pl_call *in_flight = call < cur_workload->call_num ? &cur_workload->calls[call] : NULL;
+    size_t used = ef_log_get_used_size(), committed, end, i, cmp_len, marker_len = 16;
+    uint32_t marker[4] = { 0x12345678, 0x9ABCDEF0, 0x0F1E2D3C, 0x4B5A6978 };
+    bool match = false;
+
+    committed = in_flight ? in_flight->offset : cur_workload->calls[call - 1].offset + cur_workload->calls[call - 1].len;
+    end = in_flight ? committed + in_flight->len : committed;
+    if (used > end) {
+        return fail("the log is larger than the written log%s", "");
+    }
+    /* the oldest sector may be erased for the interrupted write */
+    if (used + EF_ERASE_MIN_SIZE < shared->log_used) {
+        return fail("the log is lost%s", "");
+    }
+    if (used && ef_log_read(0, buf, used) != EF_NO_ERR) {
+        return fail("the log read failed%s", "");
+    }
+    /* the last word of the log may be torn */
+    cmp_len = cur_torn && used >= 4 ? used - 4 : used;
+    for (end = committed > used ? committed : used; !match && end <= committed + (in_flight ? in_flight->len : 0);
+            end += 4) {
+        for (i = 0; i < cmp_len && ((uint8_t *) buf)[i] == stream_byte(end - used + i); i++);
+        match = i == cmp_len;
+    }
+    if (!match) {
+        return fail("the log is NOT a tail of the written log%s", "");
+    }
+    /* the recovered log area is writable */
+    if (ef_log_write(marker, marker_len) != EF_NO_ERR) {
+        return fail("the log write failed after the recovery%s", "");
+    }
+    used = ef_log_get_used_size();
+    if (used < marker_len || ef_log_read(used - marker_len, buf, marker_len) != EF_NO_ERR
+            || memcmp(buf, marker, marker_len)) {
+        return fail("the log is wrong after the recovery%s", "");
+    }
+
+    return EXIT_DONE;
+}
+
+static int check_iap(size_t call) {
+    const uint8_t *app = ef_sim_get_mem() + (APP_ADDR - EF_START_ADDR);
+    char *flag = ef_get_env("iap_need_copy_app"), *size;
+    size_t flag_call;
+
+    for (flag_call = 0; cur_workload->calls[flag_call].type != CALL_IAP_SET_FLAG; flag_call++);
+    if (!flag) {
+        return fail("the ENV '%s' is lost", "iap_need_copy_app");
+    }
+    /* the bootloader copies the application when the flag is set */
+    if (!strcmp(flag, "1")) {
+        size = ef_get_env("iap_copy_app_size");
+        if (!size || atoi(size) != IAP_IMAGE_SIZE) {
+            return fail("the ENV '%s' is wrong", "iap_copy_app_size");
+        }
+        if (ef_erase_user_app(APP_ADDR, IAP_IMAGE_SIZE) != EF_NO_ERR
+                || ef_copy_app_from_bak(APP_ADDR, IAP_IMAGE_SIZE) != EF_NO_ERR
+                || ef_set_env("iap_need_copy_app", "0") != EF_NO_ERR) {
+            return fail("the bootloader copy failed%s", "");
+        }
+    }
+    if (!memcmp(app, new_image, IAP_IMAGE_SIZE)) {
+        return call < flag_call ? fail("the application is updated before the flag%s", "") : EXIT_DONE;
+    }
+    if (!memcmp(app, old_image, IAP_IMAGE_SIZE)) {
+        return call > flag_call ? fail("the application is NOT updated after the flag%s", "") : EXIT_DONE;
+    }
+
+    return fail("the application is broken%s", "");
+}
+
+static int check(void) {
+    size_t call = shared->call;
+
+    switch (cur_workload->calls[0].type) {
+    case CALL_LOG_WRITE: return check_log(call);
+    case CALL_IAP_ERASE_BAK: return check_iap(call);
+    default: return check_env(call);
+    }
+}
+
+/* power on, then run the calls of the segment, the power is cut at the Nth operation */
+static int workload_process(size_t begin, size_t end, uint64_t cut, uint64_t seed) {
+    size_t call;
+
+    ef_sim_set_power_cut(cut, cur_torn, seed, cut_callback);
+    shared->call = begin;
+    shared->log_used = ef_log_get_used_size();
+    if (easyflash_init() != EF_NO_ERR) {
+        return fail("the power on failed%s", "");
+    }
+    for (call = begin; call < end; call++) {
+        shared->call = call;
+        shared->log_used = ef_log_get_used_size();
+        if (run_call(cur_workload, call) != EF_NO_ERR) {
+            return fail("the call failed%s", "");
+        }
+    }
+    shared->call = end;
+
+    return EXIT_DONE;
+}
+
+/* power on with a power cut at the Nth operation of the recovery, then check the recovered flash */
+static int recovery_process(uint64_t cut, uint64_t seed) {
+    ef_sim_set_power_cut(cut, cur_torn, seed, cut_callback);
+    if (easyflash_init() != EF_NO_ERR) {
+        return fail("the recovery failed%s", "");
+    }
+    ef_sim_set_power_cut(0, false, 0, NULL);
+
+    return check();
+}
+
+static int run_child(int (*fn)(void *), void *arg) {
+    int status;
+    pid_t pid;
+
+    fflush(stdout);
+    pid = fork();
+    if (pid == 0) {
+        alarm(CHILD_TIMEOUT_S);
+        status = fn(arg);
+        fflush(stdout);
+        _exit(status);
+    }
+    if (pid < 0 || waitpid(pid, &status, 0) != pid) {
+        perror("fork");
+        exit(1);
+    }
+    if (WIFEXITED(status)) {
+        return WEXITSTATUS(status);
+    }
+    printf("Error: %s: call %zu, cut %" PRIu64 ", recovery cut %" PRIu64 " (%s): the process is killed by the "
+            "signal %d (assert or dead loop)\n", cur_workload->name, shared->call, shared->cut, shared->recovery_cut,
+            cur_torn ? "torn" : "not done", WTERMSIG(status));
+
+    return EXIT_FAIL;
+}
+
+struct child_arg {
+    size_t begin, end;
+    uint64_t cut, seed;
+};
+
+static int workload_entry(void *arg) {
+    struct child_arg *a = arg;
+
+    return workload_process(a->begin, a->end, a->cut, a->seed);
+}
+
+static int recovery_entry(void *arg) {
+    struct child_arg *a = arg;
+
+    return recovery_process(a->cut, a->seed);
+}
+
+/* the recovery is cut at every stride operation of it, the flash after the second cut is checked by a clean power on */
+static int recover(struct pl_result *result, uint64_t seed, bool cut_recovery, uint64_t stride) {
+    static uint8_t *cut_img = NULL;
+    struct child_arg arg = { 0 }, clean = { 0 };
+    uint8_t *mem = ef_sim_get_mem();
+    int status;
+
+    shared->recovery_cut = 0;
+    if (!cut_recovery) {
+        return run_child(recovery_entry, &clean);
+    }
+    if (!cut_img) {
+        cut_img = malloc(SIM_SIZE);
+    }
+    memcpy(cut_img, mem, SIM_SIZE);
+    for (arg.cut = 1; ; arg.cut += stride) {
+        memcpy(mem, cut_img, SIM_SIZE);
+        arg.seed = seed + arg.cut;
+        shared->recovery_cut = arg.cut;
+        status = run_child(recovery_entry, &arg);
+        if (status != EXIT_CUT) {
+            /* the recovery is done before the cut */
+            return status;
+        }
+        result->recovery_cuts++;
+        status = run_child(recovery_entry, &clean);
+        if (status != EXIT_DONE) {
+            return status;
+        }
+    }
+}
+
+static void run_workload(const struct pl_workload *workload, uint64_t stride, bool torn, bool cut_recovery,
+        struct pl_result *result) {
+    uint8_t *mem = ef_sim_get_mem(), *start_img = malloc(SIM_SIZE);
+    struct child_arg arg;
+    size_t begin, end;
+    int status, mode;
+
+    memset(result, 0, sizeof(*result));
+    cur_workload = workload;
+    for (begin = 0; begin < workload->call_num; begin = end) {
+        end = begin + workload->segment_calls < workload->call_num ? begin + workload->segment_calls : workload->call_num;
+        memcpy(start_img, mem, SIM_SIZE);
+        for (arg.cut = 1; ; arg.cut += stride * workload->stride) {
+            for (mode = 0; mode <= torn; mode++) {
+                cur_torn = mode;
+                memcpy(mem, start_img, SIM_SIZE);
+                arg.begin = begin;
+                arg.end = end;
+                arg.seed = arg.cut * 2654435761u + begin;
+                shared->cut = arg.cut;
+                shared->recovery_cut = 0;
+                status = run_child(workload_entry, &arg);
+                if (status == EXIT_DONE) {
+                    break;
+                }
+                if (status == EXIT_CUT) {
+                    result->points++;
+                    result->torn += cur_torn;
+                    status = recover(result, arg.seed ^ 0x5A5A5A5A, cut_recovery, workload->stride);
+                }
+                if (status != EXIT_DONE) {
+                    result->failures++;
+                    if (++failures_printed >= FAILURE_PRINT_MAX) {
+                        printf("Error: too many failures.\n");
+                        exit(1);
+                    }
+                }
+            }
+            if (status == EXIT_DONE && mode == 0) {
+                /* the segment is done without the cut, the flash is the next segment start */
+                break;
+            }
+        }
+    }
+    free(start_img);
+}
+
+static void make_workloads(struct pl_workload *env, struct pl_workload *gc, struct pl_workload *batch,
+        struct pl_workload *log, struct pl_workload *iap, size_t env_calls) {
+    uint64_t seed = 1;
+    uint32_t offset = 0;
+    unsigned long key_saved = 0;
+    size_t i;
+
+    env->name = "ENV";
+    env->calls = calloc(ENV_FILL_KEYS + env_calls + ENV_FILL_KEYS, sizeof(struct pl_call));
+    env->call_num = ENV_FILL_KEYS + env_calls + ENV_FILL_KEYS;
+    env->segment_calls = ENV_SEGMENT_CALLS;
+    env->key_num = ENV_KEY_NUM + ENV_FILL_KEYS;
+    env->stride = ENV_STRIDE;
+    for (i = 0; i < ENV_FILL_KEYS; i++) {
+        env->calls[i].type = CALL_ENV_SET;
+        env->calls[i].key = ENV_KEY_NUM + i;
+        env->calls[i].len = ENV_VALUE_MAX_SIZE;
+        env->calls[ENV_FILL_KEYS + env_calls + i].type = CALL_ENV_DEL;
+        env->calls[ENV_FILL_KEYS + env_calls + i].key = ENV_KEY_NUM + i;
+    }
+    for (i = ENV_FILL_KEYS; i < ENV_FILL_KEYS + env_calls; i++) {
+        env->calls[i].key = bench_rand(&seed) % ENV_KEY_NUM;
+        /* only the saved key is deleted */
+        if (bench_rand(&seed) % 8 == 0 && (key_saved & (1UL << env->calls[i].key))) {
+            env->calls[i].type = CALL_ENV_DEL;
+            key_saved &= ~(1UL << env->calls[i].key);
+        } else {
+            key_saved |= 1UL << env->calls[i].key;
+            env->calls[i].type = CALL_ENV_SET;
+            /* most values are short, some are long and move the GC */
+            env->calls[i].len = bench_rand(&seed) % 4 ? 1 + bench_rand(&seed) % 64
+                    : 64 + bench_rand(&seed) % (ENV_VALUE_MAX_SIZE - 63);
+        }
+    }
+
+    /* the set always collects a sector when the area is 3/4 full, the power is cut in the GC of the set */
+    gc->name = "ENV GC";
+    gc->calls = calloc(GC_KEY_NUM + GC_UPDATE_CALLS, sizeof(struct pl_call));
+    gc->call_num = GC_KEY_NUM + GC_UPDATE_CALLS;
+    gc->segment_calls = ENV_SEGMENT_CALLS;
+    gc->key_first = GC_KEY_FIRST;
+    gc->key_num = GC_KEY_NUM;
+    gc->stride = GC_STRIDE;
+    for (i = 0; i < gc->call_num; i++) {
+        gc->calls[i].type = CALL_ENV_SET;
+        gc->calls[i].key = GC_KEY_FIRST + (i < GC_KEY_NUM ? i : bench_rand(&seed) % GC_KEY_NUM);
+        gc->calls[i].len = GC_VALUE_SIZE;
+    }
+
+    /* the batches of the random keys and size, the batch of the last keys is smaller */
+    batch->name = "ENV batch";
+    batch->calls = calloc(BATCH_CALLS, sizeof(struct pl_call));
+    batch->call_num = BATCH_CALLS;
+    batch->segment_calls = ENV_SEGMENT_CALLS;
+    batch->key_first = BATCH_KEY_FIRST;
+    batch->key_num = BATCH_KEY_NUM;
+    batch->stride = 1;
+    for (i = 0; i < BATCH_CALLS; i++) {
+        batch->calls[i].type = CALL_ENV_BATCH;
+        batch->calls[i].key = bench_rand(&seed) % (BATCH_KEY_NUM - 1);
+        batch->calls[i].offset = 2 + bench_rand(&seed) % (BATCH_SIZE_MAX - 1);
+        if (batch->calls[i].key + batch->calls[i].offset > BATCH_KEY_NUM) {
+            batch->calls[i].offset = BATCH_KEY_NUM - batch->calls[i].key;
+        }
+        batch->calls[i].key += BATCH_KEY_FIRST;
+        batch->calls[i].len = 1 + bench_rand(&seed) % ENV_VALUE_MAX_SIZE;
+    }
+
+    log->name = "log";
+    log->calls = calloc(LOG_CALLS, sizeof(struct pl_call));
+    log->call_num = LOG_CALLS;
+    log->segment_calls = LOG_SEGMENT_CALLS;
+    log->stride = 1;
+    for (i = 0; i < LOG_CALLS; i++) {
+        log->calls[i].type = CALL_LOG_WRITE;
+        log->calls[i].len = 4 * (1 + bench_rand(&seed) % (LOG_WRITE_MAX_SIZE / 4));
+        log->calls[i].offset = offset;
+        offset += log->calls[i].len;
+    }
+
+    iap->name = "IAP";
+    iap->stride = 1;
+    iap->calls = calloc(IAP_IMAGE_SIZE / IAP_CHUNK_SIZE + 7, sizeof(struct pl_call));
+    iap->calls[iap->call_num++].type = CALL_IAP_ERASE_BAK;
+    for (offset = 0; offset < IAP_IMAGE_SIZE; offset += IAP_CHUNK_SIZE) {
+        iap->calls[iap->call_num].type = CALL_IAP_WRITE_BAK;
+        iap->calls[iap->call_num].offset = offset;
+        iap->calls[iap->call_num++].len = IAP_CHUNK_SIZE;
+    }
+    iap->calls[iap->call_num++].type = CALL_IAP_SET_SIZE;
+    iap->calls[iap->call_num++].type = CALL_IAP_SET_FLAG;
+    /* the bootloader after the reboot */
+    iap->segment_calls = iap->call_num;
+    iap->calls[iap->call_num++].type = CALL_IAP_ERASE_APP;
+    iap->calls[iap->call_num++].type = CALL_IAP_COPY_APP;
+    iap->calls[iap->call_num++].type = CALL_IAP_CLEAR_FLAG;
+}
+
+int main(int argc, char **argv) {
+    struct ef_sim_cfg sim = EF_SIM_CFG_DEFAULT(SIM_SIZE);
+    struct pl_workload workloads[5] = { { 0 } };
+    struct pl_result result, total = { 0 };
+    uint64_t stride = 1, seed = 7, start, ns, total_ns = 0;
+    bool torn = true, cut_recovery = true;
+    size_t env_calls = ENV_CALLS, i;
+    const char *only = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:w:TRVh")) != -1) {
+        switch (opt) {
+        case 'n': env_calls = strtoul(optarg, NULL, 0); break;
+        case 'w': only = optarg; break;
+        case 's': stride = strtoull(optarg, NULL, 0); break;
+        case 'T': torn = false; break;
+        case 'R': cut_recovery = false; break;
+        case 'V': ef_sim_set_verbose(true); break;
+        default:
+            printf("Usage: %s [-n ENV calls, default %d] [-s cut stride, default 1] [-w only the workload] "
+                    "[-T no torn operation] [-R no cut in the recovery] [-V]\n", argv[0], ENV_CALLS);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (env_calls == 0 || stride == 0) {
+        printf("The ENV calls and the stride must NOT be 0.\n");
+        return 1;
+    }
+
+    /* the flash timing doesn't matter, the forked processes share the flash memory */
+    sim.read_ns = sim.read_ns_per_byte = sim.prog_ns = sim.prog_ns_per_byte = sim.erase_ns = 0;
+    sim.shared = true;
+    ef_sim_init(&sim);
+    shared = mmap(NULL, sizeof(struct pl_shared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    old_image = malloc(IAP_IMAGE_SIZE);
+    new_image = malloc(IAP_IMAGE_SIZE);
+    if (shared == MAP_FAILED || !old_image || !new_image) {
+        printf("No memory.\n");
+        return 1;
+    }
+    for (i = 0; i < IAP_IMAGE_SIZE; i++) {
+        old_image[i] = (uint8_t) bench_rand(&seed);
+        new_image[i] = (uint8_t) bench_rand(&seed);
+    }
+    /* the old application is running */
+    memcpy(ef_sim_get_mem() + (APP_ADDR - EF_START_ADDR), old_image, IAP_IMAGE_SIZE);
+    make_workloads(&workloads[0], &workloads[1], &workloads[2], &workloads[3], &workloads[4], env_calls);
+
+    printf("cut at every %" PRIu64 " program or sector erase, %s, %s\n", stride,
+            torn ? "not done and torn" : "not done", cut_recovery ? "cut in the recovery" : "no cut in the recovery");
+    printf("%-9s %8s %12s %10s %14s %9s %12s\n", "workload", "calls", "crash points", "torn", "recovery cuts",
+            "failures", "points/min");
+    for (i = 0; i < sizeof(workloads) / sizeof(workloads[0]); i++) {
+        if (only && strcmp(only, workloads[i].name)) {
+            free(workloads[i].calls);
+            continue;
+        }
+        start = bench_now_ns();
+        run_workload(&workloads[i], stride, torn, cut_recovery, &result);
+        ns = bench_now_ns() - start;
+        total_ns += ns;
+        total.points += result.points;
+        total.torn += result.torn;
+        total.recovery_cuts += result.recovery_cuts;
+        total.failures += result.failures;
+        printf("%-9s %8zu %12" PRIu64 " %10" PRIu64 " %14" PRIu64 " %9" PRIu64 " %12.0f\n", workloads[i].name,
+                workloads[i].call_num, result.points, result.torn, result.recovery_cuts, result.failures,
+                (result.points + result.recovery_cuts) * 60e9 / ns);
+        free(workloads[i].calls);
+    }
+    printf("%-9s %8s %12" PRIu64 " %10" PRIu64 " %14" PRIu64 " %9" PRIu64 " %12.0f\n", "total", "", total.points,
+            total.torn, total.recovery_cuts, total.failures, (total.points + total.recovery_cuts) * 60e9 / total_ns);
+
+    ef_sim_deinit();
+    free(old_image);
+    free(new_image);
+
+    return total.failures ? 1 : 0;
+}
@@ -0,0 +1,422 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Structure to JSON print and JSON to structure parse by struct2json with the heap and with the arena
+ *           (s2j_arena_use), the arena is sized by a dry run pass. Then the JSON to structure decode by cJSON_Parse
+ *           and s2j against the stream parser (s2j_stream_to_struct), in memory and from the ENV. The heap
+ *           high-water mark and the heap calls are counted by the heap hooks.
+ * Created on: 2026-10-18
+ */
+
+#include <easyflash.h>
+#include <ef_types.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include "ef_sim.h"
+#include "bench_util.h"
+
+typedef struct {
+    int baud;
+    int bits;
+    char parity[8];
+    int stop;
+} UartCfg;
+
+typedef struct {
+    char name[32];
+    char model[16];
+    int hw_ver;
+    char sw_ver[16];
+    char serial[24];
+    int thresholds[32];
+    double calibration[16];
+    UartCfg uart;
+} DeviceCfg;
+
+/* the heap block header keeps the block size for the live bytes */
+#define HEAP_HDR_SIZE                            16
+
+static size_t heap_live, heap_peak, heap_calls;
+
+static void *heap_malloc(size_t sz) {
+    uint8_t *ptr = malloc(sz + HEAP_HDR_SIZE);
+
+    if (!ptr) {
+        return NULL;
+    }
+    *(size_t *) ptr = sz;
+    heap_live += sz;
+    heap_calls++;
+    if (heap_live > heap_peak) {
+        heap_peak = heap_live;
+    }
+
+    return ptr + HEAP_HDR_SIZE;
+}
+
+static void heap_free(void *ptr) {
+    uint8_t *block = (uint8_t *) ptr - HEAP_HDR_SIZE;
+
+    if (!ptr) {
+        return;
+    }
+    heap_live -= *(size_t *) block;
+    heap_calls++;
+    free(block);
+}
+
+static void heap_reset_stats(void) {
+    heap_peak = heap_live;
+    heap_calls = 0;
+}
+
+static cJSON *device_to_json(void *struct_obj) {
+    DeviceCfg *device = struct_obj;
+
+    s2j_create_json_obj(json_device);
+    s2j_json_set_basic_element(json_device, device, string, name);
+    s2j_json_set_basic_element(json_device, device, string, model);
+    s2j_json_set_basic_element(json_device, device, int, hw_ver);
+    s2j_json_set_basic_element(json_device, device, string, sw_ver);
+    s2j_json_set_basic_element(json_device, device, string, serial);
+    s2j_json_set_array_element(json_device, device, int, thresholds, 32);
+    s2j_json_set_array_element(json_device, device, double, calibration, 16);
+    s2j_json_set_struct_element(json_uart, json_device, uart, device, UartCfg, uart);
+    s2j_json_set_basic_element(json_uart, uart, int, baud);
+    s2j_json_set_basic_element(json_uart, uart, int, bits);
+    s2j_json_set_basic_element(json_uart, uart, string, parity);
+    s2j_json_set_basic_element(json_uart, uart, int, stop);
+
+    return json_device;
+}
+
+static void *json_to_device(cJSON *json_obj) {
+    s2j_create_struct_obj(device, DeviceCfg);
+    if (!device) {
+        return NULL;
+    }
+    s2j_struct_get_basic_element(device, json_obj, string, name);
+    s2j_struct_get_basic_element(device, json_obj, string, model);
+    s2j_struct_get_basic_element(device, json_obj, int, hw_ver);
+    s2j_struct_get_basic_element(device, json_obj, string, sw_ver);
+    s2j_struct_get_basic_element(device, json_obj, string, serial);
+    s2j_struct_get_array_element(device, json_obj, int, thresholds);
+    s2j_struct_get_array_element(device, json_obj, double, calibration);
+    s2j_struct_get_struct_element(uart, device, json_uart, json_obj, UartCfg, uart);
+    if (json_uart) {
+        s2j_struct_get_basic_element(uart, json_uart, int, baud);
+        s2j_struct_get_basic_element(uart, json_uart, int, bits);
+        s2j_struct_get_basic_element(uart, json_uart, string, parity);
+        s2j_struct_get_basic_element(uart, json_uart, int, stop);
+    }
+
+    return device;
+}
+
+/* the element descriptors of the stream parser */
+static const S2jField uart_fields[] = {
+    s2j_field_basic(UartCfg, int, baud),
+    s2j_field_basic(UartCfg, int, bits),
+    s2j_field_basic(UartCfg, string, parity),
+    s2j_field_basic(UartCfg, int, stop),
+};
+
+static const S2jField device_fields[] = {
+    s2j_field_basic(DeviceCfg, string, name),
+    s2j_field_basic(DeviceCfg, string, model),
+    s2j_field_basic(DeviceCfg, int, hw_ver),
+    s2j_field_basic(DeviceCfg, string, sw_ver),
+    s2j_field_basic(DeviceCfg, string, serial),
+    s2j_field_array(DeviceCfg, int, thresholds),
+    s2j_field_array(DeviceCfg, double, calibration),
+    s2j_field_struct(DeviceCfg, uart, uart_fields),
+};
+
+static void make_device(DeviceCfg *device) {
+    uint64_t seed = 1;
+    size_t i;
+
+    memset(device, 0, sizeof(DeviceCfg));
+    strcpy(device->name, "easyflash-node-01");
+    strcpy(device->model, "STM32F103RB");
+    device->hw_ver = 3;
+    strcpy(device->sw_ver, "4.1.0");
+    strcpy(device->serial, "EF2026101800042");
+    for (i = 0; i < 32; i++) {
+        device->thresholds[i] = 100 + (int) (bench_rand(&seed) % 900);
+    }
+    /* the JSON number text has 6 decimals */
+    for (i = 0; i < 16; i++) {
+        device->calibration[i] = (double) (900000 + bench_rand(&seed) % 200000) / 1e6;
+    }
+    device->uart.baud = 115200;
+    device->uart.bits = 8;
+    strcpy(device->uart.parity, "none");
+    device->uart.stop = 1;
+}
+
+/* the double is parsed from the 6 decimals text, so it's NOT exactly same */
+static bool device_equal(const DeviceCfg *a, const DeviceCfg *b) {
+    DeviceCfg a_int = *a, b_int = *b;
+    size_t i;
+
+    for (i = 0; i < 16; i++) {
+        if (fabs(a->calibration[i] - b->calibration[i]) > 1e-9) {
+            return false;
+        }
+    }
+    memset(a_int.calibration, 0, sizeof(a_int.calibration));
+    memset(b_int.calibration, 0, sizeof(b_int.calibration));
+
+    return !memcmp(&a_int, &b_int, sizeof(DeviceCfg));
+}
+
+/* print the structure and parse it back, the arena is reset after the print and the parse */
+static int print_and_parse(const DeviceCfg *device, uint64_t *print_ns, uint64_t *parse_ns) {
+    uint64_t start = bench_now_ns();
+    cJSON *json = device_to_json((void *) device);
+    char *text = cJSON_PrintUnformatted(json);
+    char saved[1024];
+    DeviceCfg *parsed;
+    int result = 0;
+
+    if (!text || strlen(text) >= sizeof(saved)) {
+        printf("Error: Print the structure failed.\n");
+        return 1;
+    }
+    strcpy(saved, text);
+    cJSON_Delete(json);
+    s2jHook.free_fn(text);
+    s2j_arena_reset();
+    *print_ns += bench_now_ns() - start;
+
+    start = bench_now_ns();
+    json = cJSON_Parse(saved);
+    parsed = json ? json_to_device(json) : NULL;
+    cJSON_Delete(json);
+    s2j_arena_reset();
+    *parse_ns += bench_now_ns() - start;
+
+    if (!parsed || !device_equal(parsed, device)) {
+        printf("Error: The parsed structure is wrong.\n");
+        result = 1;
+    }
+    s2j_delete_struct_obj(parsed);
+
+    return result;
+}
+
+static int bench_s2j(const char *name, const DeviceCfg *device, size_t rounds, const S2jArena *arena) {
+    uint64_t print_ns = 0, parse_ns = 0;
+    size_t i;
+
+    heap_reset_stats();
+    for (i = 0; i < rounds; i++) {
+        if (print_and_parse(device, &print_ns, &parse_ns)) {
+            return 1;
+        }
+    }
+    printf("%-8s %10.2f %10.2f %10zu %10.1f %10zu %10zu\n", name, print_ns / 1e3 / rounds, parse_ns / 1e3 / rounds,
+            heap_peak, (double) heap_calls / rounds, arena ? arena->size : 0, arena ? arena->fallback : 0);
+
+    return 0;
+}
+
+/* the extra document has the members which are NOT in the structure, like a shared config file */
+static char *make_document(const DeviceCfg *device, bool extra) {
+    cJSON *json = device_to_json((void *) device), *list, *ap;
+    char *print, *text;
+    size_t i;
+
+    if (extra) {
+        list = cJSON_CreateArray();
+        for (i = 0; i < 16; i++) {
+            ap = cJSON_CreateObject();
+            cJSON_AddStringToObject(ap, "ssid", "Office-2.4G");
+            cJSON_AddStringToObject(ap, "bssid", "a4:5e:60:12:34:56");
+            cJSON_AddNumberToObject(ap, "rssi", -40 - (int) i);
+            cJSON_AddNumberToObject(ap, "channel", 1 + (int) i % 13);
+            cJSON_AddFalseToObject(ap, "secure");
+            cJSON_AddItemToArray(list, ap);
+        }
+        cJSON_AddItemToObject(json, "ap_list", list);
+        cJSON_AddStringToObject(json, "note", "the \"note\" and the ap_list are \\ NOT in the structure");
+    }
+    print = cJSON_PrintUnformatted(json);
+    cJSON_Delete(json);
+    /* the document is NOT counted by the heap hooks */
+    text = print ? strdup(print) : NULL;
+    s2jHook.free_fn(print);
+
+    return text;
+}
+
+static bool decode_cjson(const char *text, DeviceCfg *device) {
+    cJSON *json = cJSON_Parse(text);
+    DeviceCfg *parsed = json ? json_to_device(json) : NULL;
+
+    cJSON_Delete(json);
+    if (parsed) {
+        *device = *parsed;
+        s2j_delete_struct_obj(parsed);
+    }
+
+    return parsed != NULL;
+}
+
+static bool decode_stream(const char *text, DeviceCfg *device) {
+    S2jStream stream;
+
+    memset(device, 0, sizeof(DeviceCfg));
+    s2j_stream_init(&stream, text, strlen(text));
+
+    return s2j_stream_to_struct(&stream, device_fields, sizeof(device_fields) / sizeof(device_fields[0]), device);
+}
+
+static bool decode_env_cjson(const char *text, DeviceCfg *device) {
+    DeviceCfg *parsed = ef_get_struct("device_doc", json_to_device);
+
+    (void) text;
+    if (parsed) {
+        *device = *parsed;
+        s2j_delete_struct_obj(parsed);
+    }
+
+    return parsed != NULL;
+}
+
+static bool decode_env_stream(const char *text, DeviceCfg *device) {
+    (void) text;
+    memset(device, 0, sizeof(DeviceCfg));
+
+    return ef_get_struct_fields("device_doc", device_fields, sizeof(device_fields) / sizeof(device_fields[0]), device);
+}
+
+static int bench_decode(const char *doc, const char *method, bool (*decode)(const char *, DeviceCfg *),
+        const char *text, const DeviceCfg *device, size_t rounds, double *base_ns) {
+    DeviceCfg parsed;
+    uint64_t start, ns;
+    size_t i;
+
+    heap_reset_stats();
+    start = bench_now_ns();
+    for (i = 0; i < rounds; i++) {
+        if (!decode(text, &parsed)) {
+            printf("Error: Decode the %s document by %s failed.\n", doc, method);
+            return 1;
+        }
+    }
+    ns = bench_now_ns() - start;
+    if (!device_equal(&parsed, device)) {
+        printf("Error: The %s document which is decoded by %s is wrong.\n", doc, method);
+        return 1;
+    }
+    if (*base_ns == 0) {
+        *base_ns = (double) ns;
+    }
+    printf("%-8s %-7s %8zu %10.2f %10zu %10.1f %8.2fx\n", doc, method, strlen(text), ns / 1e3 / rounds, heap_peak,
+            (double) heap_calls / rounds, *base_ns / ns);
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    struct ef_sim_cfg sim = EF_SIM_CFG_DEFAULT(ENV_AREA_SIZE);
+    S2jHook hook = { .malloc_fn = heap_malloc, .free_fn = heap_free };
+    S2jArena arena;
+    DeviceCfg device, *saved;
+    size_t rounds = 20000;
+    uint64_t print_ns = 0, parse_ns = 0;
+    void *arena_buf;
+    char *text;
+    double base_ns;
+    int opt, extra;
+
+    while ((opt = getopt(argc, argv, "n:Vh")) != -1) {
+        switch (opt) {
+        case 'n': rounds = strtoul(optarg, NULL, 0); break;
+        case 'V': ef_sim_set_verbose(true); break;
+        default:
+            printf("Usage: %s [-n rounds, default 20000] [-V]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (rounds == 0) {
+        printf("The rounds must NOT be 0.\n");
+        return 1;
+    }
+
+    make_device(&device);
+    ef_sim_init(&sim);
+    if (easyflash_init() != EF_NO_ERR) {
+        printf("EasyFlash initialize failed.\n");
+        return 1;
+    }
+    ef_types_init(&hook);
+
+    printf("%-8s %10s %10s %10s %10s %10s %10s\n", "memory", "print us", "parse us", "heap peak", "heap calls",
+            "arena B", "fallbacks");
+    if (bench_s2j("heap", &device, rounds, NULL)) {
+        return 1;
+    }
+
+    /* the dry run pass sizes the arena */
+    s2j_arena_init(&arena, NULL, 0);
+    s2j_arena_use(&arena);
+    if (print_and_parse(&device, &print_ns, &parse_ns)) {
+        return 1;
+    }
+    s2j_arena_use(NULL);
+    arena_buf = malloc(arena.peak);
+    s2j_arena_init(&arena, arena_buf, arena.peak);
+    s2j_arena_use(&arena);
+    if (bench_s2j("arena", &device, rounds, &arena)) {
+        return 1;
+    }
+
+    /* the types plugin resets the arena after the set and get */
+    if (ef_set_struct("device", &device, device_to_json) != EF_NO_ERR) {
+        printf("Error: Set the structure ENV failed.\n");
+        return 1;
+    }
+    saved = ef_get_struct("device", json_to_device);
+    if (!saved || !device_equal(saved, &device) || arena.used != 0 || arena.fallback != 0) {
+        printf("Error: The structure ENV is wrong.\n");
+        return 1;
+    }
+    s2j_delete_struct_obj(saved);
+    s2j_arena_use(NULL);
+    free(arena_buf);
+
+    /* decode only, cJSON with the heap against the stream parser */
+    printf("%-8s %-7s %8s %10s %10s %10s %9s\n", "document", "decoder", "bytes", "decode us", "heap peak",
+            "heap calls", "speedup");
+    for (extra = 0; extra < 2; extra++) {
+        const char *doc = extra ? "extra" : "config";
+
+        text = make_document(&device, extra);
+        base_ns = 0;
+        if (!text || bench_decode(doc, "cjson", decode_cjson, text, &device, rounds, &base_ns)
+                || bench_decode(doc, "stream", decode_stream, text, &device, rounds, &base_ns)) {
+            return 1;
+        }
+        /* the ENV value is read from the simulated flash */
+        if (ef_set_env("device_doc", text) != EF_NO_ERR) {
+            printf("Error: Set the document ENV failed.\n");
+            return 1;
+        }
+        base_ns = 0;
+        if (bench_decode(doc, "env", decode_env_cjson, text, &device, rounds, &base_ns)
+                || bench_decode(doc, "env_str", decode_env_stream, text, &device, rounds, &base_ns)) {
+            return 1;
+        }
+        free(text);
+    }
+
+    ef_sim_deinit();
+
+    return 0;
+}
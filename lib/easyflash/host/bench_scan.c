@@ -0,0 +1,113 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Sector traversal cost of the ENV load (the magic word and 0xFF run scan), it's built with the
+ *           byte scan (EF_ENV_SCAN_WORD_SIZE 1), the word scan and the host SSE2 scan.
+ * Created on: 2026-10-18
+ */
+
+#include <easyflash.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ef_sim.h"
+#include "bench_util.h"
+
+#ifndef EF_ENV_SCAN_BUF_SIZE
+#define EF_ENV_SCAN_BUF_SIZE                     64
+#endif
+
+#ifndef EF_ENV_SCAN_WORD_SIZE
+#define EF_ENV_SCAN_WORD_SIZE                    4
+#endif
+
+/* the free space of the ENV area after the writes */
+#define FREE_PERCENT                             50
+
+static uint8_t value[EF_ERASE_MIN_SIZE / 2];
+
+/* write the keys to the default ENV until the area is half used, then load the ENV loops times */
+static int bench_load(size_t value_size, size_t loops) {
+    struct ef_sim_stats stats;
+    char key[EF_ENV_NAME_MAX];
+    size_t keys, i;
+    uint64_t start, wall;
+
+    if (ef_env_set_default() != EF_NO_ERR) {
+        printf("Error: Set the default ENV failed.\n");
+        return 1;
+    }
+    keys = ENV_AREA_SIZE / 100 * (100 - FREE_PERCENT) / (value_size + 32);
+    for (i = 0; i < keys; i++) {
+        snprintf(key, sizeof(key), "key%zu", i);
+        memset(value, (int) i, value_size);
+        if (ef_set_env_blob(key, value, value_size) != EF_NO_ERR) {
+            printf("Error: Set the ENV '%s' failed.\n", key);
+            return 1;
+        }
+    }
+
+    ef_sim_reset_stats();
+    start = bench_now_ns();
+    for (i = 0; i < loops; i++) {
+        if (ef_load_env() != EF_NO_ERR) {
+            printf("Error: Load ENV failed.\n");
+            return 1;
+        }
+    }
+    wall = bench_now_ns() - start;
+    ef_sim_get_stats(&stats);
+
+    /* the last key is still right */
+    snprintf(key, sizeof(key), "key%zu", keys - 1);
+    if (ef_get_env_blob(key, value, sizeof(value), NULL) != value_size || value[0] != (uint8_t) (keys - 1)) {
+        printf("Error: The ENV '%s' is wrong after load.\n", key);
+        return 1;
+    }
+
+    printf("%-10zu %8zu %10.1f %10.2f %12.1f %10.1f\n", value_size, keys, (double) stats.reads / loops,
+            stats.read_bytes / 1024.0 / loops, stats.busy_ns / 1e3 / loops, wall / 1e3 / loops);
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    struct ef_sim_cfg sim = EF_SIM_CFG_DEFAULT(ENV_AREA_SIZE);
+    size_t loops = 20;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:Vh")) != -1) {
+        switch (opt) {
+        case 'n': loops = strtoul(optarg, NULL, 0); break;
+        case 'V': ef_sim_set_verbose(true); break;
+        default:
+            printf("Usage: %s [-n loads, default 20] [-V]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (loops == 0) {
+        printf("The loads must NOT be 0.\n");
+        return 1;
+    }
+
+#if defined(EF_ENV_SCAN_USING_SSE2) && defined(__SSE2__)
+    printf("SSE2 scan, ");
+#else
+    printf("%d bytes word scan, ", EF_ENV_SCAN_WORD_SIZE);
+#endif
+    printf("%d bytes read window, ENV_AREA_SIZE 0x%X, sector 0x%X, %d%% free\n", EF_ENV_SCAN_BUF_SIZE,
+            ENV_AREA_SIZE, EF_ERASE_MIN_SIZE, FREE_PERCENT);
+    printf("%-10s %8s %10s %10s %12s %10s\n", "value size", "keys", "reads", "read KB", "flash us", "cpu us");
+    ef_sim_init(&sim);
+    if (easyflash_init() != EF_NO_ERR) {
+        printf("EasyFlash initialize failed.\n");
+        return 1;
+    }
+    if (bench_load(16, loops) || bench_load(1000, loops) || bench_load(1500, loops)) {
+        return 1;
+    }
+    ef_sim_deinit();
+
+    return 0;
+}
@@ -0,0 +1,200 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Random differential test of the ENV sector scan. The free space scan (continue_ff_addr) and the magic
+ *           word scan (find_next_env_addr) are compared with the byte by byte scan on the random sector data and
+ *           the random scan range, the magic word scan is also checked at the sector magic scan end, and no scan
+ *           reads the flash out of its range. The static scan functions are tested by including ef_env.c, it's
+ *           built with the byte scan, the word scans and the host SSE2 scan.
+ * Created on: 2026-10-18
+ */
+
+/* all flash reads of the ENV are checked by the scan range */
+#define ef_port_read scan_port_read
+#include "ef_env.c"
+#undef ef_port_read
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "ef_sim.h"
+#include "bench_util.h"
+
+/* the test sector is after the ENV area */
+#define TEST_SEC_ADDR                            (EF_START_ADDR + ENV_AREA_SIZE)
+
+EfErrCode ef_port_read(uint32_t addr, uint32_t *buf, size_t size);
+
+static uint32_t read_min, read_max;
+static uint32_t sector[SECTOR_SIZE / 4];
+
+EfErrCode scan_port_read(uint32_t addr, uint32_t *buf, size_t size) {
+    if (addr < read_min) {
+        read_min = addr;
+    }
+    if (addr + size > read_max) {
+        read_max = addr + size;
+    }
+
+    return ef_port_read(addr, buf, size);
+}
+
+/* the old byte loop of the continue_ff_addr */
+static uint32_t ref_continue_ff_addr(uint32_t start, uint32_t end) {
+    const uint8_t *data = (const uint8_t *) sector;
+    uint32_t addr = start, i;
+
+    for (i = start; i < end; i++) {
+        if (data[i - TEST_SEC_ADDR] != 0xFF) {
+            addr = i + 1;
+        }
+    }
+
+    return addr != end ? EF_WG_ALIGN(addr) : end;
+}
+
+/* the old byte loop of the find_next_env_addr, the whole magic word is in [start, end) */
+static uint32_t ref_find_next_env_addr(uint32_t start, uint32_t end) {
+    const uint8_t *data = (const uint8_t *) sector;
+    const uint32_t magic = ENV_MAGIC_WORD;
+    uint32_t addr;
+
+    for (addr = start + ENV_MAGIC_OFFSET; addr + sizeof(magic) <= end; addr++) {
+        if (!memcmp(data + addr - TEST_SEC_ADDR, &magic, sizeof(magic))) {
+            return addr - ENV_MAGIC_OFFSET;
+        }
+    }
+
+    return FAILED_ADDR;
+}
+
+/* the random bytes are mostly 0xFF and the magic word bytes, then some whole magic words and an erased tail */
+static void make_sector(uint64_t *seed) {
+    const uint32_t magic = ENV_MAGIC_WORD;
+    uint8_t *data = (uint8_t *) sector;
+    uint64_t r;
+    size_t i, num;
+
+    for (i = 0; i < SECTOR_SIZE; i++) {
+        r = bench_rand(seed);
+        switch (r % 4) {
+        case 0: data[i] = 0xFF; break;
+        case 1: data[i] = ((const uint8_t *) &magic)[(r >> 8) % sizeof(magic)]; break;
+        default: data[i] = (uint8_t) (r >> 8); break;
+        }
+    }
+    i = bench_rand(seed) % (SECTOR_SIZE + 1);
+    memset(data + i, 0xFF, SECTOR_SIZE - i);
+    for (num = bench_rand(seed) % 4; num > 0; num--) {
+        memcpy(data + bench_rand(seed) % (SECTOR_SIZE - sizeof(magic) + 1), &magic, sizeof(magic));
+    }
+
+    ef_port_erase(TEST_SEC_ADDR, SECTOR_SIZE);
+    ef_port_write(TEST_SEC_ADDR, sector, SECTOR_SIZE);
+}
+
+static int check_range(const char *name, uint32_t start, uint32_t end, uint32_t addr, uint32_t expect) {
+    if (addr != expect) {
+        printf("Error: The %s [0x%08X, 0x%08X) is 0x%08X, it should be 0x%08X.\n", name, start, end, addr, expect);
+        return 1;
+    }
+    if (read_max > read_min && (read_min < start || read_max > end)) {
+        printf("Error: The %s [0x%08X, 0x%08X) read [0x%08X, 0x%08X).\n", name, start, end, read_min, read_max);
+        return 1;
+    }
+
+    return 0;
+}
+
+static int check_ff(uint32_t start, uint32_t end) {
+    uint32_t addr;
+
+    read_min = UINT32_MAX;
+    read_max = 0;
+    addr = continue_ff_addr(start, end);
+
+    return check_range("free space scan", start, end, addr, ref_continue_ff_addr(start, end));
+}
+
+static int check_magic(uint32_t start, uint32_t end) {
+    uint32_t addr;
+
+    read_min = UINT32_MAX;
+    read_max = 0;
+    addr = find_next_env_addr(start, end);
+
+    return check_range("magic word scan", start, end, addr, ref_find_next_env_addr(start, end));
+}
+
+/* the last magic word which ends at the scan end is found, the magic word which crosses it is NOT found */
+static int check_scan_end(void) {
+    const uint32_t magic = ENV_MAGIC_WORD, end = SECTOR_MAGIC_SCAN_END(TEST_SEC_ADDR);
+    uint32_t pos, start = TEST_SEC_ADDR + SECTOR_HDR_DATA_SIZE;
+    uint8_t *data = (uint8_t *) sector;
+
+    for (pos = end - sizeof(magic) - 8; pos <= end - sizeof(magic) + 3; pos++) {
+        memset(sector, 0xFF, sizeof(sector));
+        memcpy(data + pos - TEST_SEC_ADDR, &magic, sizeof(magic));
+        ef_port_erase(TEST_SEC_ADDR, SECTOR_SIZE);
+        ef_port_write(TEST_SEC_ADDR, sector, SECTOR_SIZE);
+        if (check_magic(start, end) || check_magic(pos - ENV_MAGIC_OFFSET, end)) {
+            return 1;
+        }
+        if ((find_next_env_addr(start, end) != FAILED_ADDR) != (pos + sizeof(magic) <= end)) {
+            printf("Error: The magic word at 0x%08X is wrong at the scan end 0x%08X.\n", pos, end);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    struct ef_sim_cfg sim = EF_SIM_CFG_DEFAULT(ENV_AREA_SIZE + SECTOR_SIZE);
+    uint64_t seed = 1;
+    size_t loops = 20000, i, j;
+    uint32_t start, end;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:Vh")) != -1) {
+        switch (opt) {
+        case 'n': loops = strtoul(optarg, NULL, 0); break;
+        case 'V': ef_sim_set_verbose(true); break;
+        default:
+            printf("Usage: %s [-n sectors, default 20000] [-V]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+#if defined(EF_ENV_SCAN_USING_SSE2) && defined(__SSE2__)
+    printf("SSE2 scan, ");
+#else
+    printf("%d bytes word scan, ", EF_ENV_SCAN_WORD_SIZE);
+#endif
+    printf("%d bytes read window, sector 0x%X, %zu random sectors\n", EF_ENV_SCAN_BUF_SIZE, SECTOR_SIZE, loops);
+    ef_sim_init(&sim);
+    if (check_scan_end()) {
+        return 1;
+    }
+    for (i = 0; i < loops; i++) {
+        make_sector(&seed);
+        /* the scan ranges of the ENV load, then the random ranges */
+        if (check_ff(TEST_SEC_ADDR + SECTOR_HDR_DATA_SIZE, TEST_SEC_ADDR + SECTOR_SIZE)
+                || check_magic(TEST_SEC_ADDR + SECTOR_HDR_DATA_SIZE, SECTOR_MAGIC_SCAN_END(TEST_SEC_ADDR))) {
+            return 1;
+        }
+        for (j = 0; j < 8; j++) {
+            start = TEST_SEC_ADDR + bench_rand(&seed) % SECTOR_SIZE;
+            end = start + bench_rand(&seed) % (TEST_SEC_ADDR + SECTOR_SIZE - start + 1);
+            if (check_ff(start, end) || check_ff(start, TEST_SEC_ADDR + SECTOR_SIZE) || check_magic(start, end)
+                    || (start <= SECTOR_MAGIC_SCAN_END(TEST_SEC_ADDR)
+                    && check_magic(start, SECTOR_MAGIC_SCAN_END(TEST_SEC_ADDR)))) {
+                return 1;
+            }
+        }
+    }
+    ef_sim_deinit();
+    printf("All scans are same as the byte scan.\n");
+
+    return 0;
+}
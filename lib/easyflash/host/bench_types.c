@@ -0,0 +1,149 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Get and set of the 256 elements int and float arrays by the types plugin, it's built with the binary
+ *           array value and with the JSON array value (EF_TYPES_USING_JSON_ARRAY).
+ * Created on: 2026-10-18
+ */
+
+#include <easyflash.h>
+#include <ef_types.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include "ef_sim.h"
+#include "bench_util.h"
+
+#define ARRAY_LEN                                256
+
+static int int_array[ARRAY_LEN], int_saved[ARRAY_LEN];
+static float float_array[ARRAY_LEN], float_saved[ARRAY_LEN];
+
+static void print_result(const char *name, const char *key, uint64_t set_ns, uint64_t get_ns, size_t rounds,
+        double max_err) {
+    struct env_node_obj env;
+
+    if (!ef_get_env_obj(key, &env)) {
+        env.len = 0;
+    }
+    printf("%-8s %10.2f %10.2f %8u %12g\n", name, set_ns / 1e3 / rounds, get_ns / 1e3 / rounds, env.len, max_err);
+}
+
+/* the JSON array value which is saved by the old version is still readable */
+static int check_legacy(void) {
+    char value[ARRAY_LEN * 8] = "[", *pos = value + 1;
+    size_t i;
+
+    for (i = 0; i < ARRAY_LEN; i++) {
+        pos += sprintf(pos, "%s%d", i ? "," : "", int_array[i]);
+    }
+    strcpy(pos, "]");
+    if (ef_set_env("legacy", value) != EF_NO_ERR) {
+        printf("Error: Set the legacy ENV failed.\n");
+        return 1;
+    }
+    memset(int_saved, 0, sizeof(int_saved));
+    ef_get_int_array("legacy", int_saved);
+    if (memcmp(int_saved, int_array, sizeof(int_array))) {
+        printf("Error: The legacy JSON array is wrong.\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    struct ef_sim_cfg sim = EF_SIM_CFG_DEFAULT(ENV_AREA_SIZE);
+    size_t rounds = 1000, i, j;
+    uint64_t start, set_ns, get_ns, seed = 1;
+    double max_err;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:Vh")) != -1) {
+        switch (opt) {
+        case 'n': rounds = strtoul(optarg, NULL, 0); break;
+        case 'V': ef_sim_set_verbose(true); break;
+        default:
+            printf("Usage: %s [-n rounds, default 1000] [-V]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (rounds == 0) {
+        printf("The rounds must NOT be 0.\n");
+        return 1;
+    }
+
+#ifdef EF_TYPES_USING_JSON_ARRAY
+    printf("JSON array value, ");
+#else
+    printf("binary array value, ");
+#endif
+    printf("%d elements, ENV_AREA_SIZE 0x%X, sector 0x%X\n", ARRAY_LEN, ENV_AREA_SIZE, EF_ERASE_MIN_SIZE);
+    for (i = 0; i < ARRAY_LEN; i++) {
+        int_array[i] = (int) (bench_rand(&seed) % 2000000) - 1000000;
+        float_array[i] = (float) (0.9 + bench_rand_unit(&seed) * 0.2);
+    }
+    ef_sim_init(&sim);
+    if (easyflash_init() != EF_NO_ERR) {
+        printf("EasyFlash initialize failed.\n");
+        return 1;
+    }
+    ef_types_init(NULL);
+
+    printf("%-8s %10s %10s %8s %12s\n", "array", "set us", "get us", "node B", "max error");
+
+    start = bench_now_ns();
+    for (j = 0; j < rounds; j++) {
+        if (ef_set_int_array("ints", int_array, ARRAY_LEN) != EF_NO_ERR) {
+            printf("Error: Set the int array failed.\n");
+            return 1;
+        }
+    }
+    set_ns = bench_now_ns() - start;
+    start = bench_now_ns();
+    for (j = 0; j < rounds; j++) {
+        ef_get_int_array("ints", int_saved);
+    }
+    get_ns = bench_now_ns() - start;
+    for (i = 0, max_err = 0; i < ARRAY_LEN; i++) {
+        max_err = fmax(max_err, fabs((double) int_saved[i] - int_array[i]));
+    }
+    print_result("int", "ints", set_ns, get_ns, rounds, max_err);
+    if (max_err != 0) {
+        printf("Error: The int array is wrong.\n");
+        return 1;
+    }
+
+    start = bench_now_ns();
+    for (j = 0; j < rounds; j++) {
+        if (ef_set_float_array("floats", float_array, ARRAY_LEN) != EF_NO_ERR) {
+            printf("Error: Set the float array failed.\n");
+            return 1;
+        }
+    }
+    set_ns = bench_now_ns() - start;
+    start = bench_now_ns();
+    for (j = 0; j < rounds; j++) {
+        ef_get_float_array("floats", float_saved);
+    }
+    get_ns = bench_now_ns() - start;
+    /* the JSON number text is the shortest text of the float, it's read back to the same float */
+    for (i = 0, max_err = 0; i < ARRAY_LEN; i++) {
+        max_err = fmax(max_err, fabs((double) float_saved[i] - float_array[i]));
+    }
+    print_result("float", "floats", set_ns, get_ns, rounds, max_err);
+    if (max_err != 0) {
+        printf("Error: The float array is wrong.\n");
+        return 1;
+    }
+
+    if (check_legacy()) {
+        return 1;
+    }
+
+    ef_sim_deinit();
+
+    return 0;
+}
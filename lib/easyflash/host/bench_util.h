@@ -0,0 +1,138 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Shared helpers for the host side benchmarks.
+ * Created on: 2026-10-18
+ */
+
+#ifndef BENCH_UTIL_H_
+#define BENCH_UTIL_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* xorshift64*, it makes every workload repeatable by seed */
+static inline uint64_t bench_rand(uint64_t *state) {
+    uint64_t x = *state;
+
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+/* uniform random double in [0, 1) */
+static inline double bench_rand_unit(uint64_t *state) {
+    return (bench_rand(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* the Zipf distribution sampler, theta 0 means uniform */
+struct bench_zipf {
+    size_t n;
+    double *cdf;
+};
+
+static inline void bench_zipf_init(struct bench_zipf *zipf, size_t n, double theta) {
+    double sum = 0;
+    size_t i;
+
+    zipf->n = n;
+    zipf->cdf = malloc(n * sizeof(double));
+    for (i = 0; i < n; i++) {
+        sum += 1.0 / pow((double) (i + 1), theta);
+        zipf->cdf[i] = sum;
+    }
+    for (i = 0; i < n; i++) {
+        zipf->cdf[i] /= sum;
+    }
+}
+
+static inline size_t bench_zipf_next(struct bench_zipf *zipf, uint64_t *state) {
+    double u = bench_rand_unit(state);
+    size_t lo = 0, hi = zipf->n - 1;
+
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (zipf->cdf[mid] < u) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+static inline void bench_zipf_free(struct bench_zipf *zipf) {
+    free(zipf->cdf);
+    zipf->cdf = NULL;
+}
+
+static inline int bench_cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+
+    return x < y ? -1 : x > y;
+}
+
+/* get the percentile of samples, the samples will be sorted */
+static inline uint64_t bench_percentile(uint64_t *samples, size_t num, double pct) {
+    size_t index;
+
+    if (num == 0) {
+        return 0;
+    }
+    qsort(samples, num, sizeof(uint64_t), bench_cmp_u64);
+    index = (size_t) (pct / 100.0 * (num - 1) + 0.5);
+
+    return samples[index];
+}
+
+/* print the latency (ns) histogram by power of 2 microseconds buckets and the main percentiles */
+static inline void bench_print_latency(const char *name, uint64_t *samples, size_t num) {
+    size_t bucket[32] = { 0 }, i, b, max_count = 0;
+    uint64_t us;
+
+    if (num == 0) {
+        return;
+    }
+    for (i = 0; i < num; i++) {
+        for (b = 0, us = samples[i] / 1000; us > 1 && b < 31; us >>= 1) {
+            b++;
+        }
+        bucket[b]++;
+    }
+    for (b = 0; b < 32; b++) {
+        if (bucket[b] > max_count) {
+            max_count = bucket[b];
+        }
+    }
+    printf("%s latency histogram (%zu samples):\n", name, num);
+    for (b = 0; b < 32; b++) {
+        if (bucket[b]) {
+            printf("  < %8llu us %8zu %6.2f%% ", 2ULL << b, bucket[b], 100.0 * bucket[b] / num);
+            for (i = 0; i < (bucket[b] * 40 + max_count - 1) / max_count; i++) {
+                putchar('#');
+            }
+            putchar('\n');
+        }
+    }
+    printf("  p50 %.1f us, p90 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us\n",
+            bench_percentile(samples, num, 50) / 1e3, bench_percentile(samples, num, 90) / 1e3,
+            bench_percentile(samples, num, 99) / 1e3, bench_percentile(samples, num, 99.9) / 1e3,
+            bench_percentile(samples, num, 100) / 1e3);
+}
+
+#endif /* BENCH_UTIL_H_ */
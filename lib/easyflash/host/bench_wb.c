@@ -0,0 +1,107 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Hot counter ENV benchmark, it's built with and without the write back cache (EF_ENV_WRITE_BACK_KEYS).
+ * Created on: 2026-10-18
+ */
+
+#include <easyflash.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ef_sim.h"
+#include "bench_util.h"
+
+/* the application main loop period */
+#define TICK_US                                  10000
+
+#define STR(...)                                 #__VA_ARGS__
+#define XSTR(...)                                STR(__VA_ARGS__)
+
+int main(int argc, char **argv) {
+    struct ef_sim_cfg sim = EF_SIM_CFG_DEFAULT(ENV_AREA_SIZE);
+    struct ef_sim_stats stats;
+    struct env_node_obj env;
+    uint32_t boot_times = 0, tick_cnt = 0, run_time = 0, value;
+    size_t seconds = 600, tick, ticks, sets = 0;
+    uint64_t start, wall;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:Vh")) != -1) {
+        switch (opt) {
+        case 't': seconds = strtoul(optarg, NULL, 0); break;
+        case 'V': ef_sim_set_verbose(true); break;
+        default:
+            printf("Usage: %s [-t simulated seconds, default 600] [-V]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+#ifdef EF_ENV_WRITE_BACK_KEYS
+    printf("write back cache: %s\n", XSTR(EF_ENV_WRITE_BACK_KEYS));
+#else
+    printf("write through (no write back cache)\n");
+#endif
+    printf("tick_cnt is set every %d ms and run_time every second, %zu simulated seconds\n", TICK_US / 1000, seconds);
+
+    ef_sim_init(&sim);
+    if (easyflash_init() != EF_NO_ERR) {
+        printf("EasyFlash initialize failed.\n");
+        return 1;
+    }
+    ef_sim_reset_stats();
+
+    /* the same to test_env in user/main.c */
+    ef_get_env_blob("boot_times", &boot_times, sizeof(boot_times), NULL);
+    boot_times++;
+    ef_set_env_blob("boot_times", &boot_times, sizeof(boot_times));
+    sets++;
+
+    start = bench_now_ns();
+    ticks = seconds * (1000000 / TICK_US);
+    for (tick = 1; tick <= ticks; tick++) {
+        ef_sim_advance_time(TICK_US);
+        tick_cnt++;
+        if (ef_set_env_blob("tick_cnt", &tick_cnt, sizeof(tick_cnt)) != EF_NO_ERR) {
+            printf("Set failed at tick %zu.\n", tick);
+            return 1;
+        }
+        sets++;
+        if (tick % (1000000 / TICK_US) == 0) {
+            run_time++;
+            ef_set_env_blob("run_time", &run_time, sizeof(run_time));
+            sets++;
+        }
+        /* the periodic task */
+        ef_env_wb_poll();
+    }
+    /* the shutdown */
+    if (ef_save_env() != EF_NO_ERR) {
+        printf("Save ENV failed.\n");
+        return 1;
+    }
+    wall = bench_now_ns() - start;
+    ef_sim_get_stats(&stats);
+
+    /* the ENV object always comes from the flash, so it checks the saved value */
+    if (!ef_get_env_obj("tick_cnt", &env) || ef_read_env_value(&env, (uint8_t *) &value, sizeof(value)) != sizeof(value)
+            || value != tick_cnt) {
+        printf("Error: The tick_cnt on flash is NOT the latest.\n");
+        return 1;
+    }
+    if (!ef_get_env_obj("run_time", &env) || ef_read_env_value(&env, (uint8_t *) &value, sizeof(value)) != sizeof(value)
+            || value != run_time) {
+        printf("Error: The run_time on flash is NOT the latest.\n");
+        return 1;
+    }
+
+    printf("sets %zu, programs %llu (%.3f/s), erases %llu (%.1f/day), flash busy %.3f ms (%.4f%%), %.2f us/set\n",
+            sets, (unsigned long long) stats.programs, (double) stats.programs / seconds,
+            (unsigned long long) stats.erases, stats.erases * 86400.0 / seconds, stats.busy_ns / 1e6,
+            stats.busy_ns / 1e7 / seconds, wall / 1e3 / sets);
+
+    ef_sim_deinit();
+
+    return 0;
+}
@@ -0,0 +1,151 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Sector wear of the hot and cold ENV workload with and without the wear leveling
+ *           (EF_ENV_USING_WEAR_LEVELING). Most of the area is taken by the cold ENV which are written once,
+ *           the few hot ENV are updated all the time.
+ * Created on: 2026-10-18
+ */
+
+#include <easyflash.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include "ef_sim.h"
+#include "bench_util.h"
+
+#ifndef EF_ENV_WL_THRESHOLD
+#define EF_ENV_WL_THRESHOLD                      32
+#endif
+
+#define COLD_VALUE_SIZE                          48
+#define HOT_KEYS                                 8
+
+static int check_cold(size_t cold_keys) {
+    char key[EF_ENV_NAME_MAX];
+    uint8_t value[COLD_VALUE_SIZE];
+    size_t i;
+
+    for (i = 0; i < cold_keys; i++) {
+        snprintf(key, sizeof(key), "cold%zu", i);
+        if (ef_get_env_blob(key, value, sizeof(value), NULL) != sizeof(value) || value[0] != (uint8_t) i
+                || value[COLD_VALUE_SIZE - 1] != (uint8_t) i) {
+            printf("Error: The cold ENV '%s' is wrong.\n", key);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    struct ef_sim_cfg sim = EF_SIM_CFG_DEFAULT(ENV_AREA_SIZE);
+    struct ef_sim_stats stats;
+    struct ef_env_wear wear;
+    uint32_t counts[ENV_AREA_SIZE / EF_ERASE_MIN_SIZE], hot[HOT_KEYS][4] = { { 0 } };
+    uint8_t value[COLD_VALUE_SIZE];
+    char key[EF_ENV_NAME_MAX];
+    size_t writes = 10000000, cold_percent = 60, cold_keys, i, j;
+    uint64_t start, wall, seed = 1;
+    double avg, var = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:c:Vh")) != -1) {
+        switch (opt) {
+        case 'n': writes = strtoul(optarg, NULL, 0); break;
+        case 'c': cold_percent = strtoul(optarg, NULL, 0); break;
+        case 'V': ef_sim_set_verbose(true); break;
+        default:
+            printf("Usage: %s [-n hot writes, default 10000000] [-c cold ENV percent of the area, default 60] [-V]\n",
+                    argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (cold_percent > 70) {
+        printf("The cold ENV percent must NOT be more than 70.\n");
+        return 1;
+    }
+
+#ifdef EF_ENV_USING_WEAR_LEVELING
+    printf("wear leveling on (threshold %d), ", EF_ENV_WL_THRESHOLD);
+#else
+    printf("wear leveling off, ");
+#endif
+    printf("ENV_AREA_SIZE 0x%X, sector 0x%X\n", ENV_AREA_SIZE, EF_ERASE_MIN_SIZE);
+    ef_sim_init(&sim);
+    if (easyflash_init() != EF_NO_ERR) {
+        printf("EasyFlash initialize failed.\n");
+        return 1;
+    }
+
+    /* the cold ENV are written once */
+    cold_keys = ENV_AREA_SIZE / 100 * cold_percent / (COLD_VALUE_SIZE + 32);
+    for (i = 0; i < cold_keys; i++) {
+        snprintf(key, sizeof(key), "cold%zu", i);
+        memset(value, (int) i, sizeof(value));
+        if (ef_set_env_blob(key, value, sizeof(value)) != EF_NO_ERR) {
+            printf("Error: Set the ENV '%s' failed.\n", key);
+            return 1;
+        }
+    }
+
+    /* the hot ENV are updated randomly */
+    ef_sim_reset_stats();
+    start = bench_now_ns();
+    for (i = 0; i < writes; i++) {
+        j = bench_rand(&seed) % HOT_KEYS;
+        hot[j][0]++;
+        snprintf(key, sizeof(key), "hot%zu", j);
+        if (ef_set_env_blob(key, hot[j], sizeof(hot[j])) != EF_NO_ERR) {
+            printf("Error: Set the ENV '%s' failed.\n", key);
+            return 1;
+        }
+    }
+    wall = bench_now_ns() - start;
+    ef_sim_get_stats(&stats);
+
+    if (check_cold(cold_keys)) {
+        return 1;
+    }
+    for (j = 0; j < HOT_KEYS; j++) {
+        uint32_t saved[4];
+
+        snprintf(key, sizeof(key), "hot%zu", j);
+        if (hot[j][0] && (ef_get_env_blob(key, saved, sizeof(saved), NULL) != sizeof(saved) || saved[0] != hot[j][0])) {
+            printf("Error: The hot ENV '%s' is wrong.\n", key);
+            return 1;
+        }
+    }
+
+    /* the erase count on the sector header must be the simulated erase count */
+    if (ef_env_get_wear(&wear, counts, sizeof(counts) / sizeof(counts[0])) != EF_NO_ERR) {
+        printf("Error: Get the ENV wear failed.\n");
+        return 1;
+    }
+    for (i = 0; i < wear.sector_num; i++) {
+        if (counts[i] != ef_sim_get_wear(i)) {
+            printf("Error: The sector %zu erase count is %u, but it's erased %u times.\n", i, counts[i],
+                    ef_sim_get_wear(i));
+            return 1;
+        }
+    }
+    avg = (double) wear.total / wear.sector_num;
+    for (i = 0; i < wear.sector_num; i++) {
+        var += (counts[i] - avg) * (counts[i] - avg);
+    }
+
+    printf("%zu cold ENV, %zu hot writes: %.2f us/write, programmed %.1f MB, %llu erases\n", cold_keys, writes,
+            wall / 1e3 / writes, stats.program_bytes / 1048576.0, (unsigned long long) stats.erases);
+    printf("sector erases:");
+    for (i = 0; i < wear.sector_num; i++) {
+        printf(" %u", counts[i]);
+    }
+    printf("\nmin %u, max %u, avg %.1f, stddev %.1f, max/avg %.2f\n", wear.min, wear.max, avg, sqrt(var / wear.sector_num),
+            wear.max / avg);
+
+    ef_sim_deinit();
+
+    return 0;
+}
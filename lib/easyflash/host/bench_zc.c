@@ -0,0 +1,158 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Get a large ENV value by copy (ef_get_env_blob), by the zero copy pointer (ef_get_env_ptr)
+ *           and by the stream read (ef_read_env_value_at), and check the pointer generation after GC.
+ * Created on: 2026-10-18
+ */
+
+#include <easyflash.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ef_sim.h"
+#include "bench_util.h"
+
+/* the stream read buffer, it's much smaller than the value */
+#define STREAM_BUF_SIZE                          64
+
+struct bench_result {
+    uint64_t wall_ns;
+    struct ef_sim_stats stats;
+};
+
+static void print_result(const char *name, size_t gets, const struct bench_result *r) {
+    printf("%-8s %10.1f %12.1f %10.2f %12.3f\n", name, (double) r->stats.reads / gets,
+            (double) r->stats.read_bytes / gets, r->wall_ns / 1e3 / gets, r->stats.busy_ns / 1e3 / gets);
+}
+
+int main(int argc, char **argv) {
+    struct ef_sim_cfg sim = EF_SIM_CFG_DEFAULT(ENV_AREA_SIZE);
+    struct bench_result copy, zero_copy, stream;
+    struct env_node_obj env;
+    size_t value_size = 1024, gets = 10000, i, len, offset, read_len, value_len, moves = 0;
+    uint8_t *value, *buf, stream_buf[STREAM_BUF_SIZE];
+    const uint8_t *ptr;
+    uint32_t crc, value_crc, gen, counter;
+    uint64_t start, seed = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:n:Vh")) != -1) {
+        switch (opt) {
+        case 's': value_size = strtoul(optarg, NULL, 0); break;
+        case 'n': gets = strtoul(optarg, NULL, 0); break;
+        case 'V': ef_sim_set_verbose(true); break;
+        default:
+            printf("Usage: %s [-s value size, default 1024] [-n gets] [-V]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (value_size == 0 || value_size > EF_ERASE_MIN_SIZE / 2 || gets == 0) {
+        printf("The value size must be 1 to %d and gets must NOT be 0.\n", EF_ERASE_MIN_SIZE / 2);
+        return 1;
+    }
+    value = malloc(value_size);
+    buf = malloc(value_size);
+    for (i = 0; i < value_size; i++) {
+        value[i] = (uint8_t) bench_rand(&seed);
+    }
+    value_crc = ef_calc_crc32(0, value, value_size);
+
+    printf("get a %zu bytes value %zu times, ENV_AREA_SIZE 0x%X, sector 0x%X\n", value_size, gets,
+            ENV_AREA_SIZE, EF_ERASE_MIN_SIZE);
+    ef_sim_init(&sim);
+    if (easyflash_init() != EF_NO_ERR || ef_set_env_blob("cert", value, value_size) != EF_NO_ERR) {
+        printf("EasyFlash initialize failed.\n");
+        return 1;
+    }
+
+    /* copy to the RAM buffer */
+    ef_sim_reset_stats();
+    start = bench_now_ns();
+    for (i = 0, crc = 0; i < gets; i++) {
+        len = ef_get_env_blob("cert", buf, value_size, NULL);
+        crc = ef_calc_crc32(0, buf, len);
+    }
+    copy.wall_ns = bench_now_ns() - start;
+    ef_sim_get_stats(&copy.stats);
+    if (crc != value_crc) {
+        printf("Error: The copied value is wrong.\n");
+        return 1;
+    }
+
+    /* use the value on the mapped flash */
+    ef_sim_reset_stats();
+    start = bench_now_ns();
+    for (i = 0, crc = 0; i < gets; i++) {
+        ptr = ef_get_env_ptr("cert", &value_len, &gen);
+        crc = ef_calc_crc32(0, ptr, value_len);
+        if (!ef_env_ptr_is_valid(gen)) {
+            printf("Error: The ENV pointer is invalid without any change.\n");
+            return 1;
+        }
+    }
+    zero_copy.wall_ns = bench_now_ns() - start;
+    ef_sim_get_stats(&zero_copy.stats);
+    if (crc != value_crc) {
+        printf("Error: The zero copy value is wrong.\n");
+        return 1;
+    }
+
+    /* stream the value by a small buffer */
+    ef_sim_reset_stats();
+    start = bench_now_ns();
+    for (i = 0, crc = 0; i < gets; i++) {
+        ef_get_env_obj("cert", &env);
+        for (offset = 0, crc = 0; (read_len = ef_read_env_value_at(&env, offset, stream_buf, sizeof(stream_buf))) > 0;
+                offset += read_len) {
+            crc = ef_calc_crc32(crc, stream_buf, read_len);
+        }
+    }
+    stream.wall_ns = bench_now_ns() - start;
+    ef_sim_get_stats(&stream.stats);
+    if (crc != value_crc) {
+        printf("Error: The streamed value is wrong.\n");
+        return 1;
+    }
+
+    printf("%-8s %10s %12s %10s %12s\n", "per get", "reads", "read B", "wall us", "flash us");
+    print_result("copy", gets, &copy);
+    print_result("zc", gets, &zero_copy);
+    print_result("stream", gets, &stream);
+
+    /* update the other ENV until the value is moved by GC, the pointer must be invalid then */
+    ptr = ef_get_env_ptr("cert", &value_len, &gen);
+    ef_get_env_obj("cert", &env);
+    for (counter = 0; counter < 100000 && moves < 3; counter++) {
+        ef_set_env_blob("counter", &counter, sizeof(counter));
+        if (!ef_env_ptr_is_valid(gen)) {
+            const uint8_t *new_ptr = ef_get_env_ptr("cert", &value_len, &gen);
+
+            if (new_ptr != ptr) {
+                moves++;
+                if (ef_read_env_value_at(&env, 0, stream_buf, sizeof(stream_buf)) != 0) {
+                    printf("Error: The stale ENV object is still readable after GC.\n");
+                    return 1;
+                }
+                ef_get_env_obj("cert", &env);
+            }
+            ptr = new_ptr;
+            if (ef_calc_crc32(0, ptr, value_len) != value_crc) {
+                printf("Error: The value is wrong after GC.\n");
+                return 1;
+            }
+        }
+    }
+    if (moves < 3) {
+        printf("Error: The value is NOT moved by GC.\n");
+        return 1;
+    }
+    printf("moved by GC %zu times in %u sets, all stale pointers are detected\n", moves, counter);
+
+    free(value);
+    free(buf);
+    ef_sim_deinit();
+
+    return 0;
+}
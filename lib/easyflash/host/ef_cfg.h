@@ -0,0 +1,44 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: It is the configure head file for the host side simulator build.
+ *           It shadows inc/ef_cfg.h, every value can be overridden on the make command line.
+ * Created on: 2026-10-18
+ */
+
+#ifndef EF_CFG_H_
+#define EF_CFG_H_
+
+/* using ENV function, default is NG (Next Generation) mode start from V4.0 */
+#define EF_USING_ENV
+
+#ifdef EF_USING_ENV
+/* ENV version number defined by user. */
+#define EF_ENV_VER_NUM            0
+#endif /* EF_USING_ENV */
+
+/* The minimum size of flash erasure. May be a flash sector size. */
+#ifndef EF_ERASE_MIN_SIZE
+#define EF_ERASE_MIN_SIZE         4096
+#endif
+
+/* the flash write granularity, unit: bit
+ * only support 1(nor flash)/ 8(stm32f4)/ 32(stm32f1) */
+#ifndef EF_WRITE_GRAN
+#define EF_WRITE_GRAN             1
+#endif
+
+/* backup area start address, it's only a virtual address for the simulated flash */
+#ifndef EF_START_ADDR
+#define EF_START_ADDR             0x10000000
+#endif
+
+/* ENV area size. It's at least one empty sector for GC. So it's definition must more then or equal 2 flash sector size. */
+#ifndef ENV_AREA_SIZE
+#define ENV_AREA_SIZE             (16 * EF_ERASE_MIN_SIZE)
+#endif
+
+/* print debug information of flash */
+/* #define PRINT_DEBUG */
+
+#endif /* EF_CFG_H_ */
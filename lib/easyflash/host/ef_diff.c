@@ -0,0 +1,245 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Host side delta patch generator. The new image is matched to the old image by a hash chain of every
+ *           8 bytes of the old image (like the LZ77 match finder, the window is the whole old image). The match
+ *           which keeps the old read position (a COPY after a REPLACE or an INSERT) needs no SEEK, so a changed
+ *           constant or a relocated pointer costs only its bytes and two tags.
+ * Created on: 2026-10-18
+ */
+
+#include <easyflash.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ef_diff.h"
+
+/* the match is found by the hash of the first bytes */
+#define DIFF_HASH_LEN                  8
+#define DIFF_HASH_BITS                 18
+/* the max candidates of a position, it limits the time of the repeated data */
+#define DIFF_CHAIN_MAX                 64
+/* the min COPY length, a shorter match is cheaper as the literal */
+#define DIFF_MIN_COPY                  8
+
+struct diff_out {
+    uint8_t *buf;
+    size_t len;
+    size_t size;
+};
+
+struct diff_ctx {
+    const uint8_t *old_img;
+    size_t old_size;
+    const uint8_t *new_img;
+    size_t new_size;
+    int32_t *head;
+    int32_t *prev;
+    size_t old_pos;
+    struct diff_out out;
+};
+
+static int out_put(struct diff_out *out, const void *data, size_t size) {
+    uint8_t *buf;
+
+    if (out->len + size > out->size) {
+        out->size = (out->len + size) * 2;
+        buf = realloc(out->buf, out->size);
+        if (!buf) {
+            return -1;
+        }
+        out->buf = buf;
+    }
+    memcpy(out->buf + out->len, data, size);
+    out->len += size;
+
+    return 0;
+}
+
+static int out_put_u32(struct diff_out *out, uint32_t value) {
+    uint8_t buf[4] = { (uint8_t) value, (uint8_t) (value >> 8), (uint8_t) (value >> 16), (uint8_t) (value >> 24) };
+
+    return out_put(out, buf, sizeof(buf));
+}
+
+static size_t leb128(uint32_t value, uint8_t *buf) {
+    size_t len = 0;
+
+    do {
+        buf[len] = value & 0x7F;
+        value >>= 7;
+        if (value) {
+            buf[len] |= 0x80;
+        }
+        len++;
+    } while (value);
+
+    return len;
+}
+
+static uint32_t zigzag(int32_t value) {
+    return ((uint32_t) value << 1) ^ (uint32_t) (value >> 31);
+}
+
+static int out_tag(struct diff_out *out, uint8_t cmd, size_t len) {
+    uint8_t buf[6];
+    size_t size = 1;
+
+    if (len < EF_IAP_PATCH_LEN_EXT) {
+        buf[0] = (cmd << 6) | (uint8_t) len;
+    } else {
+        buf[0] = (cmd << 6) | EF_IAP_PATCH_LEN_EXT;
+        size += leb128((uint32_t) len, buf + 1);
+    }
+
+    return out_put(out, buf, size);
+}
+
+/* the patch size of a SEEK */
+static size_t seek_cost(size_t from, size_t to) {
+    uint8_t buf[5];
+
+    return from == to ? 0 : 1 + leb128(zigzag((int32_t) (to - from)), buf);
+}
+
+static int out_seek(struct diff_ctx *ctx, size_t to) {
+    uint8_t buf[6];
+    size_t size;
+
+    if (ctx->old_pos == to) {
+        return 0;
+    }
+    buf[0] = (EF_IAP_PATCH_OTHER << 6) | EF_IAP_PATCH_SEEK;
+    size = 1 + leb128(zigzag((int32_t) (to - ctx->old_pos)), buf + 1);
+    ctx->old_pos = to;
+
+    return out_put(&ctx->out, buf, size);
+}
+
+/* the literals are REPLACE when the next match is after them in the old image, otherwise INSERT */
+static int out_literal(struct diff_ctx *ctx, size_t start, size_t len, size_t next_old) {
+    uint8_t cmd = EF_IAP_PATCH_INSERT;
+
+    if (!len) {
+        return 0;
+    }
+    if (next_old == ctx->old_pos + len) {
+        cmd = EF_IAP_PATCH_REPLACE;
+        ctx->old_pos += len;
+    }
+    if (out_tag(&ctx->out, cmd, len)) {
+        return -1;
+    }
+
+    return out_put(&ctx->out, ctx->new_img + start, len);
+}
+
+static uint32_t diff_hash(const uint8_t *buf) {
+    uint64_t value;
+
+    memcpy(&value, buf, sizeof(value));
+
+    return (uint32_t) ((value * 0x9E3779B97F4A7C15ULL) >> (64 - DIFF_HASH_BITS));
+}
+
+static size_t match_len(struct diff_ctx *ctx, size_t old_pos, size_t new_pos) {
+    size_t len = 0, max = ctx->old_size - old_pos;
+
+    if (max > ctx->new_size - new_pos) {
+        max = ctx->new_size - new_pos;
+    }
+    while (len < max && ctx->old_img[old_pos + len] == ctx->new_img[new_pos + len]) {
+        len++;
+    }
+
+    return len;
+}
+
+/* find the best match of the new position, the score is the saved patch size */
+static size_t find_match(struct diff_ctx *ctx, size_t new_pos, size_t lit_len, size_t *match_old) {
+    size_t len, cost, best_len = 0, i;
+    long score, best_score = 0;
+    int32_t cand;
+
+    /* the old positions which need no SEEK: after the INSERT or after the REPLACE */
+    for (i = 0; i < 2; i++) {
+        cand = (int32_t) (ctx->old_pos + (i ? lit_len : 0));
+        if ((size_t) cand < ctx->old_size) {
+            len = match_len(ctx, cand, new_pos);
+            if (len >= DIFF_MIN_COPY && (long) len > best_score) {
+                best_score = (long) len;
+                best_len = len;
+                *match_old = cand;
+            }
+        }
+    }
+    if (new_pos + DIFF_HASH_LEN > ctx->new_size) {
+        return best_len;
+    }
+    cand = ctx->head[diff_hash(ctx->new_img + new_pos)];
+    for (i = 0; cand >= 0 && i < DIFF_CHAIN_MAX; i++, cand = ctx->prev[cand]) {
+        len = match_len(ctx, cand, new_pos);
+        cost = seek_cost(ctx->old_pos + lit_len, cand);
+        score = (long) len - (long) cost;
+        if (len >= DIFF_MIN_COPY + cost && score > best_score) {
+            best_score = score;
+            best_len = len;
+            *match_old = cand;
+        }
+    }
+
+    return best_len;
+}
+
+uint8_t *ef_diff(const uint8_t *old_img, size_t old_size, const uint8_t *new_img, size_t new_size,
+        size_t *patch_size) {
+    struct diff_ctx ctx = { old_img, old_size, new_img, new_size };
+    size_t new_pos = 0, lit_start = 0, len, match_old = 0, i;
+    uint32_t hash;
+    int err = 0;
+
+    ctx.head = malloc(sizeof(int32_t) << DIFF_HASH_BITS);
+    ctx.prev = malloc(sizeof(int32_t) * (old_size + 1));
+    if (!ctx.head || !ctx.prev) {
+        err = -1;
+        goto __exit;
+    }
+    memset(ctx.head, 0xFF, sizeof(int32_t) << DIFF_HASH_BITS);
+    /* the chain is from the last position, so the near match is found first */
+    for (i = 0; i + DIFF_HASH_LEN <= old_size; i++) {
+        hash = diff_hash(old_img + i);
+        ctx.prev[i] = ctx.head[hash];
+        ctx.head[hash] = (int32_t) i;
+    }
+
+    err |= out_put_u32(&ctx.out, EF_IAP_PATCH_MAGIC);
+    err |= out_put_u32(&ctx.out, (uint32_t) old_size);
+    err |= out_put_u32(&ctx.out, ef_calc_crc32(0, old_img, old_size));
+    err |= out_put_u32(&ctx.out, (uint32_t) new_size);
+    err |= out_put_u32(&ctx.out, ef_calc_crc32(0, new_img, new_size));
+    while (!err && new_pos < new_size) {
+        len = find_match(&ctx, new_pos, new_pos - lit_start, &match_old);
+        if (!len) {
+            new_pos++;
+            continue;
+        }
+        err |= out_literal(&ctx, lit_start, new_pos - lit_start, match_old);
+        err |= out_seek(&ctx, match_old);
+        err |= out_tag(&ctx.out, EF_IAP_PATCH_COPY, len);
+        ctx.old_pos += len;
+        new_pos += len;
+        lit_start = new_pos;
+    }
+    err |= out_literal(&ctx, lit_start, new_pos - lit_start, ctx.old_pos);
+    err |= out_tag(&ctx.out, EF_IAP_PATCH_OTHER, EF_IAP_PATCH_END);
+
+__exit:
+    free(ctx.head);
+    free(ctx.prev);
+    if (err) {
+        free(ctx.out.buf);
+        return NULL;
+    }
+    *patch_size = ctx.out.len;
+
+    return ctx.out.buf;
+}
@@ -0,0 +1,37 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Host side delta patch generator for the IAP patch apply engine (ef_iap_patch_xxx).
+ *           The patch format is described in ef_def.h.
+ * Created on: 2026-10-18
+ */
+
+#ifndef EF_DIFF_H_
+#define EF_DIFF_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Make the patch which makes the new image from the old image.
+ *
+ * @param old_img the old image
+ * @param old_size the old image size
+ * @param new_img the new image
+ * @param new_size the new image size
+ * @param patch_size the patch size
+ *
+ * @return the patch which is allocated by malloc, NULL: out of memory
+ */
+uint8_t *ef_diff(const uint8_t *old_img, size_t old_size, const uint8_t *new_img, size_t new_size,
+        size_t *patch_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EF_DIFF_H_ */
@@ -0,0 +1,66 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Make the delta patch of two application images for the IAP patch apply engine.
+ *           Usage: ef_mkpatch old.bin new.bin patch.bin
+ * Created on: 2026-10-18
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ef_diff.h"
+
+static uint8_t *read_file(const char *name, size_t *size) {
+    FILE *fp = fopen(name, "rb");
+    uint8_t *buf = NULL;
+    long len;
+
+    if (!fp) {
+        return NULL;
+    }
+    if (fseek(fp, 0, SEEK_END) == 0 && (len = ftell(fp)) >= 0 && fseek(fp, 0, SEEK_SET) == 0) {
+        buf = malloc(len ? len : 1);
+        if (buf && fread(buf, 1, len, fp) != (size_t) len) {
+            free(buf);
+            buf = NULL;
+        }
+        *size = len;
+    }
+    fclose(fp);
+
+    return buf;
+}
+
+int main(int argc, char **argv) {
+    uint8_t *old_img, *new_img, *patch;
+    size_t old_size, new_size, patch_size;
+    FILE *fp;
+
+    if (argc != 4) {
+        printf("Usage: %s old.bin new.bin patch.bin\n", argv[0]);
+        return 1;
+    }
+    old_img = read_file(argv[1], &old_size);
+    new_img = read_file(argv[2], &new_size);
+    if (!old_img || !new_img) {
+        printf("Error: Read the image '%s' failed.\n", old_img ? argv[2] : argv[1]);
+        return 1;
+    }
+    patch = ef_diff(old_img, old_size, new_img, new_size, &patch_size);
+    if (!patch) {
+        printf("Error: Out of memory.\n");
+        return 1;
+    }
+    fp = fopen(argv[3], "wb");
+    if (!fp || fwrite(patch, 1, patch_size, fp) != patch_size || fclose(fp)) {
+        printf("Error: Write the patch '%s' failed.\n", argv[3]);
+        return 1;
+    }
+    printf("old %zu bytes, new %zu bytes, patch %zu bytes (%.1f%% of the new image)\n", old_size, new_size,
+            patch_size, patch_size * 100.0 / new_size);
+    free(patch);
+    free(new_img);
+    free(old_img);
+
+    return 0;
+}
@@ -0,0 +1,578 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Portable interface for the host side simulated NOR flash.
+ * Created on: 2026-10-18
+ */
+
+/* the writer preferred rwlock attribute is a GNU extension */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <easyflash.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/mman.h>
+#include "ef_sim.h"
+#ifdef EF_SIM_USING_PORT_FLASH
+#include "ef_port_flash.h"
+#endif
+
+/* the min sleep time of the real time simulation */
+#define SIM_SLEEP_MIN_NS                         50000
+
+/* default environment variables set for the simulator, it's same as the target port */
+static const ef_env sim_default_env_set[] = {
+        {"iap_need_copy_app","0"},
+        {"iap_copy_app_size","0"},
+        {"stop_in_bootloader","0"},
+        {"device_id","1"},
+        {"boot_times","0"},
+};
+
+static struct ef_sim_cfg sim_cfg;
+static struct ef_sim_stats sim_stats;
+static uint8_t *sim_mem = NULL;
+static uint32_t *sim_wear = NULL;
+static ef_env const *default_env_set = sim_default_env_set;
+static size_t default_env_set_size = sizeof(sim_default_env_set) / sizeof(sim_default_env_set[0]);
+static bool sim_verbose = false;
+/* the simulated clock, it's moved by the flash busy time and ef_sim_advance_time */
+static uint64_t sim_clock_ns = 0;
+/* the ENV lock, the readers run concurrently and the waiting writer blocks the new readers */
+static pthread_rwlock_t sim_env_lock;
+static pthread_once_t sim_env_lock_once = PTHREAD_ONCE_INIT;
+/* the power cut, the programs and the sector erases are counted down to it */
+static uint64_t sim_cut_ops = 0, sim_cut_seed = 0;
+static bool sim_cut_torn = false, sim_power_off = false;
+static void (*sim_cut_callback)(void) = NULL;
+
+/**
+ * Create the simulated flash. All bytes are erased (0xFF) after it.
+ *
+ * @param cfg simulated flash geometry and timing
+ */
+void ef_sim_init(const struct ef_sim_cfg *cfg) {
+    EF_ASSERT(cfg);
+    EF_ASSERT(cfg->erase_size && cfg->size % cfg->erase_size == 0);
+    EF_ASSERT(cfg->prog_unit && cfg->page_size % cfg->prog_unit == 0);
+
+    ef_sim_deinit();
+    sim_cfg = *cfg;
+    if (sim_cfg.shared) {
+        sim_mem = mmap(NULL, sim_cfg.size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (sim_mem == MAP_FAILED) {
+            sim_mem = NULL;
+        }
+    } else {
+        sim_mem = malloc(sim_cfg.size);
+    }
+    sim_wear = calloc(sim_cfg.size / sim_cfg.erase_size, sizeof(uint32_t));
+    EF_ASSERT(sim_mem && sim_wear);
+    memset(sim_mem, 0xFF, sim_cfg.size);
+    ef_sim_reset_stats();
+}
+
+/**
+ * Release the simulated flash.
+ */
+void ef_sim_deinit(void) {
+    if (sim_cfg.shared && sim_mem) {
+        munmap(sim_mem, sim_cfg.size);
+    } else {
+        free(sim_mem);
+    }
+    free(sim_wear);
+    sim_mem = NULL;
+    sim_wear = NULL;
+}
+
+/**
+ * Change the default ENV set which will be returned by ef_port_init.
+ *
+ * @param default_env default ENV set
+ * @param default_env_size default ENV set size
+ */
+void ef_sim_set_default_env(ef_env const *default_env, size_t default_env_size) {
+    default_env_set = default_env;
+    default_env_set_size = default_env_size;
+}
+
+/**
+ * Enable or disable the EF_INFO and EF_DEBUG output.
+ *
+ * @param verbose true: print the library log
+ */
+void ef_sim_set_verbose(bool verbose) {
+    sim_verbose = verbose;
+}
+
+void ef_sim_reset_stats(void) {
+    memset(&sim_stats, 0, sizeof(sim_stats));
+}
+
+void ef_sim_get_stats(struct ef_sim_stats *stats) {
+    *stats = sim_stats;
+}
+
+/**
+ * Move the simulated clock forward, it models the application run time between the ENV operations.
+ *
+ * @param us microseconds
+ */
+void ef_sim_advance_time(uint64_t us) {
+    __atomic_fetch_add(&sim_clock_ns, us * 1000, __ATOMIC_RELAXED);
+}
+
+/**
+ * Get the erase count of a simulated sector.
+ *
+ * @param sector sector index from the simulated flash start
+ *
+ * @return erase count
+ */
+uint32_t ef_sim_get_wear(size_t sector) {
+    EF_ASSERT(sector < ef_sim_get_sector_num());
+
+    return sim_wear[sector];
+}
+
+size_t ef_sim_get_sector_num(void) {
+    return sim_cfg.size / sim_cfg.erase_size;
+}
+
+/**
+ * Get the simulated flash raw memory. It's useful for saving and restoring an image.
+ *
+ * @return raw memory
+ */
+uint8_t *ef_sim_get_mem(void) {
+    return sim_mem;
+}
+
+/**
+ * Cut the power at a program or a sector erase, it models a reset or a brown-out during the flash operation.
+ * The cut operation is NOT done, or it's partially done when it's torn: a random part of the program or the
+ * sector erase is finished and the next byte has random bits. The power is off after the cut, all programs and
+ * erases are dropped with an error until the next call of this function.
+ * @note The callback is called at the cut, the power loss harness ends the workload process in it.
+ *
+ * @param ops the cut operation counted from now, 1: the next program or sector erase, 0: no power cut
+ * @param torn true: the cut operation is partially done
+ * @param seed random seed of the torn operation
+ * @param cut the callback at the cut, it can be NULL
+ */
+void ef_sim_set_power_cut(uint64_t ops, bool torn, uint64_t seed, void (*cut)(void)) {
+    sim_cut_ops = ops;
+    sim_cut_torn = torn;
+    sim_cut_seed = seed ? seed : 1;
+    sim_cut_callback = cut;
+    sim_power_off = false;
+}
+
+/**
+ * Check the simulated flash has lost the power.
+ *
+ * @return true: the power was cut
+ */
+bool ef_sim_is_power_off(void) {
+    return sim_power_off;
+}
+
+/* the xorshift64* generator of the torn operation */
+static uint8_t sim_cut_rand(void) {
+    sim_cut_seed ^= sim_cut_seed >> 12;
+    sim_cut_seed ^= sim_cut_seed << 25;
+    sim_cut_seed ^= sim_cut_seed >> 27;
+
+    return (uint8_t) ((sim_cut_seed * 0x2545F4914F6CDD1DULL) >> 56);
+}
+
+/* count a program or a sector erase, return true when the power is cut at it */
+static bool sim_power_cut(void) {
+    if (sim_cut_ops && --sim_cut_ops == 0) {
+        sim_power_off = true;
+        return true;
+    }
+
+    return false;
+}
+
+/* a random part size of a torn operation, it's less than the size */
+static size_t sim_cut_part(size_t size) {
+    size_t part = ((size_t) sim_cut_rand() << 24) | ((size_t) sim_cut_rand() << 16) | ((size_t) sim_cut_rand() << 8)
+            | sim_cut_rand();
+
+    return part % size;
+}
+
+/* the concurrent readers update the statistics, so they are atomic */
+static void sim_busy(uint64_t ns) {
+    /* the short operations are slept together, the sleep is NOT precise under tens of microseconds */
+    static __thread uint64_t sleep_ns = 0;
+
+    __atomic_fetch_add(&sim_stats.busy_ns, ns, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&sim_clock_ns, ns, __ATOMIC_RELAXED);
+
+    if (sim_cfg.real_time && (sleep_ns += ns) >= SIM_SLEEP_MIN_NS) {
+        struct timespec ts = { .tv_sec = sleep_ns / 1000000000, .tv_nsec = sleep_ns % 1000000000 };
+
+        nanosleep(&ts, NULL);
+        sleep_ns = 0;
+    }
+}
+
+static void sim_env_lock_init(void) {
+    pthread_rwlockattr_t attr;
+
+    pthread_rwlockattr_init(&attr);
+#ifdef __GLIBC__
+    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+    pthread_rwlock_init(&sim_env_lock, &attr);
+    pthread_rwlockattr_destroy(&attr);
+}
+
+static bool sim_in_range(uint32_t addr, size_t size) {
+    return addr >= sim_cfg.base && size <= sim_cfg.size && addr - sim_cfg.base <= sim_cfg.size - size;
+}
+
+/**
+ * Flash port for hardware initialize.
+ *
+ * @param default_env default ENV set for user
+ * @param default_env_size default ENV size
+ *
+ * @return result
+ */
+EfErrCode ef_port_init(ef_env const **default_env, size_t *default_env_size) {
+    EfErrCode result = EF_NO_ERR;
+
+    *default_env = default_env_set;
+    *default_env_size = default_env_set_size;
+
+    if (!sim_mem) {
+        struct ef_sim_cfg cfg = EF_SIM_CFG_DEFAULT(ENV_AREA_SIZE);
+        ef_sim_init(&cfg);
+    }
+    pthread_once(&sim_env_lock_once, sim_env_lock_init);
+
+    return result;
+}
+
+/**
+ * Read data from the simulated flash device.
+ *
+ * @param addr flash address
+ * @param buf buffer to store read data
+ * @param size read bytes size
+ *
+ * @return result
+ */
+EfErrCode ef_sim_read(uint32_t addr, void *buf, size_t size) {
+    if (!sim_in_range(addr, size)) {
+        return EF_READ_ERR;
+    }
+
+    memcpy(buf, sim_mem + (addr - sim_cfg.base), size);
+    __atomic_fetch_add(&sim_stats.reads, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&sim_stats.read_bytes, size, __ATOMIC_RELAXED);
+    sim_busy(sim_cfg.read_ns + (uint64_t) sim_cfg.read_ns_per_byte * size);
+
+    return EF_NO_ERR;
+}
+
+/**
+ * Erase data on the simulated flash device. The address must be aligned by the erase granularity.
+ *
+ * @param addr flash address
+ * @param size erase bytes size
+ *
+ * @return result
+ */
+EfErrCode ef_sim_erase(uint32_t addr, size_t size) {
+    uint32_t offset = addr - sim_cfg.base;
+    size_t i;
+
+    /* make sure the start address is a multiple of the erase granularity */
+    EF_ASSERT(offset % sim_cfg.erase_size == 0);
+
+    if (!sim_in_range(addr, size)) {
+        return EF_ERASE_ERR;
+    }
+
+    /* the whole sector is erased even if the size is not aligned */
+    for (i = 0; i < size; i += sim_cfg.erase_size) {
+        size_t sector = (offset + i) / sim_cfg.erase_size;
+        uint8_t *mem = sim_mem + sector * sim_cfg.erase_size;
+
+        if (sim_power_off) {
+            return EF_ERASE_ERR;
+        }
+        if (sim_power_cut()) {
+            if (sim_cut_torn) {
+                size_t part = sim_cut_part(sim_cfg.erase_size);
+
+                memset(mem, 0xFF, part);
+                mem[part] |= sim_cut_rand();
+                sim_wear[sector]++;
+            }
+            if (sim_cut_callback) {
+                sim_cut_callback();
+            }
+            return EF_ERASE_ERR;
+        }
+        memset(mem, 0xFF, sim_cfg.erase_size);
+        sim_wear[sector]++;
+        sim_stats.erases++;
+        sim_busy(sim_cfg.erase_ns);
+    }
+
+    return EF_NO_ERR;
+}
+
+/**
+ * Program data to the simulated flash device. NOR flash program can only change the bit from 1 to 0.
+ * @note The strict mode forbids programming a byte twice before erase, like the on-chip flash with ECC.
+ * @note The program which crosses a page or isn't aligned by the program unit fails, like the device.
+ *
+ * @param addr flash address
+ * @param buf the write data buffer
+ * @param size write bytes size
+ *
+ * @return result
+ */
+EfErrCode ef_sim_program(uint32_t addr, const void *buf, size_t size) {
+    const uint8_t *buf_8 = (const uint8_t *) buf;
+    uint8_t *mem;
+    bool reprogram = false;
+    size_t i;
+
+    if (!sim_in_range(addr, size)) {
+        return EF_WRITE_ERR;
+    }
+    if ((addr - sim_cfg.base) % sim_cfg.prog_unit || size % sim_cfg.prog_unit
+            || (sim_cfg.page_size && size && (addr - sim_cfg.base) / sim_cfg.page_size
+                    != (addr - sim_cfg.base + size - 1) / sim_cfg.page_size)) {
+        return EF_WRITE_ERR;
+    }
+
+    mem = sim_mem + (addr - sim_cfg.base);
+    if (sim_power_off) {
+        return EF_WRITE_ERR;
+    }
+    if (size && sim_power_cut()) {
+        if (sim_cut_torn) {
+            size_t part = sim_cut_part(size);
+
+            for (i = 0; i < part; i++) {
+                mem[i] &= buf_8[i];
+            }
+            /* some 0 bits of the last byte are NOT programmed */
+            mem[part] &= buf_8[part] | sim_cut_rand();
+        }
+        if (sim_cut_callback) {
+            sim_cut_callback();
+        }
+        return EF_WRITE_ERR;
+    }
+    for (i = 0; i < size; i++) {
+        if (mem[i] != 0xFF) {
+            reprogram = true;
+        }
+        /* the programmed 1 bit keeps the old value */
+        mem[i] &= buf_8[i];
+    }
+    sim_stats.programs++;
+    sim_stats.program_bytes += size;
+    sim_busy(sim_cfg.prog_ns + (uint64_t) sim_cfg.prog_ns_per_byte * size);
+
+    if (reprogram) {
+        sim_stats.reprograms++;
+        if (sim_cfg.strict) {
+            return EF_WRITE_ERR;
+        }
+    }
+
+    return EF_NO_ERR;
+}
+
+/**
+ * Get the simulated flash memory for the mapped read, it's NOT counted as a flash read.
+ *
+ * @param addr flash address
+ * @param size mapped bytes size
+ *
+ * @return the mapped address, NULL: out of the simulated flash
+ */
+const void *ef_sim_map(uint32_t addr, size_t size) {
+    if (!sim_in_range(addr, size)) {
+        return NULL;
+    }
+
+    return sim_mem + (addr - sim_cfg.base);
+}
+
+/**
+ * Read data from flash. The buffered backend (port/ef_port_flash.c) is between the port and the simulated flash
+ * device when EF_SIM_USING_PORT_FLASH, it's set by ef_port_flash_init before easyflash_init.
+ *
+ * @param addr flash address
+ * @param buf buffer to store read data
+ * @param size read bytes size
+ *
+ * @return result
+ */
+EfErrCode ef_port_read(uint32_t addr, uint32_t *buf, size_t size) {
+#ifdef EF_SIM_USING_PORT_FLASH
+    return ef_port_flash_read(addr, buf, size);
+#else
+    return ef_sim_read(addr, buf, size);
+#endif
+}
+
+/**
+ * Erase data on flash. The address must be aligned by the erase granularity.
+ *
+ * @param addr flash address
+ * @param size erase bytes size
+ *
+ * @return result
+ */
+EfErrCode ef_port_erase(uint32_t addr, size_t size) {
+#ifdef EF_SIM_USING_PORT_FLASH
+    return ef_port_flash_erase(addr, size);
+#else
+    return ef_sim_erase(addr, size);
+#endif
+}
+
+/**
+ * Write data to flash.
+ *
+ * @param addr flash address
+ * @param buf the write data buffer
+ * @param size write bytes size
+ *
+ * @return result
+ */
+EfErrCode ef_port_write(uint32_t addr, const uint32_t *buf, size_t size) {
+#ifdef EF_SIM_USING_PORT_FLASH
+    return ef_port_flash_write(addr, buf, size);
+#else
+    return ef_sim_program(addr, buf, size);
+#endif
+}
+
+/**
+ * Get the CPU address of the memory mapped flash.
+ *
+ * @param addr flash address
+ * @param size mapped bytes size
+ *
+ * @return the mapped address, NULL: the flash is NOT mapped
+ */
+const void *ef_port_map(uint32_t addr, size_t size) {
+#ifdef EF_SIM_USING_PORT_FLASH
+    return ef_port_flash_map(addr, size);
+#else
+    return ef_sim_map(addr, size);
+#endif
+}
+
+/**
+ * Get the simulated time, the CPU time is NOT counted.
+ *
+ * @return time in microseconds
+ */
+uint32_t ef_port_get_time_us(void) {
+    return (uint32_t) (__atomic_load_n(&sim_clock_ns, __ATOMIC_RELAXED) / 1000);
+}
+
+/**
+ * lock the ENV ram cache
+ */
+void ef_port_env_lock(void) {
+    pthread_rwlock_wrlock(&sim_env_lock);
+}
+
+/**
+ * unlock the ENV ram cache
+ */
+void ef_port_env_unlock(void) {
+    pthread_rwlock_unlock(&sim_env_lock);
+}
+
+/**
+ * lock the ENV ram cache for read
+ */
+void ef_port_env_read_lock(void) {
+    pthread_rwlock_rdlock(&sim_env_lock);
+}
+
+/**
+ * unlock the ENV ram cache for read
+ */
+void ef_port_env_read_unlock(void) {
+    pthread_rwlock_unlock(&sim_env_lock);
+}
+
+/**
+ * This function is print flash debug info.
+ *
+ * @param file the file which has call this function
+ * @param line the line number which has call this function
+ * @param format output format
+ * @param ... args
+ *
+ */
+void ef_log_debug(const char *file, const long line, const char *format, ...) {
+    va_list args;
+
+    if (!sim_verbose) {
+        return;
+    }
+
+    va_start(args, format);
+    printf("[Flash](%s:%ld) ", file, line);
+    vprintf(format, args);
+    va_end(args);
+}
+
+/**
+ * This function is print flash routine info.
+ *
+ * @param format output format
+ * @param ... args
+ */
+void ef_log_info(const char *format, ...) {
+    va_list args;
+
+    if (!sim_verbose) {
+        return;
+    }
+
+    va_start(args, format);
+    printf("[Flash]");
+    vprintf(format, args);
+    va_end(args);
+}
+
+/**
+ * This function is print flash non-package info.
+ *
+ * @param format output format
+ * @param ... args
+ */
+void ef_print(const char *format, ...) {
+    va_list args;
+
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+}
@@ -0,0 +1,95 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Simulated NOR flash backend for the host side build.
+ *           It replaces port/ef_port.c and models the erase granularity, the bit-clearing-only
+ *           program rule, the program page and unit, the per-operation latency, the per-sector wear and
+ *           the power cut.
+ * Created on: 2026-10-18
+ */
+
+#ifndef EF_SIM_H_
+#define EF_SIM_H_
+
+#include <easyflash.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct ef_sim_cfg {
+    uint32_t base;                               /**< the flash address which is mapped to the first simulated byte */
+    size_t size;                                 /**< total simulated flash size */
+    size_t erase_size;                           /**< erase granularity */
+    size_t page_size;                            /**< a program must NOT cross a page, 0: no page */
+    size_t prog_unit;                            /**< the program address and size alignment */
+    uint32_t read_ns;                            /**< fixed cost of a read operation */
+    uint32_t read_ns_per_byte;                   /**< cost per byte of a read operation */
+    uint32_t prog_ns;                            /**< fixed cost of a program operation */
+    uint32_t prog_ns_per_byte;                   /**< cost per byte of a program operation */
+    uint32_t erase_ns;                           /**< cost of one sector erase */
+    bool strict;                                 /**< return EF_WRITE_ERR when a program touches a byte which is not erased */
+    bool real_time;                              /**< the caller sleeps for the busy time, like a driver which waits the DMA */
+    bool shared;                                 /**< the flash memory is shared with the forked processes */
+};
+
+struct ef_sim_stats {
+    uint64_t reads;                              /**< read operations */
+    uint64_t read_bytes;                         /**< total read bytes */
+    uint64_t programs;                           /**< program operations */
+    uint64_t program_bytes;                      /**< total programmed bytes */
+    uint64_t erases;                             /**< erased sectors */
+    uint64_t reprograms;                         /**< programs which touched a byte which is not erased */
+    uint64_t busy_ns;                            /**< simulated flash busy time */
+};
+
+/* the default timing is modelled on a typical SPI NOR flash */
+#define EF_SIM_CFG_DEFAULT(area_size)                                                   \
+{                                                                                      \
+    .base = EF_START_ADDR, .size = (area_size), .erase_size = EF_ERASE_MIN_SIZE,        \
+    .page_size = 0, .prog_unit = 1, .read_ns = 1000, .read_ns_per_byte = 20, .prog_ns = 10000, .prog_ns_per_byte = 50,  \
+    .erase_ns = 45000000, .strict = false, .real_time = false, .shared = false,        \
+}
+
+/* the MX25L6433F QSPI NOR flash by the QuadSPI IP commands: 4 KB sector erase 40 ms, 256 bytes page program
+ * 0.6 ms, the read command and the interrupt cost 5 us and the quad read is 20 MB/s */
+#define EF_SIM_CFG_MX25L6433F(area_size)                                               \
+{                                                                                      \
+    .base = EF_START_ADDR, .size = (area_size), .erase_size = 4096,                    \
+    .page_size = 256, .prog_unit = 1, .read_ns = 5000, .read_ns_per_byte = 50,         \
+    .prog_ns = 20000, .prog_ns_per_byte = 2300, .erase_ns = 40000000, .strict = false, \
+    .real_time = false, .shared = false,                                               \
+}
+
+/* the S32K1 D-Flash (FlexNVM): 2 KB sector erase 12 ms, 8 bytes phrase program 90 us, a phrase can NOT be
+ * programmed twice, it's memory mapped, so the read is NOT a device command */
+#define EF_SIM_CFG_DFLASH(area_size)                                                   \
+{                                                                                      \
+    .base = EF_START_ADDR, .size = (area_size), .erase_size = 2048,                    \
+    .page_size = 0, .prog_unit = 8, .read_ns = 0, .read_ns_per_byte = 0,               \
+    .prog_ns = 0, .prog_ns_per_byte = 11250, .erase_ns = 12000000, .strict = true,     \
+    .real_time = false, .shared = false,                                               \
+}
+
+void ef_sim_init(const struct ef_sim_cfg *cfg);
+void ef_sim_deinit(void);
+void ef_sim_set_default_env(ef_env const *default_env, size_t default_env_size);
+void ef_sim_set_verbose(bool verbose);
+void ef_sim_reset_stats(void);
+void ef_sim_get_stats(struct ef_sim_stats *stats);
+void ef_sim_advance_time(uint64_t us);
+uint32_t ef_sim_get_wear(size_t sector);
+size_t ef_sim_get_sector_num(void);
+uint8_t *ef_sim_get_mem(void);
+EfErrCode ef_sim_read(uint32_t addr, void *buf, size_t size);
+EfErrCode ef_sim_program(uint32_t addr, const void *buf, size_t size);
+EfErrCode ef_sim_erase(uint32_t addr, size_t size);
+const void *ef_sim_map(uint32_t addr, size_t size);
+void ef_sim_set_power_cut(uint64_t ops, bool torn, uint64_t seed, void (*cut)(void));
+bool ef_sim_is_power_off(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EF_SIM_H_ */
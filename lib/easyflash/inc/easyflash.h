@@ -48,7 +48,16 @@ EfErrCode easyflash_init(void);
 size_t ef_get_env_blob(const char *key, void *value_buf, size_t buf_len, size_t *saved_value_len);
 bool ef_get_env_obj(const char *key, env_node_obj_t env);
 size_t ef_read_env_value(env_node_obj_t env, uint8_t *value_buf, size_t buf_len);
+size_t ef_read_env_value_at(env_node_obj_t env, size_t offset, uint8_t *value_buf, size_t buf_len);
+const void *ef_get_env_ptr(const char *key, size_t *value_len, uint32_t *gen);
+bool ef_env_ptr_is_valid(uint32_t gen);
 EfErrCode ef_set_env_blob(const char *key, const void *value_buf, size_t buf_len);
+void ef_env_batch_init(ef_env_batch_t batch);
+EfErrCode ef_env_batch_set(ef_env_batch_t batch, const char *key, const void *value_buf, size_t buf_len);
+EfErrCode ef_env_batch_commit(ef_env_batch_t batch);
+bool ef_env_gc_step(void);
+EfErrCode ef_env_wb_poll(void);
+EfErrCode ef_env_get_wear(ef_env_wear_t wear, uint32_t *counts, size_t num);
 
 /* ef_env.c, ef_env_legacy_wl.c and ef_env_legacy.c */
 EfErrCode ef_load_env(void);
@@ -77,6 +86,15 @@ EfErrCode ef_copy_spec_app_from_bak(uint32_t user_app_addr, size_t app_size,
                                     EfErrCode (*app_write)(uint32_t addr, const uint32_t *buf, size_t size));
 EfErrCode ef_copy_bl_from_bak(uint32_t bl_addr, size_t bl_size);
 uint32_t ef_get_bak_app_start_addr(void);
+EfErrCode ef_iap_stream_init(ef_iap_stream_t stream, size_t total_size);
+size_t ef_iap_stream_put(ef_iap_stream_t stream, const void *data, size_t size);
+EfErrCode ef_iap_stream_poll(ef_iap_stream_t stream);
+EfErrCode ef_iap_stream_finish(ef_iap_stream_t stream);
+#ifdef EF_IAP_USING_PATCH
+EfErrCode ef_iap_patch_init(ef_iap_patch_t patch, uint32_t old_addr);
+EfErrCode ef_iap_patch_put(ef_iap_patch_t patch, const void *data, size_t size);
+EfErrCode ef_iap_patch_finish(ef_iap_patch_t patch, size_t *new_size);
+#endif
 #endif
 
 #ifdef EF_USING_LOG
@@ -85,17 +103,33 @@ EfErrCode ef_log_read(size_t index, uint32_t *log, size_t size);
 EfErrCode ef_log_write(const uint32_t *log, size_t size);
 EfErrCode ef_log_clean(void);
 size_t ef_log_get_used_size(void);
+#ifdef EF_LOG_USING_ASYNC
+size_t ef_log_async_write(const void *log, size_t size);
+EfErrCode ef_log_async_flush(bool force);
+void ef_log_async_get_stats(ef_log_async_stats_t stats);
+#endif
+#ifdef EF_LOG_USING_RECORD
+EfErrCode ef_log_write_record(uint32_t time, const void *data, size_t size);
+EfErrCode ef_log_query_by_time(ef_log_query_t query, uint32_t from, uint32_t to);
+EfErrCode ef_log_query_by_seq(ef_log_query_t query, uint32_t from, uint32_t to);
+bool ef_log_query_next(ef_log_query_t query, void *data, size_t size);
+#endif
 #endif
 
 /* ef_utils.c */
 uint32_t ef_calc_crc32(uint32_t crc, const void *buf, size_t size);
+uint32_t ef_env_calc_crc32(uint32_t crc, const void *buf, size_t size);
 
 /* ef_port.c */
 EfErrCode ef_port_read(uint32_t addr, uint32_t *buf, size_t size);
 EfErrCode ef_port_erase(uint32_t addr, size_t size);
 EfErrCode ef_port_write(uint32_t addr, const uint32_t *buf, size_t size);
+const void *ef_port_map(uint32_t addr, size_t size);
 void ef_port_env_lock(void);
 void ef_port_env_unlock(void);
+void ef_port_env_read_lock(void);
+void ef_port_env_read_unlock(void);
+uint32_t ef_port_get_time_us(void);
 void ef_log_debug(const char *file, const long line, const char *format, ...);
 void ef_log_info(const char *format, ...);
 void ef_print(const char *format, ...);
@@ -44,19 +44,99 @@
 /* MCU Endian Configuration, default is Little Endian Order.*/
 /* #define EF_BIG_ENDIAN  */         
 
+/* Full RAM index for all ENV, 8 bytes RAM per entry, must be a power of 2. Every get only need one header read. */
+/* #define EF_ENV_INDEX_TABLE_SIZE   64 */
+
+/* Max ENV number of ef_env_batch_commit, the batch must fit in one sector. */
+/* #define EF_ENV_BATCH_MAX          32 */
+
+/* Incremental GC, the GC is split to bounded steps and ef_env_gc_step can be called on idle. */
+/* #define EF_ENV_USING_INCREMENTAL_GC */
+/* the max ENV moves and the max time (us, 0: no limit) of each GC step */
+/* #define EF_GC_STEP_MOVE_MAX       4 */
+/* #define EF_GC_STEP_TIME_US        0 */
+
+/* Write back cache ENV names, their set only updates RAM until ef_save_env or the write back policy.
+ * The updates after the last write back are lost on power down. */
+/* #define EF_ENV_WRITE_BACK_KEYS    "boot_times" */
+/* the max cached value length, write back after the number of sets and at most once every period (ms), 0: disable */
+/* #define EF_ENV_WB_VALUE_MAX       32 */
+/* #define EF_ENV_WB_DIRTY_MAX       0 */
+/* #define EF_ENV_WB_PERIOD_MS       0 */
+
+/* Zero copy ENV value get by ef_get_env_ptr, the flash must be memory mapped by ef_port_map. */
+/* #define EF_ENV_USING_ZERO_COPY */
+
+/* ENV snapshot area, it must NOT overlap the other areas and its size must be aligned with EF_ERASE_MIN_SIZE.
+ * The ENV index (or cache) is saved by ef_save_env and after the idle GC, then the next boot restores it
+ * without checking all ENV when the ENV is NOT changed after the snapshot. */
+/* #define EF_ENV_SNAPSHOT_ADDR      (EF_START_ADDR - EF_ENV_SNAPSHOT_SIZE) */
+/* #define EF_ENV_SNAPSHOT_SIZE      EF_ERASE_MIN_SIZE */
+
+/* the read window (aligned by 16) and the compare width (1, 4 or 8 bytes) of the flash scan on sector traversal,
+ * the host build can scan by SSE2 */
+/* #define EF_ENV_SCAN_BUF_SIZE      64 */
+/* #define EF_ENV_SCAN_WORD_SIZE     4 */
+/* #define EF_ENV_SCAN_USING_SSE2 */
+
+/* Compress the ENV value by LZ77 with a 256 bytes dictionary, the compressed value is decompressed on read.
+ * Please keep it enabled when there are compressed values on flash. */
+/* #define EF_ENV_USING_COMPRESS */
+/* the compressed value buffer size, the value shorter than the min size is NOT compressed, the hash table size */
+/* #define EF_ENV_COMPRESS_BUF_SIZE  512 */
+/* #define EF_ENV_COMPRESS_MIN_SIZE  32 */
+/* #define EF_ENV_COMPRESS_HASH_SIZE 256 */
+
+/* Wear leveling, the least worn empty sector is used first and the GC prefers the dirty sector which has the
+ * most reclaimable space and the less wear. The full sector which is the threshold erases behind the most worn
+ * sector is collected too, so its cold ENV are moved to the most worn sector. */
+/* #define EF_ENV_USING_WEAR_LEVELING */
+/* #define EF_ENV_WL_THRESHOLD       32 */
+
+/* The ENV get takes the reader lock by ef_port_env_read_lock, so the concurrent gets don't block each other.
+ * The ENV cache is NOT updated by the get. */
+/* #define EF_ENV_USING_RW_LOCK */
+
 #endif /* EF_USING_ENV */
 
 /* using IAP function */
 /* #define EF_USING_IAP */
+/* the buffer size of the streaming IAP writer (ef_iap_stream_xxx), there are two buffers and the full buffer is
+ * programmed by one ef_port_write, so the port can program it by the section program command */
+/* #define EF_IAP_BUF_SIZE           1024 */
+/* Delta update, the new application is made from the current application and a patch (ef_iap_patch_xxx), the
+ * patch is made by the host tool (host/ef_mkpatch), the output buffer size */
+/* #define EF_IAP_USING_PATCH */
+/* #define EF_IAP_PATCH_BUF_SIZE     256 */
 
 /* using save log function */
 /* #define EF_USING_LOG */
+/* The asynchronous log writer, the log is appended to a RAM staging ring by ef_log_async_write without the flash
+ * access, and it's written by ef_log_async_flush in the idle hook or a low priority task, the ring size */
+/* #define EF_LOG_USING_ASYNC */
+/* #define EF_LOG_ASYNC_BUF_SIZE     2048 */
+/* The log records (ef_log_write_record) with the sequence number and the time, every sector header has the
+ * summary of its records, so the records of a time or a sequence range are found by the binary search */
+/* #define EF_LOG_USING_RECORD */
+/* the read ahead buffer size of the log record query, the short records are read by one ef_port_read */
+/* #define EF_LOG_QUERY_BUF_SIZE     256 */
+
+/* The flash backend of the port, the default is the memory mapped flash which is written by the CPU.
+ * - EF_PORT_USING_DFLASH: the on-chip D-Flash (FlexNVM) by FLASH_DRV_xxx, the EF_WRITE_GRAN must be 64 and the
+ *   EF_ERASE_MIN_SIZE is a multiple of the 2 KB sector. The log and IAP need the byte programmable flash.
+ * - EF_PORT_USING_MX25L6433F: the external QSPI flash by FLASH_MX25L6433F_DRV_xxx, the EF_START_ADDR is the flash
+ *   address and the EF_ERASE_MIN_SIZE is a multiple of the 4 KB sector. The QuadSPI must be initialized before
+ *   easyflash_init, and the QuadSPI and MX25L6433F drivers must be added to the SDK build. */
+/* #define EF_PORT_USING_DFLASH */
+/* #define EF_PORT_USING_MX25L6433F */
+/* the read ahead buffer size of the QSPI flash, the reads which are shorter than it are served by the buffer */
+/* #define EF_PORT_READ_AHEAD_SIZE   256 */
 
 /* The minimum size of flash erasure. May be a flash sector size. */
 #define EF_ERASE_MIN_SIZE         64/* @note you must define it for a value */
 
 /* the flash write granularity, unit: bit
- * only support 1(nor flash)/ 8(stm32f4)/ 32(stm32f1) */
+ * only support 1(nor flash)/ 8(stm32f4)/ 32(stm32f1)/ 64(D-Flash phrase) */
 #define EF_WRITE_GRAN             1/* @note you must define it for a value */
 
 /*
@@ -89,6 +169,14 @@
 /* saved log area size */
 #define LOG_AREA_SIZE             /* @note you must define it for a value if you used log */
 
+/* CRC32 software engine: 1 byte table (1KB), 4 slicing-by-4 (4KB), 8 slicing-by-8 (8KB) */
+/* #define EF_CRC32_SLICING          8 */
+
+/* route the new CRC32 calculation of big buffer in the ENV to the on-chip CRC module, the CRC clock must be enabled.
+ * The ENV lock serializes the module, the other CRC32 users (IAP patch verify, etc.) use the software engine.
+ * @note It's ignored when EF_ENV_USING_RW_LOCK is enabled, the concurrent readers can NOT share the module. */
+/* #define EF_CRC32_USING_HW */
+
 /* print debug information of flash */
 #define PRINT_DEBUG
 
@@ -108,15 +108,151 @@ struct env_node_obj {
     uint8_t name_len;                            /**< name length */
     uint32_t magic;                              /**< magic word(`K`, `V`, `4`, `0`) */
     uint32_t len;                                /**< ENV node total length (header + name + value), must align by EF_WRITE_GRAN */
-    uint32_t value_len;                          /**< value length */
+    uint32_t value_len;                          /**< value length, it's the length before compression */
+    bool compressed;                             /**< the value is compressed on flash */
     char name[EF_ENV_NAME_MAX];                  /**< name */
     struct {
         uint32_t start;                          /**< ENV node start address */
         uint32_t value;                          /**< value start address */
     } addr;
+    uint32_t gen;                                /**< ENV store generation when it's got, @see ef_env_ptr_is_valid */
 };
 typedef struct env_node_obj *env_node_obj_t;
 
+/* the max ENV number in one batch */
+#ifndef EF_ENV_BATCH_MAX
+#define EF_ENV_BATCH_MAX                         32
+#endif
+
+/* the staged ENV updates, the key and value buffers are NOT copied, they must be valid until committed */
+struct ef_env_batch {
+    size_t num;                                  /**< staged ENV number */
+    struct {
+        const char *key;                         /**< ENV name */
+        const void *value;                       /**< ENV value, NULL: delete the ENV */
+        size_t value_len;                        /**< ENV value length */
+    } env[EF_ENV_BATCH_MAX];
+};
+typedef struct ef_env_batch *ef_env_batch_t;
+
+/* the ENV sector wear report, @see ef_env_get_wear */
+struct ef_env_wear {
+    size_t sector_num;                           /**< sector number */
+    uint32_t min;                                /**< the min sector erase count */
+    uint32_t max;                                /**< the max sector erase count */
+    uint64_t total;                              /**< the total erase count of all sectors */
+};
+typedef struct ef_env_wear *ef_env_wear_t;
+
+#ifdef EF_USING_IAP
+/* the buffer size of the streaming IAP writer, it must be a multiple of 4 */
+#ifndef EF_IAP_BUF_SIZE
+#define EF_IAP_BUF_SIZE                          1024
+#endif
+
+/* The streaming IAP writer with two buffers. The producer (such as the UART DMA or the CAN receive interrupt) puts
+ * the data to one buffer by ef_iap_stream_put, while the consumer programs the other one by ef_iap_stream_poll. */
+struct ef_iap_stream {
+    size_t total_size;                           /**< application total size */
+    size_t received;                             /**< the size which is put by the producer */
+    size_t written;                              /**< the size which is programmed */
+    size_t erased;                               /**< the size which is erased, it's aligned with EF_ERASE_MIN_SIZE */
+    volatile size_t fill[2];                     /**< the data size of each buffer */
+    volatile bool full[2];                       /**< the buffer is full and waiting for the program */
+    uint8_t put_idx;                             /**< the buffer which is put by the producer */
+    uint8_t prog_idx;                            /**< the buffer which is programmed by the consumer */
+    EfErrCode result;                            /**< the first error, the writer is stopped on error */
+    uint32_t buf[2][EF_IAP_BUF_SIZE / 4];
+};
+typedef struct ef_iap_stream *ef_iap_stream_t;
+
+#ifdef EF_IAP_USING_PATCH
+/* the output buffer size of the patch apply engine, it must be a multiple of 4 */
+#ifndef EF_IAP_PATCH_BUF_SIZE
+#define EF_IAP_PATCH_BUF_SIZE                    256
+#endif
+
+/* The delta patch format, the numbers are little endian.
+ * header: the magic "EFP1", the old size, the old CRC32, the new size and the new CRC32 (4 bytes each)
+ * command: the tag has the command (bit 7..6) and the length (bit 5..0), the length 63 means a LEB128 length follows
+ *   COPY: copy the length bytes from the old application
+ *   INSERT: the length literal bytes follow
+ *   REPLACE: the length literal bytes follow, and the same length of the old application is skipped
+ *   OTHER: the length 0 is END, the length 1 is SEEK and a zigzag LEB128 offset of the old application follows */
+#define EF_IAP_PATCH_MAGIC                       0x31504645
+#define EF_IAP_PATCH_HEADER_SIZE                 20
+#define EF_IAP_PATCH_COPY                        0
+#define EF_IAP_PATCH_INSERT                      1
+#define EF_IAP_PATCH_REPLACE                     2
+#define EF_IAP_PATCH_OTHER                       3
+#define EF_IAP_PATCH_LEN_EXT                     63
+#define EF_IAP_PATCH_END                         0
+#define EF_IAP_PATCH_SEEK                        1
+
+/* The delta patch apply engine, the new application is made from the old application and the patch, and it's
+ * written to the backup area by ef_write_data_to_bak. The patch is put by parts, so it's never stored. */
+struct ef_iap_patch {
+    uint32_t old_addr;                           /**< the old application address */
+    uint32_t old_size;                           /**< the old application size of the patch header */
+    uint32_t new_size;                           /**< the new application size of the patch header */
+    uint32_t new_crc;                            /**< the new application CRC32 of the patch header */
+    size_t old_pos;                              /**< the old application read position */
+    size_t cur_size;                             /**< the size which is written to the backup area */
+    size_t remain;                               /**< the remaining length of the current command */
+    uint32_t value;                              /**< the LEB128 number which is being decoded */
+    uint8_t shift;                               /**< the bit shift of the LEB128 number */
+    uint8_t state;                               /**< the decoder state */
+    uint8_t cmd;                                 /**< the current command */
+    uint8_t header_len;                          /**< the received header length */
+    uint8_t header[EF_IAP_PATCH_HEADER_SIZE];
+    EfErrCode result;                            /**< the first error, the engine is stopped on error */
+    size_t out_len;                              /**< the data length in the output buffer */
+    uint32_t out[EF_IAP_PATCH_BUF_SIZE / 4];
+};
+typedef struct ef_iap_patch *ef_iap_patch_t;
+#endif /* EF_IAP_USING_PATCH */
+#endif /* EF_USING_IAP */
+
+#ifdef EF_LOG_USING_ASYNC
+/* the staging ring size of the asynchronous log writer, it must be a power of 2 */
+#ifndef EF_LOG_ASYNC_BUF_SIZE
+#define EF_LOG_ASYNC_BUF_SIZE                    2048
+#endif
+
+/* the staging ring statistics of the asynchronous log writer */
+struct ef_log_async_stats {
+    uint32_t drops;                              /**< the dropped logs because the ring was full */
+    uint32_t drop_bytes;                         /**< the dropped log bytes */
+    size_t high_water;                           /**< the max staged size */
+    size_t staged;                               /**< the current staged size */
+};
+typedef struct ef_log_async_stats *ef_log_async_stats_t;
+#endif /* EF_LOG_USING_ASYNC */
+
+#ifdef EF_LOG_USING_RECORD
+/* the read ahead buffer size of the log record query, it must be a multiple of 4 */
+#ifndef EF_LOG_QUERY_BUF_SIZE
+#define EF_LOG_QUERY_BUF_SIZE                    256
+#endif
+
+/* the log record query, the records are read by ef_log_query_next in the write order */
+struct ef_log_query {
+    uint32_t seq;                                /**< the read record sequence number */
+    uint32_t time;                               /**< the read record time */
+    size_t len;                                  /**< the read record data length */
+    bool by_time;                                /**< the key is the time, otherwise it's the sequence number */
+    uint32_t from;                               /**< the min key */
+    uint32_t to;                                 /**< the max key */
+    size_t index;                                /**< the current sector index, 0 is the oldest sector */
+    size_t num;                                  /**< the sector number which has the records */
+    uint32_t addr;                               /**< the next record address, 0: the sector is NOT read */
+    uint32_t buf_addr;                           /**< the flash address of the read ahead buffer */
+    size_t buf_len;                              /**< the data length of the read ahead buffer */
+    uint32_t buf[EF_LOG_QUERY_BUF_SIZE / 4];
+};
+typedef struct ef_log_query *ef_log_query_t;
+#endif /* EF_LOG_USING_RECORD */
+
 #ifdef __cplusplus
 }
 #endif
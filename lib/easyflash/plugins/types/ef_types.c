@@ -30,6 +30,13 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+/* the first byte of the binary array value, a JSON text can NOT start with the NUL (0xEF is the UTF-8 BOM start) */
+#define EF_TYPES_ARRAY_MAGIC                     0x00
+/* magic, type and 16 bits count */
+#define EF_TYPES_ARRAY_HDR_SIZE                  4
+/* the max elements of the binary array value */
+#define EF_TYPES_ARRAY_MAX                       0xFFFF
+
 /**
  *  array support types
  */
@@ -44,11 +51,16 @@ typedef enum {
     EF_ARRAY_TYPES_STRING,
 } ef_array_types;
 
+/* the element size on flash of the binary array value, the long is saved as 32 bits like the JSON valueint */
+static const uint8_t ef_array_elem_size[] = { 1, 1, 2, 4, 4, 4, 8 };
+
 /**
  * EasyFlash types plugin initialize.
  *
  * @param hook Memory management hook function.
  *             If hook is null or not call this function, then use free and malloc of C library.
+ * @note The cJSON objects can be allocated from an arena by s2j_arena_use after it, the arena is reset
+ *       after every JSON array and structure get or set.
  */
 void ef_types_init(S2jHook *hook) {
     s2j_init(hook);
@@ -82,7 +94,7 @@ long ef_get_long(const char *key) {
         return atol(value);
     } else {
         EF_INFO("Couldn't find this ENV(%s)!\n", key);
-        return NULL;
+        return 0;
     }
 }
 
@@ -93,13 +105,120 @@ float ef_get_float(const char *key) {
 double ef_get_double(const char *key) {
     char *value = ef_get_env(key);
     if(value) {
-        return atof(value);
+        return cJSON_ParseDouble(value, NULL);
     } else {
         EF_INFO("Couldn't find this ENV(%s)!\n", key);
-        return NULL;
+        return 0;
+    }
+}
+
+/*
+ * The array element is same as the binary value element on the little-endian CPU with the same size,
+ * so the array is copied without the conversion.
+ */
+static bool ef_array_is_native(ef_array_types types) {
+    static const uint8_t native_size[] = { sizeof(bool), sizeof(char), sizeof(short), sizeof(int), sizeof(long),
+            sizeof(float), sizeof(double) };
+    const uint16_t endian = 1;
+
+    return *(const uint8_t *) &endian == 1 && native_size[types] == ef_array_elem_size[types];
+}
+
+#ifndef EF_TYPES_USING_JSON_ARRAY
+/* pack the array element to the little-endian binary element */
+static void ef_array_put(uint8_t *buf, const void *value, size_t i, ef_array_types types) {
+    uint64_t bits = 0;
+    uint32_t bits32;
+    size_t j;
+
+    switch (types) {
+    case EF_ARRAY_TYPES_BOOL: bits = *((bool *) value + i) ? 1 : 0; break;
+    case EF_ARRAY_TYPES_CHAR: bits = (uint8_t) *((char *) value + i); break;
+    case EF_ARRAY_TYPES_SHORT: bits = (uint16_t) *((short *) value + i); break;
+    case EF_ARRAY_TYPES_INT: bits = (uint32_t) *((int *) value + i); break;
+    case EF_ARRAY_TYPES_LONG: bits = (uint32_t) *((long *) value + i); break;
+    case EF_ARRAY_TYPES_FLOAT: memcpy(&bits32, (float *) value + i, sizeof(bits32)); bits = bits32; break;
+    case EF_ARRAY_TYPES_DOUBLE: memcpy(&bits, (double *) value + i, sizeof(bits)); break;
+    default: EF_ASSERT(0);
+    }
+    for (j = 0; j < ef_array_elem_size[types]; j++) {
+        buf[j] = (uint8_t) (bits >> (8 * j));
+    }
+}
+#endif /* EF_TYPES_USING_JSON_ARRAY */
+
+/* unpack the little-endian binary element to the array element */
+static void ef_array_get(const uint8_t *buf, void *value, size_t i, ef_array_types types) {
+    uint64_t bits = 0;
+    uint32_t bits32;
+    size_t j;
+
+    for (j = 0; j < ef_array_elem_size[types]; j++) {
+        bits |= (uint64_t) buf[j] << (8 * j);
+    }
+    switch (types) {
+    case EF_ARRAY_TYPES_BOOL: *((bool *) value + i) = bits != 0; break;
+    case EF_ARRAY_TYPES_CHAR: *((char *) value + i) = (char) (int8_t) bits; break;
+    case EF_ARRAY_TYPES_SHORT: *((short *) value + i) = (int16_t) bits; break;
+    case EF_ARRAY_TYPES_INT: *((int *) value + i) = (int32_t) bits; break;
+    case EF_ARRAY_TYPES_LONG: *((long *) value + i) = (int32_t) bits; break;
+    case EF_ARRAY_TYPES_FLOAT: bits32 = (uint32_t) bits; memcpy((float *) value + i, &bits32, sizeof(bits32)); break;
+    case EF_ARRAY_TYPES_DOUBLE: memcpy((double *) value + i, &bits, sizeof(bits)); break;
+    default: EF_ASSERT(0);
     }
 }
 
+/**
+ * get the binary array ENV value
+ *
+ * @param key ENV name
+ * @param value returned ENV value
+ * @param types ENV array's type
+ *
+ * @return false: the ENV value is NOT a binary array, it maybe the old JSON array
+ */
+static bool ef_get_array_bin(const char *key, void *value, ef_array_types types) {
+    struct env_node_obj env;
+    uint8_t hdr[EF_TYPES_ARRAY_HDR_SIZE], buf[64];
+    size_t elem_size = ef_array_elem_size[types], num, i, j, read_len;
+
+    if (!ef_get_env_obj(key, &env)) {
+        EF_INFO("Couldn't find this ENV(%s)!\n", key);
+        return true;
+    }
+    if (ef_read_env_value(&env, hdr, sizeof(hdr)) != sizeof(hdr) || hdr[0] != EF_TYPES_ARRAY_MAGIC) {
+        return false;
+    }
+    if (hdr[1] != types) {
+        return false;
+    }
+    num = hdr[2] | (hdr[3] << 8);
+    if (env.value_len != EF_TYPES_ARRAY_HDR_SIZE + num * elem_size) {
+        EF_INFO("This ENV(%s) value type has error!\n", key);
+        return true;
+    }
+
+    if (ef_array_is_native(types)) {
+        /* the elements are read to the array directly */
+        if (ef_read_env_value_at(&env, EF_TYPES_ARRAY_HDR_SIZE, value, num * elem_size) != num * elem_size) {
+            EF_INFO("Error: Read the ENV(%s) value failed!\n", key);
+        }
+    } else {
+        for (i = 0; i < num; i += read_len / elem_size) {
+            read_len = (num - i) * elem_size < sizeof(buf) ? (num - i) * elem_size : sizeof(buf);
+            if (ef_read_env_value_at(&env, EF_TYPES_ARRAY_HDR_SIZE + i * elem_size, buf, read_len) != read_len) {
+                EF_INFO("Error: Read the ENV(%s) value failed!\n", key);
+                break;
+            }
+            for (j = 0; j < read_len / elem_size; j++) {
+                ef_array_get(buf + j * elem_size, value, i + j, types);
+            }
+        }
+    }
+
+    return true;
+}
+
 /**
  * get array ENV value
  *
@@ -108,48 +227,53 @@ double ef_get_double(const char *key) {
  * @param types ENV array's type
  */
 static void ef_get_array(const char *key, void *value, ef_array_types types) {
-    char *char_value = ef_get_env(key);
-    cJSON *array;
-    size_t size, i;
+    char *char_value;
+    cJSON *array, *item;
+    size_t i;
 
     EF_ASSERT(value);
 
+    if (types != EF_ARRAY_TYPES_STRING && ef_get_array_bin(key, value, types)) {
+        return;
+    }
+
+    char_value = ef_get_env(key);
     if (char_value) {
         array = cJSON_Parse(char_value);
         if (array) {
-            size = cJSON_GetArraySize(array);
-            for (i = 0; i < size; i++) {
+            /* walk the item chain, cJSON_GetArrayItem walks it again for every item */
+            for (item = array->child, i = 0; item; item = item->next, i++) {
                 switch (types) {
                 case EF_ARRAY_TYPES_BOOL: {
-                    *((bool *) value + i) = cJSON_GetArrayItem(array, i)->valueint;
+                    *((bool *) value + i) = item->valueint;
                     break;
                 }
                 case EF_ARRAY_TYPES_CHAR: {
-                    *((char *) value + i) = cJSON_GetArrayItem(array, i)->valueint;
+                    *((char *) value + i) = item->valueint;
                     break;
                 }
                 case EF_ARRAY_TYPES_SHORT: {
-                    *((short *) value + i) = cJSON_GetArrayItem(array, i)->valueint;
+                    *((short *) value + i) = item->valueint;
                     break;
                 }
                 case EF_ARRAY_TYPES_INT: {
-                    *((int *) value + i) = cJSON_GetArrayItem(array, i)->valueint;
+                    *((int *) value + i) = item->valueint;
                     break;
                 }
                 case EF_ARRAY_TYPES_LONG: {
-                    *((long *) value + i) = cJSON_GetArrayItem(array, i)->valueint;
+                    *((long *) value + i) = item->valueint;
                     break;
                 }
                 case EF_ARRAY_TYPES_FLOAT: {
-                    *((float *) value + i) = cJSON_GetArrayItem(array, i)->valuedouble;
+                    *((float *) value + i) = item->valuedouble;
                     break;
                 }
                 case EF_ARRAY_TYPES_DOUBLE: {
-                    *((double *) value + i) = cJSON_GetArrayItem(array, i)->valuedouble;
+                    *((double *) value + i) = item->valuedouble;
                     break;
                 }
                 case EF_ARRAY_TYPES_STRING: {
-                    *((char **) value + i) = cJSON_GetArrayItem(array, i)->valuestring;
+                    *((char **) value + i) = item->valuestring;
                     break;
                 }
                 }
@@ -158,6 +282,7 @@ static void ef_get_array(const char *key, void *value, ef_array_types types) {
             EF_INFO("This ENV(%s) value type has error!\n", key);
         }
         cJSON_Delete(array);
+        s2j_arena_reset();
     } else {
         EF_INFO("Couldn't find this ENV(%s)!\n", key);
     }
@@ -214,9 +339,56 @@ void *ef_get_struct(const char *key, ef_types_get_cb get_cb) {
         value = get_cb(json_value);
         cJSON_Delete(json_value);
     }
+    s2j_arena_reset();
     return value;
 }
 
+/* the stream reader context of the structure ENV value */
+struct ef_types_reader {
+    struct env_node_obj env;
+    size_t offset;
+};
+
+static size_t ef_types_read(void *ctx, char *buf, size_t size) {
+    struct ef_types_reader *reader = ctx;
+    size_t read_len = ef_read_env_value_at(&reader->env, reader->offset, (uint8_t *) buf, size);
+
+    reader->offset += read_len;
+
+    return read_len;
+}
+
+/**
+ * get structure ENV value by the stream parser, the JSON text is read from flash by a small window,
+ * so there is no cJSON object and no heap.
+ *
+ * @param key ENV name
+ * @param fields the structure element descriptors which are made by the s2j_field_xxx macros
+ * @param fields_num the element descriptors number
+ * @param value the structure object, the elements which are NOT in the ENV are NOT changed
+ *
+ * @return true: get the structure ENV is OK
+ */
+bool ef_get_struct_fields(const char *key, const S2jField *fields, size_t fields_num, void *value) {
+    struct ef_types_reader reader;
+    S2jStream stream;
+
+    EF_ASSERT(value);
+
+    if (!ef_get_env_obj(key, &reader.env)) {
+        EF_INFO("Couldn't find this ENV(%s)!\n", key);
+        return false;
+    }
+    reader.offset = 0;
+    s2j_stream_init_reader(&stream, ef_types_read, &reader);
+    if (!s2j_stream_to_struct(&stream, fields, fields_num, value)) {
+        EF_INFO("This ENV(%s) value type has error!\n", key);
+        return false;
+    }
+
+    return true;
+}
+
 EfErrCode ef_set_bool(const char *key, bool value) {
     char char_value[2] = { 0 };
     if (!value) {
@@ -248,17 +420,66 @@ EfErrCode ef_set_long(const char *key, long value) {
 }
 
 EfErrCode ef_set_float(const char *key, float value) {
-    return ef_set_double(key, value);
+    char char_value[cJSON_NumberTextSize] = { 0 };
+
+    /* the shortest text of the float, it's shorter than the text of the double */
+    cJSON_PrintFloat(value, char_value);
+
+    return ef_set_env(key, char_value);
 }
 
 EfErrCode ef_set_double(const char *key, double value) {
-    char char_value[21] = { 0 };
+    char char_value[cJSON_NumberTextSize] = { 0 };
 
-    snprintf(char_value, 20, "%lf", value);
+    cJSON_PrintDouble(value, char_value);
 
     return ef_set_env(key, char_value);
 }
 
+#ifndef EF_TYPES_USING_JSON_ARRAY
+/**
+ * set the binary array ENV value
+ *
+ * @param key ENV name
+ * @param value ENV value
+ * @param len array length
+ * @param types ENV array's type
+ *
+ * @return ENV set result
+ */
+static EfErrCode ef_set_array_bin(const char *key, void *value, size_t len, ef_array_types types) {
+    size_t elem_size = ef_array_elem_size[types], i;
+    uint8_t *buf;
+    EfErrCode result;
+
+    if (len > EF_TYPES_ARRAY_MAX) {
+        EF_INFO("Error: The ENV(%s) array is too long!\n", key);
+        return EF_ENV_FULL;
+    }
+    buf = s2jHook.malloc_fn(EF_TYPES_ARRAY_HDR_SIZE + len * elem_size);
+    if (!buf) {
+        EF_INFO("Memory full!\n");
+        return EF_ENV_FULL;
+    }
+
+    buf[0] = EF_TYPES_ARRAY_MAGIC;
+    buf[1] = (uint8_t) types;
+    buf[2] = (uint8_t) len;
+    buf[3] = (uint8_t) (len >> 8);
+    if (ef_array_is_native(types)) {
+        memcpy(buf + EF_TYPES_ARRAY_HDR_SIZE, value, len * elem_size);
+    } else {
+        for (i = 0; i < len; i++) {
+            ef_array_put(buf + EF_TYPES_ARRAY_HDR_SIZE + i * elem_size, value, i, types);
+        }
+    }
+    result = ef_set_env_blob(key, buf, EF_TYPES_ARRAY_HDR_SIZE + len * elem_size);
+    s2jHook.free_fn(buf);
+
+    return result;
+}
+#endif /* EF_TYPES_USING_JSON_ARRAY */
+
 /**
  * set array ENV value
  *
@@ -277,6 +498,12 @@ static EfErrCode ef_set_array(const char *key, void *value, size_t len, ef_array
 
     EF_ASSERT(value);
 
+#ifndef EF_TYPES_USING_JSON_ARRAY
+    if (types != EF_ARRAY_TYPES_STRING) {
+        return ef_set_array_bin(key, value, len, types);
+    }
+#endif
+
     array = cJSON_CreateArray();
     if (array) {
         for (i = 0; i < len; i++) {
@@ -302,7 +529,7 @@ static EfErrCode ef_set_array(const char *key, void *value, size_t len, ef_array
                 break;
             }
             case EF_ARRAY_TYPES_FLOAT: {
-                array_item = cJSON_CreateNumber(*((float *) value + i));
+                array_item = cJSON_CreateNumber(cJSON_FloatToDouble(*((float *) value + i)));
                 break;
             }
             case EF_ARRAY_TYPES_DOUBLE: {
@@ -334,6 +561,7 @@ static EfErrCode ef_set_array(const char *key, void *value, size_t len, ef_array
             EF_INFO("Memory full!\n", key);
         }
         cJSON_Delete(array);
+        s2j_arena_reset();
     } else {
         result = EF_ENV_FULL;
         EF_INFO("Memory full!\n", key);
@@ -390,6 +618,7 @@ EfErrCode ef_set_struct(const char *key, void *value, ef_types_set_cb set_cb) {
 
     cJSON_Delete(json_value);
     s2jHook.free_fn(char_value);
+    s2j_arena_reset();
 
     return result;
 }
@@ -31,10 +31,15 @@
 
 #include <easyflash.h>
 #include <stdbool.h>
-#include "struct2json\inc\s2j.h"
+#include "struct2json/inc/s2j.h"
 
 /* EasyFlash types plugin's software version number */
-#define EF_TYPES_SW_VERSION                      "0.11.03"
+#define EF_TYPES_SW_VERSION                      "0.12.00"
+
+/* The arrays (except the string array) are saved as the binary value: the magic byte, the type, the count and the
+ * little-endian packed elements. The old JSON array value is still readable. Enable it to save the arrays as
+ * JSON text, which is readable by the old version. */
+/* #define EF_TYPES_USING_JSON_ARRAY */
 
 typedef cJSON *(*ef_types_set_cb)(void* struct_obj);
 typedef void *(*ef_types_get_cb)(cJSON* json_obj);
@@ -56,6 +61,7 @@ void ef_get_float_array(const char *key, float *value);
 void ef_get_double_array(const char *key, double *value);
 void ef_get_string_array(const char *key, char **value);
 void *ef_get_struct(const char *key, ef_types_get_cb get_cb);
+bool ef_get_struct_fields(const char *key, const S2jField *fields, size_t fields_num, void *value);
 EfErrCode ef_set_bool(const char *key, bool value);
 EfErrCode ef_set_char(const char *key, char value);
 EfErrCode ef_set_short(const char *key, short value);
@@ -132,6 +132,15 @@ extern cJSON *cJSON_ParseWithOpts(const char *value,const char **return_parse_en
 
 extern void cJSON_Minify(char *json);
 
+/* The number text without printf and strtod. The print functions return the shortest text (in most cases) which is
+read back to the same number, the str needs cJSON_NumberTextSize bytes. The parse function is rounded correctly. */
+#define cJSON_NumberTextSize 32
+extern int cJSON_PrintDouble(double d,char *str);
+extern int cJSON_PrintFloat(float f,char *str);
+extern double cJSON_ParseDouble(const char *num,const char **end);
+/* The double of the shortest text of the float, so the float number item is printed short. */
+extern double cJSON_FloatToDouble(float f);
+
 /* Macros for creating things quickly. */
 #define cJSON_AddNullToObject(object,name)		cJSON_AddItemToObject(object, name, cJSON_CreateNull())
 #define cJSON_AddTrueToObject(object,name)		cJSON_AddItemToObject(object, name, cJSON_CreateTrue())
@@ -80,9 +80,29 @@ extern "C" {
 #define s2j_struct_get_struct_element(child_struct, to_struct, child_json, from_json, type, element) \
     S2J_STRUCT_GET_STRUCT_ELEMENT(child_struct, to_struct, child_json, from_json, type, element)
 
+/* Basic type element descriptor for the stream parser */
+#define s2j_field_basic(type_of_struct, type, element) \
+    S2J_FIELD_BASIC(type_of_struct, type, element)
+
+/* Array type element descriptor for the stream parser */
+#define s2j_field_array(type_of_struct, type, element) \
+    S2J_FIELD_ARRAY(type_of_struct, type, element)
+
+/* Child structure type element descriptor for the stream parser, the child fields is a descriptor array */
+#define s2j_field_struct(type_of_struct, element, child_fields) \
+    S2J_FIELD_STRUCT(type_of_struct, element, child_fields)
+
 /* s2j.c */
 extern S2jHook s2jHook;
 void s2j_init(S2jHook *hook);
+void s2j_arena_init(S2jArena_t arena, void *buf, size_t size);
+void s2j_arena_use(S2jArena_t arena);
+void s2j_arena_reset(void);
+
+/* s2j_stream.c */
+void s2j_stream_init(S2jStream_t stream, const char *json, size_t len);
+void s2j_stream_init_reader(S2jStream_t stream, size_t (*read)(void *ctx, char *buf, size_t size), void *ctx);
+bool s2j_stream_to_struct(S2jStream_t stream, const S2jField *fields, size_t fields_num, void *struct_obj);
 
 #ifdef __cplusplus
 }
@@ -31,6 +31,9 @@
 
 #include <cJSON.h>
 #include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -41,6 +44,68 @@ typedef struct {
     void (*free_fn)(void *ptr);
 } S2jHook, *S2jHook_t;
 
+/* The bump allocator for the cJSON objects. The memory is given back by s2j_arena_reset. */
+typedef struct {
+    uint8_t *buf;                /* NULL: dry run, the memory is from the heap, but it's counted as the arena */
+    size_t size;
+    size_t used;
+    size_t peak;                 /* the high-water mark, it's the arena size which is needed after the dry run */
+    size_t fallback;             /* the allocations from the heap when the arena is full */
+    void *last;                  /* the last allocation, it can be given back by free */
+    size_t last_size;
+} S2jArena, *S2jArena_t;
+
+/* the input window of the stream parser when the JSON text is read by the read callback */
+#ifndef S2J_STREAM_WINDOW_SIZE
+#define S2J_STREAM_WINDOW_SIZE        64
+#endif
+
+/* the max key length of the stream parser, the longer key is NOT matched */
+#ifndef S2J_STREAM_KEY_MAX
+#define S2J_STREAM_KEY_MAX            32
+#endif
+
+/* the structure element type of the stream parser, the lower case name is same as the s2j element type */
+typedef enum {
+    S2J_FIELD_int,
+    S2J_FIELD_double,
+    S2J_FIELD_string,
+    S2J_FIELD_struct,
+} S2jFieldType;
+
+/* The structure element descriptor of the stream parser, it's made by the s2j_field_xxx macros. */
+typedef struct S2jField {
+    const char *name;
+    S2jFieldType type;
+    size_t offset;
+    size_t size;                 /* the element size, the array item size for the array */
+    size_t count;                /* 0: NOT an array, else the array item count */
+    const struct S2jField *fields;
+    size_t fields_num;
+} S2jField;
+
+/* The JSON text input of the stream parser, it's in memory or read by the read callback */
+typedef struct {
+    const char *buf;
+    size_t len;
+    size_t pos;
+    size_t (*read)(void *ctx, char *buf, size_t size);
+    void *ctx;
+    char window[S2J_STREAM_WINDOW_SIZE];
+} S2jStream, *S2jStream_t;
+
+#define S2J_FIELD_BASIC(type_of_struct, type, _element) \
+    { #_element, S2J_FIELD_##type, offsetof(type_of_struct, _element), sizeof(((type_of_struct *) 0)->_element), 0, \
+      NULL, 0 }
+
+#define S2J_FIELD_ARRAY(type_of_struct, type, _element) \
+    { #_element, S2J_FIELD_##type, offsetof(type_of_struct, _element), sizeof(((type_of_struct *) 0)->_element[0]), \
+      sizeof(((type_of_struct *) 0)->_element) / sizeof(((type_of_struct *) 0)->_element[0]), NULL, 0 }
+
+#define S2J_FIELD_STRUCT(type_of_struct, _element, child_fields) \
+    { #_element, S2J_FIELD_struct, offsetof(type_of_struct, _element), sizeof(((type_of_struct *) 0)->_element), 0, \
+      child_fields, sizeof(child_fields) / sizeof(child_fields[0]) }
+
 #define S2J_STRUCT_GET_int_ELEMENT(to_struct, from_json, _element) \
     json_temp = cJSON_GetObjectItem(from_json, #_element); \
     if (json_temp) (to_struct)->_element = json_temp->valueint;
@@ -65,11 +130,15 @@ typedef struct {
 #define S2J_STRUCT_ARRAY_GET_ELEMENT(to_struct, from_json, type, _element, index) \
     S2J_STRUCT_ARRAY_GET_##type##_ELEMENT(to_struct, from_json, _element, index)
 
+/* the float element is printed by the shortest text of the float */
+#define S2J_JSON_DOUBLE_OF(value) \
+    (sizeof(value) == sizeof(float) ? cJSON_FloatToDouble((float) (value)) : (double) (value))
+
 #define S2J_JSON_SET_int_ELEMENT(to_json, from_struct, _element) \
     cJSON_AddNumberToObject(to_json, #_element, (from_struct)->_element);
 
 #define S2J_JSON_SET_double_ELEMENT(to_json, from_struct, _element) \
-    cJSON_AddNumberToObject(to_json, #_element, (from_struct)->_element);
+    cJSON_AddNumberToObject(to_json, #_element, S2J_JSON_DOUBLE_OF((from_struct)->_element));
 
 #define S2J_JSON_SET_string_ELEMENT(to_json, from_struct, _element) \
     cJSON_AddStringToObject(to_json, #_element, (from_struct)->_element);
@@ -78,7 +147,7 @@ typedef struct {
     cJSON_AddItemToArray(to_json, cJSON_CreateNumber((from_struct)->_element[index]));
 
 #define S2J_JSON_ARRAY_SET_double_ELEMENT(to_json, from_struct, _element, index) \
-    cJSON_AddItemToArray(to_json, cJSON_CreateNumber((from_struct)->_element[index]));
+    cJSON_AddItemToArray(to_json, cJSON_CreateNumber(S2J_JSON_DOUBLE_OF((from_struct)->_element[index])));
 
 #define S2J_JSON_ARRAY_SET_string_ELEMENT(to_json, from_struct, _element, index) \
     cJSON_AddItemToArray(to_json, cJSON_CreateString((from_struct)->_element[index]));
@@ -29,6 +29,7 @@
 #include <stdlib.h>
 #include <float.h>
 #include <limits.h>
+#include <stdint.h>
 #include <ctype.h>
 #include "cJSON.h"
 
@@ -92,22 +93,376 @@ void cJSON_Delete(cJSON *c)
 	}
 }
 
-/* Parse the input text to generate a number, and populate the result into item. */
-static const char *parse_number(cJSON *item,const char *num)
+/* Number text without printf and strtod. The double is printed by Grisu2, the shortest digits in the rounding
+   interval of the value (it is the shortest in most cases, and it is always read back to the same value). The text
+   is parsed exactly by the 15 digits fast path, else by the 64-bit DiyFp with the error bound, only the text which
+   is too close to the half way of two doubles is parsed by strtod. */
+typedef struct {uint64_t f; int e;} diy_fp;
+
+/* 10^-348, 10^-340, ..., 10^340, normalized to 64 bits */
+static const uint64_t cached_pow_f[]={
+	0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+	0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+	0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+	0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+	0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+	0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+	0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+	0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+	0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+	0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+	0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+	0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+	0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+	0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+	0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+	0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+	0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+	0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+	0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+	0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+	0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+	0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+	0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+	0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+	0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+	0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+	0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+	0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+	0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL,
+};
+static const short cached_pow_e[]={
+	-1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+	-901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+	-582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+	-263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+	56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+	375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+	694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+	1013, 1039, 1066,
+};
+static const uint32_t pow10_u32[]={1,10,100,1000,10000,100000,1000000,10000000,100000000,1000000000};
+static const uint64_t pow10_u64[]={1ULL,10ULL,100ULL,1000ULL,10000ULL,100000ULL,1000000ULL,10000000ULL,100000000ULL,
+	1000000000ULL,10000000000ULL,100000000000ULL,1000000000000ULL,10000000000000ULL,100000000000000ULL,
+	1000000000000000ULL,10000000000000000ULL,100000000000000000ULL,1000000000000000000ULL,10000000000000000000ULL};
+static const double pow10_exact[]={1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,1e12,1e13,1e14,1e15,1e16,1e17,1e18,
+	1e19,1e20,1e21,1e22};
+
+static diy_fp diy_fp_mul(diy_fp x,diy_fp y)
+{
+	uint64_t a=x.f>>32,b=x.f&0xFFFFFFFF,c=y.f>>32,d=y.f&0xFFFFFFFF;
+	uint64_t ac=a*c,bc=b*c,ad=a*d,bd=b*d;
+	uint64_t tmp=(bd>>32)+(ad&0xFFFFFFFF)+(bc&0xFFFFFFFF)+(1U<<31);	/* Round the low half. */
+	diy_fp r;
+	r.f=ac+(ad>>32)+(bc>>32)+(tmp>>32);
+	r.e=x.e+y.e+64;
+	return r;
+}
+
+static diy_fp diy_fp_normalize(diy_fp x)
+{
+#if defined(__GNUC__)
+	int s=__builtin_clzll(x.f);
+	x.f<<=s;x.e-=s;
+#else
+	while (!(x.f&0xFFC0000000000000ULL)) {x.f<<=10;x.e-=10;}
+	while (!(x.f&0x8000000000000000ULL)) {x.f<<=1;x.e--;}
+#endif
+	return x;
+}
+
+static diy_fp cached_pow(int index)
+{
+	diy_fp r;
+	r.f=cached_pow_f[index];
+	r.e=cached_pow_e[index];
+	return r;
+}
+
+static void grisu_round(char *buf,int len,uint64_t delta,uint64_t rest,uint64_t ten_kappa,uint64_t wp_w)
+{
+	while (rest<wp_w && delta-rest>=ten_kappa && (rest+ten_kappa<wp_w || wp_w-rest>rest+ten_kappa-wp_w))
+	{
+		buf[len-1]--;
+		rest+=ten_kappa;
+	}
+}
+
+/* Generate the digits of w in the interval [mp - delta, mp], the value is buf * 10^k. */
+static int grisu_digits(diy_fp w,diy_fp mp,uint64_t delta,char *buf,int *k)
+{
+	int shift=-mp.e,kappa,len=0;
+	uint64_t one=1ULL<<shift,wp_w=mp.f-w.f,p2=mp.f&(one-1),tmp;
+	uint32_t p1=(uint32_t)(mp.f>>shift),d;
+
+	for (kappa=1;kappa<10 && p1>=pow10_u32[kappa];kappa++);
+	while (kappa>0)
+	{
+		d=p1/pow10_u32[kappa-1];p1%=pow10_u32[kappa-1];
+		if (d || len) buf[len++]='0'+d;
+		kappa--;
+		tmp=((uint64_t)p1<<shift)+p2;
+		if (tmp<=delta)
+		{
+			*k+=kappa;
+			grisu_round(buf,len,delta,tmp,(uint64_t)pow10_u32[kappa]<<shift,wp_w);
+			return len;
+		}
+	}
+	for (;;)
+	{
+		p2*=10;delta*=10;
+		d=(uint32_t)(p2>>shift);
+		if (d || len) buf[len++]='0'+d;
+		p2&=one-1;
+		kappa--;
+		if (p2<delta)
+		{
+			*k+=kappa;
+			grisu_round(buf,len,delta,p2,one,-kappa<20?wp_w*pow10_u64[-kappa]:0);
+			return len;
+		}
+	}
+}
+
+/* The shortest digits of the binary floating point f * 2^e, the lower neighbour is closer when f is a power of 2. */
+static int grisu2(uint64_t f,int e,int lower_closer,char *buf,int *k)
+{
+	diy_fp v,mp,mm,c;
+	int index;
+	double dk;
+
+	mp.f=(f<<1)+1;mp.e=e-1;
+	mp=diy_fp_normalize(mp);
+	if (lower_closer)	{mm.f=(f<<2)-1;mm.e=e-2;}
+	else				{mm.f=(f<<1)-1;mm.e=e-1;}
+	mm.f<<=mm.e-mp.e;mm.e=mp.e;
+
+	/* The cached power c makes the exponent of the product in [-60, -32]. */
+	dk=(-61-mp.e)*0.30102999566398114+347;
+	index=(int)dk;
+	if (dk-index>0) index++;
+	index=(index>>3)+1;
+	*k=-(-348+index*8);
+	c=cached_pow(index);
+
+	v.f=f;v.e=e;
+	v=diy_fp_mul(diy_fp_normalize(v),c);
+	mp=diy_fp_mul(mp,c);mm=diy_fp_mul(mm,c);
+	mm.f++;mp.f--;
+	return grisu_digits(v,mp,mp.f-mm.f,buf,k);
+}
+
+static int print_exponent(char *str,int exp)
+{
+	char *start=str;
+	*str++='e';
+	if (exp<0)	{*str++='-';exp=-exp;}
+	else		*str++='+';
+	if (exp>=100)	{*str++='0'+exp/100;exp%=100;*str++='0'+exp/10;}
+	else if (exp>=10)	*str++='0'+exp/10;
+	*str++='0'+exp%10;
+	return str-start;
+}
+
+/* Format the digits buf * 10^k, the plain notation is used when the exponent is small. */
+static int prettify(char *buf,int len,int k)
+{
+	int kk=len+k,i,offset;
+
+	if (k>=0 && kk<=21)
+	{
+		for (i=len;i<kk;i++) buf[i]='0';
+		len=kk;
+	}
+	else if (kk>0 && kk<=21)
+	{
+		memmove(buf+kk+1,buf+kk,len-kk);
+		buf[kk]='.';
+		len++;
+	}
+	else if (kk>-6 && kk<=0)
+	{
+		offset=2-kk;
+		memmove(buf+offset,buf,len);
+		buf[0]='0';buf[1]='.';
+		for (i=2;i<offset;i++) buf[i]='0';
+		len+=offset;
+	}
+	else if (len==1)
+		len+=print_exponent(buf+1,kk-1);
+	else
+	{
+		memmove(buf+2,buf+1,len-1);
+		buf[1]='.';
+		len+=1+print_exponent(buf+len+1,kk-1);
+	}
+	buf[len]=0;
+	return len;
+}
+
+static int print_uint64(char *str,uint64_t u)
+{
+	char tmp[20];int len=0,i;
+	do {tmp[len++]='0'+(char)(u%10);u/=10;} while (u);
+	for (i=0;i<len;i++) str[i]=tmp[len-1-i];
+	str[len]=0;
+	return len;
+}
+
+/* Print the shortest text of the double which is read back to the same double, NaN and infinity are "null".
+   The str needs cJSON_NumberTextSize bytes, returns the text length. */
+int cJSON_PrintDouble(double d,char *str)
 {
-	double n=0,sign=1,scale=0;int subscale=0,signsubscale=1;
+	union {double d; uint64_t u;} v;
+	int sign,biased,len,k;
+	uint64_t frac;
+
+	v.d=d;
+	sign=(int)(v.u>>63);
+	biased=(int)(v.u>>52)&0x7FF;
+	frac=v.u&0xFFFFFFFFFFFFFULL;
+	if (biased==0x7FF)	{strcpy(str,"null");return 4;}
+	if (d==0)			{strcpy(str,"0");return 1;}
+	if (sign) *str='-';
+	/* The integer fast path. */
+	if (fabs(d)<9007199254740992.0 && d==(double)(int64_t)d)
+		return sign+print_uint64(str+sign,(uint64_t)fabs(d));
+	if (biased)	len=grisu2(frac|(1ULL<<52),biased-1075,frac==0 && biased>1,str+sign,&k);
+	else		len=grisu2(frac,-1074,0,str+sign,&k);
+	return sign+prettify(str+sign,len,k);
+}
+
+/* Print the shortest text of the float which is read back to the same float (the double of the text may NOT be
+   the same double of the float), it's shorter than the text of the double of the float. */
+int cJSON_PrintFloat(float f,char *str)
+{
+	union {float f; uint32_t u;} v;
+	int sign,biased,len,k;
+	uint32_t frac;
+
+	v.f=f;
+	sign=(int)(v.u>>31);
+	biased=(int)(v.u>>23)&0xFF;
+	frac=v.u&0x7FFFFF;
+	if (biased==0xFF)	{strcpy(str,"null");return 4;}
+	if (f==0)			{strcpy(str,"0");return 1;}
+	if (sign) *str='-';
+	if (fabsf(f)<16777216.0f && f==(float)(int32_t)f)
+		return sign+print_uint64(str+sign,(uint64_t)fabsf(f));
+	if (biased)	len=grisu2(frac|(1U<<23),biased-150,frac==0 && biased>1,str+sign,&k);
+	else		len=grisu2(frac,-149,0,str+sign,&k);
+	return sign+prettify(str+sign,len,k);
+}
+
+/* The double of the shortest text of the float, the float is printed as the short text by the double. */
+double cJSON_FloatToDouble(float f)
+{
+	char str[cJSON_NumberTextSize];
+	cJSON_PrintFloat(f,str);
+	return cJSON_ParseDouble(str,0);
+}
+
+/* The significand * 10^exp by the DiyFp, it has at most 19 digits and the remaining digits (cut) make an error.
+   Returns 0 when the result may NOT be rounded correctly. */
+static int diy_fp_strtod(uint64_t significand,int digits,int exp,int cut,double *result)
+{
+	/* The error is in 1/8 ulp. */
+	static const diy_fp pow10_small[]={{0xa000000000000000ULL,-60},{0xc800000000000000ULL,-57},
+		{0xfa00000000000000ULL,-54},{0x9c40000000000000ULL,-50},{0xc350000000000000ULL,-47},
+		{0xf424000000000000ULL,-44},{0x9896800000000000ULL,-40}};
+	union {double d; uint64_t u;} r;
+	int64_t error=cut?4:0;
+	int index,actual,old_e,precision,scale,order;
+	uint64_t bits,half,biased;
+	diy_fp v;
+
+	v.f=significand;v.e=0;
+	v=diy_fp_normalize(v);
+	error<<=-v.e;
+	index=(exp+348)/8;
+	actual=-348+index*8;
+	if (actual!=exp)
+	{
+		v=diy_fp_mul(v,pow10_small[exp-actual-1]);
+		if (digits+exp-actual>19) error+=4;	/* The product has more digits than 64 bits. */
+	}
+	v=diy_fp_mul(v,cached_pow(index));
+	error+=8+(error?1:0);
+	old_e=v.e;
+	v=diy_fp_normalize(v);
+	error<<=old_e-v.e;
+
+	/* The significand bits of the double, it's less than 53 for the denormal. */
+	order=64+v.e;
+	if (order<-1074)	{*result=0;return 0;}	/* It's near half of the min denormal. */
+	precision=64-(order>=-1021?53:order<=-1074?0:order+1074);
+	if (precision+3>=64)
+	{
+		scale=precision+3-63;
+		v.f>>=scale;v.e+=scale;
+		error=(error>>scale)+1+8;
+		precision-=scale;
+	}
+	bits=(v.f&((1ULL<<precision)-1))*8;
+	half=(1ULL<<(precision-1))*8;
+	v.f>>=precision;v.e+=precision;
+	if (bits>=half+(uint64_t)error)
+	{
+		v.f++;
+		if (v.f&(1ULL<<53)) {v.f>>=1;v.e++;}
+	}
+	biased=(v.e==-1074 && !(v.f&(1ULL<<52)))?0:(uint64_t)(v.e+1075);
+	if (biased>=0x7FF)	r.d=HUGE_VAL;
+	else				{r.u=(v.f&0xFFFFFFFFFFFFFULL)|(biased<<52);}
+	*result=r.d;
+	return half-(uint64_t)error>=bits || bits>=half+(uint64_t)error;
+}
+
+/* Put a digit to the significand, the zeros are put when there is a nonzero digit after them. */
+#define PUT_DIGIT(d)	do {	\
+	if (!(d)) {if (significand) zeros++; break;}	\
+	for (;zeros;zeros--) {if (digits<19) significand*=10,digits++; else exp++;}	\
+	if (digits<19) significand=significand*10+(d),digits++;	\
+	else {if (!cut) round_up=(d)>=5; exp++;cut=1;}	\
+} while (0)
 
-	if (*num=='-') sign=-1,num++;	/* Has sign? */
-	if (*num=='0') num++;			/* is zero */
-	if (*num>='1' && *num<='9')	do	n=(n*10.0)+(*num++ -'0');	while (*num>='0' && *num<='9');	/* Number? */
-	if (*num=='.' && num[1]>='0' && num[1]<='9') {num++;		do	n=(n*10.0)+(*num++ -'0'),scale--; while (*num>='0' && *num<='9');}	/* Fractional part? */
+/* Parse the number text to the double, it's rounded correctly. The end returns the char after the number. */
+double cJSON_ParseDouble(const char *num,const char **end)
+{
+	const char *start=num;
+	uint64_t significand=0;
+	int digits=0,zeros=0,exp=0,cut=0,round_up=0,subscale=0,signsubscale=1,negative=0;
+	double n;
+
+	if (*num=='-') negative=1,num++;	/* Has sign? */
+	if (*num=='0') num++;				/* is zero */
+	if (*num>='1' && *num<='9')	do	PUT_DIGIT(*num-'0');	while (*++num>='0' && *num<='9');	/* Number? */
+	if (*num=='.' && num[1]>='0' && num[1]<='9') {num++;	do	{exp--;PUT_DIGIT(*num-'0');} while (*++num>='0' && *num<='9');}	/* Fractional part? */
 	if (*num=='e' || *num=='E')		/* Exponent? */
 	{	num++;if (*num=='+') num++;	else if (*num=='-') signsubscale=-1,num++;		/* With sign? */
-		while (*num>='0' && *num<='9') subscale=(subscale*10)+(*num++ - '0');	/* Number? */
+		while (*num>='0' && *num<='9') {if (subscale<100000) subscale=(subscale*10)+(*num-'0');num++;}	/* Number? */
 	}
+	if (end) *end=num;
+	exp+=zeros+subscale*signsubscale;
+	significand+=round_up;
+
+	if (significand==0)				n=0;
+	else if (digits+exp>309)		n=HUGE_VAL;
+	else if (digits+exp<=-324)		n=0;
+	else if (!cut && significand<=9007199254740991ULL && exp>=-22 && exp<=22)
+		n=exp<0?(double)significand/pow10_exact[-exp]:(double)significand*pow10_exact[exp];	/* Both are exact. */
+	else if (!diy_fp_strtod(significand,digits,exp,cut,&n))
+		n=fabs(strtod(start,0));	/* It's rare. */
+	return negative?-n:n;
+}
+#undef PUT_DIGIT
+
+/* Parse the input text to generate a number, and populate the result into item. */
+static const char *parse_number(cJSON *item,const char *num)
+{
+	double n=cJSON_ParseDouble(num,&num);
 
-	n=sign*n*pow(10.0,(scale+subscale*signsubscale));	/* number = +/- number.fraction * 10^+/- exponent */
-	
 	item->valuedouble=n;
 	item->valueint=(int)n;
 	item->type=cJSON_Number;
@@ -158,20 +513,18 @@ static char *print_number(cJSON *item,printbuffer *p)
 	{
 		if (p)	str=ensure(p,21);
 		else	str=(char*)cJSON_malloc(21);	/* 2^64+1 can be represented in 21 chars. */
-		if (str)	sprintf(str,"%d",item->valueint);
-	}
-	else
-	{
-		if (p)	str=ensure(p,64);
-		else	str=(char*)cJSON_malloc(64);	/* This is a nice tradeoff. */
 		if (str)
 		{
-			if (fpclassify(d) != FP_ZERO && !isnormal(d))				sprintf(str,"null");
-			else if (fabs(floor(d)-d)<=DBL_EPSILON && fabs(d)<1.0e60)	sprintf(str,"%.0f",d);
-			else if (fabs(d)<1.0e-6 || fabs(d)>1.0e9)					sprintf(str,"%e",d);
-			else														sprintf(str,"%f",d);
+			if (item->valueint<0)	{*str='-';print_uint64(str+1,-(uint64_t)item->valueint);}
+			else					print_uint64(str,(uint64_t)item->valueint);
 		}
 	}
+	else
+	{
+		if (p)	str=ensure(p,cJSON_NumberTextSize);
+		else	str=(char*)cJSON_malloc(cJSON_NumberTextSize);
+		if (str)	cJSON_PrintDouble(d,str);	/* The shortest text which is read back to the same double. */
+	}
 	return str;
 }
 
@@ -712,7 +1065,7 @@ cJSON *cJSON_CreateObject(void)					{cJSON *item=cJSON_New_Item();if(item)item->
 
 /* Create Arrays: */
 cJSON *cJSON_CreateIntArray(const int *numbers,int count)		{int i;cJSON *n=0,*p=0,*a=cJSON_CreateArray();for(i=0;a && i<count;i++){n=cJSON_CreateNumber(numbers[i]);if(!i)a->child=n;else suffix_object(p,n);p=n;}return a;}
-cJSON *cJSON_CreateFloatArray(const float *numbers,int count)	{int i;cJSON *n=0,*p=0,*a=cJSON_CreateArray();for(i=0;a && i<count;i++){n=cJSON_CreateNumber(numbers[i]);if(!i)a->child=n;else suffix_object(p,n);p=n;}return a;}
+cJSON *cJSON_CreateFloatArray(const float *numbers,int count)	{int i;cJSON *n=0,*p=0,*a=cJSON_CreateArray();for(i=0;a && i<count;i++){n=cJSON_CreateNumber(cJSON_FloatToDouble(numbers[i]));if(!i)a->child=n;else suffix_object(p,n);p=n;}return a;}
 cJSON *cJSON_CreateDoubleArray(const double *numbers,int count)	{int i;cJSON *n=0,*p=0,*a=cJSON_CreateArray();for(i=0;a && i<count;i++){n=cJSON_CreateNumber(numbers[i]);if(!i)a->child=n;else suffix_object(p,n);p=n;}return a;}
 cJSON *cJSON_CreateStringArray(const char **strings,int count)	{int i;cJSON *n=0,*p=0,*a=cJSON_CreateArray();for(i=0;a && i<count;i++){n=cJSON_CreateString(strings[i]);if(!i)a->child=n;else suffix_object(p,n);p=n;}return a;}
 
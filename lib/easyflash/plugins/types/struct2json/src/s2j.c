@@ -34,6 +34,17 @@ S2jHook s2jHook = {
         .free_fn = free,
 };
 
+/* the arena block alignment, it's enough for the double */
+#define S2J_ARENA_ALIGN               8
+
+/* the arena which is used by cJSON, NULL: cJSON uses the heap */
+static S2jArena_t s2j_arena = NULL;
+/* the hooks before the arena is used, the dry run and the full arena allocate from it */
+static S2jHook s2j_heap_hook = {
+        .malloc_fn = malloc,
+        .free_fn = free,
+};
+
 /**
  * struct2json library initialize
  * @note It will initialize cJSON library hooks.
@@ -46,7 +57,103 @@ void s2j_init(S2jHook *hook) {
         s2jHook.malloc_fn = (hook->malloc_fn) ? hook->malloc_fn : malloc;
         s2jHook.free_fn = (hook->free_fn) ? hook->free_fn : free;
     } else {
-        hook->malloc_fn = malloc;
-        hook->free_fn = free;
+        s2jHook.malloc_fn = malloc;
+        s2jHook.free_fn = free;
+    }
+}
+
+/**
+ * Initialize an arena.
+ *
+ * @param arena the arena object
+ * @param buf the arena memory, NULL: dry run, the allocations are from the heap and the high-water mark of the
+ *        arena is counted, so the arena can be sized by the peak after a dry run pass
+ * @param size the arena memory size
+ */
+void s2j_arena_init(S2jArena_t arena, void *buf, size_t size) {
+    memset(arena, 0, sizeof(S2jArena));
+    arena->buf = buf;
+    arena->size = buf ? size : 0;
+}
+
+static void *s2j_arena_malloc(size_t sz) {
+    S2jArena_t arena = s2j_arena;
+    size_t size = (sz + S2J_ARENA_ALIGN - 1) & ~((size_t) S2J_ARENA_ALIGN - 1);
+    void *ptr;
+
+    if (arena->buf && size <= arena->size - arena->used) {
+        ptr = arena->buf + arena->used;
+    } else {
+        ptr = s2j_heap_hook.malloc_fn(sz);
+        if (!ptr) {
+            return NULL;
+        }
+        if (arena->buf) {
+            arena->fallback++;
+            return ptr;
+        }
+    }
+
+    arena->last = ptr;
+    arena->last_size = size;
+    arena->used += size;
+    if (arena->used > arena->peak) {
+        arena->peak = arena->used;
+    }
+
+    return ptr;
+}
+
+static void s2j_arena_free(void *ptr) {
+    S2jArena_t arena = s2j_arena;
+
+    if (!ptr) {
+        return;
+    }
+    /* only the last block is given back, the others are given back by reset */
+    if (ptr == arena->last) {
+        arena->used -= arena->last_size;
+        arena->last = NULL;
+    }
+    if (arena->buf && (uint8_t *) ptr >= arena->buf && (uint8_t *) ptr < arena->buf + arena->size) {
+        return;
+    }
+    s2j_heap_hook.free_fn(ptr);
+}
+
+/**
+ * Use the arena for all cJSON objects and printed texts. The structure objects are still from the heap hook.
+ * @note Call it after s2j_init. The hooks are global, so only one thread can use cJSON at the same time.
+ *
+ * @param arena the arena object, NULL: go back to the heap
+ */
+void s2j_arena_use(S2jArena_t arena) {
+    cJSON_Hooks hooks;
+
+    if (arena && !s2j_arena) {
+        s2j_heap_hook = s2jHook;
+    }
+    s2j_arena = arena;
+    if (arena) {
+        hooks.malloc_fn = s2j_arena_malloc;
+        hooks.free_fn = s2j_arena_free;
+        cJSON_InitHooks(&hooks);
+        /* the printed text is freed by s2jHook.free_fn */
+        s2jHook.malloc_fn = s2j_heap_hook.malloc_fn;
+        s2jHook.free_fn = s2j_arena_free;
+    } else {
+        s2jHook = s2j_heap_hook;
+        cJSON_InitHooks((cJSON_Hooks *) &s2jHook);
+    }
+}
+
+/**
+ * Give back all memory of the used arena after a parse or print.
+ * @note All cJSON objects and printed texts from the arena must NOT be used after it.
+ */
+void s2j_arena_reset(void) {
+    if (s2j_arena) {
+        s2j_arena->used = 0;
+        s2j_arena->last = NULL;
     }
 }
@@ -0,0 +1,486 @@
+/*
+ * This file is part of the struct2json Library.
+ *
+ * Copyright (c) 2015, Armink, <armink.ztl@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Function: The stream parser, it fills the structure object by the element descriptors while reading the
+ *           JSON text. There is no cJSON object and no heap.
+ * Created on: 2026-10-18
+ */
+
+#include <s2j.h>
+
+/* the max length of a number text */
+#define S2J_NUMBER_MAX                32
+/* the max nesting of the skipped JSON value */
+#define S2J_SKIP_DEPTH_MAX            32
+
+/**
+ * Initialize the stream by a JSON text in memory.
+ *
+ * @param stream the stream object
+ * @param json the JSON text
+ * @param len the JSON text length
+ */
+void s2j_stream_init(S2jStream_t stream, const char *json, size_t len) {
+    stream->buf = json;
+    stream->len = len;
+    stream->pos = 0;
+    stream->read = NULL;
+    stream->ctx = NULL;
+}
+
+/**
+ * Initialize the stream by a read callback, the JSON text is read by the S2J_STREAM_WINDOW_SIZE window.
+ *
+ * @param stream the stream object
+ * @param read the read callback, it returns the read size, 0: the JSON text is end
+ * @param ctx the read callback context
+ */
+void s2j_stream_init_reader(S2jStream_t stream, size_t (*read)(void *ctx, char *buf, size_t size), void *ctx) {
+    stream->buf = stream->window;
+    stream->len = 0;
+    stream->pos = 0;
+    stream->read = read;
+    stream->ctx = ctx;
+}
+
+static int stream_peek(S2jStream_t stream) {
+    if (stream->pos >= stream->len) {
+        if (!stream->read || (stream->len = stream->read(stream->ctx, stream->window, sizeof(stream->window))) == 0) {
+            return -1;
+        }
+        stream->buf = stream->window;
+        stream->pos = 0;
+    }
+
+    return (unsigned char) stream->buf[stream->pos];
+}
+
+static int stream_getc(S2jStream_t stream) {
+    int c = stream_peek(stream);
+
+    if (c >= 0) {
+        stream->pos++;
+    }
+
+    return c;
+}
+
+/* skip the white spaces and return the next char */
+static int stream_skip_ws(S2jStream_t stream) {
+    int c;
+
+    while ((c = stream_peek(stream)) == ' ' || c == '\t' || c == '\n' || c == '\r') {
+        stream->pos++;
+    }
+
+    return c;
+}
+
+static int hex_value(int c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/* put a char to the string buffer, the too long string is cut */
+static void string_put(char *dst, size_t size, size_t *len, int c) {
+    if (dst && *len + 1 < size) {
+        dst[(*len)++] = (char) c;
+    }
+}
+
+/* parse the \uXXXX escape to UTF-8 */
+static bool parse_unicode(S2jStream_t stream, char *dst, size_t size, size_t *len) {
+    uint32_t code = 0;
+    int i, v;
+
+    for (i = 0; i < 4; i++) {
+        if ((v = hex_value(stream_getc(stream))) < 0) {
+            return false;
+        }
+        code = (code << 4) | (uint32_t) v;
+    }
+    if (code < 0x80) {
+        string_put(dst, size, len, (int) code);
+    } else if (code < 0x800) {
+        string_put(dst, size, len, 0xC0 | (code >> 6));
+        string_put(dst, size, len, 0x80 | (code & 0x3F));
+    } else {
+        /* the surrogate pair is NOT combined, it's same as cJSON */
+        string_put(dst, size, len, 0xE0 | (code >> 12));
+        string_put(dst, size, len, 0x80 | ((code >> 6) & 0x3F));
+        string_put(dst, size, len, 0x80 | (code & 0x3F));
+    }
+
+    return true;
+}
+
+/* parse the string after the quote to the buffer, the string is skipped when the buffer is NULL */
+static bool parse_string(S2jStream_t stream, char *dst, size_t size) {
+    size_t len = 0, start, copy;
+    int c = -1;
+
+    for (;;) {
+        /* copy the plain chars in the window at once */
+        if (stream_peek(stream) < 0) {
+            break;
+        }
+        for (start = stream->pos; stream->pos < stream->len && stream->buf[stream->pos] != '"'
+                && stream->buf[stream->pos] != '\\'; stream->pos++);
+        if (dst && len + 1 < size) {
+            copy = stream->pos - start < size - len - 1 ? stream->pos - start : size - len - 1;
+            memcpy(dst + len, stream->buf + start, copy);
+            len += copy;
+        }
+        if (stream->pos == stream->len) {
+            continue;
+        }
+        if ((c = stream_getc(stream)) == '"') {
+            break;
+        }
+        switch (c = stream_getc(stream)) {
+        case 'b': c = '\b'; break;
+        case 'f': c = '\f'; break;
+        case 'n': c = '\n'; break;
+        case 'r': c = '\r'; break;
+        case 't': c = '\t'; break;
+        case 'u':
+            if (!parse_unicode(stream, dst, size, &len)) {
+                return false;
+            }
+            continue;
+        case '"': case '\\': case '/': break;
+        default: return false;
+        }
+        string_put(dst, size, &len, c);
+    }
+    if (dst && size) {
+        dst[len] = '\0';
+    }
+
+    return c == '"';
+}
+
+/* the exact powers of 10 for the double */
+static const double pow10_exact[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+    1e20, 1e21, 1e22
+};
+
+/* parse the number to the integer when it's an integer text, else to the double */
+static bool parse_number(S2jStream_t stream, long long *integer, double *number, bool *is_integer) {
+    char text[S2J_NUMBER_MAX];
+    size_t len = 0, digits = 0;
+    unsigned long long mantissa = 0;
+    int c, exp = 0, exp_value = 0, exp_sign = 1;
+    bool negative = false, in_frac = false, in_exp = false;
+
+    *is_integer = true;
+    while ((c = stream_peek(stream)) == '-' || c == '+' || c == '.' || c == 'e' || c == 'E' || (c >= '0' && c <= '9')) {
+        if (len + 1 >= sizeof(text)) {
+            return false;
+        }
+        if (c >= '0' && c <= '9') {
+            if (in_exp) {
+                exp_value = exp_value < 10000 ? exp_value * 10 + (c - '0') : exp_value;
+            } else if (mantissa || c != '0') {
+                mantissa = mantissa * 10 + (unsigned) (c - '0');
+                digits++;
+                exp -= in_frac;
+            } else {
+                exp -= in_frac;
+            }
+        } else if (c == '-' && len == 0) {
+            negative = true;
+        } else if (c == '.') {
+            in_frac = true;
+            *is_integer = false;
+        } else if (c == 'e' || c == 'E') {
+            in_exp = true;
+            *is_integer = false;
+        } else if (c == '-') {
+            exp_sign = -1;
+        }
+        text[len++] = (char) c;
+        stream->pos++;
+    }
+    if (len == 0 || (negative && len == 1)) {
+        return false;
+    }
+    /* the long integer is parsed as the double */
+    if (*is_integer && digits > 18) {
+        *is_integer = false;
+    }
+    if (*is_integer) {
+        *integer = negative ? -(long long) mantissa : (long long) mantissa;
+        *number = (double) *integer;
+        return true;
+    }
+    /* the mantissa and the power of 10 are both exact, so the one division or multiplication is rounded correctly,
+     * the same as strtod, the others are parsed by cJSON_ParseDouble */
+    exp += exp_sign * exp_value;
+    if (digits <= 15 && exp >= -22 && exp <= 22) {
+        *number = exp < 0 ? (double) mantissa / pow10_exact[-exp] : (double) mantissa * pow10_exact[exp];
+        if (negative) {
+            *number = -*number;
+        }
+    } else {
+        text[len] = '\0';
+        *number = cJSON_ParseDouble(text, NULL);
+    }
+    *integer = (long long) *number;
+
+    return true;
+}
+
+/* parse the literal (true, false, null) */
+static bool parse_literal(S2jStream_t stream, const char *literal) {
+    for (; *literal; literal++) {
+        if (stream_getc(stream) != *literal) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* skip a JSON value, the nested object and array are skipped by the depth */
+static bool skip_value(S2jStream_t stream) {
+    char closing[S2J_SKIP_DEPTH_MAX];
+    size_t depth = 0;
+    long long integer;
+    double number;
+    bool is_integer;
+    int c;
+
+    do {
+        c = stream_skip_ws(stream);
+        if (c == '{' || c == '[') {
+            if (depth == S2J_SKIP_DEPTH_MAX) {
+                return false;
+            }
+            closing[depth++] = c == '{' ? '}' : ']';
+            stream->pos++;
+            continue;
+        }
+        if (depth && c == closing[depth - 1]) {
+            stream->pos++;
+            depth--;
+        } else if (c == '"') {
+            stream->pos++;
+            if (!parse_string(stream, NULL, 0)) {
+                return false;
+            }
+        } else if (c == 't' || c == 'f' || c == 'n') {
+            if (!parse_literal(stream, c == 't' ? "true" : c == 'f' ? "false" : "null")) {
+                return false;
+            }
+        } else if (!parse_number(stream, &integer, &number, &is_integer)) {
+            return false;
+        }
+        /* the item separator or the key separator in the skipped object */
+        if (depth) {
+            c = stream_skip_ws(stream);
+            if (c == ',' || c == ':') {
+                stream->pos++;
+            } else if (c != closing[depth - 1]) {
+                return false;
+            }
+        }
+    } while (depth);
+
+    return true;
+}
+
+static void store_integer(void *dst, size_t size, long long value) {
+    switch (size) {
+    case 1: *(uint8_t *) dst = (uint8_t) value; break;
+    case 2: *(uint16_t *) dst = (uint16_t) value; break;
+    case 4: *(uint32_t *) dst = (uint32_t) value; break;
+    case 8: *(uint64_t *) dst = (uint64_t) value; break;
+    default: break;
+    }
+}
+
+static void store_double(void *dst, size_t size, double value) {
+    if (size == sizeof(float)) {
+        *(float *) dst = (float) value;
+    } else if (size == sizeof(double)) {
+        *(double *) dst = value;
+    }
+}
+
+static bool parse_object(S2jStream_t stream, const S2jField *fields, size_t fields_num, uint8_t *struct_obj);
+
+/* parse a value to the element or an array item, the mismatched value is skipped */
+static bool parse_item(S2jStream_t stream, const S2jField *field, uint8_t *dst) {
+    long long integer;
+    double number;
+    bool is_integer;
+    int c = stream_skip_ws(stream);
+
+    switch (field->type) {
+    case S2J_FIELD_int:
+    case S2J_FIELD_double:
+        if (c == 't' || c == 'f') {
+            if (!parse_literal(stream, c == 't' ? "true" : "false")) {
+                return false;
+            }
+            integer = c == 't';
+            number = (double) integer;
+        } else if (c == '-' || (c >= '0' && c <= '9')) {
+            if (!parse_number(stream, &integer, &number, &is_integer)) {
+                return false;
+            }
+        } else {
+            return skip_value(stream);
+        }
+        if (field->type == S2J_FIELD_int) {
+            store_integer(dst, field->size, integer);
+        } else {
+            store_double(dst, field->size, number);
+        }
+        return true;
+    case S2J_FIELD_string:
+        if (c != '"') {
+            return skip_value(stream);
+        }
+        stream->pos++;
+        return parse_string(stream, (char *) dst, field->size);
+    case S2J_FIELD_struct:
+        if (c != '{') {
+            return skip_value(stream);
+        }
+        return parse_object(stream, field->fields, field->fields_num, dst);
+    }
+
+    return false;
+}
+
+/* parse the array to the array element, the items more than the array element are skipped */
+static bool parse_array(S2jStream_t stream, const S2jField *field, uint8_t *dst) {
+    size_t index = 0;
+    int c;
+
+    if (stream_skip_ws(stream) != '[') {
+        return skip_value(stream);
+    }
+    stream->pos++;
+    if (stream_skip_ws(stream) == ']') {
+        stream->pos++;
+        return true;
+    }
+    for (;;) {
+        if (index < field->count) {
+            if (!parse_item(stream, field, dst + index * field->size)) {
+                return false;
+            }
+        } else if (!skip_value(stream)) {
+            return false;
+        }
+        index++;
+        c = stream_skip_ws(stream);
+        stream->pos++;
+        if (c == ']') {
+            return true;
+        } else if (c != ',') {
+            return false;
+        }
+    }
+}
+
+static const S2jField *find_field(const S2jField *fields, size_t fields_num, const char *name) {
+    size_t i;
+
+    for (i = 0; i < fields_num; i++) {
+        if (!strcmp(fields[i].name, name)) {
+            return &fields[i];
+        }
+    }
+
+    return NULL;
+}
+
+static bool parse_object(S2jStream_t stream, const S2jField *fields, size_t fields_num, uint8_t *struct_obj) {
+    char key[S2J_STREAM_KEY_MAX + 1];
+    const S2jField *field;
+    bool ok;
+    int c;
+
+    if (stream_skip_ws(stream) != '{') {
+        return false;
+    }
+    stream->pos++;
+    if (stream_skip_ws(stream) == '}') {
+        stream->pos++;
+        return true;
+    }
+    for (;;) {
+        if (stream_getc(stream) != '"' || !parse_string(stream, key, sizeof(key)) || stream_skip_ws(stream) != ':') {
+            return false;
+        }
+        stream->pos++;
+        /* the key which is cut is NOT matched */
+        field = strlen(key) < S2J_STREAM_KEY_MAX ? find_field(fields, fields_num, key) : NULL;
+        if (!field) {
+            ok = skip_value(stream);
+        } else if (field->count) {
+            ok = parse_array(stream, field, struct_obj + field->offset);
+        } else {
+            ok = parse_item(stream, field, struct_obj + field->offset);
+        }
+        if (!ok) {
+            return false;
+        }
+        c = stream_skip_ws(stream);
+        stream->pos++;
+        if (c == '}') {
+            return true;
+        } else if (c != ',' || stream_skip_ws(stream) != '"') {
+            return false;
+        }
+    }
+}
+
+/**
+ * Parse the JSON object in the stream to the structure object by the element descriptors.
+ * The unknown elements are skipped, the missing elements are NOT changed, the too long string is cut and the
+ * array items more than the array element are skipped.
+ * @note The structure object maybe partly filled when the JSON text has an error.
+ *
+ * @param stream the stream object
+ * @param fields the element descriptors which are made by the s2j_field_xxx macros
+ * @param fields_num the element descriptors number
+ * @param struct_obj the structure object
+ *
+ * @return true: the JSON object is parsed OK
+ */
+bool s2j_stream_to_struct(S2jStream_t stream, const S2jField *fields, size_t fields_num, void *struct_obj) {
+    return parse_object(stream, fields, fields_num, struct_obj);
+}
@@ -30,6 +30,37 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include "osif.h"
+
+#if defined(EF_PORT_USING_MX25L6433F) && defined(EF_PORT_USING_DFLASH)
+#error "only one flash backend can be used"
+#elif defined(EF_PORT_USING_MX25L6433F) || defined(EF_PORT_USING_DFLASH)
+#define EF_PORT_USING_FLASH
+#include "ef_port_flash.h"
+#endif
+
+#ifdef EF_PORT_USING_MX25L6433F
+#include "flash_mx25l6433f_driver.h"
+
+/* the QuadSPI instance of the MX25L6433F, the QuadSPI must be initialized by QSPI_DRV_Init before easyflash_init */
+#ifndef EF_PORT_MX25L6433F_INSTANCE
+#define EF_PORT_MX25L6433F_INSTANCE              0
+#endif
+
+/* the MX25L6433F is 8 MB, it's programmed by the 256 bytes page and erased by the 4 KB sector */
+#define MX25L6433F_SIZE                          (8 * 1024 * 1024)
+#define MX25L6433F_PAGE_SIZE                     256
+#define MX25L6433F_SECTOR_SIZE                   4096
+#endif /* EF_PORT_USING_MX25L6433F */
+
+#ifdef EF_PORT_USING_DFLASH
+#include "flash_driver.h"
+
+/* the D-Flash (FlexNVM) is programmed by the 8 bytes phrase, a phrase can NOT be programmed twice before erase */
+#if (EF_WRITE_GRAN != 64)
+#error "the D-Flash backend needs the EF_WRITE_GRAN 64"
+#endif
+#endif /* EF_PORT_USING_DFLASH */
 
 /* default environment variables set for user */
 static const ef_env default_env_set[] = {
@@ -42,6 +73,106 @@ static const ef_env default_env_set[] = {
 
 static char log_buf[128];
 
+/* The ENV lock is a writer preferred reader/writer lock. The writer holds the write semaphore, the first reader
+ * takes it for all readers and the last reader gives it back. The waiting writer holds the turnstile, so the
+ * new readers wait behind it. */
+static mutex_t env_turnstile;
+static mutex_t env_reader_mutex;
+static semaphore_t env_write_sem;
+static size_t env_readers = 0;
+
+#ifdef EF_PORT_USING_MX25L6433F
+static flash_mx25l6433f_state_t mx25_state;
+static const flash_mx25l6433f_user_config_t mx25_cfg = {
+    .dmaSupport = false,
+    .outputDriverStrength = FLASH_MX25L6433F_DRV_STRENGTH_HIGH,
+};
+
+/* the driver only launches the command, so wait for the QuadSPI transfer and the flash operation */
+static EfErrCode mx25_wait(status_t status, EfErrCode err) {
+    while (status == STATUS_SUCCESS
+            && (status = FLASH_MX25L6433F_DRV_GetStatus(EF_PORT_MX25L6433F_INSTANCE)) == STATUS_BUSY);
+
+    return status == STATUS_SUCCESS ? EF_NO_ERR : err;
+}
+
+static EfErrCode mx25_read(uint32_t addr, void *buf, size_t size) {
+    return mx25_wait(FLASH_MX25L6433F_DRV_Read(EF_PORT_MX25L6433F_INSTANCE, addr, buf, size), EF_READ_ERR);
+}
+
+static EfErrCode mx25_program(uint32_t addr, const void *buf, size_t size) {
+    /* the driver doesn't change the data */
+    return mx25_wait(FLASH_MX25L6433F_DRV_Program(EF_PORT_MX25L6433F_INSTANCE, addr, (uint8_t *) buf, size),
+            EF_WRITE_ERR);
+}
+
+static EfErrCode mx25_erase(uint32_t addr) {
+    return mx25_wait(FLASH_MX25L6433F_DRV_Erase4K(EF_PORT_MX25L6433F_INSTANCE, addr), EF_ERASE_ERR);
+}
+
+#ifdef EF_ENV_USING_RW_LOCK
+/* the concurrent ENV readers share the read ahead buffer */
+static mutex_t read_ahead_mutex;
+
+static void read_ahead_lock(void) {
+    OSIF_MutexLock(&read_ahead_mutex, OSIF_WAIT_FOREVER);
+}
+
+static void read_ahead_unlock(void) {
+    OSIF_MutexUnlock(&read_ahead_mutex);
+}
+#endif /* EF_ENV_USING_RW_LOCK */
+
+/* the flash area is from EF_START_ADDR to the flash end */
+static const struct ef_port_flash port_flash = {
+    .size = MX25L6433F_SIZE - EF_START_ADDR,
+    .sector_size = MX25L6433F_SECTOR_SIZE,
+    .page_size = MX25L6433F_PAGE_SIZE,
+    .prog_unit = 1,
+    .read_ahead = EF_PORT_READ_AHEAD_SIZE,
+    .mapped = NULL,
+    .read = mx25_read,
+    .program = mx25_program,
+    .erase = mx25_erase,
+#ifdef EF_ENV_USING_RW_LOCK
+    .lock = read_ahead_lock,
+    .unlock = read_ahead_unlock,
+#endif
+};
+#endif /* EF_PORT_USING_MX25L6433F */
+
+#ifdef EF_PORT_USING_DFLASH
+static flash_ssd_config_t dflash_ssd_cfg;
+static const flash_user_config_t dflash_user_cfg = {
+    .PFlashBase = 0,
+    .PFlashSize = FEATURE_FLS_PF_BLOCK_SIZE,
+    .DFlashBase = FEATURE_FLS_DF_START_ADDRESS,
+    .EERAMBase = FEATURE_FLS_FLEX_RAM_START_ADDRESS,
+    .CallBack = NULL_CALLBACK,
+};
+
+static EfErrCode dflash_program(uint32_t addr, const void *buf, size_t size) {
+    return FLASH_DRV_Program(&dflash_ssd_cfg, addr, size, buf) == STATUS_SUCCESS ? EF_NO_ERR : EF_WRITE_ERR;
+}
+
+static EfErrCode dflash_erase(uint32_t addr) {
+    return FLASH_DRV_EraseSector(&dflash_ssd_cfg, addr, FEATURE_FLS_DF_BLOCK_SECTOR_SIZE) == STATUS_SUCCESS ? EF_NO_ERR
+            : EF_ERASE_ERR;
+}
+
+/* the flash area size is set by the D-Flash partition, the D-Flash is memory mapped, so it's read by the CPU */
+static struct ef_port_flash port_flash = {
+    .sector_size = FEATURE_FLS_DF_BLOCK_SECTOR_SIZE,
+    .page_size = FEATURE_FLS_DF_BLOCK_SECTOR_SIZE,
+    .prog_unit = FEATURE_FLS_DF_BLOCK_WRITE_UNIT_SIZE,
+    .read_ahead = 0,
+    .mapped = (const uint8_t *) EF_START_ADDR,
+    .read = NULL,
+    .program = dflash_program,
+    .erase = dflash_erase,
+};
+#endif /* EF_PORT_USING_DFLASH */
+
 /**
  * Flash port for hardware initialize.
  *
@@ -56,6 +187,38 @@ EfErrCode ef_port_init(ef_env const **default_env, size_t *default_env_size) {
     *default_env = default_env_set;
     *default_env_size = sizeof(default_env_set) / sizeof(default_env_set[0]);
 
+    if (OSIF_MutexCreate(&env_turnstile) != STATUS_SUCCESS || OSIF_MutexCreate(&env_reader_mutex) != STATUS_SUCCESS
+            || OSIF_SemaCreate(&env_write_sem, 1) != STATUS_SUCCESS) {
+        result = EF_ENV_INIT_FAILED;
+    }
+
+#ifdef EF_PORT_USING_MX25L6433F
+#ifdef EF_ENV_USING_RW_LOCK
+    if (OSIF_MutexCreate(&read_ahead_mutex) != STATUS_SUCCESS) {
+        result = EF_ENV_INIT_FAILED;
+    }
+#endif
+    if (FLASH_MX25L6433F_DRV_Init(EF_PORT_MX25L6433F_INSTANCE, &mx25_cfg, &mx25_state) != STATUS_SUCCESS) {
+        result = EF_ENV_INIT_FAILED;
+    }
+#endif /* EF_PORT_USING_MX25L6433F */
+
+#ifdef EF_PORT_USING_DFLASH
+    /* the EasyFlash area must be in the D-Flash partition of the FlexNVM */
+    if (FLASH_DRV_Init(&dflash_user_cfg, &dflash_ssd_cfg) != STATUS_SUCCESS || EF_START_ADDR < dflash_ssd_cfg.DFlashBase
+            || EF_START_ADDR >= dflash_ssd_cfg.DFlashBase + dflash_ssd_cfg.DFlashSize) {
+        result = EF_ENV_INIT_FAILED;
+    } else {
+        port_flash.size = dflash_ssd_cfg.DFlashBase + dflash_ssd_cfg.DFlashSize - EF_START_ADDR;
+    }
+#endif /* EF_PORT_USING_DFLASH */
+
+#ifdef EF_PORT_USING_FLASH
+    if (result == EF_NO_ERR) {
+        ef_port_flash_init(&port_flash);
+    }
+#endif
+
     return result;
 }
 
@@ -70,6 +233,9 @@ EfErrCode ef_port_init(ef_env const **default_env, size_t *default_env_size) {
  * @return result
  */
 EfErrCode ef_port_read(uint32_t addr, uint32_t *buf, size_t size) {
+#ifdef EF_PORT_USING_FLASH
+    return ef_port_flash_read(addr, buf, size);
+#else
     EfErrCode result = EF_NO_ERR;
     uint8_t *buf_8 = (uint8_t *)buf;
     size_t i;
@@ -80,6 +246,24 @@ EfErrCode ef_port_read(uint32_t addr, uint32_t *buf, size_t size) {
     }
 
     return result;
+#endif /* EF_PORT_USING_FLASH */
+}
+
+/**
+ * Get the CPU address of the memory mapped flash.
+ *
+ * @param addr flash address
+ * @param size mapped bytes size
+ *
+ * @return the mapped address, NULL: the flash is NOT mapped
+ */
+const void *ef_port_map(uint32_t addr, size_t size) {
+#ifdef EF_PORT_USING_FLASH
+    return ef_port_flash_map(addr, size);
+#else
+    /* the on-chip flash is mapped at the same address */
+    return (const void *) addr;
+#endif /* EF_PORT_USING_FLASH */
 }
 
 /**
@@ -93,6 +277,9 @@ EfErrCode ef_port_read(uint32_t addr, uint32_t *buf, size_t size) {
  * @return result
  */
 EfErrCode ef_port_erase(uint32_t addr, size_t size) {
+#ifdef EF_PORT_USING_FLASH
+    return ef_port_flash_erase(addr, size);
+#else
     EfErrCode result = EF_NO_ERR;
 
     /* make sure the start address is a multiple of EF_ERASE_MIN_SIZE */
@@ -105,6 +292,7 @@ EfErrCode ef_port_erase(uint32_t addr, size_t size) {
     }
 
     return result;
+#endif /* EF_PORT_USING_FLASH */
 }
 /**
  * Write data to flash.
@@ -118,6 +306,9 @@ EfErrCode ef_port_erase(uint32_t addr, size_t size) {
  * @return result
  */
 EfErrCode ef_port_write(uint32_t addr, const uint32_t *buf, size_t size) {
+#ifdef EF_PORT_USING_FLASH
+    return ef_port_flash_write(addr, buf, size);
+#else
     EfErrCode result = EF_NO_ERR;
     uint8_t *buf_8 = (uint8_t *)buf;
     size_t i;
@@ -129,24 +320,59 @@ EfErrCode ef_port_write(uint32_t addr, const uint32_t *buf, size_t size) {
 
 
     return result;
+#endif /* EF_PORT_USING_FLASH */
+}
+
+/**
+ * Get the current time for the incremental GC step time limit.
+ *
+ * @return time in microseconds
+ */
+uint32_t ef_port_get_time_us(void) {
+    /* the OSIF only has millisecond resolution, the OSIF timer must be started by OSIF_TimeDelay(0) */
+    return OSIF_GetMilliseconds() * 1000;
 }
 
 /**
  * lock the ENV ram cache
  */
 void ef_port_env_lock(void) {
-    
-    /* You can add your code under here. */
-    
+    OSIF_MutexLock(&env_turnstile, OSIF_WAIT_FOREVER);
+    OSIF_SemaWait(&env_write_sem, OSIF_WAIT_FOREVER);
+    OSIF_MutexUnlock(&env_turnstile);
 }
 
 /**
  * unlock the ENV ram cache
  */
 void ef_port_env_unlock(void) {
-    
-    /* You can add your code under here. */
-    
+    OSIF_SemaPost(&env_write_sem);
+}
+
+/**
+ * lock the ENV ram cache for read, the readers don't block each other
+ */
+void ef_port_env_read_lock(void) {
+    /* wait for the writer which is waiting or writing */
+    OSIF_MutexLock(&env_turnstile, OSIF_WAIT_FOREVER);
+    OSIF_MutexUnlock(&env_turnstile);
+
+    OSIF_MutexLock(&env_reader_mutex, OSIF_WAIT_FOREVER);
+    if (++env_readers == 1) {
+        OSIF_SemaWait(&env_write_sem, OSIF_WAIT_FOREVER);
+    }
+    OSIF_MutexUnlock(&env_reader_mutex);
+}
+
+/**
+ * unlock the ENV ram cache for read
+ */
+void ef_port_env_read_unlock(void) {
+    OSIF_MutexLock(&env_reader_mutex, OSIF_WAIT_FOREVER);
+    if (--env_readers == 0) {
+        OSIF_SemaPost(&env_write_sem);
+    }
+    OSIF_MutexUnlock(&env_reader_mutex);
 }
 
 
@@ -0,0 +1,234 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Buffered flash backend of the port, @see ef_port_flash.h.
+ * Created on: 2026-10-18
+ */
+
+#include <easyflash.h>
+#include <string.h>
+#include "ef_port_flash.h"
+
+static const struct ef_port_flash *port_flash = NULL;
+static struct ef_port_flash_stats port_flash_stats;
+/* the read ahead buffer, it's the flash data from the cached address */
+static uint32_t read_ahead_buf[EF_PORT_READ_AHEAD_SIZE / 4];
+static uint32_t read_ahead_addr;
+static size_t read_ahead_len = 0;
+
+/**
+ * Set the flash device of the buffered backend. It's called by ef_port_init.
+ *
+ * @param flash the flash device, it must be kept until the flash is NOT used
+ */
+void ef_port_flash_init(const struct ef_port_flash *flash) {
+    EF_ASSERT(flash);
+    EF_ASSERT(flash->sector_size && EF_ERASE_MIN_SIZE % flash->sector_size == 0);
+    EF_ASSERT(flash->page_size && flash->prog_unit && flash->page_size % flash->prog_unit == 0);
+    EF_ASSERT(flash->read_ahead <= EF_PORT_READ_AHEAD_SIZE);
+
+    port_flash = flash;
+    read_ahead_len = 0;
+    memset(&port_flash_stats, 0, sizeof(port_flash_stats));
+}
+
+static bool port_flash_in_range(uint32_t addr, size_t size) {
+    return addr >= EF_START_ADDR && size <= port_flash->size && addr - EF_START_ADDR <= port_flash->size - size;
+}
+
+static void port_flash_lock(void) {
+    if (port_flash->lock) {
+        port_flash->lock();
+    }
+}
+
+static void port_flash_unlock(void) {
+    if (port_flash->unlock) {
+        port_flash->unlock();
+    }
+}
+
+/* the overlapped part of the read ahead buffer and the flash range, return the buffer offset and the length */
+static size_t read_ahead_overlap(uint32_t addr, size_t size, size_t *buf_offset) {
+    uint32_t start = addr > read_ahead_addr ? addr : read_ahead_addr;
+    uint32_t end = addr + size < read_ahead_addr + read_ahead_len ? addr + size : read_ahead_addr + read_ahead_len;
+
+    if (read_ahead_len == 0 || start >= end) {
+        return 0;
+    }
+    *buf_offset = start - read_ahead_addr;
+
+    return end - start;
+}
+
+/**
+ * Read data from flash. The memory mapped flash is read by the CPU, the short read of the other flash is served
+ * by the read ahead buffer, which is filled by one device read from the read address.
+ *
+ * @param addr flash address
+ * @param buf buffer to store read data
+ * @param size read bytes size
+ *
+ * @return result
+ */
+EfErrCode ef_port_flash_read(uint32_t addr, uint32_t *buf, size_t size) {
+    EfErrCode result = EF_NO_ERR;
+    size_t fill_size;
+
+    EF_ASSERT(port_flash);
+
+    if (!port_flash_in_range(addr, size)) {
+        return EF_READ_ERR;
+    }
+    if (port_flash->mapped) {
+        memcpy(buf, port_flash->mapped + (addr - EF_START_ADDR), size);
+        return EF_NO_ERR;
+    }
+    if (size >= port_flash->read_ahead) {
+        return port_flash->read(addr, buf, size);
+    }
+
+    port_flash_lock();
+    port_flash_stats.reads++;
+    if (read_ahead_len && addr >= read_ahead_addr && addr + size <= read_ahead_addr + read_ahead_len) {
+        port_flash_stats.read_hits++;
+    } else {
+        /* the EasyFlash reads go forward, so the buffer starts from the read address */
+        fill_size = port_flash->size - (addr - EF_START_ADDR);
+        if (fill_size > port_flash->read_ahead) {
+            fill_size = port_flash->read_ahead;
+        }
+        read_ahead_len = 0;
+        result = port_flash->read(addr, read_ahead_buf, fill_size);
+        if (result == EF_NO_ERR) {
+            read_ahead_addr = addr;
+            read_ahead_len = fill_size;
+        }
+    }
+    if (result == EF_NO_ERR) {
+        memcpy(buf, (uint8_t *) read_ahead_buf + (addr - read_ahead_addr), size);
+    }
+    port_flash_unlock();
+
+    return result;
+}
+
+/**
+ * Write data to flash. It's split to one program command per device page, the read ahead buffer is updated
+ * like the flash, so the program only clears the bits of it.
+ * @note The address and the size must be aligned by the device program unit, @see EF_WRITE_GRAN.
+ *
+ * @param addr flash address
+ * @param buf the write data buffer
+ * @param size write bytes size
+ *
+ * @return result
+ */
+EfErrCode ef_port_flash_write(uint32_t addr, const uint32_t *buf, size_t size) {
+    EfErrCode result = EF_NO_ERR;
+    const uint8_t *data = (const uint8_t *) buf;
+    size_t prog_size, buf_offset, overlap, i;
+
+    EF_ASSERT(port_flash);
+    EF_ASSERT((addr - EF_START_ADDR) % port_flash->prog_unit == 0 && size % port_flash->prog_unit == 0);
+
+    if (!port_flash_in_range(addr, size)) {
+        return EF_WRITE_ERR;
+    }
+
+    port_flash_lock();
+    while (size) {
+        prog_size = port_flash->page_size - addr % port_flash->page_size;
+        if (prog_size > size) {
+            prog_size = size;
+        }
+        result = port_flash->program(addr, data, prog_size);
+        port_flash_stats.programs++;
+        overlap = read_ahead_overlap(addr, prog_size, &buf_offset);
+        if (result != EF_NO_ERR) {
+            /* the failed program may change some bits */
+            if (overlap) {
+                read_ahead_len = 0;
+            }
+            break;
+        }
+        for (i = 0; i < overlap; i++) {
+            ((uint8_t *) read_ahead_buf)[buf_offset + i] &= data[read_ahead_addr + buf_offset + i - addr];
+        }
+        addr += prog_size;
+        data += prog_size;
+        size -= prog_size;
+    }
+    port_flash_unlock();
+
+    return result;
+}
+
+/**
+ * Erase data on flash. The EasyFlash erase size may be several device sectors.
+ *
+ * @param addr flash address
+ * @param size erase bytes size
+ *
+ * @return result
+ */
+EfErrCode ef_port_flash_erase(uint32_t addr, size_t size) {
+    EfErrCode result = EF_NO_ERR;
+    size_t i, buf_offset, erase_size;
+
+    EF_ASSERT(port_flash);
+    /* make sure the start address is a multiple of the device erase size */
+    EF_ASSERT((addr - EF_START_ADDR) % port_flash->sector_size == 0);
+
+    if (!port_flash_in_range(addr, size)) {
+        return EF_ERASE_ERR;
+    }
+
+    port_flash_lock();
+    /* the whole device sector is erased even if the size is not aligned, the read ahead buffer is dropped */
+    erase_size = (size + port_flash->sector_size - 1) / port_flash->sector_size * port_flash->sector_size;
+    if (read_ahead_overlap(addr, erase_size, &buf_offset)) {
+        read_ahead_len = 0;
+    }
+    for (i = 0; i < size && result == EF_NO_ERR; i += port_flash->sector_size) {
+        result = port_flash->erase(addr + i);
+        port_flash_stats.erases++;
+    }
+    port_flash_unlock();
+
+    return result;
+}
+
+/**
+ * Get the CPU address of the memory mapped flash.
+ *
+ * @param addr flash address
+ * @param size mapped bytes size
+ *
+ * @return the mapped address, NULL: the flash is NOT mapped
+ */
+const void *ef_port_flash_map(uint32_t addr, size_t size) {
+    EF_ASSERT(port_flash);
+
+    if (!port_flash->mapped || !port_flash_in_range(addr, size)) {
+        return NULL;
+    }
+
+    return port_flash->mapped + (addr - EF_START_ADDR);
+}
+
+/**
+ * Get the statistics of the buffered backend.
+ *
+ * @param stats the statistics
+ */
+void ef_port_flash_get_stats(struct ef_port_flash_stats *stats) {
+    *stats = port_flash_stats;
+}
+
+/**
+ * Reset the statistics of the buffered backend.
+ */
+void ef_port_flash_reset_stats(void) {
+    memset(&port_flash_stats, 0, sizeof(port_flash_stats));
+}
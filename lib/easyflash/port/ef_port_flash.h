@@ -0,0 +1,62 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Buffered flash backend of the port. The short reads are served by a read ahead buffer, and the
+ *           write is programmed by the page aligned commands. The device erase size and page size are described
+ *           by the backend, so EF_ERASE_MIN_SIZE can be any multiple of the device erase size.
+ * Created on: 2026-10-18
+ */
+
+#ifndef EF_PORT_FLASH_H_
+#define EF_PORT_FLASH_H_
+
+#include <easyflash.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* the read ahead buffer size, the read which is shorter than the read ahead size is served by the buffer */
+#ifndef EF_PORT_READ_AHEAD_SIZE
+#define EF_PORT_READ_AHEAD_SIZE                  256
+#endif
+
+/* the flash device under the EasyFlash area, all addresses are the EasyFlash addresses */
+struct ef_port_flash {
+    size_t size;                                 /**< the flash area size from EF_START_ADDR */
+    size_t sector_size;                          /**< the device erase size, EF_ERASE_MIN_SIZE is a multiple of it */
+    size_t page_size;                            /**< the device program page size, a program never crosses a page */
+    size_t prog_unit;                            /**< the program address and size alignment, 1: NOR flash */
+    size_t read_ahead;                           /**< the read ahead size (up to EF_PORT_READ_AHEAD_SIZE), 0: disable */
+    const uint8_t *mapped;                       /**< the CPU address of EF_START_ADDR, NULL: NOT memory mapped */
+    /* read from the device */
+    EfErrCode (*read)(uint32_t addr, void *buf, size_t size);
+    /* program inside one page, the program is finished when it returns */
+    EfErrCode (*program)(uint32_t addr, const void *buf, size_t size);
+    /* erase one device sector, the erase is finished when it returns */
+    EfErrCode (*erase)(uint32_t addr);
+    /* the read ahead buffer lock for the concurrent ENV readers (EF_ENV_USING_RW_LOCK), NULL: no lock */
+    void (*lock)(void);
+    void (*unlock)(void);
+};
+
+struct ef_port_flash_stats {
+    uint32_t reads;                              /**< the reads which are shorter than the read ahead size */
+    uint32_t read_hits;                          /**< the reads which are served by the read ahead buffer */
+    uint32_t programs;                           /**< the device program commands */
+    uint32_t erases;                             /**< the device sector erases */
+};
+
+void ef_port_flash_init(const struct ef_port_flash *flash);
+EfErrCode ef_port_flash_read(uint32_t addr, uint32_t *buf, size_t size);
+EfErrCode ef_port_flash_write(uint32_t addr, const uint32_t *buf, size_t size);
+EfErrCode ef_port_flash_erase(uint32_t addr, size_t size);
+const void *ef_port_flash_map(uint32_t addr, size_t size);
+void ef_port_flash_get_stats(struct ef_port_flash_stats *stats);
+void ef_port_flash_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EF_PORT_FLASH_H_ */
@@ -29,6 +29,10 @@
 #include <string.h>
 #include <easyflash.h>
 
+#if defined(EF_ENV_SCAN_USING_SSE2) && defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #if defined(EF_USING_ENV) && !defined(EF_ENV_USING_LEGACY_MODE)
 
 #ifndef EF_WRITE_GRAN
@@ -43,6 +47,8 @@
 #define SECTOR_MAGIC_WORD                        0x30344645
 /* magic word(`K`, `V`, `4`, `0`) */
 #define ENV_MAGIC_WORD                           0x3034564B
+/* magic word(`S`, `N`, `4`, `0`) */
+#define SNAPSHOT_MAGIC_WORD                      0x30344E53
 
 /* the using status sector table length */
 #ifndef USING_SECTOR_TABLE_LEN
@@ -64,6 +70,26 @@
 #define EF_GC_EMPTY_SEC_THRESHOLD                1
 #endif
 
+/* the max ENV move number of an incremental GC step, @see EF_ENV_USING_INCREMENTAL_GC */
+#ifndef EF_GC_STEP_MOVE_MAX
+#define EF_GC_STEP_MOVE_MAX                      4
+#endif
+
+/* the max time (us) of an incremental GC step, 0: no limit. The ef_port_get_time_us must be implemented when using it. */
+#ifndef EF_GC_STEP_TIME_US
+#define EF_GC_STEP_TIME_US                       0
+#endif
+
+/* the idle GC step starts to collect a dirty sector when the remain empty sector is less than or equal to it */
+#ifndef EF_GC_IDLE_EMPTY_SEC_THRESHOLD
+#define EF_GC_IDLE_EMPTY_SEC_THRESHOLD           (EF_GC_EMPTY_SEC_THRESHOLD + 1)
+#endif
+
+/* the erase count difference which triggers the static wear leveling, @see EF_ENV_USING_WEAR_LEVELING */
+#ifndef EF_ENV_WL_THRESHOLD
+#define EF_ENV_WL_THRESHOLD                      32
+#endif
+
 /* the ENV cache table size, it will improve ENV search speed when using cache */
 #ifndef EF_ENV_CACHE_TABLE_SIZE
 #define EF_ENV_CACHE_TABLE_SIZE                  16
@@ -74,6 +100,64 @@
 #define EF_SECTOR_CACHE_TABLE_SIZE               4
 #endif
 
+/* the ENV index table size, it's a full open addressing hash index for all ENV, 0: disable.
+ * Every entry costs 8 bytes RAM, the index can hold 3/4 of the table size ENV at most.
+ * When the index is enabled, every ENV get only need one flash read. */
+#ifndef EF_ENV_INDEX_TABLE_SIZE
+#define EF_ENV_INDEX_TABLE_SIZE                  0
+#endif
+
+/* the write buffer size of the ENV batch commit, every flash write is up to this size */
+#ifndef EF_ENV_BATCH_BUF_SIZE
+#define EF_ENV_BATCH_BUF_SIZE                    64
+#endif
+
+/* the max value length of the write back cache ENV, the longer value is written through */
+#ifndef EF_ENV_WB_VALUE_MAX
+#define EF_ENV_WB_VALUE_MAX                      32
+#endif
+
+/* write back the cached ENV after the number of sets, 0: disable */
+#ifndef EF_ENV_WB_DIRTY_MAX
+#define EF_ENV_WB_DIRTY_MAX                      0
+#endif
+
+/* write back the cached ENV at most once every period (ms), 0: disable. The ef_port_get_time_us must be
+ * implemented when using it. */
+#ifndef EF_ENV_WB_PERIOD_MS
+#define EF_ENV_WB_PERIOD_MS                      0
+#endif
+
+/* the ENV snapshot area size, it must be aligned with EF_ERASE_MIN_SIZE */
+#ifndef EF_ENV_SNAPSHOT_SIZE
+#define EF_ENV_SNAPSHOT_SIZE                     EF_ERASE_MIN_SIZE
+#endif
+
+/* the read window of the flash scan on sector traversal, it's on the stack */
+#ifndef EF_ENV_SCAN_BUF_SIZE
+#define EF_ENV_SCAN_BUF_SIZE                     64
+#endif
+
+/* the compare width (1, 4 or 8 bytes) of the flash scan on sector traversal */
+#ifndef EF_ENV_SCAN_WORD_SIZE
+#define EF_ENV_SCAN_WORD_SIZE                    4
+#endif
+
+/* the compressed value buffer size, the value is saved without compression when the compressed value is larger */
+#ifndef EF_ENV_COMPRESS_BUF_SIZE
+#define EF_ENV_COMPRESS_BUF_SIZE                 512
+#endif
+
+/* the value which is shorter than it is NOT compressed */
+#ifndef EF_ENV_COMPRESS_MIN_SIZE
+#define EF_ENV_COMPRESS_MIN_SIZE                 32
+#endif
+
+/* the hash table size of the compressor, every item is 2 bytes */
+#ifndef EF_ENV_COMPRESS_HASH_SIZE
+#define EF_ENV_COMPRESS_HASH_SIZE                256
+#endif
+
 #if EF_ENV_CACHE_TABLE_SIZE > 0xFFFF
 #error "The ENV cache table size must less than 0xFFFF"
 #endif
@@ -82,6 +166,68 @@
 #define EF_ENV_USING_CACHE
 #endif
 
+#if EF_ENV_BATCH_BUF_SIZE % 8 != 0
+#error "The ENV batch buffer size must be aligned by 8"
+#endif
+
+#ifdef EF_ENV_WRITE_BACK_KEYS
+#if EF_ENV_WB_VALUE_MAX % 4 != 0
+#error "The write back cache value max length must be aligned by 4"
+#endif
+#if EF_ENV_WB_PERIOD_MS > 4294967
+#error "The write back period must less than 4294967ms, the ef_port_get_time_us is 32bit"
+#endif
+#define EF_ENV_USING_WRITE_BACK
+#endif
+
+#if EF_ENV_INDEX_TABLE_SIZE > 0
+#if (EF_ENV_INDEX_TABLE_SIZE & (EF_ENV_INDEX_TABLE_SIZE - 1)) != 0
+#error "The ENV index table size must be a power of 2"
+#endif
+#define EF_ENV_USING_INDEX
+#define ENV_INDEX_MAX_USED                       (EF_ENV_INDEX_TABLE_SIZE / 4 * 3)
+#endif
+
+#ifdef EF_ENV_SNAPSHOT_ADDR
+#if EF_ENV_SNAPSHOT_SIZE == 0 || EF_ENV_SNAPSHOT_SIZE % EF_ERASE_MIN_SIZE != 0
+#error "The ENV snapshot area size must be aligned with EF_ERASE_MIN_SIZE"
+#endif
+#if !defined(EF_ENV_USING_INDEX) && !defined(EF_ENV_USING_CACHE)
+#error "The ENV snapshot saves the ENV index or the ENV cache, one of them must be enabled"
+#endif
+#define EF_ENV_USING_SNAPSHOT
+#endif
+
+#if EF_ENV_SCAN_BUF_SIZE < 32 || EF_ENV_SCAN_BUF_SIZE % 16 != 0
+#error "The flash scan buffer size must be aligned by 16 and NOT less than 32"
+#endif
+
+#if EF_ENV_SCAN_WORD_SIZE != 1 && EF_ENV_SCAN_WORD_SIZE != 4 && EF_ENV_SCAN_WORD_SIZE != 8
+#error "The flash scan word size can be only setting as 1, 4 and 8"
+#endif
+
+#if defined(EF_ENV_SCAN_USING_SSE2) && defined(__SSE2__)
+#define ENV_SCAN_USING_SSE2
+#endif
+
+#ifdef EF_ENV_USING_COMPRESS
+#if EF_ENV_COMPRESS_BUF_SIZE == 0 || EF_ENV_COMPRESS_BUF_SIZE % 4 != 0
+#error "The compressed value buffer size must be aligned by 4"
+#endif
+#if (EF_ENV_COMPRESS_HASH_SIZE & (EF_ENV_COMPRESS_HASH_SIZE - 1)) != 0 || EF_ENV_COMPRESS_HASH_SIZE > 0x10000
+#error "The compressor hash table size must be a power of 2 and NOT more than 0x10000"
+#endif
+#endif /* EF_ENV_USING_COMPRESS */
+
+/* the ENV get only takes the reader lock, the readers don't change any RAM state, so they run concurrently */
+#ifdef EF_ENV_USING_RW_LOCK
+#define env_read_lock()                          ef_port_env_read_lock()
+#define env_read_unlock()                        ef_port_env_read_unlock()
+#else
+#define env_read_lock()                          ef_port_env_lock()
+#define env_read_unlock()                        ef_port_env_unlock()
+#endif
+
 /* the sector is not combined value */
 #define SECTOR_NOT_COMBINED                      0xFFFFFFFF
 /* the next address is get failed */
@@ -110,6 +256,7 @@
 #define STORE_STATUS_TABLE_SIZE                  STATUS_TABLE_SIZE(SECTOR_STORE_STATUS_NUM)
 #define DIRTY_STATUS_TABLE_SIZE                  STATUS_TABLE_SIZE(SECTOR_DIRTY_STATUS_NUM)
 #define ENV_STATUS_TABLE_SIZE                    STATUS_TABLE_SIZE(ENV_STATUS_NUM)
+#define SNAPSHOT_STATUS_TABLE_SIZE               STATUS_TABLE_SIZE(SNAPSHOT_STATUS_NUM)
 
 #define SECTOR_SIZE                              EF_ERASE_MIN_SIZE
 #define SECTOR_NUM                               (ENV_AREA_SIZE / (EF_ERASE_MIN_SIZE))
@@ -128,8 +275,30 @@
 #define ENV_MAGIC_OFFSET                         ((unsigned long)(&((struct env_hdr_data *)0)->magic))
 #define ENV_LEN_OFFSET                           ((unsigned long)(&((struct env_hdr_data *)0)->len))
 #define ENV_NAME_LEN_OFFSET                      ((unsigned long)(&((struct env_hdr_data *)0)->name_len))
+/* the magic word scan end of the sector, it's the magic word end of the last ENV header which ends at the sector end */
+#define SECTOR_MAGIC_SCAN_END(sec_addr)          ((sec_addr) + SECTOR_SIZE - (ENV_HDR_DATA_SIZE - ENV_MAGIC_OFFSET) \
+                                                  + sizeof(uint32_t))
+#define SNAPSHOT_HDR_DATA_SIZE                   (EF_WG_ALIGN(sizeof(struct env_snapshot_hdr)))
+#define SNAPSHOT_MAGIC_OFFSET                    ((unsigned long)(&((struct env_snapshot_hdr *)0)->magic))
 
 #define VER_NUM_ENV_NAME                         "__ver_num__"
+/* the batch record ENV name, it only lives during an ENV batch commit */
+#define BATCH_ENV_NAME                           "__batch__"
+/* the set default record ENV name, it lives until all default ENV are created, so the interrupted set default
+ * is found and done again by ef_load_env */
+#define DEFAULT_ENV_NAME                         "__default__"
+
+/* the ENV value is compressed when the flag bit is cleared, the old ENV flags is 0xFF */
+#define ENV_FLAG_COMPRESSED                      0x01
+/* the max value length which can be compressed, @see env_hdr_data.raw_len */
+#define ENV_COMPRESS_MAX_SIZE                    0xFFFF
+/* the LZ dictionary size, the match offset is saved in 1 byte */
+#define ENV_LZ_WINDOW_SIZE                       256
+#define ENV_LZ_MIN_MATCH                         3
+/* the token is (literal length << 4 | match length - ENV_LZ_MIN_MATCH), the 15 is extended by the next bytes */
+#define ENV_LZ_TOKEN_LEN_MAX                     15
+#define ENV_LZ_HASH(p)                           (((uint32_t) (p)[0] | (uint32_t) (p)[1] << 8 | (uint32_t) (p)[2] << 16) \
+                                                  * 2654435761U >> 16 & (EF_ENV_COMPRESS_HASH_SIZE - 1))
 
 enum sector_store_status {
     SECTOR_STORE_UNUSED,
@@ -149,6 +318,15 @@ enum sector_dirty_status {
 };
 typedef enum sector_dirty_status sector_dirty_status_t;
 
+enum env_snapshot_status {
+    SNAPSHOT_UNUSED,
+    SNAPSHOT_PRE_WRITE,
+    SNAPSHOT_VALID,
+    SNAPSHOT_STALE,
+    SNAPSHOT_STATUS_NUM,
+};
+typedef enum env_snapshot_status env_snapshot_status_t;
+
 struct sector_hdr_data {
     struct {
         uint8_t store[STORE_STATUS_TABLE_SIZE];  /**< sector store status @see sector_store_status_t */
@@ -156,7 +334,7 @@ struct sector_hdr_data {
     } status_table;
     uint32_t magic;                              /**< magic word(`E`, `F`, `4`, `0`) */
     uint32_t combined;                           /**< the combined next sector number, 0xFFFFFFFF: not combined */
-    uint32_t reserved;
+    uint32_t erase_count;                        /**< the sector erase count, 0xFFFFFFFF: unknown */
 };
 typedef struct sector_hdr_data *sector_hdr_data_t;
 
@@ -169,6 +347,7 @@ struct sector_meta_data {
     uint32_t addr;                               /**< sector start address */
     uint32_t magic;                              /**< magic word(`E`, `F`, `4`, `0`) */
     uint32_t combined;                           /**< the combined next sector number, 0xFFFFFFFF: not combined */
+    uint32_t erase_count;                        /**< the sector erase count, 0: unknown */
     size_t remain;                               /**< remain size */
     uint32_t empty_env;                          /**< the next empty ENV node start address */
 };
@@ -180,6 +359,8 @@ struct env_hdr_data {
     uint32_t len;                                /**< ENV node total length (header + name + value), must align by EF_WRITE_GRAN */
     uint32_t crc32;                              /**< ENV node crc32(name_len + data_len + name + value) */
     uint8_t name_len;                            /**< name length */
+    uint8_t flags;                               /**< ENV flags, @see ENV_FLAG_COMPRESSED */
+    uint16_t raw_len;                            /**< value length before compression */
     uint32_t value_len;                          /**< value length */
 };
 typedef struct env_hdr_data *env_hdr_data_t;
@@ -197,7 +378,90 @@ struct sector_cache_node {
 };
 typedef struct sector_cache_node *sector_cache_node_t;
 
+struct env_index_node {
+    uint32_t name_crc;                           /**< ENV name's CRC32 value */
+    uint32_t addr;                               /**< ENV node address, FAILED_ADDR: empty entry */
+};
+typedef struct env_index_node *env_index_node_t;
+
+/* the batch record ENV value is an array of it */
+struct env_batch_record {
+    uint32_t new_addr;                           /**< the new ENV node address, FAILED_ADDR: delete the ENV */
+    uint32_t old_addr;                           /**< the old ENV node address, FAILED_ADDR: no old ENV */
+};
+typedef struct env_batch_record *env_batch_record_t;
+
+struct env_batch_writer {
+    uint32_t addr;                               /**< the flash address of the buffer */
+    size_t len;                                  /**< the data length in buffer */
+    uint32_t buf[EF_ENV_BATCH_BUF_SIZE / 4];     /**< the data will be written */
+};
+typedef struct env_batch_writer *env_batch_writer_t;
+
+struct env_lz_reader {
+    uint32_t addr;                               /**< the next read address */
+    uint32_t end;                                /**< the compressed value end address */
+    size_t pos;                                  /**< the next byte position in buffer */
+    size_t len;                                  /**< the data length in buffer */
+    uint32_t buf[8];                             /**< the compressed data read from flash */
+};
+typedef struct env_lz_reader *env_lz_reader_t;
+
+struct env_wb_node {
+    bool valid;                                  /**< the value is cached */
+    bool dirty;                                  /**< the value is NOT written back to flash */
+    size_t value_len;                            /**< value length */
+    uint32_t value[EF_ENV_WB_VALUE_MAX / 4];     /**< value */
+};
+typedef struct env_wb_node *env_wb_node_t;
+
+/* the snapshot data is the sector summary of all sectors, then the key table */
+struct env_snapshot_hdr {
+    uint8_t status_table[SNAPSHOT_STATUS_TABLE_SIZE]; /**< snapshot status, @see env_snapshot_status_t */
+    uint32_t magic;                              /**< magic word(`S`, `N`, `4`, `0`) */
+    uint32_t len;                                /**< snapshot data length */
+    uint32_t crc32;                              /**< snapshot data crc32 */
+    uint32_t key_num;                            /**< key table entry number */
+};
+typedef struct env_snapshot_hdr *env_snapshot_hdr_t;
+
+struct env_snapshot_sector {
+    uint16_t store;                              /**< sector store status @see sector_store_status_t */
+    uint16_t dirty;                              /**< sector dirty status @see sector_dirty_status_t */
+    uint32_t empty_addr;                         /**< the next empty ENV node start address */
+};
+typedef struct env_snapshot_sector *env_snapshot_sector_t;
+
+/* the key table entry is the ENV index entry, or the ENV cache entry which only has 16bit name CRC */
+typedef struct env_index_node env_snapshot_key;
+
+struct gc_select {
+    struct sector_meta_data sector;              /**< the selected sector, the addr is FAILED_ADDR when NOT selected */
+    uint64_t cost;                               /**< the GC cost of the selected sector, @see gc_sector_cost */
+    size_t empty_sec;                            /**< the empty sector number */
+    bool full_only;                              /**< only select the full sector */
+#ifdef EF_ENV_USING_WEAR_LEVELING
+    bool cold;                                   /**< the sector is selected by the static wear leveling */
+    struct sector_meta_data cold_sector;         /**< the least worn full sector, it's NOT dirty usually */
+    uint32_t wear_min;                           /**< the min erase count of all sectors */
+    uint32_t wear_max;                           /**< the max erase count of all sectors */
+#endif
+};
+typedef struct gc_select *gc_select_t;
+
 static void gc_collect(void);
+static EfErrCode align_write(uint32_t addr, const uint32_t *buf, size_t size);
+static EfErrCode create_env_blob(sector_meta_data_t sector, const char *key, const void *value, size_t len,
+        size_t raw_len);
+static bool recovery_env_batch_cb(env_node_obj_t env, void *arg1, void *arg2);
+#ifdef EF_ENV_USING_WRITE_BACK
+static EfErrCode set_env_wb(const char *key, const void *value_buf, size_t buf_len);
+static EfErrCode env_wb_flush(void);
+#endif
+#ifdef EF_ENV_USING_SNAPSHOT
+static void env_snapshot_drop(void);
+static EfErrCode save_env_snapshot(void);
+#endif
 
 /* ENV start address in flash */
 static uint32_t env_start_addr = 0;
@@ -211,6 +475,24 @@ static bool init_ok = false;
 static bool gc_request = false;
 /* is in recovery check status when first reboot */
 static bool in_recovery_check = false;
+/* ENV store generation, it's changed when any ENV is deleted, moved, erased or cached, @see ef_env_ptr_is_valid */
+static uint32_t env_gen = 0;
+/* the max known sector erase count, it's used when the sector erase count is lost */
+static uint32_t sector_wear_max = 0;
+
+#ifdef EF_ENV_USING_WEAR_LEVELING
+/* the static wear leveling is moving the cold ENV, they are moved to the most worn empty sector */
+static bool gc_cold_move = false;
+#endif
+
+#ifdef EF_ENV_USING_INCREMENTAL_GC
+/* the sector which is collecting by the incremental GC, the addr is FAILED_ADDR when no sector */
+static struct sector_meta_data gc_sector;
+/* the last checked ENV in the collecting sector */
+static struct env_node_obj gc_env;
+/* the sector which the ENV are moved to, it's kept for the collection until the collecting sector is formatted */
+static uint32_t gc_dst_sector = FAILED_ADDR;
+#endif /* EF_ENV_USING_INCREMENTAL_GC */
 
 #ifdef EF_ENV_USING_CACHE
 /* ENV cache table */
@@ -219,6 +501,53 @@ struct env_cache_node env_cache_table[EF_ENV_CACHE_TABLE_SIZE] = { 0 };
 struct sector_cache_node sector_cache_table[EF_SECTOR_CACHE_TABLE_SIZE] = { 0 };
 #endif /* EF_ENV_USING_CACHE */
 
+#ifdef EF_ENV_USING_WRITE_BACK
+/* the write back cache ENV names */
+static const char * const env_wb_keys[] = { EF_ENV_WRITE_BACK_KEYS };
+#define ENV_WB_TABLE_SIZE                        (sizeof(env_wb_keys) / sizeof(env_wb_keys[0]))
+/* write back cache table, the node is the same index to env_wb_keys */
+static struct env_wb_node env_wb_table[ENV_WB_TABLE_SIZE];
+/* the cached set number after last write back */
+static size_t env_wb_dirty_count = 0;
+#if EF_ENV_WB_PERIOD_MS > 0
+/* the last write back time (us) */
+static uint32_t env_wb_time = 0;
+#endif
+#endif /* EF_ENV_USING_WRITE_BACK */
+
+#ifdef EF_ENV_USING_SNAPSHOT
+/* the valid snapshot address, FAILED_ADDR: no valid snapshot, the ENV is changed after it */
+static uint32_t snapshot_addr = FAILED_ADDR;
+/* the next snapshot address, FAILED_ADDR: the snapshot area must be erased first */
+static uint32_t snapshot_end = FAILED_ADDR;
+#ifdef EF_ENV_USING_INCREMENTAL_GC
+/* save a snapshot when the idle GC is finished */
+static bool gc_snapshot_request = false;
+#endif
+#endif /* EF_ENV_USING_SNAPSHOT */
+
+#ifdef EF_ENV_USING_COMPRESS
+/* the compressed value which will be written */
+static uint32_t env_lz_buf[EF_ENV_COMPRESS_BUF_SIZE / 4];
+/* the last position of the 3 bytes hash, 0xFFFF: no position */
+static uint16_t env_lz_hash[EF_ENV_COMPRESS_HASH_SIZE];
+#ifndef EF_ENV_USING_RW_LOCK
+/* the last decompressed bytes, it's the dictionary of the decompressor */
+static uint8_t env_lz_window[ENV_LZ_WINDOW_SIZE];
+#endif
+#endif /* EF_ENV_USING_COMPRESS */
+
+#ifdef EF_ENV_USING_INDEX
+/* ENV index table, it holds all ENV when env_index_overflow is false */
+static struct env_index_node env_index_table[EF_ENV_INDEX_TABLE_SIZE];
+/* used entry number of the index table */
+static size_t env_index_used = 0;
+/* the index table is full, some ENV is NOT indexed */
+static bool env_index_overflow = true;
+/* the index table has been built by ef_load_env */
+static bool env_index_ready = false;
+#endif /* EF_ENV_USING_INDEX */
+
 static size_t set_status(uint8_t status_table[], size_t status_num, size_t status_index)
 {
     size_t byte_index = ~0UL;
@@ -279,6 +608,10 @@ static EfErrCode write_status(uint32_t addr, uint8_t status_table[], size_t stat
     if (byte_index == ~0UL) {
         return EF_NO_ERR;
     }
+#ifdef EF_ENV_USING_SNAPSHOT
+    /* the snapshot is stale before any change of ENV */
+    env_snapshot_drop();
+#endif
 #if (EF_WRITE_GRAN == 1)
     result = ef_port_write(addr + byte_index, (uint32_t *)&status_table[byte_index], 1);
 #else /*  (EF_WRITE_GRAN == 8) ||  (EF_WRITE_GRAN == 32) ||  (EF_WRITE_GRAN == 64) */
@@ -352,7 +685,7 @@ static bool get_sector_from_cache(uint32_t sec_addr, uint32_t *empty_addr)
 static void update_env_cache(const char *name, size_t name_len, uint32_t addr)
 {
     size_t i, empty_index = EF_ENV_CACHE_TABLE_SIZE, min_activity_index = EF_ENV_CACHE_TABLE_SIZE;
-    uint16_t name_crc = (uint16_t) (ef_calc_crc32(0, name, name_len) >> 16), min_activity = 0xFFFF;
+    uint16_t name_crc = (uint16_t) (ef_env_calc_crc32(0, name, name_len) >> 16), min_activity = 0xFFFF;
 
     for (i = 0; i < EF_ENV_CACHE_TABLE_SIZE; i++) {
         if (addr != FAILED_ADDR) {
@@ -391,12 +724,12 @@ static void update_env_cache(const char *name, size_t name_len, uint32_t addr)
 }
 
 /*
- * Get ENV info from cache. It's return true when cache is hit.
+ * Get ENV info from cache. It's return true when cache is hit. The reader doesn't change the cache activity.
  */
-static bool get_env_from_cache(const char *name, size_t name_len, uint32_t *addr)
+static bool get_env_from_cache(const char *name, size_t name_len, uint32_t *addr, bool reader)
 {
     size_t i;
-    uint16_t name_crc = (uint16_t) (ef_calc_crc32(0, name, name_len) >> 16);
+    uint16_t name_crc = (uint16_t) (ef_env_calc_crc32(0, name, name_len) >> 16);
 
     for (i = 0; i < EF_ENV_CACHE_TABLE_SIZE; i++) {
         if ((env_cache_table[i].addr != FAILED_ADDR) && (env_cache_table[i].name_crc == name_crc)) {
@@ -405,6 +738,9 @@ static bool get_env_from_cache(const char *name, size_t name_len, uint32_t *addr
             ef_port_read(env_cache_table[i].addr + ENV_HDR_DATA_SIZE, (uint32_t *) saved_name, EF_ENV_NAME_MAX);
             if (!strncmp(name, saved_name, name_len)) {
                 *addr = env_cache_table[i].addr;
+                if (reader) {
+                    return true;
+                }
                 if (env_cache_table[i].active >= 0xFFFF - EF_ENV_CACHE_TABLE_SIZE) {
                     env_cache_table[i].active = 0xFFFF;
                 } else {
@@ -419,30 +755,300 @@ static bool get_env_from_cache(const char *name, size_t name_len, uint32_t *addr
 }
 #endif /* EF_ENV_USING_CACHE */
 
+/*
+ * the value length of the ENV object is the length before compression when the value is compressed
+ */
+static void get_env_value_len(env_node_obj_t env, env_hdr_data_t env_hdr)
+{
+    env->compressed = (env_hdr->flags & ENV_FLAG_COMPRESSED) == 0;
+    if (env->compressed) {
+        env->value_len = env_hdr->raw_len;
+    } else {
+        env->value_len = env_hdr->value_len;
+    }
+}
+
+#ifdef EF_ENV_USING_INDEX
+/*
+ * Read the ENV header and name by one flash read, then compare the name.
+ * The CRC32 is NOT checked again, the ENV is already checked OK before it's indexed.
+ */
+static bool read_env_hdr_by_name(uint32_t addr, const char *name, size_t name_len, env_node_obj_t env)
+{
+    uint32_t buf[(EF_WG_ALIGN(ENV_HDR_DATA_SIZE + EF_ENV_NAME_MAX) + 3) / 4];
+    env_hdr_data_t env_hdr = (env_hdr_data_t) buf;
+    uint8_t *saved_name = (uint8_t *) buf + ENV_HDR_DATA_SIZE;
+    size_t read_size = EF_WG_ALIGN(ENV_HDR_DATA_SIZE + name_len);
+
+    /* the ENV header and name never cross the sector, the read is aligned by the write granularity */
+    if (name_len > EF_ENV_NAME_MAX || read_size > EF_ALIGN_DOWN(addr, SECTOR_SIZE) + SECTOR_SIZE - addr) {
+        return false;
+    }
+    ef_port_read(addr, buf, read_size);
+    if (env_hdr->magic != ENV_MAGIC_WORD || env_hdr->name_len != name_len || memcmp(saved_name, name, name_len)) {
+        return false;
+    }
+    if (env) {
+        env->status = (env_status_t) get_status(env_hdr->status_table, ENV_STATUS_NUM);
+        env->crc_is_ok = true;
+        env->len = env_hdr->len;
+        env->name_len = env_hdr->name_len;
+        get_env_value_len(env, env_hdr);
+        memcpy(env->name, saved_name, name_len);
+        env->addr.start = addr;
+        env->addr.value = addr + ENV_HDR_DATA_SIZE + EF_WG_ALIGN(name_len);
+    }
+
+    return true;
+}
+
+static void env_index_reset(void)
+{
+    size_t i;
+
+    for (i = 0; i < EF_ENV_INDEX_TABLE_SIZE; i++) {
+        env_index_table[i].addr = FAILED_ADDR;
+    }
+    env_index_used = 0;
+    env_index_overflow = false;
+}
+
+/*
+ * Find the index entry by name with linear probing. It's return an empty entry when not found.
+ */
+static size_t env_index_lookup(const char *name, size_t name_len, uint32_t name_crc, env_node_obj_t env)
+{
+    size_t i = name_crc & (EF_ENV_INDEX_TABLE_SIZE - 1);
+
+    while (env_index_table[i].addr != FAILED_ADDR) {
+        if (env_index_table[i].name_crc == name_crc
+                && read_env_hdr_by_name(env_index_table[i].addr, name, name_len, env)) {
+            break;
+        }
+        i = (i + 1) & (EF_ENV_INDEX_TABLE_SIZE - 1);
+    }
+
+    return i;
+}
+
+/*
+ * Delete the entry and shift the following entries back, so the probe chain has no hole.
+ */
+static void env_index_remove(size_t i)
+{
+    size_t j = i, k;
+
+    while (true) {
+        j = (j + 1) & (EF_ENV_INDEX_TABLE_SIZE - 1);
+        if (env_index_table[j].addr == FAILED_ADDR) {
+            break;
+        }
+        /* the home entry of j */
+        k = env_index_table[j].name_crc & (EF_ENV_INDEX_TABLE_SIZE - 1);
+        if ((j > i && (k <= i || k > j)) || (j < i && (k <= i && k > j))) {
+            env_index_table[i] = env_index_table[j];
+            i = j;
+        }
+    }
+    env_index_table[i].addr = FAILED_ADDR;
+    env_index_used--;
+}
+
+/*
+ * Add, update or delete (addr is FAILED_ADDR) the ENV in index.
+ */
+static void update_env_index(const char *name, size_t name_len, uint32_t addr)
+{
+    uint32_t name_crc;
+    size_t i;
+
+    if (env_index_overflow) {
+        return;
+    }
+
+    name_crc = ef_env_calc_crc32(0, name, name_len);
+    i = env_index_lookup(name, name_len, name_crc, NULL);
+    if (addr == FAILED_ADDR) {
+        if (env_index_table[i].addr != FAILED_ADDR) {
+            env_index_remove(i);
+        }
+    } else if (env_index_table[i].addr != FAILED_ADDR) {
+        env_index_table[i].addr = addr;
+    } else if (env_index_used < ENV_INDEX_MAX_USED) {
+        env_index_table[i].name_crc = name_crc;
+        env_index_table[i].addr = addr;
+        env_index_used++;
+    } else {
+        EF_INFO("Warning: The ENV index table is full, please increase the EF_ENV_INDEX_TABLE_SIZE.\n");
+        env_index_overflow = true;
+    }
+}
+
+/*
+ * Find the ENV by index. It's return false when the index can't be used.
+ */
+static bool get_env_from_index(const char *name, size_t name_len, env_node_obj_t env, bool *find_ok)
+{
+    size_t i;
+
+    if (!env_index_ready || env_index_overflow) {
+        return false;
+    }
+
+    i = env_index_lookup(name, name_len, ef_env_calc_crc32(0, name, name_len), env);
+    *find_ok = env_index_table[i].addr != FAILED_ADDR
+            && (env->status == ENV_WRITE || env->status == ENV_PRE_DELETE);
+
+    return true;
+}
+
+static bool build_env_index_cb(env_node_obj_t env, void *arg1, void *arg2)
+{
+    if (env->crc_is_ok && env->status == ENV_WRITE) {
+        update_env_index(env->name, env->name_len, env->addr.start);
+    }
+
+    return false;
+}
+#endif /* EF_ENV_USING_INDEX */
+
+#if EF_ENV_SCAN_WORD_SIZE == 8
+typedef uint64_t scan_word_t;
+#else
+typedef uint32_t scan_word_t;
+#endif
+/* the scan_word_t which every byte is the b */
+#define SCAN_WORD_BYTES(b)                       ((scan_word_t) -1 / 0xFF * (b))
+/* it's NOT 0 when one byte of the w is 0 */
+#define SCAN_WORD_HAS_ZERO(w)                    (((w) - SCAN_WORD_BYTES(0x01)) & ~(w) & SCAN_WORD_BYTES(0x80))
+
+/*
+ * the length to the last non 0xFF byte of the buffer, 0: all bytes are 0xFF
+ */
+static size_t scan_last_not_ff(const uint8_t *buf, size_t size)
+{
+    size_t i = size;
+
+#if defined(ENV_SCAN_USING_SSE2)
+    const __m128i ff = _mm_set1_epi8((char) 0xFF);
+    unsigned int mask;
+
+    for (; i % 16 != 0; i--) {
+        if (buf[i - 1] != 0xFF) {
+            return i;
+        }
+    }
+    for (; i > 0; i -= 16) {
+        mask = ~_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (buf + i - 16)), ff)) & 0xFFFF;
+        if (mask) {
+            return i - 16 + (32 - __builtin_clz(mask));
+        }
+    }
+#elif EF_ENV_SCAN_WORD_SIZE > 1
+    /* the buffer is aligned by the scan_word_t */
+    const scan_word_t *word = (const scan_word_t *) buf;
+
+    for (; i % sizeof(scan_word_t) != 0; i--) {
+        if (buf[i - 1] != 0xFF) {
+            return i;
+        }
+    }
+    for (; i > 0; i -= sizeof(scan_word_t)) {
+        if (word[i / sizeof(scan_word_t) - 1] != (scan_word_t) -1) {
+            break;
+        }
+    }
+#endif /* defined(ENV_SCAN_USING_SSE2) */
+
+    for (; i > 0; i--) {
+        if (buf[i - 1] != 0xFF) {
+            break;
+        }
+    }
+
+    return i;
+}
+
+/*
+ * the first magic word position in [from, size) of the buffer, the buffer has 3 more bytes after the size
+ */
+static size_t scan_magic_word(const uint8_t *buf, size_t from, size_t size)
+{
+    const uint32_t magic = ENV_MAGIC_WORD;
+    /* the first byte of the magic word on the flash */
+    const uint8_t first = *(const uint8_t *) &magic;
+    size_t i = from;
+
+#if defined(ENV_SCAN_USING_SSE2)
+    const __m128i pattern = _mm_set1_epi8((char) first);
+    unsigned int mask;
+    size_t block;
+
+    for (block = EF_ALIGN_DOWN(from, 16); block < size; block += 16) {
+        mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (buf + block)), pattern));
+        for (; mask; mask &= mask - 1) {
+            i = block + __builtin_ctz(mask);
+            if (i >= from && i < size && !memcmp(buf + i, &magic, sizeof(magic))) {
+                return i;
+            }
+        }
+    }
+
+    return size;
+#else
+#if EF_ENV_SCAN_WORD_SIZE > 1
+    /* the buffer is aligned by the scan_word_t */
+    const scan_word_t *word = (const scan_word_t *) buf;
+    size_t w;
+
+    for (w = from / sizeof(scan_word_t); w * sizeof(scan_word_t) < size; w++) {
+        /* skip the words which has no first byte of the magic word */
+        if (!SCAN_WORD_HAS_ZERO(word[w] ^ SCAN_WORD_BYTES(first))) {
+            i = (w + 1) * sizeof(scan_word_t);
+            continue;
+        }
+        for (i = w * sizeof(scan_word_t) < from ? from : w * sizeof(scan_word_t);
+                i < (w + 1) * sizeof(scan_word_t) && i < size; i++) {
+            if (buf[i] == first && !memcmp(buf + i, &magic, sizeof(magic))) {
+                return i;
+            }
+        }
+    }
+#endif /* EF_ENV_SCAN_WORD_SIZE > 1 */
+
+    for (; i < size; i++) {
+        if (buf[i] == first && !memcmp(buf + i, &magic, sizeof(magic))) {
+            return i;
+        }
+    }
+
+    return size;
+#endif /* defined(ENV_SCAN_USING_SSE2) */
+}
+
 /*
  * find the continue 0xFF flash address to end address
  */
 static uint32_t continue_ff_addr(uint32_t start, uint32_t end)
 {
-    uint8_t buf[32], last_data = 0x00;
-    size_t i, addr = start, read_size;
+    scan_word_t buf[EF_ENV_SCAN_BUF_SIZE / sizeof(scan_word_t)];
+    /* the address after the last non 0xFF byte */
+    uint32_t addr = start;
+    size_t read_size, len;
 
-    for (; start < end; start += sizeof(buf)) {
+    for (; start < end; start += read_size) {
         if (start + sizeof(buf) < end) {
             read_size = sizeof(buf);
         } else {
             read_size = end - start;
         }
         ef_port_read(start, (uint32_t *) buf, read_size);
-        for (i = 0; i < read_size; i++) {
-            if (last_data != 0xFF && buf[i] == 0xFF) {
-                addr = start + i;
-            }
-            last_data = buf[i];
+        if ((len = scan_last_not_ff((uint8_t *) buf, read_size)) > 0) {
+            addr = start + len;
         }
     }
 
-    if (last_data == 0xFF) {
+    if (addr != end) {
         return EF_WG_ALIGN(addr);
     } else {
         return end;
@@ -450,13 +1056,15 @@ static uint32_t continue_ff_addr(uint32_t start, uint32_t end)
 }
 
 /*
- * find the next ENV address by magic word on the flash
+ * find the next ENV address by magic word on the flash, the whole magic word is in [start, end)
  */
 static uint32_t find_next_env_addr(uint32_t start, uint32_t end)
 {
-    uint8_t buf[32];
-    uint32_t start_bak = start, i;
-    uint32_t magic;
+    scan_word_t buf[EF_ENV_SCAN_BUF_SIZE / sizeof(scan_word_t)];
+    /* the ENV start address is NOT less than the start address */
+    uint32_t first_magic = start + ENV_MAGIC_OFFSET;
+    /* the next ENV is usually at the start address, so the first window is small */
+    size_t window = 32, read_size, scan_size, i, from;
 
 #ifdef EF_ENV_USING_CACHE
     uint32_t empty_env;
@@ -466,17 +1074,21 @@ static uint32_t find_next_env_addr(uint32_t start, uint32_t end)
     }
 #endif /* EF_ENV_USING_CACHE */
 
-    for (; start < end; start += (sizeof(buf) - sizeof(uint32_t))) {
-        ef_port_read(start, (uint32_t *) buf, sizeof(buf));
-        for (i = 0; i < sizeof(buf) - sizeof(uint32_t) && start + i < end; i++) {
-#ifndef EF_BIG_ENDIAN            /* Little Endian Order */
-            magic = buf[i] + (buf[i + 1] << 8) + (buf[i + 2] << 16) + (buf[i + 3] << 24);
-#else                       /* Big Endian Order */
-            magic = buf[i + 3] + (buf[i + 2] << 8) + (buf[i + 1] << 16) + (buf[i] << 24);
-#endif
-            if (magic == ENV_MAGIC_WORD && (start + i - ENV_MAGIC_OFFSET) >= start_bak) {
-                return start + i - ENV_MAGIC_OFFSET;
-            }
+    /* every position of the window has a whole magic word, so the next window overlaps 3 bytes */
+    for (; start + sizeof(uint32_t) <= end; start += scan_size, window = sizeof(buf)) {
+        if (start + window < end) {
+            read_size = window;
+        } else {
+            read_size = end - start;
+        }
+        scan_size = read_size - (sizeof(uint32_t) - 1);
+        from = first_magic > start ? first_magic - start : 0;
+        if (from >= scan_size) {
+            continue;
+        }
+        ef_port_read(start, (uint32_t *) buf, read_size);
+        if ((i = scan_magic_word((uint8_t *) buf, from, scan_size)) < scan_size) {
+            return start + i - ENV_MAGIC_OFFSET;
         }
     }
 
@@ -504,7 +1116,7 @@ static uint32_t get_next_env_addr(sector_meta_data_t sector, env_node_obj_t pre_
                 addr = pre_env->addr.start + EF_WG_ALIGN(1);
             }
             /* check and find next ENV address */
-            addr = find_next_env_addr(addr, sector->addr + SECTOR_SIZE - SECTOR_HDR_DATA_SIZE);
+            addr = find_next_env_addr(addr, SECTOR_MAGIC_SCAN_END(sector->addr));
 
             if (addr > sector->addr + SECTOR_SIZE || pre_env->len == 0) {
                 //TODO ģʽ
@@ -557,7 +1169,7 @@ static EfErrCode read_env(env_node_obj_t env)
         }
 
         ef_port_read(env->addr.start + ENV_NAME_LEN_OFFSET + len, (uint32_t *) buf, EF_WG_ALIGN(size));
-        calc_crc32 = ef_calc_crc32(calc_crc32, buf, size);
+        calc_crc32 = ef_env_calc_crc32(calc_crc32, buf, size);
     }
     /* check CRC32 */
     if (calc_crc32 != env_hdr.crc32) {
@@ -570,7 +1182,7 @@ static EfErrCode read_env(env_node_obj_t env)
         ef_port_read(env_name_addr, (uint32_t *) env->name, EF_WG_ALIGN(env_hdr.name_len));
         /* the value is behind aligned name */
         env->addr.value = env_name_addr + EF_WG_ALIGN(env_hdr.name_len);
-        env->value_len = env_hdr.value_len;
+        get_env_value_len(env, &env_hdr);
         env->name_len = env_hdr.name_len;
     }
 
@@ -594,11 +1206,13 @@ static EfErrCode read_sector_meta_data(uint32_t addr, sector_meta_data_t sector,
     if (sector->magic != SECTOR_MAGIC_WORD) {
         sector->check_ok = false;
         sector->combined = SECTOR_NOT_COMBINED;
+        sector->erase_count = 0;
         return EF_ENV_INIT_FAILED;
     }
     sector->check_ok = true;
     /* get other sector meta data */
     sector->combined = sec_hdr.combined;
+    sector->erase_count = sec_hdr.erase_count == 0xFFFFFFFF ? 0 : sec_hdr.erase_count;
     sector->status.store = (sector_store_status_t) get_status(sec_hdr.status_table.store, SECTOR_STORE_STATUS_NUM);
     sector->status.dirty = (sector_dirty_status_t) get_status(sec_hdr.status_table.dirty, SECTOR_DIRTY_STATUS_NUM);
     /* traversal all ENV and calculate the remain space size */
@@ -711,19 +1325,53 @@ static bool find_env_cb(env_node_obj_t env, void *arg1, void *arg2)
 {
     const char *key = arg1;
     bool *find_ok = arg2;
-    uint8_t max_len = strlen(key);
 
-    if (max_len < env->name_len) {
-        max_len = env->name_len;
-    }
-    /* check ENV */
-    if (env->crc_is_ok && env->status == ENV_WRITE && !strncmp(env->name, key, max_len)) {
+    /* check ENV, the name buffer is NOT terminated, so the name length must be same */
+    if (env->crc_is_ok && env->status == ENV_WRITE && env->name_len == strlen(key)
+            && !strncmp(env->name, key, env->name_len)) {
         *find_ok = true;
         return true;
     }
     return false;
 }
 
+#ifdef EF_ENV_USING_WRITE_BACK
+static env_wb_node_t find_env_wb(const char *key)
+{
+    size_t i;
+
+    for (i = 0; i < ENV_WB_TABLE_SIZE; i++) {
+        if (!strcmp(env_wb_keys[i], key)) {
+            return &env_wb_table[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Drop the cached value, the ENV on flash is the latest.
+ */
+static void drop_env_wb(const char *key)
+{
+    env_wb_node_t wb_node = find_env_wb(key);
+
+    if (wb_node) {
+        wb_node->valid = false;
+        wb_node->dirty = false;
+    }
+}
+
+static void env_wb_reset(void)
+{
+    memset(env_wb_table, 0, sizeof(env_wb_table));
+    env_wb_dirty_count = 0;
+#if EF_ENV_WB_PERIOD_MS > 0
+    env_wb_time = ef_port_get_time_us();
+#endif
+}
+#endif /* EF_ENV_USING_WRITE_BACK */
+
 static bool find_env_no_cache(const char *key, env_node_obj_t env)
 {
     bool find_ok = false;
@@ -737,10 +1385,16 @@ static bool find_env(const char *key, env_node_obj_t env)
 {
     bool find_ok = false;
 
+#ifdef EF_ENV_USING_INDEX
+    if (get_env_from_index(key, strlen(key), env, &find_ok)) {
+        return find_ok;
+    }
+#endif /* EF_ENV_USING_INDEX */
+
 #ifdef EF_ENV_USING_CACHE
     size_t key_len = strlen(key);
 
-    if (get_env_from_cache(key, key_len, &env->addr.start)) {
+    if (get_env_from_cache(key, key_len, &env->addr.start, false)) {
         read_env(env);
         return true;
     }
@@ -757,6 +1411,33 @@ static bool find_env(const char *key, env_node_obj_t env)
     return find_ok;
 }
 
+/*
+ * Find the ENV under the reader lock, the ENV cache is only looked up and NOT updated.
+ */
+static bool find_env_reader(const char *key, env_node_obj_t env)
+{
+#ifdef EF_ENV_USING_RW_LOCK
+#ifdef EF_ENV_USING_INDEX
+    bool find_ok = false;
+
+    if (get_env_from_index(key, strlen(key), env, &find_ok)) {
+        return find_ok;
+    }
+#endif /* EF_ENV_USING_INDEX */
+
+#ifdef EF_ENV_USING_CACHE
+    if (get_env_from_cache(key, strlen(key), &env->addr.start, true)) {
+        read_env(env);
+        return true;
+    }
+#endif /* EF_ENV_USING_CACHE */
+
+    return find_env_no_cache(key, env);
+#else
+    return find_env(key, env);
+#endif /* EF_ENV_USING_RW_LOCK */
+}
+
 static bool ef_is_str(uint8_t *value, size_t len)
 {
 #define __is_print(ch)       ((unsigned int)((ch) - ' ') < 127u - ' ')
@@ -770,22 +1451,241 @@ static bool ef_is_str(uint8_t *value, size_t len)
     return true;
 }
 
-static size_t get_env(const char *key, void *value_buf, size_t buf_len, size_t *value_len)
+#ifdef EF_ENV_USING_COMPRESS
+/* put the extended length of the LZ token */
+static size_t lz_put_len(uint8_t *dst, size_t pos, size_t len)
 {
-    struct env_node_obj env;
-    size_t read_len = 0;
-
-    if (find_env(key, &env)) {
-        if (value_len) {
-            *value_len = env.value_len;
+    if (len >= ENV_LZ_TOKEN_LEN_MAX) {
+        for (len -= ENV_LZ_TOKEN_LEN_MAX; len >= 0xFF; len -= 0xFF) {
+            dst[pos++] = 0xFF;
+        }
+        dst[pos++] = (uint8_t) len;
+    }
+
+    return pos;
+}
+
+/* put a LZ sequence (token, literals, match offset), the match_len is 0 when it's the last literals */
+static bool lz_put_seq(uint8_t *dst, size_t *out, size_t dst_size, const uint8_t *literal, size_t literal_len,
+        size_t match_offset, size_t match_len)
+{
+    size_t pos = *out, extra = match_len ? match_len - ENV_LZ_MIN_MATCH : 0;
+    size_t need = 1 + literal_len;
+
+    if (literal_len >= ENV_LZ_TOKEN_LEN_MAX) {
+        need += (literal_len - ENV_LZ_TOKEN_LEN_MAX) / 0xFF + 1;
+    }
+    if (match_len) {
+        need += 1 + (extra >= ENV_LZ_TOKEN_LEN_MAX ? (extra - ENV_LZ_TOKEN_LEN_MAX) / 0xFF + 1 : 0);
+    }
+    if (pos + need > dst_size) {
+        return false;
+    }
+
+    dst[pos++] = (uint8_t) ((literal_len < ENV_LZ_TOKEN_LEN_MAX ? literal_len : ENV_LZ_TOKEN_LEN_MAX) << 4
+            | (extra < ENV_LZ_TOKEN_LEN_MAX ? extra : ENV_LZ_TOKEN_LEN_MAX));
+    pos = lz_put_len(dst, pos, literal_len);
+    memcpy(dst + pos, literal, literal_len);
+    pos += literal_len;
+    if (match_len) {
+        dst[pos++] = (uint8_t) (match_offset - 1);
+        pos = lz_put_len(dst, pos, extra);
+    }
+    *out = pos;
+
+    return true;
+}
+
+/*
+ * Compress the value to env_lz_buf by LZ77 with the 256 bytes dictionary. The greedy match is found
+ * by the hash table of 3 bytes, so the compressor needs no more RAM.
+ *
+ * @return the compressed length, 0: the compressed value is NOT smaller or larger than env_lz_buf
+ */
+static size_t lz_compress(const uint8_t *src, size_t len)
+{
+    uint8_t *dst = (uint8_t *) env_lz_buf;
+    size_t dst_size = len - 1 < sizeof(env_lz_buf) ? len - 1 : sizeof(env_lz_buf);
+    size_t pos = 0, anchor = 0, out = 0, match, match_len, match_end, hash;
+
+    memset(env_lz_hash, 0xFF, sizeof(env_lz_hash));
+    while (pos + ENV_LZ_MIN_MATCH <= len) {
+        hash = ENV_LZ_HASH(src + pos);
+        match = env_lz_hash[hash];
+        env_lz_hash[hash] = (uint16_t) pos;
+        if (match == 0xFFFF || pos - match > ENV_LZ_WINDOW_SIZE || memcmp(src + match, src + pos, ENV_LZ_MIN_MATCH)) {
+            pos++;
+            continue;
+        }
+        for (match_len = ENV_LZ_MIN_MATCH; pos + match_len < len && src[match + match_len] == src[pos + match_len];
+                match_len++);
+        if (!lz_put_seq(dst, &out, dst_size, src + anchor, pos - anchor, pos - match, match_len)) {
+            return 0;
+        }
+        /* the matched bytes are also in the dictionary */
+        for (match_end = pos + match_len, pos++; pos < match_end && pos + ENV_LZ_MIN_MATCH <= len; pos++) {
+            env_lz_hash[ENV_LZ_HASH(src + pos)] = (uint16_t) pos;
+        }
+        pos = anchor = match_end;
+    }
+    if (anchor < len && !lz_put_seq(dst, &out, dst_size, src + anchor, len - anchor, 0, 0)) {
+        return 0;
+    }
+
+    return out;
+}
+
+static bool lz_read_byte(env_lz_reader_t reader, uint8_t *byte)
+{
+    if (reader->pos == reader->len) {
+        if (reader->addr >= reader->end) {
+            return false;
+        }
+        if (reader->addr + sizeof(reader->buf) < reader->end) {
+            reader->len = sizeof(reader->buf);
+        } else {
+            reader->len = reader->end - reader->addr;
+        }
+        ef_port_read(reader->addr, reader->buf, reader->len);
+        reader->addr += reader->len;
+        reader->pos = 0;
+    }
+    *byte = ((uint8_t *) reader->buf)[reader->pos++];
+
+    return true;
+}
+
+static bool lz_read_len(env_lz_reader_t reader, size_t *len)
+{
+    uint8_t byte = 0xFF;
+
+    if (*len == ENV_LZ_TOKEN_LEN_MAX) {
+        while (byte == 0xFF) {
+            if (!lz_read_byte(reader, &byte)) {
+                return false;
+            }
+            *len += byte;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Decompress the value on flash from its beginning, the output before the offset is only kept in the
+ * dictionary, so any part of the value can be read without a whole value buffer.
+ *
+ * @return the decompressed length in the buffer
+ */
+static size_t lz_decompress(env_node_obj_t env, size_t offset, uint8_t *buf, size_t buf_len)
+{
+    struct env_lz_reader reader;
+    size_t out = 0, end = offset + buf_len, len, match_offset;
+    uint8_t token, byte;
+#ifdef EF_ENV_USING_RW_LOCK
+    /* the concurrent readers have their own dictionary */
+    uint8_t env_lz_window[ENV_LZ_WINDOW_SIZE];
+#endif
+
+    reader.addr = env->addr.value;
+    reader.end = env->addr.start + env->len;
+    reader.pos = reader.len = 0;
+    while (out < end && lz_read_byte(&reader, &token)) {
+        /* copy the literals */
+        len = token >> 4;
+        if (!lz_read_len(&reader, &len)) {
+            break;
+        }
+        for (; len > 0 && out < end && lz_read_byte(&reader, &byte); len--, out++) {
+            env_lz_window[out % ENV_LZ_WINDOW_SIZE] = byte;
+            if (out >= offset) {
+                buf[out - offset] = byte;
+            }
+        }
+        /* the read is finished or the compressed value is broken */
+        if (len > 0 || out >= end) {
+            break;
+        }
+        /* copy the match from the dictionary */
+        len = token & 0x0F;
+        if (!lz_read_byte(&reader, &byte) || !lz_read_len(&reader, &len) || (match_offset = byte + 1) > out) {
+            break;
+        }
+        for (len += ENV_LZ_MIN_MATCH; len > 0 && out < end; len--, out++) {
+            byte = env_lz_window[(out - match_offset) % ENV_LZ_WINDOW_SIZE];
+            env_lz_window[out % ENV_LZ_WINDOW_SIZE] = byte;
+            if (out >= offset) {
+                buf[out - offset] = byte;
+            }
+        }
+    }
+
+    return out > offset ? out - offset : 0;
+}
+#endif /* EF_ENV_USING_COMPRESS */
+
+/*
+ * Read the ENV value from the offset, the compressed value is decompressed.
+ */
+static size_t read_env_value(env_node_obj_t env, size_t offset, void *value_buf, size_t len)
+{
+    if (!env->compressed) {
+        ef_port_read(env->addr.value + offset, (uint32_t *) value_buf, len);
+        return len;
+    }
+
+#ifdef EF_ENV_USING_COMPRESS
+    return lz_decompress(env, offset, value_buf, len);
+#else
+    EF_INFO("Error: The ENV (%.*s) value is compressed, please enable EF_ENV_USING_COMPRESS.\n", env->name_len,
+            env->name);
+    return 0;
+#endif /* EF_ENV_USING_COMPRESS */
+}
+
+static size_t get_env(const char *key, void *value_buf, size_t buf_len, size_t *value_len)
+{
+    struct env_node_obj env;
+    size_t read_len = 0;
+
+#ifdef EF_ENV_USING_WRITE_BACK
+    env_wb_node_t wb_node = find_env_wb(key);
+
+    if (wb_node && wb_node->valid) {
+        if (value_len) {
+            *value_len = wb_node->value_len;
+        }
+        read_len = buf_len > wb_node->value_len ? wb_node->value_len : buf_len;
+        if (value_buf) {
+            memcpy(value_buf, wb_node->value, read_len);
+        }
+        return read_len;
+    }
+#endif /* EF_ENV_USING_WRITE_BACK */
+
+    if (find_env_reader(key, &env)) {
+        if (value_len) {
+            *value_len = env.value_len;
         }
         if (buf_len > env.value_len) {
             read_len = env.value_len;
         } else {
             read_len = buf_len;
         }
+#if defined(EF_ENV_USING_WRITE_BACK) && !defined(EF_ENV_USING_RW_LOCK)
+        if (wb_node && env.value_len <= EF_ENV_WB_VALUE_MAX
+                && read_env_value(&env, 0, wb_node->value, env.value_len) == env.value_len) {
+            /* load the value to the write back cache, the next get and set don't need the flash */
+            wb_node->value_len = env.value_len;
+            wb_node->valid = true;
+            if (value_buf) {
+                memcpy(value_buf, wb_node->value, read_len);
+            }
+            return read_len;
+        }
+#endif /* defined(EF_ENV_USING_WRITE_BACK) && !defined(EF_ENV_USING_RW_LOCK) */
         if (value_buf){
-            ef_port_read(env.addr.value, (uint32_t *) value_buf, read_len);
+            read_len = read_env_value(&env, 0, value_buf, read_len);
         }
     }
 
@@ -809,13 +1709,26 @@ bool ef_get_env_obj(const char *key, env_node_obj_t env)
         return 0;
     }
 
+#ifdef EF_ENV_USING_WRITE_BACK
     /* lock the ENV cache */
     ef_port_env_lock();
+    /* the ENV object is on the flash, so the cached value must be written back first */
+    env_wb_flush();
+#else
+    /* lock the ENV cache for read */
+    env_read_lock();
+#endif
 
-    find_ok = find_env(key, env);
+    find_ok = find_env_reader(key, env);
+    env->gen = env_gen;
 
+#ifdef EF_ENV_USING_WRITE_BACK
     /* unlock the ENV cache */
     ef_port_env_unlock();
+#else
+    /* unlock the ENV cache for read */
+    env_read_unlock();
+#endif
 
     return find_ok;
 }
@@ -839,13 +1752,13 @@ size_t ef_get_env_blob(const char *key, void *value_buf, size_t buf_len, size_t
         return 0;
     }
 
-    /* lock the ENV cache */
-    ef_port_env_lock();
+    /* lock the ENV cache for read */
+    env_read_lock();
 
     read_len = get_env(key, value_buf, buf_len, saved_value_len);
 
-    /* unlock the ENV cache */
-    ef_port_env_unlock();
+    /* unlock the ENV cache for read */
+    env_read_unlock();
 
     return read_len;
 }
@@ -901,8 +1814,8 @@ size_t ef_read_env_value(env_node_obj_t env, uint8_t *value_buf, size_t buf_len)
     }
 
     if (env->crc_is_ok) {
-        /* lock the ENV cache */
-        ef_port_env_lock();
+        /* lock the ENV cache for read */
+        env_read_lock();
 
         if (buf_len > env->value_len) {
             read_len = env->value_len;
@@ -910,14 +1823,123 @@ size_t ef_read_env_value(env_node_obj_t env, uint8_t *value_buf, size_t buf_len)
             read_len = buf_len;
         }
 
-        ef_port_read(env->addr.value, (uint32_t *) value_buf, read_len);
-        /* unlock the ENV cache */
-        ef_port_env_unlock();
+        read_len = read_env_value(env, 0, value_buf, read_len);
+        /* unlock the ENV cache for read */
+        env_read_unlock();
+    }
+
+    return read_len;
+}
+
+/**
+ * Read a part of the ENV value by ENV object. The value which is larger than RAM can be streamed
+ * by reading it piece by piece to a small buffer.
+ *
+ * @param env ENV object which is got by ef_get_env_obj
+ * @param offset the read start offset in the value
+ * @param value_buf the buffer for store ENV value
+ * @param buf_len buffer length
+ *
+ * @return the actually read size on successful, 0: the offset is at the end of value or the ENV object is
+ *         stale (@see ef_env_ptr_is_valid), please get the ENV object again when it's stale
+ */
+size_t ef_read_env_value_at(env_node_obj_t env, size_t offset, uint8_t *value_buf, size_t buf_len)
+{
+    size_t read_len = 0;
+
+    EF_ASSERT(env);
+    EF_ASSERT(value_buf);
+
+    if (!init_ok) {
+        EF_INFO("ENV isn't initialize OK.\n");
+        return 0;
+    }
+
+    /* lock the ENV cache for read */
+    env_read_lock();
+
+    if (env->crc_is_ok && env->gen == env_gen && offset < env->value_len) {
+        if (buf_len > env->value_len - offset) {
+            read_len = env->value_len - offset;
+        } else {
+            read_len = buf_len;
+        }
+        read_len = read_env_value(env, offset, value_buf, read_len);
     }
 
+    /* unlock the ENV cache for read */
+    env_read_unlock();
+
     return read_len;
 }
 
+#ifdef EF_ENV_USING_ZERO_COPY
+/**
+ * Get the ENV value pointer on the memory mapped flash, the value is NOT copied to RAM.
+ *
+ * @note The value on flash is stale after the ENV is changed, deleted or moved by GC. Please check the
+ *       generation by ef_env_ptr_is_valid after the value has been used, then get it again if it's invalid.
+ *
+ * @param key ENV name
+ * @param value_len return the value length
+ * @param gen return the ENV store generation of the pointer
+ *
+ * @return the value pointer, NULL: NOT found, the value is compressed or the flash is NOT mapped
+ */
+const void *ef_get_env_ptr(const char *key, size_t *value_len, uint32_t *gen)
+{
+    struct env_node_obj env;
+    const void *value = NULL;
+
+    EF_ASSERT(value_len);
+    EF_ASSERT(gen);
+
+    if (!init_ok) {
+        EF_INFO("ENV isn't initialize OK.\n");
+        return NULL;
+    }
+
+#ifdef EF_ENV_USING_WRITE_BACK
+    /* lock the ENV cache */
+    ef_port_env_lock();
+    /* the pointer is on the flash, so the cached value must be written back first */
+    env_wb_flush();
+#else
+    /* lock the ENV cache for read */
+    env_read_lock();
+#endif
+
+    if (find_env_reader(key, &env) && env.crc_is_ok && !env.compressed) {
+        value = ef_port_map(env.addr.value, env.value_len);
+        *value_len = env.value_len;
+        *gen = env_gen;
+    }
+
+#ifdef EF_ENV_USING_WRITE_BACK
+    /* unlock the ENV cache */
+    ef_port_env_unlock();
+#else
+    /* unlock the ENV cache for read */
+    env_read_unlock();
+#endif
+
+    return value;
+}
+#endif /* EF_ENV_USING_ZERO_COPY */
+
+/**
+ * Check the ENV value pointer (or the ENV object) is still valid.
+ * It's lock free, so it can be called at the end of a lock free value read, same as a sequence lock.
+ *
+ * @param gen the generation which is got by ef_get_env_ptr or the gen of ENV object
+ *
+ * @return true: the ENV store is NOT changed after the generation
+ */
+bool ef_env_ptr_is_valid(uint32_t gen)
+{
+    return gen == *(volatile uint32_t *) &env_gen;
+}
+
 static EfErrCode write_env_hdr(uint32_t addr, env_hdr_data_t env_hdr) {
     EfErrCode result = EF_NO_ERR;
     /* write the status will by write granularity */
@@ -925,30 +1947,60 @@ static EfErrCode write_env_hdr(uint32_t addr, env_hdr_data_t env_hdr) {
     if (result != EF_NO_ERR) {
         return result;
     }
-    /* write other header data */
-    result = ef_port_write(addr + ENV_MAGIC_OFFSET, &env_hdr->magic, sizeof(struct env_hdr_data) - ENV_MAGIC_OFFSET);
+    /* write other header data, the header padding is written by the write granularity */
+    result = align_write(addr + ENV_MAGIC_OFFSET, &env_hdr->magic, sizeof(struct env_hdr_data) - ENV_MAGIC_OFFSET);
 
     return result;
 }
 
-static EfErrCode format_sector(uint32_t addr, uint32_t combined_value)
+/*
+ * Format the sector. The ENV is written in front of the sector header when the key is NOT NULL, the sector is NOT
+ * valid until its header is written, so the ENV is always found in the valid sector after a power loss.
+ */
+static EfErrCode format_sector_with_env(uint32_t addr, uint32_t combined_value, const char *key, const void *value,
+        size_t len)
 {
     EfErrCode result = EF_NO_ERR;
     struct sector_hdr_data sec_hdr;
+    struct sector_meta_data sector;
+    uint32_t erase_count;
 
     EF_ASSERT(addr % SECTOR_SIZE == 0);
 
+#ifdef EF_ENV_USING_SNAPSHOT
+    env_snapshot_drop();
+#endif
+    env_gen++;
+    /* the erase count is carried to the new header, the lost (or old format) count is the max known count */
+    ef_port_read(addr, (uint32_t *)&sec_hdr, sizeof(struct sector_hdr_data));
+    if (sec_hdr.magic == SECTOR_MAGIC_WORD && sec_hdr.erase_count < 0xFFFFFFFE) {
+        erase_count = sec_hdr.erase_count + 1;
+    } else {
+        erase_count = sector_wear_max > 0 ? sector_wear_max : 1;
+    }
+    if (erase_count > sector_wear_max) {
+        sector_wear_max = erase_count;
+    }
     result = ef_port_erase(addr, SECTOR_SIZE);
+    if (result == EF_NO_ERR && key) {
+        /* the sector is using by the ENV */
+        sector.addr = addr;
+        sector.status.store = SECTOR_STORE_USING;
+        sector.remain = SECTOR_SIZE - SECTOR_HDR_DATA_SIZE;
+        sector.empty_env = addr + SECTOR_HDR_DATA_SIZE;
+        result = create_env_blob(&sector, key, value, len, 0);
+    }
     if (result == EF_NO_ERR) {
         /* initialize the header data */
         memset(&sec_hdr, 0xFF, sizeof(struct sector_hdr_data));
-        set_status(sec_hdr.status_table.store, SECTOR_STORE_STATUS_NUM, SECTOR_STORE_EMPTY);
+        set_status(sec_hdr.status_table.store, SECTOR_STORE_STATUS_NUM,
+                key ? SECTOR_STORE_USING : SECTOR_STORE_EMPTY);
         set_status(sec_hdr.status_table.dirty, SECTOR_DIRTY_STATUS_NUM, SECTOR_DIRTY_FALSE);
         sec_hdr.magic = SECTOR_MAGIC_WORD;
         sec_hdr.combined = combined_value;
-        sec_hdr.reserved = 0xFFFFFFFF;
+        sec_hdr.erase_count = erase_count;
         /* save the header */
-        result = ef_port_write(addr, (uint32_t *)&sec_hdr, sizeof(struct sector_hdr_data));
+        result = align_write(addr, (uint32_t *)&sec_hdr, sizeof(struct sector_hdr_data));
 
 #ifdef EF_ENV_USING_CACHE
         /* delete the sector cache */
@@ -959,6 +2011,11 @@ static EfErrCode format_sector(uint32_t addr, uint32_t combined_value)
     return result;
 }
 
+static EfErrCode format_sector(uint32_t addr, uint32_t combined_value)
+{
+    return format_sector_with_env(addr, combined_value, NULL, NULL, 0);
+}
+
 static EfErrCode update_sec_status(sector_meta_data_t sector, size_t new_env_len, bool *is_full)
 {
     uint8_t status_table[STORE_STATUS_TABLE_SIZE];
@@ -1022,17 +2079,46 @@ static bool sector_statistics_cb(sector_meta_data_t sector, void *arg1, void *ar
     return false;
 }
 
+#ifdef EF_ENV_USING_INCREMENTAL_GC
+/*
+ * The max size of the ENV which is NOT moved yet in the collecting sector.
+ */
+static size_t gc_remain_size(void)
+{
+    uint32_t addr = gc_sector.addr + SECTOR_HDR_DATA_SIZE;
+
+    if (gc_sector.addr == FAILED_ADDR) {
+        return 0;
+    }
+    if (gc_env.addr.start != FAILED_ADDR) {
+        addr = gc_env.addr.start + (gc_env.crc_is_ok ? gc_env.len : 0);
+    }
+
+    return gc_sector.addr + SECTOR_SIZE > addr ? gc_sector.addr + SECTOR_SIZE - addr : 0;
+}
+#endif /* EF_ENV_USING_INCREMENTAL_GC */
+
 static bool alloc_env_cb(sector_meta_data_t sector, void *arg1, void *arg2)
 {
     size_t *env_size = arg1;
     uint32_t *empty_env = arg2;
 
+#ifdef EF_ENV_USING_INCREMENTAL_GC
+    /* 1. sector has space
+     * 2. NOT the collecting sector, the GC only collects one sector at a time
+     * 3. the GC destination sector must keep enough space for the ENV which is not moved yet, and for the torn copy
+     *    which is left by the move interrupted by a power loss, it's moved again on the recovery */
+    if (sector->check_ok && sector->remain > *env_size
+            && (sector->status.dirty == SECTOR_DIRTY_FALSE || sector->status.dirty == SECTOR_DIRTY_TRUE)
+            && (gc_request || sector->addr != gc_dst_sector || sector->remain > *env_size + 2 * gc_remain_size())) {
+#else
     /* 1. sector has space
      * 2. the NO dirty sector
      * 3. the dirty sector only when the gc_request is false */
     if (sector->check_ok && sector->remain > *env_size
             && ((sector->status.dirty == SECTOR_DIRTY_FALSE)
                     || (sector->status.dirty == SECTOR_DIRTY_TRUE && !gc_request))) {
+#endif /* EF_ENV_USING_INCREMENTAL_GC */
         *empty_env = sector->empty_env;
         return true;
     }
@@ -1040,6 +2126,24 @@ static bool alloc_env_cb(sector_meta_data_t sector, void *arg1, void *arg2)
     return false;
 }
 
+#ifdef EF_ENV_USING_WEAR_LEVELING
+/*
+ * Select the least worn empty sector, or the most worn one when the static wear leveling moves the cold ENV.
+ */
+static bool alloc_wl_cb(sector_meta_data_t sector, void *arg1, void *arg2)
+{
+    sector_meta_data_t select = arg2;
+    uint32_t empty_env;
+
+    if (alloc_env_cb(sector, arg1, &empty_env) && (select->addr == FAILED_ADDR
+            || (gc_cold_move ? sector->erase_count > select->erase_count : sector->erase_count < select->erase_count))) {
+        *select = *sector;
+    }
+
+    return false;
+}
+#endif /* EF_ENV_USING_WEAR_LEVELING */
+
 static uint32_t alloc_env(sector_meta_data_t sector, size_t env_size)
 {
     uint32_t empty_env = FAILED_ADDR;
@@ -1053,7 +2157,25 @@ static uint32_t alloc_env(sector_meta_data_t sector, size_t env_size)
     }
     if (empty_sector > 0 && empty_env == FAILED_ADDR) {
         if (empty_sector > EF_GC_EMPTY_SEC_THRESHOLD || gc_request) {
+#ifdef EF_ENV_USING_WEAR_LEVELING
+            struct sector_meta_data select;
+
+            select.addr = FAILED_ADDR;
+            sector_iterator(sector, SECTOR_STORE_EMPTY, &env_size, &select, alloc_wl_cb, true);
+            if (select.addr != FAILED_ADDR) {
+                *sector = select;
+                empty_env = select.empty_env;
+            }
+#else
             sector_iterator(sector, SECTOR_STORE_EMPTY, &env_size, &empty_env, alloc_env_cb, true);
+#endif /* EF_ENV_USING_WEAR_LEVELING */
+#ifdef EF_ENV_USING_INCREMENTAL_GC
+            /* the reserved empty sector which the GC moves to is kept for the GC, the ENV moved to a using sector
+             * doesn't change it */
+            if (gc_request && gc_sector.addr != FAILED_ADDR && empty_env != FAILED_ADDR) {
+                gc_dst_sector = EF_ALIGN_DOWN(empty_env, SECTOR_SIZE);
+            }
+#endif /* EF_ENV_USING_INCREMENTAL_GC */
         } else {
             /* no space for new ENV now will GC and retry */
             EF_DEBUG("Trigger a GC check after alloc ENV failed.\n");
@@ -1064,20 +2186,32 @@ static uint32_t alloc_env(sector_meta_data_t sector, size_t env_size)
     return empty_env;
 }
 
+/*
+ * Change the sector dirty status to true when the ENV on it is deleted.
+ */
+static EfErrCode set_sec_dirty(uint32_t env_addr)
+{
+    uint8_t status_table[DIRTY_STATUS_TABLE_SIZE];
+    uint32_t dirty_status_addr = EF_ALIGN_DOWN(env_addr, SECTOR_SIZE) + SECTOR_DIRTY_OFFSET;
+
+    /* the ENV pointers which have been got are stale */
+    env_gen++;
+    /* read and change the sector dirty status */
+    if (read_status(dirty_status_addr, status_table, SECTOR_DIRTY_STATUS_NUM) == SECTOR_DIRTY_FALSE) {
+        return write_status(dirty_status_addr, status_table, SECTOR_DIRTY_STATUS_NUM, SECTOR_DIRTY_TRUE);
+    }
+
+    return EF_NO_ERR;
+}
+
 static EfErrCode del_env(const char *key, env_node_obj_t old_env, bool complete_del) {
     EfErrCode result = EF_NO_ERR;
-    uint32_t dirty_status_addr;
     static bool last_is_complete_del = false;
-
-#if (ENV_STATUS_TABLE_SIZE >= DIRTY_STATUS_TABLE_SIZE)
     uint8_t status_table[ENV_STATUS_TABLE_SIZE];
-#else
-    uint8_t status_table[DIRTY_STATUS_TABLE_SIZE];
-#endif
+    struct env_node_obj env;
 
     /* need find ENV */
     if (!old_env) {
-        struct env_node_obj env;
         /* find ENV */
         if (find_env(key, &env)) {
             old_env = &env;
@@ -1093,21 +2227,22 @@ static EfErrCode del_env(const char *key, env_node_obj_t old_env, bool complete_
     } else {
         result = write_status(old_env->addr.start, status_table, ENV_STATUS_NUM, ENV_DELETED);
 
-        if (!last_is_complete_del && result == EF_NO_ERR) {
+        if (!last_is_complete_del && key && result == EF_NO_ERR) {
 #ifdef EF_ENV_USING_CACHE
             /* only delete the ENV in flash and cache when only using del_env(key, env, true) in ef_del_env() */
             update_env_cache(key, strlen(key), FAILED_ADDR);
 #endif /* EF_ENV_USING_CACHE */
+
+#ifdef EF_ENV_USING_INDEX
+            update_env_index(key, strlen(key), FAILED_ADDR);
+#endif /* EF_ENV_USING_INDEX */
         }
 
         last_is_complete_del = false;
     }
 
-    dirty_status_addr = EF_ALIGN_DOWN(old_env->addr.start, SECTOR_SIZE) + SECTOR_DIRTY_OFFSET;
-    /* read and change the sector dirty status */
-    if (result == EF_NO_ERR
-            && read_status(dirty_status_addr, status_table, SECTOR_DIRTY_STATUS_NUM) == SECTOR_DIRTY_FALSE) {
-        result = write_status(dirty_status_addr, status_table, SECTOR_DIRTY_STATUS_NUM, SECTOR_DIRTY_TRUE);
+    if (result == EF_NO_ERR) {
+        result = set_sec_dirty(old_env->addr.start);
     }
 
     return result;
@@ -1147,9 +2282,10 @@ static EfErrCode move_env(env_node_obj_t env)
     {
         uint8_t buf[32];
         size_t len, size, env_len = env->len;
+        bool is_full = false;
 
         /* update the new ENV sector status first */
-        update_sec_status(&sector, env->len, NULL);
+        update_sec_status(&sector, env->len, &is_full);
 
         write_status(env_addr, status_table, ENV_STATUS_NUM, ENV_PRE_WRITE);
         env_len -= ENV_MAGIC_OFFSET;
@@ -1165,10 +2301,16 @@ static EfErrCode move_env(env_node_obj_t env)
         write_status(env_addr, status_table, ENV_STATUS_NUM, ENV_WRITE);
 
 #ifdef EF_ENV_USING_CACHE
-        update_sector_cache(EF_ALIGN_DOWN(env_addr, SECTOR_SIZE),
-                env_addr + ENV_HDR_DATA_SIZE + EF_WG_ALIGN(env->name_len) + EF_WG_ALIGN(env->value_len));
+        /* the full sector is NOT cached */
+        if (!is_full) {
+            update_sector_cache(EF_ALIGN_DOWN(env_addr, SECTOR_SIZE), env_addr + env->len);
+        }
         update_env_cache(env->name, env->name_len, env_addr);
 #endif /* EF_ENV_USING_CACHE */
+
+#ifdef EF_ENV_USING_INDEX
+        update_env_index(env->name, env->name_len, env_addr);
+#endif /* EF_ENV_USING_INDEX */
     }
 
     EF_DEBUG("Moved the ENV (%.*s) from 0x%08X to 0x%08X.\n", env->name_len, env->name, env->addr.start, env_addr);
@@ -1179,11 +2321,22 @@ __exit:
     return result;
 }
 
+#ifdef EF_ENV_USING_INCREMENTAL_GC
+static bool gc_collect_step(size_t empty_sec_threshold, bool idle);
+#endif
+
 static uint32_t new_env(sector_meta_data_t sector, size_t env_size)
 {
-    bool already_gc = false;
     uint32_t empty_env = FAILED_ADDR;
 
+#ifdef EF_ENV_USING_INCREMENTAL_GC
+    /* GC step by step until the ENV is allocated, the idle GC steps make it rarely happen */
+    while ((empty_env = alloc_env(sector, env_size)) == FAILED_ADDR && gc_collect_step(EF_GC_EMPTY_SEC_THRESHOLD, false)) {
+        EF_DEBUG("Warning: Alloc an ENV (size %d) failed when new ENV. Now will GC one step then retry.\n", env_size);
+    }
+#else
+    bool already_gc = false;
+
 __retry:
 
     if ((empty_env = alloc_env(sector, env_size)) == FAILED_ADDR && gc_request && !already_gc) {
@@ -1192,6 +2345,7 @@ __retry:
         already_gc = true;
         goto __retry;
     }
+#endif /* EF_ENV_USING_INCREMENTAL_GC */
 
     return empty_env;
 }
@@ -1203,6 +2357,53 @@ static uint32_t new_env_by_kv(sector_meta_data_t sector, size_t key_len, size_t
     return new_env(sector, env_len);
 }
 
+/*
+ * Get the size of the ENV which will be moved when the sector is collected. Only the ENV header is read.
+ *
+ * @param sec_addr the sector address
+ * @param max_len the max length of the ENV which will be moved
+ */
+static size_t get_sector_live_size(uint32_t sec_addr, size_t *max_len)
+{
+    struct env_hdr_data env_hdr;
+    uint32_t addr = sec_addr + SECTOR_HDR_DATA_SIZE, end = sec_addr + SECTOR_SIZE;
+    size_t live_size = 0;
+    env_status_t status;
+
+    *max_len = 0;
+    while (addr != FAILED_ADDR && addr + ENV_HDR_DATA_SIZE <= end) {
+        ef_port_read(addr, (uint32_t *) &env_hdr, sizeof(struct env_hdr_data));
+        if (env_hdr.magic != ENV_MAGIC_WORD || env_hdr.len < ENV_HDR_DATA_SIZE
+                || env_hdr.len > SECTOR_SIZE - SECTOR_HDR_DATA_SIZE) {
+            /* the free space or a broken ENV, find the next ENV after it */
+            addr = find_next_env_addr(addr + EF_WG_ALIGN(1), SECTOR_MAGIC_SCAN_END(sec_addr));
+            continue;
+        }
+        status = (env_status_t) get_status(env_hdr.status_table, ENV_STATUS_NUM);
+        if (status == ENV_WRITE || status == ENV_PRE_DELETE) {
+            live_size += env_hdr.len;
+            if (env_hdr.len > *max_len) {
+                *max_len = env_hdr.len;
+            }
+        }
+        addr += env_hdr.len;
+    }
+
+    return live_size;
+}
+
+/*
+ * The interrupted move leaves a torn copy in the reserved empty sector, and the recovery moves the ENV again.
+ * So the dirty sector is NOT collected until the reserved sector has the space for the torn copies of a power
+ * loss in the GC and one in the recovery, it frees little space anyway.
+ */
+static bool gc_sector_fits(size_t live_size, size_t max_len)
+{
+    return live_size + 2 * max_len <= SECTOR_SIZE - SECTOR_HDR_DATA_SIZE;
+}
+
+#ifndef EF_ENV_USING_INCREMENTAL_GC
+#ifndef EF_ENV_USING_WEAR_LEVELING
 static bool gc_check_cb(sector_meta_data_t sector, void *arg1, void *arg2)
 {
     size_t *empty_sec = arg1;
@@ -1214,13 +2415,23 @@ static bool gc_check_cb(sector_meta_data_t sector, void *arg1, void *arg2)
     return false;
 
 }
+#endif /* EF_ENV_USING_WEAR_LEVELING */
 
 static bool do_gc(sector_meta_data_t sector, void *arg1, void *arg2)
 {
     struct env_node_obj env;
+    size_t live_size, max_len;
+    bool moved = true;
 
     if (sector->check_ok && (sector->status.dirty == SECTOR_DIRTY_TRUE || sector->status.dirty == SECTOR_DIRTY_GC)) {
         uint8_t status_table[DIRTY_STATUS_TABLE_SIZE];
+        /* the GC which is interrupted by power down is always finished */
+        if (sector->status.dirty == SECTOR_DIRTY_TRUE) {
+            live_size = get_sector_live_size(sector->addr, &max_len);
+            if (!gc_sector_fits(live_size, max_len)) {
+                return false;
+            }
+        }
         /* change the sector status to GC */
         write_status(sector->addr + SECTOR_DIRTY_OFFSET, status_table, SECTOR_DIRTY_STATUS_NUM, SECTOR_DIRTY_GC);
         /* search all ENV */
@@ -1231,23 +2442,297 @@ static bool do_gc(sector_meta_data_t sector, void *arg1, void *arg2)
                 /* move the ENV to new space */
                 if (move_env(&env) != EF_NO_ERR) {
                     EF_DEBUG("Error: Moved the ENV (%.*s) for GC failed.\n", env.name_len, env.name);
+                    moved = false;
                 }
             }
         }
-        format_sector(sector->addr, SECTOR_NOT_COMBINED);
-        EF_DEBUG("Collect a sector @0x%08X\n", sector->addr);
+        /* the ENV which is NOT moved is kept, the sector is collected again by the next GC */
+        if (moved) {
+            format_sector(sector->addr, SECTOR_NOT_COMBINED);
+            EF_DEBUG("Collect a sector @0x%08X\n", sector->addr);
+        }
     }
 
     return false;
 }
+#endif /* EF_ENV_USING_INCREMENTAL_GC */
 
+#if defined(EF_ENV_USING_INCREMENTAL_GC) || defined(EF_ENV_USING_WEAR_LEVELING)
 /*
- * The GC will be triggered on the following scene:
- * 1. alloc an ENV when the flash not has enough space
- * 2. write an ENV then the flash not has enough space
+ * The GC cost of the dirty sector is the ENV size to be moved. With the wear leveling, every
+ * EF_ENV_WL_THRESHOLD erases more than the least worn sector cost a sector size more, so the sector which
+ * has the most reclaimable space and the less wear goes first.
  */
-static void gc_collect(void)
+static uint64_t gc_sector_cost(gc_select_t select, sector_meta_data_t sector, size_t live_size)
 {
+#ifdef EF_ENV_USING_WEAR_LEVELING
+    return (uint64_t) live_size * EF_ENV_WL_THRESHOLD
+            + (uint64_t) (sector->erase_count - select->wear_min) * SECTOR_SIZE;
+#else
+    return live_size;
+#endif
+}
+
+static bool gc_check_cb(sector_meta_data_t sector, void *arg1, void *arg2)
+{
+    gc_select_t select = arg1;
+
+    if (sector->check_ok) {
+        if (sector->status.store == SECTOR_STORE_EMPTY) {
+            select->empty_sec++;
+        } else if (sector->status.dirty == SECTOR_DIRTY_GC) {
+            /* the GC which is interrupted by power down */
+            select->sector = *sector;
+        }
+#ifdef EF_ENV_USING_WEAR_LEVELING
+        if (sector->erase_count < select->wear_min) {
+            select->wear_min = sector->erase_count;
+        }
+        if (sector->erase_count > select->wear_max) {
+            select->wear_max = sector->erase_count;
+        }
+        if (sector->status.store == SECTOR_STORE_FULL && sector->status.dirty != SECTOR_DIRTY_GC
+                && (select->cold_sector.addr == FAILED_ADDR || sector->erase_count < select->cold_sector.erase_count)) {
+            select->cold_sector = *sector;
+        }
+#endif /* EF_ENV_USING_WEAR_LEVELING */
+    }
+
+    return false;
+}
+
+/*
+ * Select the dirty sector which has the least GC cost. The full sector goes first, the using
+ * sector is the last choice because its free space will be erased too.
+ */
+static bool gc_select_cb(sector_meta_data_t sector, void *arg1, void *arg2)
+{
+    gc_select_t select = arg1;
+    size_t live_size, max_len;
+    uint64_t cost;
+
+    if (sector->check_ok && sector->status.dirty == SECTOR_DIRTY_TRUE
+            && (sector->status.store == SECTOR_STORE_FULL || !select->full_only)) {
+        if (select->sector.addr != FAILED_ADDR && select->sector.status.store == SECTOR_STORE_FULL
+                && sector->status.store == SECTOR_STORE_USING) {
+            return false;
+        }
+        live_size = get_sector_live_size(sector->addr, &max_len);
+        if (!gc_sector_fits(live_size, max_len)) {
+            return false;
+        }
+        cost = gc_sector_cost(select, sector, live_size);
+        if (select->sector.addr == FAILED_ADDR || cost < select->cost
+                || (select->sector.status.store == SECTOR_STORE_USING && sector->status.store == SECTOR_STORE_FULL)) {
+            select->sector = *sector;
+            select->cost = cost;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Select the sector to be collected. The GC which is interrupted by power down goes first, then the dirty
+ * sector when the remain empty sector is less than or equal to the threshold. With the wear leveling, the
+ * least worn full sector goes before the dirty sector when it's EF_ENV_WL_THRESHOLD erases behind the most
+ * worn one, its cold ENV are moved to the most worn empty sector. The move takes an empty sector and frees
+ * the cold one, so the empty sector number is NOT changed.
+ *
+ * @param select the selected sector
+ * @param empty_sec_threshold select the dirty sector when the remain empty sector is less than or equal to it
+ * @param full_only only select the full dirty sector
+ * @param cold the cold sector can be selected
+ */
+static void gc_select_sector(gc_select_t select, size_t empty_sec_threshold, bool full_only, bool cold)
+{
+    struct sector_meta_data sector;
+
+    select->sector.addr = FAILED_ADDR;
+    select->empty_sec = 0;
+    select->full_only = full_only;
+#ifdef EF_ENV_USING_WEAR_LEVELING
+    select->cold = false;
+    select->cold_sector.addr = FAILED_ADDR;
+    select->wear_min = 0xFFFFFFFF;
+    select->wear_max = 0;
+#endif
+    sector_iterator(&sector, SECTOR_STORE_UNUSED, select, NULL, gc_check_cb, false);
+    if (select->sector.addr == FAILED_ADDR && select->empty_sec <= empty_sec_threshold) {
+        sector_iterator(&sector, SECTOR_STORE_UNUSED, select, NULL, gc_select_cb, false);
+    }
+#ifdef EF_ENV_USING_WEAR_LEVELING
+    if (cold && (select->sector.addr == FAILED_ADDR || select->sector.status.dirty != SECTOR_DIRTY_GC)
+            && select->cold_sector.addr != FAILED_ADDR && select->empty_sec >= EF_GC_EMPTY_SEC_THRESHOLD
+            && select->wear_max - select->cold_sector.erase_count > EF_ENV_WL_THRESHOLD) {
+        select->sector = select->cold_sector;
+        select->cold = true;
+    }
+#endif /* EF_ENV_USING_WEAR_LEVELING */
+}
+#endif /* defined(EF_ENV_USING_INCREMENTAL_GC) || defined(EF_ENV_USING_WEAR_LEVELING) */
+
+#ifdef EF_ENV_USING_INCREMENTAL_GC
+/*
+ * Collect the dirty sector step by step. Every step moves EF_GC_STEP_MOVE_MAX ENV at most (and runs
+ * EF_GC_STEP_TIME_US at most) or formats the collected sector. The collecting sector is SECTOR_DIRTY_GC,
+ * so alloc_env never uses it between steps and the recovery will resume it.
+ *
+ * @param empty_sec_threshold start to collect a new sector when the remain empty sector is less than or equal to it
+ * @param idle the idle step only collects the full sector
+ *
+ * @return true: the step has done some work
+ */
+static bool gc_collect_step(size_t empty_sec_threshold, bool idle)
+{
+    struct env_node_obj last_env;
+    struct gc_select select;
+    size_t moved = 0;
+    uint32_t env_addr;
+
+#if EF_GC_STEP_TIME_US > 0
+    uint32_t start_time = ef_port_get_time_us();
+#endif
+
+    if (gc_sector.addr == FAILED_ADDR) {
+        gc_select_sector(&select, empty_sec_threshold, idle, true);
+        if (select.sector.addr == FAILED_ADDR) {
+            gc_request = false;
+            return false;
+        }
+        gc_sector = select.sector;
+#ifdef EF_ENV_USING_WEAR_LEVELING
+        gc_cold_move = select.cold;
+#endif
+        if (gc_sector.status.dirty != SECTOR_DIRTY_GC) {
+            uint8_t status_table[DIRTY_STATUS_TABLE_SIZE];
+            /* change the sector status to GC */
+            write_status(gc_sector.addr + SECTOR_DIRTY_OFFSET, status_table, SECTOR_DIRTY_STATUS_NUM, SECTOR_DIRTY_GC);
+            gc_sector.status.dirty = SECTOR_DIRTY_GC;
+        }
+        gc_env.addr.start = FAILED_ADDR;
+        EF_DEBUG("Start to collect a sector @0x%08X, the remain empty sector is %d.\n", gc_sector.addr, select.empty_sec);
+    }
+
+    /* the ENV move can use the reserved empty sector */
+    gc_request = true;
+    while ((env_addr = get_next_env_addr(&gc_sector, &gc_env)) != FAILED_ADDR) {
+        if (moved >= EF_GC_STEP_MOVE_MAX
+#if EF_GC_STEP_TIME_US > 0
+                || ef_port_get_time_us() - start_time >= EF_GC_STEP_TIME_US
+#endif
+                ) {
+            /* continue on the next step */
+            gc_request = false;
+            return true;
+        }
+        last_env = gc_env;
+        gc_env.addr.start = env_addr;
+        read_env(&gc_env);
+        if (gc_env.crc_is_ok && (gc_env.status == ENV_WRITE || gc_env.status == ENV_PRE_DELETE)) {
+            /* move the ENV to new space */
+            if (move_env(&gc_env) != EF_NO_ERR) {
+                EF_DEBUG("Error: Moved the ENV (%.*s) for GC failed.\n", gc_env.name_len, gc_env.name);
+                /* retry it on the next step, the sector must NOT be formatted before all ENV moved */
+                gc_env = last_env;
+                gc_request = false;
+                return false;
+            }
+            moved++;
+        }
+    }
+    /* the sector format is a single step */
+    if (moved == 0) {
+        format_sector(gc_sector.addr, SECTOR_NOT_COMBINED);
+        EF_DEBUG("Collect a sector @0x%08X\n", gc_sector.addr);
+        gc_sector.addr = FAILED_ADDR;
+        gc_dst_sector = FAILED_ADDR;
+#ifdef EF_ENV_USING_WEAR_LEVELING
+        gc_cold_move = false;
+#endif
+#ifdef EF_ENV_USING_SNAPSHOT
+        gc_snapshot_request = true;
+#endif
+    }
+    gc_request = false;
+
+    return true;
+}
+
+/*
+ * Only one GC step is done when the GC is triggered, the others are done by ef_env_gc_step or next trigger.
+ */
+static void gc_collect(void)
+{
+    gc_collect_step(EF_GC_EMPTY_SEC_THRESHOLD, false);
+}
+
+/**
+ * Do one incremental GC step, it's designed for the idle hook.
+ * It starts to collect a dirty sector when the remain empty sector is less than or equal to
+ * EF_GC_IDLE_EMPTY_SEC_THRESHOLD, so the ENV set rarely waits for the GC.
+ *
+ * @return true: the step has done some work, false: nothing to be collected now
+ */
+bool ef_env_gc_step(void)
+{
+    bool result;
+
+    if (!init_ok) {
+        EF_INFO("ENV isn't initialize OK.\n");
+        return false;
+    }
+
+    /* lock the ENV cache */
+    ef_port_env_lock();
+
+    result = gc_collect_step(EF_GC_IDLE_EMPTY_SEC_THRESHOLD, true);
+
+#ifdef EF_ENV_USING_SNAPSHOT
+    /* the idle GC is finished, the ENV will not be changed soon */
+    if (!result && gc_snapshot_request) {
+        gc_snapshot_request = false;
+        save_env_snapshot();
+    }
+#endif /* EF_ENV_USING_SNAPSHOT */
+
+    /* unlock the ENV cache */
+    ef_port_env_unlock();
+
+    return result;
+}
+#else
+/*
+ * The GC will be triggered on the following scene:
+ * 1. alloc an ENV when the flash not has enough space
+ * 2. write an ENV then the flash not has enough space
+ */
+static void gc_collect(void)
+{
+#ifdef EF_ENV_USING_WEAR_LEVELING
+    struct gc_select select;
+    bool cold_moved = false;
+    size_t i;
+
+    /* collect the least cost dirty sector one by one until the empty sector is enough, the static wear leveling
+     * moves one cold sector at most */
+    for (i = 0; i < SECTOR_NUM; i++) {
+        gc_select_sector(&select, EF_GC_EMPTY_SEC_THRESHOLD, false, !cold_moved);
+        if (select.sector.addr == FAILED_ADDR) {
+            break;
+        }
+        if (select.cold) {
+            uint8_t status_table[DIRTY_STATUS_TABLE_SIZE];
+            /* the cold sector is collected as the dirty sector */
+            write_status(select.sector.addr + SECTOR_DIRTY_OFFSET, status_table, SECTOR_DIRTY_STATUS_NUM, SECTOR_DIRTY_GC);
+            select.sector.status.dirty = SECTOR_DIRTY_GC;
+            cold_moved = true;
+        }
+        gc_cold_move = select.cold;
+        do_gc(&select.sector, NULL, NULL);
+        gc_cold_move = false;
+    }
+#else
     struct sector_meta_data sector;
     size_t empty_sec = 0;
 
@@ -1259,9 +2744,11 @@ static void gc_collect(void)
     if (empty_sec <= EF_GC_EMPTY_SEC_THRESHOLD) {
         sector_iterator(&sector, SECTOR_STORE_UNUSED, NULL, NULL, do_gc, false);
     }
+#endif /* EF_ENV_USING_WEAR_LEVELING */
 
     gc_request = false;
 }
+#endif /* EF_ENV_USING_INCREMENTAL_GC */
 
 static EfErrCode align_write(uint32_t addr, const uint32_t *buf, size_t size)
 {
@@ -1289,7 +2776,43 @@ static EfErrCode align_write(uint32_t addr, const uint32_t *buf, size_t size)
     return result;
 }
 
-static EfErrCode create_env_blob(sector_meta_data_t sector, const char *key, const void *value, size_t len)
+static void init_env_hdr(env_hdr_data_t env_hdr, const char *key, size_t len)
+{
+    memset(env_hdr, 0xFF, sizeof(struct env_hdr_data));
+    env_hdr->magic = ENV_MAGIC_WORD;
+    env_hdr->name_len = strlen(key);
+    env_hdr->value_len = len;
+    env_hdr->len = ENV_HDR_DATA_SIZE + EF_WG_ALIGN(env_hdr->name_len) + EF_WG_ALIGN(env_hdr->value_len);
+}
+
+static void calc_env_crc(env_hdr_data_t env_hdr, const char *key, const void *value)
+{
+    size_t align_remain;
+    uint8_t ff = 0xFF;
+
+    env_hdr->crc32 = ef_env_calc_crc32(0, &env_hdr->name_len, sizeof(struct env_hdr_data) - ENV_NAME_LEN_OFFSET);
+    /* the header padding (64bit write granularity) is 0xFF on flash */
+    align_remain = ENV_HDR_DATA_SIZE - sizeof(struct env_hdr_data);
+    while (align_remain--) {
+        env_hdr->crc32 = ef_env_calc_crc32(env_hdr->crc32, &ff, 1);
+    }
+    env_hdr->crc32 = ef_env_calc_crc32(env_hdr->crc32, key, env_hdr->name_len);
+    align_remain = EF_WG_ALIGN(env_hdr->name_len) - env_hdr->name_len;
+    while (align_remain--) {
+        env_hdr->crc32 = ef_env_calc_crc32(env_hdr->crc32, &ff, 1);
+    }
+    env_hdr->crc32 = ef_env_calc_crc32(env_hdr->crc32, value, env_hdr->value_len);
+    align_remain = EF_WG_ALIGN(env_hdr->value_len) - env_hdr->value_len;
+    while (align_remain--) {
+        env_hdr->crc32 = ef_env_calc_crc32(env_hdr->crc32, &ff, 1);
+    }
+}
+
+/*
+ * Create an ENV, the raw_len is the value length before compression when the value is compressed, otherwise 0.
+ */
+static EfErrCode create_env_blob(sector_meta_data_t sector, const char *key, const void *value, size_t len,
+        size_t raw_len)
 {
     EfErrCode result = EF_NO_ERR;
     struct env_hdr_data env_hdr;
@@ -1301,11 +2824,11 @@ static EfErrCode create_env_blob(sector_meta_data_t sector, const char *key, con
         return EF_ENV_NAME_ERR;
     }
 
-    memset(&env_hdr, 0xFF, sizeof(struct env_hdr_data));
-    env_hdr.magic = ENV_MAGIC_WORD;
-    env_hdr.name_len = strlen(key);
-    env_hdr.value_len = len;
-    env_hdr.len = ENV_HDR_DATA_SIZE + EF_WG_ALIGN(env_hdr.name_len) + EF_WG_ALIGN(env_hdr.value_len);
+    init_env_hdr(&env_hdr, key, len);
+    if (raw_len) {
+        env_hdr.flags &= ~ENV_FLAG_COMPRESSED;
+        env_hdr.raw_len = (uint16_t) raw_len;
+    }
 
     if (env_hdr.len > SECTOR_SIZE - SECTOR_HDR_DATA_SIZE) {
         EF_INFO("Error: The ENV size is too big\n");
@@ -1313,25 +2836,13 @@ static EfErrCode create_env_blob(sector_meta_data_t sector, const char *key, con
     }
 
     if (env_addr != FAILED_ADDR || (env_addr = new_env(sector, env_hdr.len)) != FAILED_ADDR) {
-        size_t align_remain;
         /* update the sector status */
         if (result == EF_NO_ERR) {
             result = update_sec_status(sector, env_hdr.len, &is_full);
         }
         if (result == EF_NO_ERR) {
-            uint8_t ff = 0xFF;
             /* start calculate CRC32 */
-            env_hdr.crc32 = ef_calc_crc32(0, &env_hdr.name_len, ENV_HDR_DATA_SIZE - ENV_NAME_LEN_OFFSET);
-            env_hdr.crc32 = ef_calc_crc32(env_hdr.crc32, key, env_hdr.name_len);
-            align_remain = EF_WG_ALIGN(env_hdr.name_len) - env_hdr.name_len;
-            while (align_remain--) {
-                env_hdr.crc32 = ef_calc_crc32(env_hdr.crc32, &ff, 1);
-            }
-            env_hdr.crc32 = ef_calc_crc32(env_hdr.crc32, value, env_hdr.value_len);
-            align_remain = EF_WG_ALIGN(env_hdr.value_len) - env_hdr.value_len;
-            while (align_remain--) {
-                env_hdr.crc32 = ef_calc_crc32(env_hdr.crc32, &ff, 1);
-            }
+            calc_env_crc(&env_hdr, key, value);
             /* write ENV header data */
             result = write_env_hdr(env_addr, &env_hdr);
 
@@ -1347,6 +2858,10 @@ static EfErrCode create_env_blob(sector_meta_data_t sector, const char *key, con
             }
             update_env_cache(key, env_hdr.name_len, env_addr);
 #endif /* EF_ENV_USING_CACHE */
+
+#ifdef EF_ENV_USING_INDEX
+            update_env_index(key, env_hdr.name_len, env_addr);
+#endif /* EF_ENV_USING_INDEX */
         }
         /* write value */
         if (result == EF_NO_ERR) {
@@ -1388,7 +2903,11 @@ EfErrCode ef_del_env(const char *key)
     /* lock the ENV cache */
     ef_port_env_lock();
 
+#ifdef EF_ENV_USING_WRITE_BACK
+    result = set_env_wb(key, NULL, 0);
+#else
     result = del_env(key, NULL, true);
+#endif
 
     /* unlock the ENV cache */
     ef_port_env_unlock();
@@ -1417,10 +2936,23 @@ static EfErrCode set_env(const char *key, const void *value_buf, size_t buf_len)
     static struct env_node_obj env;
     static struct sector_meta_data sector;
     bool env_is_found = false;
+    size_t raw_len = 0;
 
     if (value_buf == NULL) {
         result = del_env(key, NULL, true);
     } else {
+#ifdef EF_ENV_USING_COMPRESS
+        /* the compressed value is saved when it's smaller on flash */
+        if (buf_len >= EF_ENV_COMPRESS_MIN_SIZE && buf_len <= ENV_COMPRESS_MAX_SIZE) {
+            size_t zip_len = lz_compress(value_buf, buf_len);
+
+            if (zip_len > 0 && EF_WG_ALIGN(zip_len) < EF_WG_ALIGN(buf_len)) {
+                raw_len = buf_len;
+                value_buf = env_lz_buf;
+                buf_len = zip_len;
+            }
+        }
+#endif /* EF_ENV_USING_COMPRESS */
         /* make sure the flash has enough space */
         if (new_env_by_kv(&sector, strlen(key), buf_len) == FAILED_ADDR) {
             return EF_ENV_FULL;
@@ -1432,7 +2964,7 @@ static EfErrCode set_env(const char *key, const void *value_buf, size_t buf_len)
         }
         /* create the new ENV */
         if (result == EF_NO_ERR) {
-            result = create_env_blob(&sector, key, value_buf, buf_len);
+            result = create_env_blob(&sector, key, value_buf, buf_len, raw_len);
         }
         /* delete the old ENV */
         if (env_is_found && result == EF_NO_ERR) {
@@ -1447,6 +2979,100 @@ static EfErrCode set_env(const char *key, const void *value_buf, size_t buf_len)
     return result;
 }
 
+#ifdef EF_ENV_USING_WRITE_BACK
+/*
+ * Write back all dirty cached ENV to flash.
+ */
+static EfErrCode env_wb_flush(void)
+{
+    EfErrCode result = EF_NO_ERR, set_result;
+    size_t i;
+
+    for (i = 0; i < ENV_WB_TABLE_SIZE; i++) {
+        if (env_wb_table[i].dirty) {
+            set_result = set_env(env_wb_keys[i], env_wb_table[i].value, env_wb_table[i].value_len);
+            if (set_result == EF_NO_ERR) {
+                env_wb_table[i].dirty = false;
+            } else {
+                EF_INFO("Error: Write back the ENV (%s) failed (%d).\n", env_wb_keys[i], set_result);
+                result = set_result;
+            }
+        }
+    }
+    if (result == EF_NO_ERR) {
+        env_wb_dirty_count = 0;
+    }
+#if EF_ENV_WB_PERIOD_MS > 0
+    env_wb_time = ef_port_get_time_us();
+#endif
+
+    return result;
+}
+
+/*
+ * Write back the cached ENV when the dirty set number or the period is reached.
+ */
+static EfErrCode env_wb_poll(void)
+{
+    if (env_wb_dirty_count == 0) {
+        return EF_NO_ERR;
+    }
+#if EF_ENV_WB_DIRTY_MAX > 0
+    if (env_wb_dirty_count >= EF_ENV_WB_DIRTY_MAX) {
+        return env_wb_flush();
+    }
+#endif
+#if EF_ENV_WB_PERIOD_MS > 0
+    if (ef_port_get_time_us() - env_wb_time >= EF_ENV_WB_PERIOD_MS * 1000UL) {
+        return env_wb_flush();
+    }
+#endif
+
+    return EF_NO_ERR;
+}
+
+/*
+ * Set the ENV by the write back cache when it's in EF_ENV_WRITE_BACK_KEYS, the others are set to flash.
+ */
+static EfErrCode set_env_wb(const char *key, const void *value_buf, size_t buf_len)
+{
+    EfErrCode result;
+    env_wb_node_t wb_node = find_env_wb(key);
+    bool dirty;
+
+    if (wb_node == NULL) {
+        return set_env(key, value_buf, buf_len);
+    }
+
+    if (value_buf == NULL || buf_len > EF_ENV_WB_VALUE_MAX) {
+        /* the delete and the long value are written through */
+        dirty = wb_node->dirty;
+        wb_node->valid = false;
+        wb_node->dirty = false;
+        result = set_env(key, value_buf, buf_len);
+        if (value_buf == NULL && dirty && result == EF_ENV_NAME_ERR) {
+            /* the ENV only has been saved in the cache */
+            result = EF_NO_ERR;
+        }
+        return result;
+    }
+
+    if (wb_node->valid && wb_node->value_len == buf_len && !memcmp(wb_node->value, value_buf, buf_len)) {
+        /* the value is NOT changed */
+        return EF_NO_ERR;
+    }
+    memcpy(wb_node->value, value_buf, buf_len);
+    wb_node->value_len = buf_len;
+    wb_node->valid = true;
+    wb_node->dirty = true;
+    env_wb_dirty_count++;
+    /* the value on flash is stale */
+    env_gen++;
+
+    return env_wb_poll();
+}
+#endif /* EF_ENV_USING_WRITE_BACK */
+
 /**
  * Set a blob ENV. If it value is NULL, delete it.
  * If not find it in flash, then create it.
@@ -1470,7 +3096,11 @@ EfErrCode ef_set_env_blob(const char *key, const void *value_buf, size_t buf_len
     /* lock the ENV cache */
     ef_port_env_lock();
 
+#ifdef EF_ENV_USING_WRITE_BACK
+    result = set_env_wb(key, value_buf, buf_len);
+#else
     result = set_env(key, value_buf, buf_len);
+#endif
 
     /* unlock the ENV cache */
     ef_port_env_unlock();
@@ -1509,86 +3139,588 @@ EfErrCode ef_set_and_save_env(const char *key, const char *value)
 }
 
 /**
- * Save ENV to flash.
+ * Clean the staged ENV of the batch.
  *
- * @note this function is DEPRECATED
+ * @param batch ENV batch
  */
-EfErrCode ef_save_env(void)
+void ef_env_batch_init(ef_env_batch_t batch)
 {
-    /* do nothing not cur mode */
-    return EF_NO_ERR;
+    EF_ASSERT(batch);
+
+    batch->num = 0;
 }
 
 /**
- * ENV set default.
+ * Stage a blob ENV update to the batch. If it value is NULL, delete it.
+ * The later update of the same key overrides the former one.
+ *
+ * @note the key and value buffer are NOT copied, they must be valid until the batch is committed
+ *
+ * @param batch ENV batch
+ * @param key ENV name
+ * @param value_buf ENV value
+ * @param buf_len ENV value length
  *
  * @return result
  */
-EfErrCode ef_env_set_default(void)
+EfErrCode ef_env_batch_set(ef_env_batch_t batch, const char *key, const void *value_buf, size_t buf_len)
 {
-    EfErrCode result = EF_NO_ERR;
-    uint32_t addr, i, value_len;
-    struct sector_meta_data sector;
+    size_t i;
 
-    EF_ASSERT(default_env_set);
-    EF_ASSERT(default_env_set_size);
+    EF_ASSERT(batch);
+    EF_ASSERT(key);
 
-    /* lock the ENV cache */
-    ef_port_env_lock();
-    /* format all sectors */
-    for (addr = env_start_addr; addr < env_start_addr + ENV_AREA_SIZE; addr += SECTOR_SIZE) {
-        result = format_sector(addr, SECTOR_NOT_COMBINED);
-        if (result != EF_NO_ERR) {
-            goto __exit;
+    if (strlen(key) > EF_ENV_NAME_MAX) {
+        EF_INFO("Error: The ENV name length is more than %d\n", EF_ENV_NAME_MAX);
+        return EF_ENV_NAME_ERR;
+    }
+
+    for (i = 0; i < batch->num; i++) {
+        if (!strcmp(batch->env[i].key, key)) {
+            break;
         }
     }
-    /* create default ENV */
-    for (i = 0; i < default_env_set_size; i++) {
-        /* It seems to be a string when value length is 0.
-         * This mechanism is for compatibility with older versions (less then V4.0). */
-        if (default_env_set[i].value_len == 0) {
-            value_len = strlen(default_env_set[i].value);
+    if (i == batch->num) {
+        if (batch->num >= EF_ENV_BATCH_MAX) {
+            EF_INFO("Error: The ENV batch is full, please increase the EF_ENV_BATCH_MAX.\n");
+            return EF_ENV_FULL;
+        }
+        batch->num++;
+    }
+    batch->env[i].key = key;
+    batch->env[i].value = value_buf;
+    batch->env[i].value_len = buf_len;
+
+    return EF_NO_ERR;
+}
+
+/*
+ * Append data to the batch writer, the buffer is written to flash when it's full.
+ * The data is 0xFF padding when data is NULL.
+ */
+static EfErrCode batch_write(env_batch_writer_t writer, const void *data, size_t size)
+{
+    EfErrCode result = EF_NO_ERR;
+    size_t copy_size;
+
+    while (size && result == EF_NO_ERR) {
+        copy_size = sizeof(writer->buf) - writer->len;
+        if (copy_size > size) {
+            copy_size = size;
+        }
+        if (data) {
+            memcpy((uint8_t *) writer->buf + writer->len, data, copy_size);
+            data = (const uint8_t *) data + copy_size;
         } else {
-            value_len = default_env_set[i].value_len;
+            memset((uint8_t *) writer->buf + writer->len, 0xFF, copy_size);
         }
-        sector.empty_env = FAILED_ADDR;
-        create_env_blob(&sector, default_env_set[i].key, default_env_set[i].value, value_len);
-        if (result != EF_NO_ERR) {
-            goto __exit;
+        writer->len += copy_size;
+        size -= copy_size;
+        if (writer->len == sizeof(writer->buf)) {
+            result = ef_port_write(writer->addr, writer->buf, writer->len);
+            writer->addr += writer->len;
+            writer->len = 0;
         }
     }
 
-__exit:
-    /* unlock the ENV cache */
-    ef_port_env_unlock();
+    return result;
+}
+
+static EfErrCode batch_write_flush(env_batch_writer_t writer)
+{
+    EfErrCode result = EF_NO_ERR;
+
+    if (writer->len) {
+        result = ef_port_write(writer->addr, writer->buf, writer->len);
+        writer->addr += writer->len;
+        writer->len = 0;
+    }
 
     return result;
 }
 
-static bool print_env_cb(env_node_obj_t env, void *arg1, void *arg2)
+/*
+ * Append an ENV to the batch writer. The status table is written with the other data when the write
+ * granularity is 1bit, otherwise it's written alone, because some flash NOT supported repeated write.
+ */
+static EfErrCode batch_write_env(env_batch_writer_t writer, const char *key, const void *value, size_t len,
+        size_t status)
 {
-    bool value_is_str = true, print_value = false;
-    size_t *using_size = arg1;
+    EfErrCode result = EF_NO_ERR;
+    struct env_hdr_data env_hdr;
 
-    if (env->crc_is_ok) {
-        /* calculate the total using flash size */
-        *using_size += env->len;
-        /* check ENV */
-        if (env->status == ENV_WRITE) {
-            ef_print("%.*s=", env->name_len, env->name);
+    init_env_hdr(&env_hdr, key, len);
+    calc_env_crc(&env_hdr, key, value);
 
-            if (env->value_len < EF_STR_ENV_VALUE_MAX_SIZE ) {
-                uint8_t buf[32];
-                size_t len, size;
-__reload:
-                /* check the value is string */
-                for (len = 0, size = 0; len < env->value_len; len += size) {
+#if (EF_WRITE_GRAN == 1)
+    set_status(env_hdr.status_table, ENV_STATUS_NUM, status);
+    result = batch_write(writer, &env_hdr, sizeof(struct env_hdr_data));
+#else
+    result = batch_write_flush(writer);
+    if (result == EF_NO_ERR) {
+        result = write_status(writer->addr, env_hdr.status_table, ENV_STATUS_NUM, status);
+        writer->addr += ENV_MAGIC_OFFSET;
+    }
+    if (result == EF_NO_ERR) {
+        result = batch_write(writer, &env_hdr.magic, sizeof(struct env_hdr_data) - ENV_MAGIC_OFFSET);
+    }
+#endif /* EF_WRITE_GRAN == 1 */
+
+    if (result == EF_NO_ERR) {
+        result = batch_write(writer, NULL, ENV_HDR_DATA_SIZE - sizeof(struct env_hdr_data));
+    }
+    if (result == EF_NO_ERR) {
+        result = batch_write(writer, key, env_hdr.name_len);
+    }
+    if (result == EF_NO_ERR) {
+        result = batch_write(writer, NULL, EF_WG_ALIGN(env_hdr.name_len) - env_hdr.name_len);
+    }
+    if (result == EF_NO_ERR) {
+        result = batch_write(writer, value, env_hdr.value_len);
+    }
+    if (result == EF_NO_ERR) {
+        result = batch_write(writer, NULL, EF_WG_ALIGN(env_hdr.value_len) - env_hdr.value_len);
+    }
+
+    return result;
+}
+
+static bool find_batch_env_cb(env_node_obj_t env, void *arg1, void *arg2)
+{
+    ef_env_batch_t batch = arg1;
+    env_batch_record_t record = arg2;
+    size_t i;
+
+    if (env->crc_is_ok && env->status == ENV_WRITE) {
+        for (i = 0; i < batch->num; i++) {
+            if (record[i].old_addr == FAILED_ADDR && strlen(batch->env[i].key) == env->name_len
+                    && !strncmp(batch->env[i].key, env->name, env->name_len)) {
+                record[i].old_addr = env->addr.start;
+                break;
+            }
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Find all old ENV of the batch. It's only one ENV iteration when the index can't be used.
+ */
+static void find_batch_env(ef_env_batch_t batch, env_batch_record_t record)
+{
+    struct env_node_obj env;
+    size_t i;
+
+#ifdef EF_ENV_USING_INDEX
+    if (env_index_ready && !env_index_overflow) {
+        for (i = 0; i < batch->num; i++) {
+            record[i].old_addr = find_env(batch->env[i].key, &env) ? env.addr.start : FAILED_ADDR;
+        }
+        return;
+    }
+#endif /* EF_ENV_USING_INDEX */
+
+    for (i = 0; i < batch->num; i++) {
+        record[i].old_addr = FAILED_ADDR;
+    }
+    env_iterator(&env, batch, record, find_batch_env_cb);
+}
+
+/*
+ * Finish the committed batch by deleting all old ENV. It's also used by recovery,
+ * so the old ENV which is already deleted will be skipped.
+ */
+static EfErrCode finish_env_batch(env_batch_record_t record, size_t num)
+{
+    EfErrCode result = EF_NO_ERR;
+    uint8_t status_table[ENV_STATUS_TABLE_SIZE];
+    size_t i, status;
+
+    for (i = 0; i < num && result == EF_NO_ERR; i++) {
+        if (record[i].old_addr != FAILED_ADDR) {
+            status = read_status(record[i].old_addr, status_table, ENV_STATUS_NUM);
+            if (status == ENV_WRITE || status == ENV_PRE_DELETE) {
+                result = write_status(record[i].old_addr, status_table, ENV_STATUS_NUM, ENV_DELETED);
+                if (result == EF_NO_ERR) {
+                    result = set_sec_dirty(record[i].old_addr);
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/*
+ * Drop the uncommitted batch by changing all new ENV which has been written to ENV_ERR_HDR.
+ */
+static void drop_env_batch(env_batch_record_t record, size_t num)
+{
+    struct env_hdr_data env_hdr;
+    size_t i, status;
+
+    for (i = 0; i < num; i++) {
+        if (record[i].new_addr != FAILED_ADDR) {
+            ef_port_read(record[i].new_addr, (uint32_t *) &env_hdr, sizeof(struct env_hdr_data));
+            status = get_status(env_hdr.status_table, ENV_STATUS_NUM);
+            if (status != ENV_ERR_HDR && (status != ENV_UNUSED || env_hdr.magic == ENV_MAGIC_WORD)) {
+                write_status(record[i].new_addr, env_hdr.status_table, ENV_STATUS_NUM, ENV_ERR_HDR);
+            }
+        }
+    }
+}
+
+/*
+ * The batch record and all new ENV are written to one sector by one allocation. The new ENV is
+ * written as ENV_WRITE directly, but it's NOT valid until the batch record status is changed to
+ * ENV_WRITE, it's the only commit point of the whole batch. The batch record is always in front of
+ * its ENV, so the recovery drops or finishes the batch by it before any ENV of the batch is checked.
+ */
+static EfErrCode commit_env_batch(ef_env_batch_t batch)
+{
+    EfErrCode result = EF_NO_ERR;
+    struct env_batch_record record[EF_ENV_BATCH_MAX];
+    struct env_batch_writer writer;
+    struct sector_meta_data sector;
+    uint8_t status_table[ENV_STATUS_TABLE_SIZE];
+    size_t i, total_len, record_len = batch->num * sizeof(struct env_batch_record);
+    uint32_t batch_addr, env_addr;
+    bool is_full = false;
+
+    /* the batch record is the first ENV, then the new ENV follow it */
+    total_len = ENV_HDR_DATA_SIZE + EF_WG_ALIGN(sizeof(BATCH_ENV_NAME) - 1) + EF_WG_ALIGN(record_len);
+    for (i = 0; i < batch->num; i++) {
+        if (batch->env[i].value) {
+            total_len += ENV_HDR_DATA_SIZE + EF_WG_ALIGN(strlen(batch->env[i].key))
+                    + EF_WG_ALIGN(batch->env[i].value_len);
+        }
+    }
+    if (total_len > SECTOR_SIZE - SECTOR_HDR_DATA_SIZE) {
+        EF_INFO("Error: The ENV batch size is more than one sector\n");
+        return EF_ENV_FULL;
+    }
+    if ((batch_addr = new_env(&sector, total_len)) == FAILED_ADDR) {
+        return EF_ENV_FULL;
+    }
+    /* find the old ENV after the GC which maybe in new_env */
+    find_batch_env(batch, record);
+    env_addr = batch_addr + ENV_HDR_DATA_SIZE + EF_WG_ALIGN(sizeof(BATCH_ENV_NAME) - 1) + EF_WG_ALIGN(record_len);
+    for (i = 0; i < batch->num; i++) {
+        if (batch->env[i].value) {
+            record[i].new_addr = env_addr;
+            env_addr += ENV_HDR_DATA_SIZE + EF_WG_ALIGN(strlen(batch->env[i].key))
+                    + EF_WG_ALIGN(batch->env[i].value_len);
+        } else {
+            record[i].new_addr = FAILED_ADDR;
+        }
+    }
+
+#ifdef EF_ENV_USING_SNAPSHOT
+    /* the batch writer doesn't write the status first */
+    env_snapshot_drop();
+#endif
+    result = update_sec_status(&sector, total_len, &is_full);
+    /* the batch record is written completely before any new ENV */
+    writer.addr = batch_addr;
+    writer.len = 0;
+    if (result == EF_NO_ERR) {
+        result = batch_write_env(&writer, BATCH_ENV_NAME, record, record_len, ENV_PRE_WRITE);
+    }
+    if (result == EF_NO_ERR) {
+        result = batch_write_flush(&writer);
+    }
+    for (i = 0; i < batch->num && result == EF_NO_ERR; i++) {
+        if (batch->env[i].value) {
+            result = batch_write_env(&writer, batch->env[i].key, batch->env[i].value, batch->env[i].value_len,
+                    ENV_WRITE);
+        }
+    }
+    if (result == EF_NO_ERR) {
+        result = batch_write_flush(&writer);
+    }
+    /* commit the batch */
+    if (result == EF_NO_ERR) {
+        result = write_status(batch_addr, status_table, ENV_STATUS_NUM, ENV_WRITE);
+    }
+    if (result == EF_NO_ERR) {
+        result = finish_env_batch(record, batch->num);
+    } else {
+        drop_env_batch(record, batch->num);
+    }
+    /* the batch record is useless after the batch is finished or dropped */
+    write_status(batch_addr, status_table, ENV_STATUS_NUM, ENV_DELETED);
+    set_sec_dirty(batch_addr);
+
+#ifdef EF_ENV_USING_CACHE
+    if (!is_full) {
+        update_sector_cache(sector.addr, batch_addr + total_len);
+    }
+#endif /* EF_ENV_USING_CACHE */
+
+    for (i = 0; i < batch->num && result == EF_NO_ERR; i++) {
+#ifdef EF_ENV_USING_CACHE
+        update_env_cache(batch->env[i].key, strlen(batch->env[i].key), record[i].new_addr);
+#endif /* EF_ENV_USING_CACHE */
+
+#ifdef EF_ENV_USING_INDEX
+        update_env_index(batch->env[i].key, strlen(batch->env[i].key), record[i].new_addr);
+#endif /* EF_ENV_USING_INDEX */
+
+#ifdef EF_ENV_USING_WRITE_BACK
+        drop_env_wb(batch->env[i].key);
+#endif /* EF_ENV_USING_WRITE_BACK */
+    }
+
+    /* trigger GC collect when current sector is full */
+    if (is_full) {
+        EF_DEBUG("Trigger a GC check after committed ENV batch.\n");
+        gc_request = true;
+    }
+    if (gc_request) {
+        gc_collect();
+    }
+
+    return result;
+}
+
+/**
+ * Commit all staged ENV of the batch by one flash allocation and one status change.
+ * It's atomic on power down, all of the batch or none of it is found after recovery.
+ * The batch is cleaned after committed successful.
+ *
+ * @note the batch record and all new ENV must fit in one sector
+ *
+ * @param batch ENV batch
+ *
+ * @return result
+ */
+EfErrCode ef_env_batch_commit(ef_env_batch_t batch)
+{
+    EfErrCode result = EF_NO_ERR;
+
+    EF_ASSERT(batch);
+
+    if (!init_ok) {
+        EF_INFO("ENV isn't initialize OK.\n");
+        return EF_ENV_INIT_FAILED;
+    }
+
+    if (batch->num == 0) {
+        return EF_NO_ERR;
+    }
+
+    /* lock the ENV cache */
+    ef_port_env_lock();
+
+    result = commit_env_batch(batch);
+
+    /* unlock the ENV cache */
+    ef_port_env_unlock();
+
+    if (result == EF_NO_ERR) {
+        batch->num = 0;
+    }
+
+    return result;
+}
+
+/**
+ * Save ENV to flash. Only the write back cache ENV (EF_ENV_WRITE_BACK_KEYS) need be saved on this mode,
+ * the others have been saved when it's set. The ENV snapshot is saved too, please call it on clean shutdown.
+ *
+ * @return result
+ */
+EfErrCode ef_save_env(void)
+{
+#if defined(EF_ENV_USING_WRITE_BACK) || defined(EF_ENV_USING_SNAPSHOT)
+    EfErrCode result = EF_NO_ERR;
+
+    if (!init_ok) {
+        EF_INFO("ENV isn't initialize OK.\n");
+        return EF_ENV_INIT_FAILED;
+    }
+
+    /* lock the ENV cache */
+    ef_port_env_lock();
+
+#ifdef EF_ENV_USING_WRITE_BACK
+    result = env_wb_flush();
+#endif
+
+#ifdef EF_ENV_USING_SNAPSHOT
+    if (result == EF_NO_ERR) {
+        result = save_env_snapshot();
+    }
+#endif
+
+    /* unlock the ENV cache */
+    ef_port_env_unlock();
+
+    return result;
+#else
+    /* do nothing not cur mode */
+    return EF_NO_ERR;
+#endif /* defined(EF_ENV_USING_WRITE_BACK) || defined(EF_ENV_USING_SNAPSHOT) */
+}
+
+/**
+ * Write back the cached ENV when the EF_ENV_WB_DIRTY_MAX or EF_ENV_WB_PERIOD_MS is reached.
+ * It's designed for the periodic task, the ENV set also checks it.
+ *
+ * @return result
+ */
+EfErrCode ef_env_wb_poll(void)
+{
+#ifdef EF_ENV_USING_WRITE_BACK
+    EfErrCode result = EF_NO_ERR;
+
+    if (!init_ok) {
+        EF_INFO("ENV isn't initialize OK.\n");
+        return EF_ENV_INIT_FAILED;
+    }
+
+    /* lock the ENV cache */
+    ef_port_env_lock();
+
+    result = env_wb_poll();
+
+    /* unlock the ENV cache */
+    ef_port_env_unlock();
+
+    return result;
+#else
+    return EF_NO_ERR;
+#endif /* EF_ENV_USING_WRITE_BACK */
+}
+
+/**
+ * ENV set default.
+ *
+ * @return result
+ */
+EfErrCode ef_env_set_default(void)
+{
+    EfErrCode result = EF_NO_ERR;
+    uint32_t addr, record_sec_addr, i, value_len;
+    struct sector_meta_data sector;
+    struct env_node_obj env;
+    /* it's protected by the ENV lock */
+    static struct ef_env_batch batch;
+
+    EF_ASSERT(default_env_set);
+    EF_ASSERT(default_env_set_size);
+
+    /* lock the ENV cache */
+    ef_port_env_lock();
+
+#ifdef EF_ENV_USING_INDEX
+    /* all ENV will be dropped */
+    env_index_reset();
+#endif /* EF_ENV_USING_INDEX */
+
+#ifdef EF_ENV_USING_INCREMENTAL_GC
+    /* the collecting sector will be formatted */
+    gc_sector.addr = FAILED_ADDR;
+    gc_dst_sector = FAILED_ADDR;
+#endif /* EF_ENV_USING_INCREMENTAL_GC */
+
+#ifdef EF_ENV_USING_WRITE_BACK
+    /* the cached ENV will be dropped */
+    env_wb_reset();
+#endif /* EF_ENV_USING_WRITE_BACK */
+
+    /* The record sector is formatted with the set default record before any other sector is formatted. It's the
+     * next sector when the first sector has the record of the interrupted set default, so one of the records is
+     * always found after a power loss. The record value is the default ENV number, it's only for debug. */
+    record_sec_addr = env_start_addr;
+    if (find_env_no_cache(DEFAULT_ENV_NAME, &env) && env.addr.start < env_start_addr + SECTOR_SIZE) {
+        record_sec_addr += SECTOR_SIZE;
+    }
+    value_len = default_env_set_size;
+    result = format_sector_with_env(record_sec_addr, SECTOR_NOT_COMBINED, DEFAULT_ENV_NAME, &value_len,
+            sizeof(value_len));
+    if (result != EF_NO_ERR) {
+        goto __exit;
+    }
+    /* format the other sectors */
+    for (addr = env_start_addr; addr < env_start_addr + ENV_AREA_SIZE; addr += SECTOR_SIZE) {
+        if (addr == record_sec_addr) {
+            continue;
+        }
+        result = format_sector(addr, SECTOR_NOT_COMBINED);
+        if (result != EF_NO_ERR) {
+            goto __exit;
+        }
+    }
+    /* create default ENV and delete the set default record by one batch when they fit in it */
+    ef_env_batch_init(&batch);
+    ef_env_batch_set(&batch, DEFAULT_ENV_NAME, NULL, 0);
+    for (i = 0; i < default_env_set_size; i++) {
+        /* It seems to be a string when value length is 0.
+         * This mechanism is for compatibility with older versions (less then V4.0). */
+        if (default_env_set[i].value_len == 0) {
+            value_len = strlen(default_env_set[i].value);
+        } else {
+            value_len = default_env_set[i].value_len;
+        }
+        if (ef_env_batch_set(&batch, default_env_set[i].key, default_env_set[i].value, value_len) != EF_NO_ERR) {
+            break;
+        }
+    }
+    if (i == default_env_set_size && commit_env_batch(&batch) == EF_NO_ERR) {
+        goto __exit;
+    }
+    for (i = 0; i < default_env_set_size; i++) {
+        if (default_env_set[i].value_len == 0) {
+            value_len = strlen(default_env_set[i].value);
+        } else {
+            value_len = default_env_set[i].value_len;
+        }
+        sector.empty_env = FAILED_ADDR;
+        result = create_env_blob(&sector, default_env_set[i].key, default_env_set[i].value, value_len, 0);
+        if (result != EF_NO_ERR) {
+            goto __exit;
+        }
+    }
+    /* all default ENV are created */
+    result = del_env(DEFAULT_ENV_NAME, NULL, true);
+
+__exit:
+    /* unlock the ENV cache */
+    ef_port_env_unlock();
+
+    return result;
+}
+
+static bool print_env_cb(env_node_obj_t env, void *arg1, void *arg2)
+{
+    bool value_is_str = true, print_value = false;
+    size_t *using_size = arg1;
+
+    if (env->crc_is_ok) {
+        /* calculate the total using flash size */
+        *using_size += env->len;
+        /* check ENV */
+        if (env->status == ENV_WRITE) {
+            ef_print("%.*s=", env->name_len, env->name);
+
+            if (env->value_len < EF_STR_ENV_VALUE_MAX_SIZE ) {
+                uint8_t buf[32];
+                size_t len, size;
+__reload:
+                /* check the value is string */
+                for (len = 0, size = 0; len < env->value_len; len += size) {
                     if (len + sizeof(buf) < env->value_len) {
                         size = sizeof(buf);
                     } else {
                         size = env->value_len - len;
                     }
-                    ef_port_read(env->addr.value + len, (uint32_t *) buf, EF_WG_ALIGN(size));
+                    if (env->compressed) {
+                        read_env_value(env, len, buf, size);
+                    } else {
+                        ef_port_read(env->addr.value + len, (uint32_t *) buf, EF_WG_ALIGN(size));
+                    }
                     if (print_value) {
                         ef_print("%.*s", size, buf);
                     } else if (!ef_is_str(buf, size)) {
@@ -1629,6 +3761,11 @@ void ef_print_env(void)
     /* lock the ENV cache */
     ef_port_env_lock();
 
+#ifdef EF_ENV_USING_WRITE_BACK
+    /* print the latest value */
+    env_wb_flush();
+#endif
+
     env_iterator(&env, &using_size, NULL, print_env_cb);
 
     ef_print("\nmode: next generation\n");
@@ -1639,6 +3776,55 @@ void ef_print_env(void)
     ef_port_env_unlock();
 }
 
+/**
+ * Get the ENV sector wear. The erase count is saved on the sector header, it's 0 when the sector is
+ * NOT formatted after the erase count is supported.
+ *
+ * @param wear the wear report
+ * @param counts the erase count of every sector by address order, NULL: only get the report
+ * @param num the counts number, the sectors after it are NOT filled
+ *
+ * @return result
+ */
+EfErrCode ef_env_get_wear(ef_env_wear_t wear, uint32_t *counts, size_t num)
+{
+    struct sector_meta_data sector;
+    size_t i;
+
+    EF_ASSERT(wear);
+
+    if (!init_ok) {
+        EF_INFO("ENV isn't initialize OK.\n");
+        return EF_ENV_INIT_FAILED;
+    }
+
+    /* lock the ENV cache for read */
+    env_read_lock();
+
+    wear->sector_num = SECTOR_NUM;
+    wear->min = 0xFFFFFFFF;
+    wear->max = 0;
+    wear->total = 0;
+    for (i = 0; i < SECTOR_NUM; i++) {
+        read_sector_meta_data(env_start_addr + i * SECTOR_SIZE, &sector, false);
+        if (sector.erase_count < wear->min) {
+            wear->min = sector.erase_count;
+        }
+        if (sector.erase_count > wear->max) {
+            wear->max = sector.erase_count;
+        }
+        wear->total += sector.erase_count;
+        if (counts && i < num) {
+            counts[i] = sector.erase_count;
+        }
+    }
+
+    /* unlock the ENV cache for read */
+    env_read_unlock();
+
+    return EF_NO_ERR;
+}
+
 #ifdef EF_ENV_AUTO_UPDATE
 /*
  * Auto update ENV to latest default when current EF_ENV_VER_NUM is changed.
@@ -1665,7 +3851,7 @@ static void env_auto_update(void)
                         value_len = default_env_set[i].value_len;
                     }
                     sector.empty_env = FAILED_ADDR;
-                    create_env_blob(&sector, default_env_set[i].key, default_env_set[i].value, value_len);
+                    create_env_blob(&sector, default_env_set[i].key, default_env_set[i].value, value_len, 0);
                 }
             }
         } else {
@@ -1680,12 +3866,18 @@ static void env_auto_update(void)
 
 static bool check_sec_hdr_cb(sector_meta_data_t sector, void *arg1, void *arg2)
 {
+    if (sector->erase_count > sector_wear_max) {
+        sector_wear_max = sector->erase_count;
+    }
     if (!sector->check_ok) {
         size_t *failed_count = arg1;
+        bool *format = arg2;
 
-        EF_INFO("Warning: Sector header check failed. Format this sector (0x%08x).\n", sector->addr);
         (*failed_count) ++;
-        format_sector(sector->addr, SECTOR_NOT_COMBINED);
+        if (*format) {
+            EF_INFO("Warning: Sector header check failed. Format this sector (0x%08x).\n", sector->addr);
+            format_sector(sector->addr, SECTOR_NOT_COMBINED);
+        }
     }
 
     return false;
@@ -1694,10 +3886,60 @@ static bool check_sec_hdr_cb(sector_meta_data_t sector, void *arg1, void *arg2)
 static bool check_and_recovery_gc_cb(sector_meta_data_t sector, void *arg1, void *arg2)
 {
     if (sector->check_ok && sector->status.dirty == SECTOR_DIRTY_GC) {
+        struct env_node_obj env;
+
+        /* finish or drop the ENV batch first, the GC must NOT move the ENV of an uncommitted batch, and the moved
+         * ENV must NOT be written to the space of the batch ENV which is NOT written yet */
+        env_iterator(&env, NULL, NULL, recovery_env_batch_cb);
         /* make sure the GC request flag to true */
         gc_request = true;
         /* resume the GC operate */
+#ifdef EF_ENV_USING_INCREMENTAL_GC
+        while (gc_collect_step(EF_GC_EMPTY_SEC_THRESHOLD, false));
+#else
         gc_collect();
+#endif
+    }
+
+    return false;
+}
+
+/*
+ * Finish the committed ENV batch or drop the uncommitted ENV batch by the batch record.
+ */
+static void recovery_env_batch(env_node_obj_t env)
+{
+    struct env_batch_record record[EF_ENV_BATCH_MAX];
+    uint8_t status_table[ENV_STATUS_TABLE_SIZE];
+    size_t num = env->value_len / sizeof(struct env_batch_record);
+
+    if (num > EF_ENV_BATCH_MAX) {
+        EF_INFO("Error: The ENV batch record (@0x%08X) is too big.\n", env->addr.start);
+        num = 0;
+    }
+    ef_port_read(env->addr.value, (uint32_t *) record, num * sizeof(struct env_batch_record));
+
+    if (env->status == ENV_WRITE) {
+        EF_INFO("Found an ENV batch which has committed. Now will finish it.\n");
+        finish_env_batch(record, num);
+    } else {
+        EF_INFO("Found an ENV batch which has not committed. Now will drop it.\n");
+        drop_env_batch(record, num);
+    }
+    write_status(env->addr.start, status_table, ENV_STATUS_NUM, ENV_DELETED);
+    set_sec_dirty(env->addr.start);
+}
+
+static bool is_env_batch_record(env_node_obj_t env)
+{
+    return env->crc_is_ok && env->status <= ENV_WRITE
+            && env->name_len == sizeof(BATCH_ENV_NAME) - 1 && !strncmp(env->name, BATCH_ENV_NAME, env->name_len);
+}
+
+static bool recovery_env_batch_cb(env_node_obj_t env, void *arg1, void *arg2)
+{
+    if (is_env_batch_record(env)) {
+        recovery_env_batch(env);
     }
 
     return false;
@@ -1705,6 +3947,26 @@ static bool check_and_recovery_gc_cb(sector_meta_data_t sector, void *arg1, void
 
 static bool check_and_recovery_env_cb(env_node_obj_t env, void *arg1, void *arg2)
 {
+    bool *interrupted = arg1;
+    uint32_t *default_addr = arg2;
+
+    /* the batch record is always in front of the ENV in it */
+    if (is_env_batch_record(env)) {
+        recovery_env_batch(env);
+        /* the ENV before the batch record has been changed, so index them again */
+        *interrupted = true;
+        return false;
+    }
+
+#ifdef EF_ENV_USING_INDEX
+    /* index the ENV on the way */
+    build_env_index_cb(env, NULL, NULL);
+#endif /* EF_ENV_USING_INDEX */
+
+    if (env->crc_is_ok && env->status == ENV_WRITE
+            && env->name_len == sizeof(DEFAULT_ENV_NAME) - 1 && !strncmp(env->name, DEFAULT_ENV_NAME, env->name_len)) {
+        *default_addr = env->addr.start;
+    }
     /* recovery the prepare deleted ENV */
     if (env->crc_is_ok && env->status == ENV_PRE_DELETE) {
         EF_INFO("Found an ENV (%.*s) which has changed value failed. Now will recovery it.\n", env->name_len, env->name);
@@ -1713,6 +3975,7 @@ static bool check_and_recovery_env_cb(env_node_obj_t env, void *arg1, void *arg2
             EF_DEBUG("Recovery the ENV successful.\n");
         } else {
             EF_DEBUG("Warning: Moved an ENV (size %d) failed when recovery. Now will GC then retry.\n", env->len);
+            *interrupted = true;
             return true;
         }
     } else if (env->status == ENV_PRE_WRITE) {
@@ -1720,12 +3983,303 @@ static bool check_and_recovery_env_cb(env_node_obj_t env, void *arg1, void *arg2
         /* the ENV has not write finish, change the status to error */
         //TODO 쳣״̬װͼ
         write_status(env->addr.start, status_table, ENV_STATUS_NUM, ENV_ERR_HDR);
-        return true;
+        /* keep checking, the old ENV of it may be in the later sector and it needs recovery */
+    }
+
+    return false;
+}
+
+#ifdef EF_ENV_USING_SNAPSHOT
+/*
+ * Find the valid snapshot and the next snapshot address in the snapshot area.
+ */
+static void find_env_snapshot(void)
+{
+    struct env_snapshot_hdr hdr;
+    uint32_t addr = EF_ENV_SNAPSHOT_ADDR, end_addr = EF_ENV_SNAPSHOT_ADDR + EF_ENV_SNAPSHOT_SIZE;
+
+    snapshot_addr = FAILED_ADDR;
+    snapshot_end = FAILED_ADDR;
+    while (end_addr - addr >= SNAPSHOT_HDR_DATA_SIZE) {
+        ef_port_read(addr, (uint32_t *) &hdr, sizeof(struct env_snapshot_hdr));
+        if (get_status(hdr.status_table, SNAPSHOT_STATUS_NUM) == SNAPSHOT_UNUSED) {
+            if (hdr.magic == 0xFFFFFFFF) {
+                snapshot_end = addr;
+            }
+            break;
+        }
+        if (hdr.magic != SNAPSHOT_MAGIC_WORD || hdr.len > end_addr - addr - SNAPSHOT_HDR_DATA_SIZE) {
+            /* the snapshot save is interrupted, the area will be erased on next save */
+            break;
+        }
+        if (get_status(hdr.status_table, SNAPSHOT_STATUS_NUM) == SNAPSHOT_VALID) {
+            snapshot_addr = addr;
+        }
+        addr += SNAPSHOT_HDR_DATA_SIZE + EF_WG_ALIGN(hdr.len);
+    }
+}
+
+/*
+ * Change the valid snapshot to stale, it must be called before the ENV area is changed.
+ */
+static void env_snapshot_drop(void)
+{
+    uint8_t status_table[SNAPSHOT_STATUS_TABLE_SIZE];
+    uint32_t addr = snapshot_addr;
+
+    if (addr != FAILED_ADDR) {
+        /* clear it first, the write_status will call it again */
+        snapshot_addr = FAILED_ADDR;
+        write_status(addr, status_table, SNAPSHOT_STATUS_NUM, SNAPSHOT_STALE);
+    }
+}
+
+/*
+ * Check the sector is same as the summary in snapshot. The sector which has free space must NOT be
+ * written after its empty address.
+ */
+static bool check_snapshot_sector(uint32_t sec_addr, env_snapshot_sector_t summary)
+{
+    struct sector_meta_data sector;
+    uint8_t buf[4];
+    size_t i, size;
+
+    if (read_sector_meta_data(sec_addr, &sector, false) != EF_NO_ERR || sector.status.store != summary->store
+            || sector.status.dirty != summary->dirty) {
+        return false;
+    }
+    if (sector.status.store == SECTOR_STORE_EMPTY || sector.status.store == SECTOR_STORE_USING) {
+        if (summary->empty_addr < sec_addr + SECTOR_HDR_DATA_SIZE || summary->empty_addr > sec_addr + SECTOR_SIZE) {
+            return false;
+        }
+        size = sec_addr + SECTOR_SIZE - summary->empty_addr;
+        if (size > sizeof(buf)) {
+            size = sizeof(buf);
+        }
+        ef_port_read(summary->empty_addr, (uint32_t *) buf, size);
+        for (i = 0; i < size; i++) {
+            if (buf[i] != 0xFF) {
+                return false;
+            }
+        }
+#ifdef EF_ENV_USING_CACHE
+        if (sector.status.store == SECTOR_STORE_USING) {
+            update_sector_cache(sec_addr, summary->empty_addr);
+        }
+#endif /* EF_ENV_USING_CACHE */
     }
 
+    return true;
+}
+
+/*
+ * Restore the ENV index (or the ENV cache) and the sector cache from the valid snapshot.
+ * The snapshot data is read by small pieces, they are checked and restored on the way.
+ */
+static bool load_env_snapshot(void)
+{
+    struct env_snapshot_hdr hdr;
+    uint32_t buf[EF_ENV_BATCH_BUF_SIZE / 4], addr, crc = 0;
+    size_t i, j, num, item_num, read_num;
+
+    ef_port_read(snapshot_addr, (uint32_t *) &hdr, sizeof(struct env_snapshot_hdr));
+#ifdef EF_ENV_USING_INDEX
+    if (hdr.key_num > ENV_INDEX_MAX_USED) {
+        return false;
+    }
+#else
+    if (hdr.key_num > EF_ENV_CACHE_TABLE_SIZE) {
+        return false;
+    }
+#endif /* EF_ENV_USING_INDEX */
+    if (hdr.len != SECTOR_NUM * sizeof(struct env_snapshot_sector) + hdr.key_num * sizeof(env_snapshot_key)) {
+        return false;
+    }
+
+#ifdef EF_ENV_USING_INDEX
+    env_index_reset();
+#endif /* EF_ENV_USING_INDEX */
+
+#ifdef EF_ENV_USING_CACHE
+    for (i = 0; i < EF_SECTOR_CACHE_TABLE_SIZE; i++) {
+        sector_cache_table[i].addr = FAILED_ADDR;
+    }
+    for (i = 0; i < EF_ENV_CACHE_TABLE_SIZE; i++) {
+        env_cache_table[i].addr = FAILED_ADDR;
+    }
+#endif /* EF_ENV_USING_CACHE */
+
+    /* the sector summary and the key entry are both 8 bytes */
+    item_num = SECTOR_NUM + hdr.key_num;
+    addr = snapshot_addr + SNAPSHOT_HDR_DATA_SIZE;
+    for (i = 0; i < item_num; i += read_num) {
+        read_num = item_num - i < sizeof(buf) / 8 ? item_num - i : sizeof(buf) / 8;
+        ef_port_read(addr, buf, read_num * 8);
+        crc = ef_env_calc_crc32(crc, buf, read_num * 8);
+        addr += read_num * 8;
+        for (j = 0; j < read_num; j++) {
+            num = i + j;
+            if (num < SECTOR_NUM) {
+                if (!check_snapshot_sector(env_start_addr + num * SECTOR_SIZE, (env_snapshot_sector_t) &buf[j * 2])) {
+                    EF_DEBUG("The sector (@0x%08X) is changed after the ENV snapshot.\n", env_start_addr + num * SECTOR_SIZE);
+                    goto __failed;
+                }
+            } else {
+#ifdef EF_ENV_USING_INDEX
+                env_snapshot_key *key = (env_snapshot_key *) &buf[j * 2];
+                size_t k = key->name_crc & (EF_ENV_INDEX_TABLE_SIZE - 1);
+
+                while (env_index_table[k].addr != FAILED_ADDR) {
+                    k = (k + 1) & (EF_ENV_INDEX_TABLE_SIZE - 1);
+                }
+                env_index_table[k] = *key;
+                env_index_used++;
+#else
+                env_snapshot_key *key = (env_snapshot_key *) &buf[j * 2];
+
+                env_cache_table[num - SECTOR_NUM].name_crc = (uint16_t) key->name_crc;
+                env_cache_table[num - SECTOR_NUM].active = 0;
+                env_cache_table[num - SECTOR_NUM].addr = key->addr;
+#endif /* EF_ENV_USING_INDEX */
+            }
+        }
+    }
+    if (crc != hdr.crc32) {
+        EF_INFO("Warning: The ENV snapshot (@0x%08X) CRC32 check failed.\n", snapshot_addr);
+        goto __failed;
+    }
+
+#ifdef EF_ENV_USING_INDEX
+    env_index_ready = true;
+#endif /* EF_ENV_USING_INDEX */
+    EF_DEBUG("Loaded the ENV snapshot (@0x%08X) of %d keys.\n", snapshot_addr, hdr.key_num);
+
+    return true;
+
+__failed:
+#ifdef EF_ENV_USING_INDEX
+    env_index_reset();
+#endif /* EF_ENV_USING_INDEX */
+
+#ifdef EF_ENV_USING_CACHE
+    for (i = 0; i < EF_SECTOR_CACHE_TABLE_SIZE; i++) {
+        sector_cache_table[i].addr = FAILED_ADDR;
+    }
+    for (i = 0; i < EF_ENV_CACHE_TABLE_SIZE; i++) {
+        env_cache_table[i].addr = FAILED_ADDR;
+    }
+#endif /* EF_ENV_USING_CACHE */
+
     return false;
 }
 
+/*
+ * Save the sector summary and the key table to a new snapshot, it's skipped when the valid snapshot
+ * is NOT stale. The snapshot is appended to the snapshot area until the area is full.
+ */
+static EfErrCode save_env_snapshot(void)
+{
+    EfErrCode result = EF_NO_ERR;
+    struct env_snapshot_hdr hdr;
+    struct env_snapshot_sector summary;
+    struct sector_meta_data sector;
+    struct env_batch_writer writer;
+    env_snapshot_key key;
+    uint32_t addr;
+    size_t i;
+
+    if (snapshot_addr != FAILED_ADDR) {
+        /* the ENV is NOT changed after the last snapshot */
+        return EF_NO_ERR;
+    }
+
+#ifdef EF_ENV_USING_INCREMENTAL_GC
+    if (gc_sector.addr != FAILED_ADDR) {
+        /* the collection is resumed on next boot, so the snapshot will be stale at once */
+        return EF_NO_ERR;
+    }
+#endif /* EF_ENV_USING_INCREMENTAL_GC */
+
+#ifdef EF_ENV_USING_INDEX
+    if (!env_index_ready || env_index_overflow) {
+        EF_INFO("Warning: The ENV index is NOT completed, the ENV snapshot is NOT saved.\n");
+        return EF_ENV_FULL;
+    }
+    hdr.key_num = env_index_used;
+#else
+    for (i = 0, hdr.key_num = 0; i < EF_ENV_CACHE_TABLE_SIZE; i++) {
+        if (env_cache_table[i].addr != FAILED_ADDR) {
+            hdr.key_num++;
+        }
+    }
+#endif /* EF_ENV_USING_INDEX */
+
+    hdr.len = SECTOR_NUM * sizeof(struct env_snapshot_sector) + hdr.key_num * sizeof(env_snapshot_key);
+    if (SNAPSHOT_HDR_DATA_SIZE + hdr.len > EF_ENV_SNAPSHOT_SIZE) {
+        EF_INFO("Warning: The ENV snapshot (%d bytes) is larger than the EF_ENV_SNAPSHOT_SIZE.\n",
+                SNAPSHOT_HDR_DATA_SIZE + hdr.len);
+        return EF_ENV_FULL;
+    }
+    if (snapshot_end == FAILED_ADDR
+            || SNAPSHOT_HDR_DATA_SIZE + hdr.len > EF_ENV_SNAPSHOT_ADDR + EF_ENV_SNAPSHOT_SIZE - snapshot_end) {
+        /* the stale snapshots are erased only when the area is full */
+        result = ef_port_erase(EF_ENV_SNAPSHOT_ADDR, EF_ENV_SNAPSHOT_SIZE);
+        if (result != EF_NO_ERR) {
+            return result;
+        }
+        snapshot_end = EF_ENV_SNAPSHOT_ADDR;
+    }
+    addr = snapshot_end;
+    /* the snapshot area can be used after it even if this save is interrupted */
+    snapshot_end = FAILED_ADDR;
+
+    /* the snapshot is NOT valid until the data and the header are both written */
+    result = write_status(addr, hdr.status_table, SNAPSHOT_STATUS_NUM, SNAPSHOT_PRE_WRITE);
+    writer.addr = addr + SNAPSHOT_HDR_DATA_SIZE;
+    writer.len = 0;
+    hdr.crc32 = 0;
+    for (i = 0; i < SECTOR_NUM && result == EF_NO_ERR; i++) {
+        read_sector_meta_data(env_start_addr + i * SECTOR_SIZE, &sector, true);
+        summary.store = sector.status.store;
+        summary.dirty = sector.status.dirty;
+        summary.empty_addr = sector.empty_env;
+        hdr.crc32 = ef_env_calc_crc32(hdr.crc32, &summary, sizeof(summary));
+        result = batch_write(&writer, &summary, sizeof(summary));
+    }
+#ifdef EF_ENV_USING_INDEX
+    for (i = 0; i < EF_ENV_INDEX_TABLE_SIZE && result == EF_NO_ERR; i++) {
+        key = env_index_table[i];
+#else
+    for (i = 0; i < EF_ENV_CACHE_TABLE_SIZE && result == EF_NO_ERR; i++) {
+        key.name_crc = env_cache_table[i].name_crc;
+        key.addr = env_cache_table[i].addr;
+#endif /* EF_ENV_USING_INDEX */
+        if (key.addr != FAILED_ADDR) {
+            hdr.crc32 = ef_env_calc_crc32(hdr.crc32, &key, sizeof(key));
+            result = batch_write(&writer, &key, sizeof(key));
+        }
+    }
+    if (result == EF_NO_ERR) {
+        result = batch_write_flush(&writer);
+    }
+    if (result == EF_NO_ERR) {
+        hdr.magic = SNAPSHOT_MAGIC_WORD;
+        result = ef_port_write(addr + SNAPSHOT_MAGIC_OFFSET, &hdr.magic,
+                sizeof(struct env_snapshot_hdr) - SNAPSHOT_MAGIC_OFFSET);
+    }
+    if (result == EF_NO_ERR) {
+        result = write_status(addr, hdr.status_table, SNAPSHOT_STATUS_NUM, SNAPSHOT_VALID);
+    }
+    if (result == EF_NO_ERR) {
+        snapshot_addr = addr;
+        snapshot_end = addr + SNAPSHOT_HDR_DATA_SIZE + EF_WG_ALIGN(hdr.len);
+        EF_DEBUG("Saved the ENV snapshot (@0x%08X) of %d keys.\n", addr, hdr.key_num);
+    }
+
+    return result;
+}
+#endif /* EF_ENV_USING_SNAPSHOT */
+
 /**
  * Check and load the flash ENV meta data.
  *
@@ -1737,14 +4291,40 @@ EfErrCode ef_load_env(void)
     struct env_node_obj env;
     struct sector_meta_data sector;
     size_t check_failed_count = 0;
+    uint32_t default_addr = FAILED_ADDR;
+    uint8_t status_table[ENV_STATUS_TABLE_SIZE];
+    bool interrupted, format = false;
 
     in_recovery_check = true;
-    /* check all sector header */
-    sector_iterator(&sector, SECTOR_STORE_UNUSED, &check_failed_count, NULL, check_sec_hdr_cb, false);
+
+#ifdef EF_ENV_USING_INDEX
+    env_index_ready = false;
+#endif /* EF_ENV_USING_INDEX */
+
+#ifdef EF_ENV_USING_INCREMENTAL_GC
+    gc_sector.addr = FAILED_ADDR;
+    gc_dst_sector = FAILED_ADDR;
+#endif /* EF_ENV_USING_INCREMENTAL_GC */
+
+#ifdef EF_ENV_USING_WRITE_BACK
+    env_wb_reset();
+#endif /* EF_ENV_USING_WRITE_BACK */
+
+#ifdef EF_ENV_USING_SNAPSHOT
+    find_env_snapshot();
+#endif /* EF_ENV_USING_SNAPSHOT */
+
+    /* check all sector header, the failed sector is NOT formatted before all sectors are checked, so the partly
+     * formatted blank flash is still set to default after a power loss */
+    sector_iterator(&sector, SECTOR_STORE_UNUSED, &check_failed_count, &format, check_sec_hdr_cb, false);
     /* all sector header check failed */
     if (check_failed_count == SECTOR_NUM) {
         EF_INFO("Warning: All sector header check failed. Set it to default.\n");
         ef_env_set_default();
+    } else if (check_failed_count > 0) {
+        format = true;
+        check_failed_count = 0;
+        sector_iterator(&sector, SECTOR_STORE_UNUSED, &check_failed_count, &format, check_sec_hdr_cb, false);
     }
 
     /* lock the ENV cache */
@@ -1752,19 +4332,69 @@ EfErrCode ef_load_env(void)
     /* check all sector header for recovery GC */
     sector_iterator(&sector, SECTOR_STORE_UNUSED, NULL, NULL, check_and_recovery_gc_cb, false);
 
+#ifdef EF_ENV_USING_SNAPSHOT
+    /* the ENV is NOT changed after the valid snapshot, so the recovery check of all ENV is skipped */
+    if (snapshot_addr != FAILED_ADDR) {
+        if (load_env_snapshot()) {
+            goto __exit;
+        }
+        env_snapshot_drop();
+    }
+#endif /* EF_ENV_USING_SNAPSHOT */
+
 __retry:
+    interrupted = false;
+    default_addr = FAILED_ADDR;
+
+#ifdef EF_ENV_USING_INDEX
+    env_index_reset();
+#endif /* EF_ENV_USING_INDEX */
+
     /* check all ENV for recovery */
-    env_iterator(&env, NULL, NULL, check_and_recovery_env_cb);
+    env_iterator(&env, &interrupted, &default_addr, check_and_recovery_env_cb);
+#ifdef EF_ENV_USING_INCREMENTAL_GC
+    /* The GC is done to the end, one bounded step may NOT free the space for the recovered ENV. The failed move
+     * doesn't request the GC when no empty sector is left, so the recovery is retried while the GC makes progress. */
+    if (gc_request || interrupted) {
+        bool gc_done = false;
+
+        while (gc_collect_step(EF_GC_EMPTY_SEC_THRESHOLD, false)) {
+            gc_done = true;
+        }
+        if (gc_done) {
+            goto __retry;
+        }
+    }
+#else
     if (gc_request) {
         gc_collect();
         goto __retry;
     }
+#endif /* EF_ENV_USING_INCREMENTAL_GC */
+
+#ifdef EF_ENV_USING_INDEX
+    /* the recovery iterator didn't reach all ENV or some ENV is changed, so index them again */
+    if (interrupted) {
+        env_index_reset();
+        env_iterator(&env, NULL, NULL, build_env_index_cb);
+    }
+    env_index_ready = true;
+#endif /* EF_ENV_USING_INDEX */
 
+#ifdef EF_ENV_USING_SNAPSHOT
+__exit:
+#endif
     in_recovery_check = false;
 
     /* unlock the ENV cache */
     ef_port_env_unlock();
 
+    /* the set default record is deleted by the batch recovery when the default ENV batch has committed */
+    if (default_addr != FAILED_ADDR && read_status(default_addr, status_table, ENV_STATUS_NUM) == ENV_WRITE) {
+        EF_INFO("Found an ENV set default which has not finished. Now will set it to default again.\n");
+        result = ef_env_set_default();
+    }
+
     return result;
 }
 
@@ -27,9 +27,17 @@
  */
 
 #include <easyflash.h>
+#include <string.h>
 
 #ifdef EF_USING_IAP
 
+/* the buffer data must be seen before the buffer flag, the buffer is shared with the interrupt (or the thread) */
+#if defined(__GNUC__)
+#define IAP_BARRIER()                  __sync_synchronize()
+#else
+#define IAP_BARRIER()
+#endif
+
 /* IAP section backup application section start address in flash */
 static uint32_t bak_app_start_addr = 0;
 
@@ -277,6 +285,444 @@ EfErrCode ef_copy_bl_from_bak(uint32_t bl_addr, size_t bl_size) {
     return result;
 }
 
+/**
+ * Initialize the streaming IAP writer. The backup area is erased ahead by ef_iap_stream_poll, so it's NOT
+ * needed to call ef_erase_bak_app.
+ *
+ * @param stream the writer object
+ * @param total_size application total size, it's the max size when the size is unknown, @see ef_iap_stream_finish
+ *
+ * @return result
+ */
+EfErrCode ef_iap_stream_init(ef_iap_stream_t stream, size_t total_size) {
+    EF_ASSERT(stream);
+
+    memset(stream, 0, sizeof(struct ef_iap_stream));
+    stream->total_size = total_size;
+    stream->result = EF_NO_ERR;
+
+    return EF_NO_ERR;
+}
+
+/**
+ * Put the application data to the writer, it's called by the producer, such as the UART DMA or the CAN receive
+ * interrupt. It only copies the data to the buffer, so it never waits for the flash.
+ *
+ * @param stream the writer object
+ * @param data a part of application
+ * @param size data size
+ *
+ * @return the put size, it's less than the size when both buffers are full, the rest must be put again later
+ */
+size_t ef_iap_stream_put(ef_iap_stream_t stream, const void *data, size_t size) {
+    const uint8_t *src = data;
+    size_t put_size = 0, fill, len;
+    uint8_t idx;
+
+    EF_ASSERT(stream);
+    EF_ASSERT(data);
+
+    /* make sure don't put excess data */
+    if (stream->received + size > stream->total_size) {
+        size = stream->total_size - stream->received;
+    }
+
+    while (put_size < size) {
+        idx = stream->put_idx;
+        if (stream->full[idx]) {
+            /* the consumer is still programming this buffer */
+            break;
+        }
+        fill = stream->fill[idx];
+        len = EF_IAP_BUF_SIZE - fill < size - put_size ? EF_IAP_BUF_SIZE - fill : size - put_size;
+        memcpy((uint8_t *) stream->buf[idx] + fill, src + put_size, len);
+        put_size += len;
+        stream->received += len;
+        stream->fill[idx] = fill + len;
+        if (fill + len == EF_IAP_BUF_SIZE || stream->received == stream->total_size) {
+            IAP_BARRIER();
+            stream->full[idx] = true;
+            stream->put_idx = idx ^ 1;
+        }
+    }
+
+    return put_size;
+}
+
+/* erase the next sector of the backup area */
+static EfErrCode iap_stream_erase(ef_iap_stream_t stream) {
+    EfErrCode result = ef_port_erase(ef_get_bak_app_start_addr() + stream->erased, EF_ERASE_MIN_SIZE);
+
+    if (result == EF_NO_ERR) {
+        stream->erased += EF_ERASE_MIN_SIZE;
+    } else {
+        EF_INFO("Warning: Erase backup area application fault!\n");
+    }
+
+    return result;
+}
+
+/**
+ * Do the flash work of the writer, it's called by the consumer (the main loop or the IAP task) until the
+ * application is written. It programs one full buffer by one write, and the sectors which are needed by the
+ * buffer are erased before it. When there is no full buffer, it erases one sector ahead, so the erase is
+ * overlapped with the data receiving.
+ *
+ * @param stream the writer object
+ *
+ * @return result
+ */
+EfErrCode ef_iap_stream_poll(ef_iap_stream_t stream) {
+    EfErrCode result = EF_NO_ERR;
+    uint8_t idx;
+    size_t size, write_size;
+
+    EF_ASSERT(stream);
+
+    if (stream->result != EF_NO_ERR) {
+        return stream->result;
+    }
+
+    idx = stream->prog_idx;
+    if (stream->full[idx]) {
+        IAP_BARRIER();
+        size = stream->fill[idx];
+        while (result == EF_NO_ERR && stream->erased < stream->written + size) {
+            result = iap_stream_erase(stream);
+        }
+        if (result == EF_NO_ERR) {
+            /* the last data is padded by the erased value to the word */
+            write_size = (size + 3) / 4 * 4;
+            memset((uint8_t *) stream->buf[idx] + size, 0xFF, write_size - size);
+            result = ef_port_write(ef_get_bak_app_start_addr() + stream->written, stream->buf[idx], write_size);
+            if (result == EF_NO_ERR) {
+                stream->written += size;
+                stream->fill[idx] = 0;
+                IAP_BARRIER();
+                stream->full[idx] = false;
+                stream->prog_idx = idx ^ 1;
+            } else {
+                EF_INFO("Warning: Write data to backup area fault!\n");
+            }
+        }
+    } else if (stream->erased < stream->total_size) {
+        result = iap_stream_erase(stream);
+    }
+    stream->result = result;
+
+    return result;
+}
+
+/**
+ * Finish the streaming IAP writer after the producer has put all data. The data in the buffers is programmed.
+ * When the received size is less than the total size (the size was unknown), the rest data is programmed too
+ * and the received size is the application size.
+ *
+ * @param stream the writer object
+ *
+ * @return result
+ */
+EfErrCode ef_iap_stream_finish(ef_iap_stream_t stream) {
+    uint8_t idx;
+
+    EF_ASSERT(stream);
+
+    /* the producer has stopped, so the partial buffer is programmed too */
+    idx = stream->put_idx;
+    if (!stream->full[idx] && stream->fill[idx]) {
+        stream->full[idx] = true;
+        stream->put_idx = idx ^ 1;
+    }
+    stream->total_size = stream->received;
+    while (stream->result == EF_NO_ERR && stream->written < stream->received) {
+        ef_iap_stream_poll(stream);
+    }
+    if (stream->result == EF_NO_ERR) {
+        EF_INFO("Write data to backup area OK.\n");
+    }
+
+    return stream->result;
+}
+
+#ifdef EF_IAP_USING_PATCH
+/* the patch decoder states */
+enum {
+    PATCH_HEADER,
+    PATCH_TAG,
+    PATCH_LEN,
+    PATCH_DATA,
+    PATCH_END,
+};
+
+static uint32_t patch_get_u32(const uint8_t *buf) {
+    return buf[0] | ((uint32_t) buf[1] << 8) | ((uint32_t) buf[2] << 16) | ((uint32_t) buf[3] << 24);
+}
+
+/* write the output buffer to the backup area */
+static EfErrCode patch_flush(ef_iap_patch_t patch) {
+    EfErrCode result = EF_NO_ERR;
+
+    if (patch->out_len) {
+        result = ef_write_data_to_bak((uint8_t *) patch->out, patch->out_len, &patch->cur_size, patch->new_size);
+        patch->out_len = 0;
+    }
+
+    return result;
+}
+
+/* calculate the flash CRC32 by the output buffer, it must be empty */
+static EfErrCode patch_flash_crc(ef_iap_patch_t patch, uint32_t addr, size_t size, uint32_t *crc) {
+    size_t len;
+
+    for (*crc = 0; size; addr += len, size -= len) {
+        len = size < EF_IAP_PATCH_BUF_SIZE ? size : EF_IAP_PATCH_BUF_SIZE;
+        if (ef_port_read(addr, patch->out, len) != EF_NO_ERR) {
+            return EF_READ_ERR;
+        }
+        *crc = ef_calc_crc32(*crc, patch->out, len);
+    }
+
+    return EF_NO_ERR;
+}
+
+/* check the patch header, the old application must be same as the patch base, then erase the backup area */
+static EfErrCode patch_start(ef_iap_patch_t patch) {
+    uint32_t crc;
+
+    if (patch_get_u32(patch->header) != EF_IAP_PATCH_MAGIC) {
+        EF_INFO("Error: The IAP patch header is wrong.\n");
+        return EF_READ_ERR;
+    }
+    patch->old_size = patch_get_u32(patch->header + 4);
+    patch->new_size = patch_get_u32(patch->header + 12);
+    patch->new_crc = patch_get_u32(patch->header + 16);
+    if (patch_flash_crc(patch, patch->old_addr, patch->old_size, &crc) != EF_NO_ERR
+            || crc != patch_get_u32(patch->header + 8)) {
+        EF_INFO("Error: The current application is NOT the IAP patch base.\n");
+        return EF_READ_ERR;
+    }
+
+    return ef_erase_bak_app(patch->new_size);
+}
+
+/* start the command which has the length, the COPY command is done at once */
+static EfErrCode patch_command(ef_iap_patch_t patch, size_t len) {
+    EfErrCode result = EF_NO_ERR;
+    size_t size;
+
+    if (patch->cur_size + patch->out_len + len > patch->new_size) {
+        EF_INFO("Error: The IAP patch output is larger than the new application.\n");
+        return EF_READ_ERR;
+    }
+    if (patch->cmd != EF_IAP_PATCH_INSERT && patch->old_pos + len > patch->old_size) {
+        EF_INFO("Error: The IAP patch reads out of the old application.\n");
+        return EF_READ_ERR;
+    }
+    if (patch->cmd == EF_IAP_PATCH_COPY) {
+        while (len && result == EF_NO_ERR) {
+            size = EF_IAP_PATCH_BUF_SIZE - patch->out_len;
+            if (size > len) {
+                size = len;
+            }
+            result = ef_port_read(patch->old_addr + patch->old_pos, (uint32_t *) ((uint8_t *) patch->out
+                    + patch->out_len), size);
+            patch->old_pos += size;
+            patch->out_len += size;
+            len -= size;
+            if (patch->out_len == EF_IAP_PATCH_BUF_SIZE && result == EF_NO_ERR) {
+                result = patch_flush(patch);
+            }
+        }
+        patch->state = PATCH_TAG;
+    } else {
+        patch->remain = len;
+        patch->state = len ? PATCH_DATA : PATCH_TAG;
+    }
+
+    return result;
+}
+
+/* move the old application read position by the zigzag offset */
+static EfErrCode patch_seek(ef_iap_patch_t patch, uint32_t value) {
+    int32_t offset = (int32_t) (value >> 1) ^ -(int32_t) (value & 1);
+
+    if ((offset < 0 && (size_t) -offset > patch->old_pos)
+            || (offset > 0 && patch->old_pos + offset > patch->old_size)) {
+        EF_INFO("Error: The IAP patch seeks out of the old application.\n");
+        return EF_READ_ERR;
+    }
+    patch->old_pos += offset;
+    patch->state = PATCH_TAG;
+
+    return EF_NO_ERR;
+}
+
+/**
+ * Initialize the delta update. The new application is made from the old (current) application and the patch which
+ * is made by the host tool, then it's written to the backup area. The RAM is only the patch object, the patch is
+ * put by parts (@see ef_iap_patch_put) and the old application is read by ef_port_read.
+ *
+ * @param patch the patch apply engine object
+ * @param old_addr the old application address
+ *
+ * @return result
+ */
+EfErrCode ef_iap_patch_init(ef_iap_patch_t patch, uint32_t old_addr) {
+    EF_ASSERT(patch);
+    EF_ASSERT(EF_IAP_PATCH_BUF_SIZE % 4 == 0);
+
+    memset(patch, 0, sizeof(struct ef_iap_patch));
+    patch->old_addr = old_addr;
+    patch->state = PATCH_HEADER;
+
+    return EF_NO_ERR;
+}
+
+/**
+ * Put a part of the patch, it can be called in any size. The backup area is erased after the patch header is
+ * received, and the new application is written to it when the output buffer is full.
+ *
+ * @param patch the patch apply engine object
+ * @param data a part of the patch
+ * @param size data size
+ *
+ * @return result, EF_READ_ERR: the patch is wrong or it's NOT for the old application
+ */
+EfErrCode ef_iap_patch_put(ef_iap_patch_t patch, const void *data, size_t size) {
+    const uint8_t *buf = data;
+    uint8_t byte;
+    size_t len;
+
+    EF_ASSERT(patch);
+    EF_ASSERT(data);
+
+    while (size && patch->result == EF_NO_ERR) {
+        switch (patch->state) {
+        case PATCH_HEADER:
+            len = EF_IAP_PATCH_HEADER_SIZE - patch->header_len;
+            if (len > size) {
+                len = size;
+            }
+            memcpy(patch->header + patch->header_len, buf, len);
+            patch->header_len += len;
+            buf += len;
+            size -= len;
+            if (patch->header_len == EF_IAP_PATCH_HEADER_SIZE) {
+                patch->result = patch_start(patch);
+                patch->state = PATCH_TAG;
+            }
+            break;
+        case PATCH_TAG:
+            byte = *buf++;
+            size--;
+            patch->cmd = byte >> 6;
+            len = byte & EF_IAP_PATCH_LEN_EXT;
+            if (patch->cmd == EF_IAP_PATCH_OTHER) {
+                if (len == EF_IAP_PATCH_END) {
+                    patch->state = PATCH_END;
+                } else if (len == EF_IAP_PATCH_SEEK) {
+                    patch->value = 0;
+                    patch->shift = 0;
+                    patch->state = PATCH_LEN;
+                } else {
+                    patch->result = EF_READ_ERR;
+                }
+            } else if (len == EF_IAP_PATCH_LEN_EXT) {
+                patch->value = 0;
+                patch->shift = 0;
+                patch->state = PATCH_LEN;
+            } else {
+                patch->result = patch_command(patch, len);
+            }
+            break;
+        case PATCH_LEN:
+            byte = *buf++;
+            size--;
+            if (patch->shift > 28) {
+                patch->result = EF_READ_ERR;
+                break;
+            }
+            patch->value |= (uint32_t) (byte & 0x7F) << patch->shift;
+            patch->shift += 7;
+            if (!(byte & 0x80)) {
+                if (patch->cmd == EF_IAP_PATCH_OTHER) {
+                    patch->result = patch_seek(patch, patch->value);
+                } else {
+                    patch->result = patch_command(patch, patch->value);
+                }
+            }
+            break;
+        case PATCH_DATA:
+            len = EF_IAP_PATCH_BUF_SIZE - patch->out_len;
+            if (len > patch->remain) {
+                len = patch->remain;
+            }
+            if (len > size) {
+                len = size;
+            }
+            memcpy((uint8_t *) patch->out + patch->out_len, buf, len);
+            patch->out_len += len;
+            patch->remain -= len;
+            buf += len;
+            size -= len;
+            if (patch->cmd == EF_IAP_PATCH_REPLACE) {
+                patch->old_pos += len;
+            }
+            if (patch->out_len == EF_IAP_PATCH_BUF_SIZE) {
+                patch->result = patch_flush(patch);
+            }
+            if (!patch->remain) {
+                patch->state = PATCH_TAG;
+            }
+            break;
+        default:
+            EF_INFO("Error: The IAP patch has the data after the end.\n");
+            patch->result = EF_READ_ERR;
+            break;
+        }
+    }
+
+    return patch->result;
+}
+
+/**
+ * Finish the delta update after the whole patch is put. The rest output is written, then the new application is
+ * read back from the backup area and checked by the CRC32 of the patch header.
+ *
+ * @param patch the patch apply engine object
+ * @param new_size the new application size, it's used to copy the application from the backup area
+ *
+ * @return result, EF_READ_ERR: the patch is incomplete, EF_WRITE_ERR: the new application is wrong
+ */
+EfErrCode ef_iap_patch_finish(ef_iap_patch_t patch, size_t *new_size) {
+    uint32_t crc = 0;
+
+    EF_ASSERT(patch);
+    EF_ASSERT(new_size);
+
+    if (patch->result == EF_NO_ERR && patch->state != PATCH_END) {
+        EF_INFO("Error: The IAP patch is incomplete.\n");
+        patch->result = EF_READ_ERR;
+    }
+    if (patch->result == EF_NO_ERR) {
+        patch->result = patch_flush(patch);
+    }
+    if (patch->result == EF_NO_ERR) {
+        patch->result = patch_flash_crc(patch, ef_get_bak_app_start_addr(), patch->cur_size, &crc);
+    }
+    if (patch->result == EF_NO_ERR && (patch->cur_size != patch->new_size || crc != patch->new_crc)) {
+        EF_INFO("Error: The new application CRC32 check failed.\n");
+        patch->result = EF_WRITE_ERR;
+    }
+    if (patch->result == EF_NO_ERR) {
+        *new_size = patch->new_size;
+        EF_INFO("Apply the patch to backup area OK.\n");
+    }
+
+    return patch->result;
+}
+#endif /* EF_IAP_USING_PATCH */
+
 /**
  * Get IAP section start address in flash.
  *
@@ -27,6 +27,7 @@
  */
 
 #include <easyflash.h>
+#include <string.h>
 
 #ifdef EF_USING_LOG
 
@@ -37,7 +38,12 @@
 /* magic code on every sector header. 'EF' is 0xEF30EF30 */
 #define LOG_SECTOR_MAGIC               0xEF30EF30
 /* sector header size, includes the sector magic code and status magic code */
+#ifdef EF_LOG_USING_RECORD
+/* the record summary is after the status: the first and the last record sequence number and time */
+#define LOG_SECTOR_HEADER_SIZE         28
+#else
 #define LOG_SECTOR_HEADER_SIZE         12
+#endif
 /* sector header word size,what is equivalent to the total number of sectors header index */
 #define LOG_SECTOR_HEADER_WORD_SIZE    3
 
@@ -59,6 +65,15 @@
 #define SECTOR_STATUS_MAGIC_USING     0xFEFEFEFE
 #define SECTOR_STATUS_MAGIC_FULL      0xFCFCFCFC
 
+#ifdef EF_LOG_USING_ASYNC
+/* the staging ring data must be seen by the other side before its index */
+#if defined(__GNUC__) || defined(__clang__)
+#define LOG_BARRIER()                  __sync_synchronize()
+#else
+#define LOG_BARRIER()
+#endif
+#endif /* EF_LOG_USING_ASYNC */
+
 typedef enum {
     SECTOR_STATUS_EMPUT,
     SECTOR_STATUS_USING,
@@ -70,17 +85,58 @@ typedef enum {
     SECTOR_HEADER_MAGIC_INDEX,
     SECTOR_HEADER_USING_INDEX,
     SECTOR_HEADER_FULL_INDEX,
+#ifdef EF_LOG_USING_RECORD
+    SECTOR_HEADER_FIRST_SEQ_INDEX,
+    SECTOR_HEADER_FIRST_TIME_INDEX,
+    SECTOR_HEADER_LAST_SEQ_INDEX,
+    SECTOR_HEADER_LAST_TIME_INDEX,
+#endif
 } SectorHeaderIndex;
 
+#ifdef EF_LOG_USING_RECORD
+/* magic code on every record header. 'EL' */
+#define LOG_RECORD_MAGIC               0x4C45
+/* record header size */
+#define LOG_RECORD_HEADER_SIZE         12
+/* the record summary of the sector which has no record */
+#define LOG_SUMMARY_EMPTY              0xFFFFFFFF
+/* the buffer of the record write, the short record is written by one ef_port_write */
+#define LOG_RECORD_BUF_SIZE            64
+
+/* the record header, the data is padded to word after it and the record never crosses the sector */
+struct log_record_hdr {
+    uint16_t magic;
+    uint16_t len;
+    uint32_t seq;
+    uint32_t time;
+};
+#endif /* EF_LOG_USING_RECORD */
+
 /* the stored logs start address and end address. It's like a ring buffer implemented on flash. */
 static uint32_t log_start_addr = 0, log_end_addr = 0;
 /* saved log area address for flash */
 static uint32_t log_area_start_addr = 0;
 /* initialize OK flag */
 static bool init_ok = false;
+#ifdef EF_LOG_USING_RECORD
+/* the next record sequence number and the last record time */
+static uint32_t log_next_seq = 0, log_last_time = 0;
+#endif
+#ifdef EF_LOG_USING_ASYNC
+/* the staging ring, the producer moves the head and the flush moves the tail, the indexes are free running */
+static uint32_t log_async_buf[EF_LOG_ASYNC_BUF_SIZE / 4];
+static volatile uint32_t log_async_head = 0, log_async_tail = 0;
+/* they are only changed by the producer */
+static uint32_t log_async_drops = 0, log_async_drop_bytes = 0;
+static size_t log_async_high_water = 0;
+#endif
 
 static void find_start_and_end_addr(void);
 static uint32_t get_next_flash_sec_addr(uint32_t cur_addr);
+static EfErrCode log_switch_sector(uint32_t cur_addr);
+#ifdef EF_LOG_USING_RECORD
+static void log_record_init(void);
+#endif
 
 /**
  * The flash save log function initialize.
@@ -103,8 +159,16 @@ EfErrCode ef_log_init(void) {
     log_area_start_addr = EF_START_ADDR;
 #endif
 
+#ifdef EF_LOG_USING_ASYNC
+    /* the staging ring size must be a power of 2 */
+    EF_ASSERT(EF_LOG_ASYNC_BUF_SIZE % 4 == 0 && (EF_LOG_ASYNC_BUF_SIZE & (EF_LOG_ASYNC_BUF_SIZE - 1)) == 0);
+#endif
+
     /* find the log store start address and end address */
     find_start_and_end_addr();
+#ifdef EF_LOG_USING_RECORD
+    log_record_init();
+#endif
     /* initialize OK */
     init_ok = true;
 
@@ -135,13 +199,14 @@ static SectorStatus get_sector_status(uint32_t addr) {
         return SECTOR_STATUS_HEADER_ERROR;
     }
 
-    /* compare header magic code */
+    /* compare header magic code, the status which is partially written by a power loss is written, because the
+     * program only clears the bits of the erased status */
     if(sector_header_magic == LOG_SECTOR_MAGIC){
         if((status_use_magic == SECTOR_STATUS_MAGIC_EMPUT) && (status_full_magic == SECTOR_STATUS_MAGIC_EMPUT)) {
             return SECTOR_STATUS_EMPUT;
-        } else if((status_use_magic == SECTOR_STATUS_MAGIC_USING) && (status_full_magic == SECTOR_STATUS_MAGIC_EMPUT)) {
+        } else if((status_use_magic != SECTOR_STATUS_MAGIC_EMPUT) && (status_full_magic == SECTOR_STATUS_MAGIC_EMPUT)) {
              return SECTOR_STATUS_USING;
-        } else if((status_use_magic == SECTOR_STATUS_MAGIC_USING) && (status_full_magic == SECTOR_STATUS_MAGIC_FULL)) {
+        } else if(status_use_magic != SECTOR_STATUS_MAGIC_EMPUT) {
              return SECTOR_STATUS_FULL;
         } else {
             return SECTOR_STATUS_HEADER_ERROR;
@@ -227,10 +292,9 @@ static uint32_t find_sec_using_end_addr(uint32_t addr) {
         return sector_start + LOG_SECTOR_HEADER_SIZE;
     } else if (continue_ff >= 4) {
         /* form end_addr - 4 to sec_size length all area is 0xFF, so it's used part of the sector.
-         * the address must be word alignment. */
-        if (continue_ff % 4 != 0) {
-            continue_ff = (continue_ff / 4 + 1) * 4;
-        }
+         * the address must be word alignment, the partially programmed word (the log data ends with 0xFF or
+         * the write is interrupted) is used. */
+        continue_ff = continue_ff / 4 * 4;
         return sector_start + EF_ERASE_MIN_SIZE - continue_ff;
     } else {
         /* all sector not has continuous 0xFF, so the sector is full */
@@ -238,6 +302,60 @@ static uint32_t find_sec_using_end_addr(uint32_t addr) {
     }
 }
 
+/* the USING sector is closed by the sector switch, so the next sector can be USING */
+static bool log_sector_is_closed(uint32_t sec_addr) {
+#ifdef EF_LOG_USING_RECORD
+    uint32_t last_seq;
+
+    /* the summary is written before the switch */
+    return ef_port_read(sec_addr + SECTOR_HEADER_LAST_SEQ_INDEX * 4, &last_seq, sizeof(last_seq)) == EF_NO_ERR
+            && last_seq != LOG_SUMMARY_EMPTY;
+#else
+    return find_sec_using_end_addr(sec_addr) == sec_addr + EF_ERASE_MIN_SIZE;
+#endif
+}
+
+/**
+ * Finish the sector switch which is interrupted by a power loss, @see log_switch_sector.
+ * The next sector of the USING sector is erased or changed to USING, then the USING sector is changed to FULL.
+ */
+static void log_finish_switch(void) {
+    uint32_t sec_addr = log_area_start_addr, last_addr = log_area_start_addr + LOG_AREA_SIZE - EF_ERASE_MIN_SIZE;
+    uint32_t next_addr;
+    SectorStatus next_status;
+
+    /* find the first USING sector, the two USING sectors may be the last one and the first one */
+    while (sec_addr <= last_addr && get_sector_status(sec_addr) != SECTOR_STATUS_USING) {
+        sec_addr += EF_ERASE_MIN_SIZE;
+    }
+    if (sec_addr > last_addr) {
+        return;
+    }
+    if (sec_addr == log_area_start_addr && get_sector_status(last_addr) == SECTOR_STATUS_USING) {
+        sec_addr = last_addr;
+    }
+    next_addr = get_next_flash_sec_addr(sec_addr);
+    next_status = get_sector_status(next_addr);
+    /* the erase or the header of the next sector is interrupted */
+    if (next_status == SECTOR_STATUS_HEADER_ERROR) {
+        EF_DEBUG("Warning: The log sector switch is interrupted. Now will erase the next sector.\n");
+        if (ef_port_erase(next_addr, EF_ERASE_MIN_SIZE) != EF_NO_ERR
+                || write_sector_status(next_addr, SECTOR_STATUS_EMPUT) != EF_NO_ERR) {
+            return;
+        }
+        next_status = SECTOR_STATUS_EMPUT;
+    }
+    if (next_status == SECTOR_STATUS_EMPUT && log_sector_is_closed(sec_addr)) {
+        if (write_sector_status(next_addr, SECTOR_STATUS_USING) != EF_NO_ERR) {
+            return;
+        }
+        next_status = SECTOR_STATUS_USING;
+    }
+    if (next_status == SECTOR_STATUS_USING) {
+        write_sector_status(sec_addr, SECTOR_STATUS_FULL);
+    }
+}
+
 /**
  * Find the log store start address and end address.
  * It's like a ring buffer implemented on flash.
@@ -272,6 +390,9 @@ static void find_start_and_end_addr(void) {
     /* see comment of find_start_and_end_addr function */
     uint8_t cur_log_sec_state = 0;
 
+    /* the sector switch may be interrupted by a power loss */
+    log_finish_switch();
+
     /* get the first sector status */
     cur_sec_status = get_sector_status(log_area_start_addr);
     last_sec_status = cur_sec_status;
@@ -405,7 +526,8 @@ size_t ef_log_get_used_size(void) {
         physical_size = LOG_AREA_SIZE - (log_start_addr - log_end_addr);
     }
 
-    header_total_num = physical_size / EF_ERASE_MIN_SIZE + 1;
+    /* the end address may be on the sector boundary */
+    header_total_num = (physical_size + EF_ERASE_MIN_SIZE - 1) / EF_ERASE_MIN_SIZE;
 
     return physical_size - header_total_num * LOG_SECTOR_HEADER_SIZE;
 }
@@ -429,7 +551,7 @@ static EfErrCode log_seq_read(uint32_t addr, uint32_t *log, size_t size) {
             addr += LOG_SECTOR_HEADER_SIZE;
         }
         /* calculate current sector last data size */
-        read_size_temp = EF_ERASE_MIN_SIZE - (addr % EF_ERASE_MIN_SIZE);
+        read_size_temp = EF_ERASE_MIN_SIZE - ((addr + read_size) % EF_ERASE_MIN_SIZE);
         if (size < read_size_temp) {
             read_size_temp = size;
         }
@@ -505,7 +627,11 @@ EfErrCode ef_log_read(size_t index, uint32_t *log, size_t size) {
     if (log_start_addr < log_end_addr) {
         log_seq_read(log_index2addr(index), log, size);
     } else {
-        if (log_index2addr(index) + size <= log_area_start_addr + LOG_AREA_SIZE) {
+        /* the log data size from the read start to the flash log area end, the sector headers are NOT log data */
+        read_size_temp = (log_area_start_addr + LOG_AREA_SIZE) - log_index2addr(index);
+        header_total_num = read_size_temp / EF_ERASE_MIN_SIZE;
+        read_size_temp -= header_total_num * LOG_SECTOR_HEADER_SIZE;
+        if (size <= read_size_temp) {
             /*                          Flash log area
              *                         |--------------|
              * log_area_start_addr --> |##############|
@@ -543,10 +669,6 @@ EfErrCode ef_log_read(size_t index, uint32_t *log, size_t size) {
              * step1: read from (log_start_addr + log_index2addr(index)) to flash log area end address
              * step2: read from flash log area start address to read size's end address
              */
-            read_size_temp = (log_area_start_addr + LOG_AREA_SIZE) - log_index2addr(index);
-            header_total_num = read_size_temp / EF_ERASE_MIN_SIZE;
-            /* Minus some ignored bytes */
-            read_size_temp -= header_total_num * LOG_SECTOR_HEADER_SIZE;
             result = log_seq_read(log_index2addr(index), log, read_size_temp);
             if (result == EF_NO_ERR) {
                 result = log_seq_read(log_area_start_addr, log + read_size_temp / 4, size - read_size_temp);
@@ -586,7 +708,7 @@ EfErrCode ef_log_read(size_t index, uint32_t *log, size_t size) {
 EfErrCode ef_log_write(const uint32_t *log, size_t size) {
     EfErrCode result = EF_NO_ERR;
     size_t write_size = 0, writable_size = 0;
-    uint32_t write_addr = log_end_addr, erase_addr;
+    uint32_t write_addr = log_end_addr;
     SectorStatus sector_status;
 
     EF_ASSERT(size % 4 == 0);
@@ -595,74 +717,51 @@ EfErrCode ef_log_write(const uint32_t *log, size_t size) {
         return EF_ENV_INIT_FAILED;
     }
 
-    if ((sector_status = get_sector_status(write_addr)) == SECTOR_STATUS_HEADER_ERROR) {
+    /* the end address may be the log area end when the last sector is full */
+    if ((sector_status = get_sector_status(write_addr - 4)) == SECTOR_STATUS_HEADER_ERROR) {
         return EF_WRITE_ERR;
     }
-    /* write some log when current sector status is USING and EMPTY */
-    if ((sector_status == SECTOR_STATUS_USING) || (sector_status == SECTOR_STATUS_EMPUT)) {
+    /* write some log when current sector status is USING and EMPTY, the end address on the sector boundary means
+     * the last sector is full, and the address is the next sector header */
+    if (((sector_status == SECTOR_STATUS_USING) || (sector_status == SECTOR_STATUS_EMPUT))
+            && (write_addr - log_area_start_addr) % EF_ERASE_MIN_SIZE != 0) {
         /* write the already erased but not used area */
         writable_size = EF_ERASE_MIN_SIZE - ((write_addr - log_area_start_addr) % EF_ERASE_MIN_SIZE);
         if (size >= writable_size) {
+            /* the sector is closed by the next sector switch */
             result = ef_port_write(write_addr, log, writable_size);
             if (result != EF_NO_ERR) {
                 goto exit;
             }
-            /* change the current sector status to FULL */
-            result = write_sector_status(write_addr, SECTOR_STATUS_FULL);
-            if (result != EF_NO_ERR) {
-                goto exit;
-            }
             write_size += writable_size;
+            write_addr += writable_size;
+            log_end_addr = write_addr;
         } else {
             result = ef_port_write(write_addr, log, size);
             log_end_addr = write_addr + size;
             goto exit;
         }
     }
-    /* erase and write remain log */
-    while (true) {
-        /* calculate next available sector address */
-        erase_addr = write_addr = get_next_flash_sec_addr(write_addr - 4);
-        /* move the flash log start address to next available sector address */
-        if (log_start_addr == erase_addr) {
-            log_start_addr = get_next_flash_sec_addr(log_start_addr);
-        }
-        /* erase sector */
-        result = ef_port_erase(erase_addr, EF_ERASE_MIN_SIZE);
+    /* switch to the next sector and write remain log */
+    while (write_size < size) {
+        result = log_switch_sector(write_addr - 4);
         if (result != EF_NO_ERR) {
             goto exit;
         }
-        /* change the sector status to EMPTY and USING when write begin sector start address */
-        result = write_sector_status(write_addr, SECTOR_STATUS_EMPUT);
-        result = write_sector_status(write_addr, SECTOR_STATUS_USING);
-        if (result == EF_NO_ERR) {
-            write_addr += LOG_SECTOR_HEADER_SIZE;
-        } else {
-            goto exit;
-        }
+        write_addr = get_next_flash_sec_addr(write_addr - 4) + LOG_SECTOR_HEADER_SIZE;
+        log_end_addr = write_addr;
         /* calculate current sector writable data size */
         writable_size = EF_ERASE_MIN_SIZE - LOG_SECTOR_HEADER_SIZE;
-        if (size - write_size >= writable_size) {
-            result = ef_port_write(write_addr, log + write_size / 4, writable_size);
-            if (result != EF_NO_ERR) {
-                goto exit;
-            }
-            /* change the current sector status to FULL */
-            result = write_sector_status(write_addr, SECTOR_STATUS_FULL);
-            if (result != EF_NO_ERR) {
-                goto exit;
-            }
-            log_end_addr = write_addr + writable_size;
-            write_size += writable_size;
-            write_addr += writable_size;
-        } else {
-            result = ef_port_write(write_addr, log + write_size / 4, size - write_size);
-            if (result != EF_NO_ERR) {
-                goto exit;
-            }
-            log_end_addr = write_addr + (size - write_size);
-            break;
+        if (size - write_size < writable_size) {
+            writable_size = size - write_size;
+        }
+        result = ef_port_write(write_addr, log + write_size / 4, writable_size);
+        if (result != EF_NO_ERR) {
+            goto exit;
         }
+        write_size += writable_size;
+        write_addr += writable_size;
+        log_end_addr = write_addr;
     }
 
 exit:
@@ -688,8 +787,41 @@ static uint32_t get_next_flash_sec_addr(uint32_t cur_addr) {
     }
 }
 
+/**
+ * Switch to the next sector. The next sector is erased and changed to EMPTY and USING, then the current sector is
+ * changed to FULL. So there is always a USING sector, and the switch which is interrupted by a power loss is
+ * finished by log_finish_switch. The oldest sector is erased when the log area is full.
+ *
+ * @param cur_addr an address of the current sector
+ *
+ * @return result
+ */
+static EfErrCode log_switch_sector(uint32_t cur_addr) {
+    EfErrCode result;
+    uint32_t next_addr = get_next_flash_sec_addr(cur_addr);
+
+    /* move the flash log start address to next available sector address */
+    if (log_start_addr == next_addr) {
+        log_start_addr = get_next_flash_sec_addr(log_start_addr);
+    }
+    result = ef_port_erase(next_addr, EF_ERASE_MIN_SIZE);
+    if (result == EF_NO_ERR) {
+        result = write_sector_status(next_addr, SECTOR_STATUS_EMPUT);
+    }
+    if (result == EF_NO_ERR) {
+        result = write_sector_status(next_addr, SECTOR_STATUS_USING);
+    }
+    if (result == EF_NO_ERR && get_sector_status(cur_addr) == SECTOR_STATUS_USING) {
+        result = write_sector_status(cur_addr, SECTOR_STATUS_FULL);
+    }
+
+    return result;
+}
+
 /**
  * Clean all log which in flash.
+ * @note The staged logs and the statistics of the asynchronous writer are dropped, so it can NOT be called during
+ *       ef_log_async_write.
  *
  * @return result
  */
@@ -700,6 +832,18 @@ EfErrCode ef_log_clean(void) {
     /* clean address */
     log_start_addr = log_area_start_addr;
     log_end_addr = log_start_addr + LOG_SECTOR_HEADER_SIZE;
+#ifdef EF_LOG_USING_RECORD
+    log_next_seq = 0;
+    log_last_time = 0;
+#endif
+#ifdef EF_LOG_USING_ASYNC
+    /* the staged logs are dropped too, the ring is restarted so the flush writes from a word again */
+    log_async_head = 0;
+    log_async_tail = 0;
+    log_async_drops = 0;
+    log_async_drop_bytes = 0;
+    log_async_high_water = 0;
+#endif
     /* erase log flash area */
     result = ef_port_erase(log_area_start_addr, LOG_AREA_SIZE);
     if (result != EF_NO_ERR) {
@@ -728,4 +872,439 @@ exit:
     return result;
 }
 
+#ifdef EF_LOG_USING_ASYNC
+/**
+ * Append the log to the RAM staging ring, it never accesses the flash, so it can be called by a timing sensitive
+ * task. The log size is any size, the logs are packed. The log is dropped when the ring has no space.
+ * @note There is only one producer, the other producers need a lock.
+ *
+ * @param log the log
+ * @param size log size
+ *
+ * @return the appended size, 0: the log is dropped
+ */
+size_t ef_log_async_write(const void *log, size_t size) {
+    uint32_t head = log_async_head, used = head - log_async_tail, pos, len;
+
+    EF_ASSERT(log || !size);
+
+    if (size > EF_LOG_ASYNC_BUF_SIZE - used) {
+        log_async_drops++;
+        log_async_drop_bytes += size;
+        return 0;
+    }
+    pos = head & (EF_LOG_ASYNC_BUF_SIZE - 1);
+    len = EF_LOG_ASYNC_BUF_SIZE - pos < size ? EF_LOG_ASYNC_BUF_SIZE - pos : size;
+    memcpy((uint8_t *) log_async_buf + pos, log, len);
+    memcpy(log_async_buf, (const uint8_t *) log + len, size - len);
+    LOG_BARRIER();
+    log_async_head = head + size;
+    if (used + size > log_async_high_water) {
+        log_async_high_water = used + size;
+    }
+
+    return size;
+}
+
+/* the free size of the current sector, the end address on the sector boundary means a new sector */
+static size_t log_async_sector_room(void) {
+    size_t offset = (log_end_addr - log_area_start_addr) % EF_ERASE_MIN_SIZE;
+
+    return offset ? EF_ERASE_MIN_SIZE - offset : EF_ERASE_MIN_SIZE - LOG_SECTOR_HEADER_SIZE;
+}
+
+/**
+ * Write the staged logs to flash by ef_log_write. It's called by the idle hook or a low priority task.
+ * The logs are written when they fill the rest of the current sector (or the half ring), so every program is
+ * about a sector and at most one sector is erased by a call. The last bytes which are less than a word are kept
+ * until the next log.
+ *
+ * @param force write all staged words now, e.g. by a timer or before the power off
+ *
+ * @return result
+ */
+EfErrCode ef_log_async_flush(bool force) {
+    EfErrCode result = EF_NO_ERR;
+    uint32_t tail = log_async_tail, size, room, len;
+
+    /* must be call this function after initialize OK */
+    if (!init_ok) {
+        return EF_ENV_INIT_FAILED;
+    }
+
+    size = (log_async_head - tail) & ~3;
+    LOG_BARRIER();
+    room = log_async_sector_room();
+    if (!force && size < room && size < EF_LOG_ASYNC_BUF_SIZE / 2) {
+        return result;
+    }
+    while (size && result == EF_NO_ERR) {
+        len = size < room ? size : room;
+        if (len > EF_LOG_ASYNC_BUF_SIZE - (tail & (EF_LOG_ASYNC_BUF_SIZE - 1))) {
+            len = EF_LOG_ASYNC_BUF_SIZE - (tail & (EF_LOG_ASYNC_BUF_SIZE - 1));
+        }
+        result = ef_log_write(log_async_buf + (tail & (EF_LOG_ASYNC_BUF_SIZE - 1)) / 4, len);
+        if (result == EF_NO_ERR) {
+            tail += len;
+            size -= len;
+            LOG_BARRIER();
+            log_async_tail = tail;
+            /* the next sector is erased by the next call */
+            room = log_async_sector_room();
+            if (!force && room == EF_ERASE_MIN_SIZE - LOG_SECTOR_HEADER_SIZE) {
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Get the staging ring statistics.
+ *
+ * @param stats the statistics
+ */
+void ef_log_async_get_stats(ef_log_async_stats_t stats) {
+    EF_ASSERT(stats);
+
+    stats->drops = log_async_drops;
+    stats->drop_bytes = log_async_drop_bytes;
+    stats->high_water = log_async_high_water;
+    stats->staged = log_async_head - log_async_tail;
+}
+#endif /* EF_LOG_USING_ASYNC */
+
+#ifdef EF_LOG_USING_RECORD
+/* the record size in flash */
+static size_t log_record_size(size_t len) {
+    return LOG_RECORD_HEADER_SIZE + ((len + 3) & ~3);
+}
+
+/* the sector of the log end address, the end address is the next sector address when the sector is full */
+static uint32_t log_end_sec_addr(void) {
+    return (log_end_addr - 1) & (~(EF_ERASE_MIN_SIZE - 1));
+}
+
+/**
+ * Read the records by the read ahead buffer of the query, the buffer is filled from the address to the records
+ * end address. The data is read directly when there is no query.
+ *
+ * @param query the query object, it can be NULL
+ * @param addr the read address
+ * @param end_addr the records end address
+ * @param buf the read buffer
+ * @param size the read size
+ *
+ * @return result
+ */
+static EfErrCode log_query_read(ef_log_query_t query, uint32_t addr, uint32_t end_addr, void *buf, size_t size) {
+    EfErrCode result = EF_NO_ERR;
+
+    if (!query || size > EF_LOG_QUERY_BUF_SIZE) {
+        return ef_port_read(addr, (uint32_t *) buf, size);
+    }
+    if (addr < query->buf_addr || addr + size > query->buf_addr + query->buf_len) {
+        query->buf_addr = addr;
+        query->buf_len = end_addr - addr < EF_LOG_QUERY_BUF_SIZE ? end_addr - addr : EF_LOG_QUERY_BUF_SIZE;
+        result = ef_port_read(addr, query->buf, query->buf_len);
+        if (result != EF_NO_ERR) {
+            query->buf_len = 0;
+            return result;
+        }
+    }
+    memcpy(buf, (uint8_t *) query->buf + (addr - query->buf_addr), size);
+
+    return result;
+}
+
+/**
+ * Read the record header.
+ *
+ * @param query the query object, it can be NULL
+ * @param addr record address
+ * @param end_addr the records end address
+ * @param hdr the record header
+ *
+ * @return true: it's a record
+ */
+static bool log_read_record_hdr(ef_log_query_t query, uint32_t addr, uint32_t end_addr,
+        struct log_record_hdr *hdr) {
+    if (addr + LOG_RECORD_HEADER_SIZE > end_addr
+            || log_query_read(query, addr, end_addr, hdr, LOG_RECORD_HEADER_SIZE) != EF_NO_ERR) {
+        return false;
+    }
+
+    return hdr->magic == LOG_RECORD_MAGIC && addr + log_record_size(hdr->len) <= end_addr;
+}
+
+/**
+ * Find the last record by the USING sector records, or by the summary of the sector before it.
+ * The end address is the last record end, so the data which has the 0xFF tail is NOT overwritten.
+ */
+static void log_record_init(void) {
+    uint32_t sec_addr = log_end_sec_addr(), addr, summary[2];
+    struct log_record_hdr hdr;
+
+    log_next_seq = 0;
+    log_last_time = 0;
+    for (addr = sec_addr + LOG_SECTOR_HEADER_SIZE; log_read_record_hdr(NULL, addr, sec_addr + EF_ERASE_MIN_SIZE, &hdr);
+            addr += log_record_size(hdr.len)) {
+        log_next_seq = hdr.seq + 1;
+        log_last_time = hdr.time;
+    }
+    log_end_addr = addr;
+    if (addr == sec_addr + LOG_SECTOR_HEADER_SIZE && sec_addr != log_start_addr) {
+        /* the USING sector has no record */
+        sec_addr = sec_addr == log_area_start_addr ? log_area_start_addr + LOG_AREA_SIZE - EF_ERASE_MIN_SIZE
+                : sec_addr - EF_ERASE_MIN_SIZE;
+        if (ef_port_read(sec_addr + SECTOR_HEADER_LAST_SEQ_INDEX * 4, summary, sizeof(summary)) == EF_NO_ERR
+                && summary[0] != LOG_SUMMARY_EMPTY) {
+            log_next_seq = summary[0] + 1;
+            log_last_time = summary[1];
+        }
+    }
+}
+
+/**
+ * Close the current sector by the summary, then switch to the next sector like ef_log_write.
+ *
+ * @param sec_addr current sector address
+ *
+ * @return result
+ */
+static EfErrCode log_record_next_sector(uint32_t sec_addr) {
+    EfErrCode result;
+    uint32_t summary[2] = { log_next_seq - 1, log_last_time };
+
+    /* the summary is written before the switch, so every FULL sector has the summary */
+    result = ef_port_write(sec_addr + SECTOR_HEADER_LAST_SEQ_INDEX * 4, summary, sizeof(summary));
+    if (result == EF_NO_ERR) {
+        result = log_switch_sector(sec_addr);
+    }
+    if (result != EF_NO_ERR) {
+        return result;
+    }
+    log_end_addr = get_next_flash_sec_addr(sec_addr) + LOG_SECTOR_HEADER_SIZE;
+
+    return result;
+}
+
+/**
+ * Write a log record to flash. The record has the sequence number which is added by one for every record, and
+ * the time which is given by the caller, the time must NOT decrease. The record is NOT split by the sector, the
+ * sector is closed when the record is NOT fit. The records can be found by ef_log_query_by_time and
+ * ef_log_query_by_seq. @note The ef_log_write logs can NOT be written with the records.
+ *
+ * @param time the record time, e.g. the seconds or the milliseconds
+ * @param data the record data
+ * @param size the record data size
+ *
+ * @return result
+ */
+EfErrCode ef_log_write_record(uint32_t time, const void *data, size_t size) {
+    EfErrCode result = EF_NO_ERR;
+    size_t rec_size = log_record_size(size), len, pos = LOG_RECORD_HEADER_SIZE;
+    uint32_t buf[LOG_RECORD_BUF_SIZE / 4], sec_addr, addr;
+    struct log_record_hdr *hdr = (struct log_record_hdr *) buf;
+    const uint8_t *src = data;
+
+    EF_ASSERT(data || !size);
+    /* must be call this function after initialize OK */
+    if (!init_ok) {
+        return EF_ENV_INIT_FAILED;
+    }
+    if (rec_size > EF_ERASE_MIN_SIZE - LOG_SECTOR_HEADER_SIZE) {
+        EF_INFO("Error: The log record is larger than the sector.\n");
+        return EF_WRITE_ERR;
+    }
+
+    sec_addr = log_end_sec_addr();
+    if (log_end_addr + rec_size > sec_addr + EF_ERASE_MIN_SIZE) {
+        result = log_record_next_sector(sec_addr);
+        if (result != EF_NO_ERR) {
+            return result;
+        }
+        sec_addr = log_end_sec_addr();
+    }
+    if (log_end_addr == sec_addr + LOG_SECTOR_HEADER_SIZE) {
+        /* the first record of the sector */
+        buf[0] = log_next_seq;
+        buf[1] = time;
+        result = ef_port_write(sec_addr + SECTOR_HEADER_FIRST_SEQ_INDEX * 4, buf, 8);
+        if (result != EF_NO_ERR) {
+            return result;
+        }
+    }
+
+    hdr->magic = LOG_RECORD_MAGIC;
+    hdr->len = (uint16_t) size;
+    hdr->seq = log_next_seq;
+    hdr->time = time;
+    for (addr = log_end_addr; result == EF_NO_ERR && addr < log_end_addr + rec_size; addr += pos, pos = 0) {
+        /* fill the buffer by the data and the 0xFF padding */
+        len = size < LOG_RECORD_BUF_SIZE - pos ? size : LOG_RECORD_BUF_SIZE - pos;
+        memcpy((uint8_t *) buf + pos, src, len);
+        src += len;
+        size -= len;
+        pos += len;
+        while (pos % 4) {
+            ((uint8_t *) buf)[pos++] = 0xFF;
+        }
+        result = ef_port_write(addr, buf, pos);
+    }
+    if (result == EF_NO_ERR) {
+        log_end_addr += rec_size;
+        log_next_seq++;
+        log_last_time = time;
+    }
+
+    return result;
+}
+
+/* the sector address by the order, 0 is the oldest sector */
+static uint32_t log_query_sec_addr(size_t index) {
+    size_t start = (log_start_addr - log_area_start_addr) / EF_ERASE_MIN_SIZE;
+
+    return log_area_start_addr + (start + index) % (LOG_AREA_SIZE / EF_ERASE_MIN_SIZE) * EF_ERASE_MIN_SIZE;
+}
+
+/**
+ * Get the min and the max key of the sector records by the sector summary.
+ * The last record of the USING sector is in RAM.
+ *
+ * @return false: the sector has no record
+ */
+static bool log_query_summary(ef_log_query_t query, uint32_t sec_addr, uint32_t *min, uint32_t *max) {
+    uint32_t header[LOG_SECTOR_HEADER_SIZE / 4];
+
+    if (ef_port_read(sec_addr, header, sizeof(header)) != EF_NO_ERR
+            || header[SECTOR_HEADER_FIRST_SEQ_INDEX] == LOG_SUMMARY_EMPTY) {
+        return false;
+    }
+    if (query->by_time) {
+        *min = header[SECTOR_HEADER_FIRST_TIME_INDEX];
+        *max = header[SECTOR_HEADER_FULL_INDEX] == SECTOR_STATUS_MAGIC_FULL ? header[SECTOR_HEADER_LAST_TIME_INDEX]
+                : log_last_time;
+    } else {
+        *min = header[SECTOR_HEADER_FIRST_SEQ_INDEX];
+        *max = header[SECTOR_HEADER_FULL_INDEX] == SECTOR_STATUS_MAGIC_FULL ? header[SECTOR_HEADER_LAST_SEQ_INDEX]
+                : log_next_seq - 1;
+    }
+
+    return true;
+}
+
+/* binary search the first sector which max key is NOT less than the query min key */
+static EfErrCode log_query_init(ef_log_query_t query, bool by_time, uint32_t from, uint32_t to) {
+    size_t low = 0, high, mid;
+    uint32_t min, max;
+
+    EF_ASSERT(query);
+    /* must be call this function after initialize OK */
+    if (!init_ok) {
+        return EF_ENV_INIT_FAILED;
+    }
+
+    query->by_time = by_time;
+    query->from = from;
+    query->to = to;
+    query->num = (log_end_sec_addr() - log_start_addr + LOG_AREA_SIZE) % LOG_AREA_SIZE / EF_ERASE_MIN_SIZE + 1;
+    high = query->num;
+    while (low < high) {
+        mid = (low + high) / 2;
+        if (log_query_summary(query, log_query_sec_addr(mid), &min, &max) && max < from) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    query->index = low;
+    query->addr = 0;
+    query->buf_addr = 0;
+    query->buf_len = 0;
+
+    return EF_NO_ERR;
+}
+
+/**
+ * Start the log record query by the time. The sectors before the time are skipped by the sector summary, so the
+ * recent records are found without reading the whole log area. @note Don't write the record during the query.
+ *
+ * @param query the query object
+ * @param from the min time
+ * @param to the max time
+ *
+ * @return result
+ */
+EfErrCode ef_log_query_by_time(ef_log_query_t query, uint32_t from, uint32_t to) {
+    return log_query_init(query, true, from, to);
+}
+
+/**
+ * Start the log record query by the sequence number. @see ef_log_query_by_time
+ *
+ * @param query the query object
+ * @param from the min sequence number
+ * @param to the max sequence number
+ *
+ * @return result
+ */
+EfErrCode ef_log_query_by_seq(ef_log_query_t query, uint32_t from, uint32_t to) {
+    return log_query_init(query, false, from, to);
+}
+
+/**
+ * Read the next record of the query in the write order. The record sequence number, time and data length are
+ * in the query object.
+ *
+ * @param query the query object
+ * @param data the record data buffer
+ * @param size the buffer size, the longer record data is cut
+ *
+ * @return true: a record is read, false: no more record
+ */
+bool ef_log_query_next(ef_log_query_t query, void *data, size_t size) {
+    uint32_t sec_addr, end_addr, min, max, key;
+    struct log_record_hdr hdr;
+
+    EF_ASSERT(query);
+
+    while (query->index < query->num) {
+        sec_addr = log_query_sec_addr(query->index);
+        if (!query->addr) {
+            /* the sector is skipped when the records are after the max key */
+            if (!log_query_summary(query, sec_addr, &min, &max) || min > query->to) {
+                break;
+            }
+            query->addr = sec_addr + LOG_SECTOR_HEADER_SIZE;
+        }
+        end_addr = sec_addr == log_end_sec_addr() ? log_end_addr : sec_addr + EF_ERASE_MIN_SIZE;
+        if (!log_read_record_hdr(query, query->addr, end_addr, &hdr)) {
+            query->index++;
+            query->addr = 0;
+            continue;
+        }
+        key = query->by_time ? hdr.time : hdr.seq;
+        if (key > query->to) {
+            break;
+        }
+        query->addr += log_record_size(hdr.len);
+        if (key >= query->from) {
+            query->seq = hdr.seq;
+            query->time = hdr.time;
+            query->len = hdr.len;
+            if (size > hdr.len) {
+                size = hdr.len;
+            }
+            return log_query_read(query, query->addr - log_record_size(hdr.len) + LOG_RECORD_HEADER_SIZE, end_addr,
+                    data, size) == EF_NO_ERR;
+        }
+    }
+    query->index = query->num;
+
+    return false;
+}
+#endif /* EF_LOG_USING_RECORD */
+
 #endif /* EF_USING_LOG */
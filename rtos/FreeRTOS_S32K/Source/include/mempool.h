@@ -0,0 +1,149 @@
+/*
+    FreeRTOS V8.2.1 fixed size block pools.
+
+    1 tab == 4 spaces!
+*/
+
+/*-----------------------------------------------------------
+ * Fixed size block pools.
+ *
+ * A pool is a static array of equal sized blocks with a lock free list of the
+ * free blocks, so pvMemPoolAlloc() and xMemPoolFree() take a constant time,
+ * never suspend the scheduler and can be called from any task or interrupt.
+ * The blocks are carved from the static storage on the first use, so a pool
+ * defined by memPOOL_DEFINE() needs no initialisation.
+ *
+ * The pools do NOT depend on the kernel, so they are used by the bare-metal
+ * OSIF as well.  On the Cortex-M4 the list is updated with LDREX/STREX, the
+ * exclusive monitor is cleared by every exception entry and return, so a
+ * preempted update is retried and the ABA problem can NOT happen.  Other
+ * targets (the POSIX host) use the C11 atomics with a generation count in the
+ * list head.
+ *
+ * Usage notes:
+ *
+ * memPOOL_DEFINE( xCanFramePool, sizeof( flexcan_msgbuff_t ), 32 ); << 32 blocks of a CAN frame.
+ *
+ * flexcan_msgbuff_t *pxFrame = pvMemPoolAlloc( &xCanFramePool );
+ * ...
+ * xMemPoolFree( &xCanFramePool, pxFrame );
+ *
+ * A set of pools in the ascending block size order is a set of size classes,
+ * pvMemPoolAllocClass() takes the block from the smallest pool that fits, or
+ * from the next bigger one when it's exhausted.
+ *----------------------------------------------------------*/
+
+#ifndef MEMPOOL_H
+#define MEMPOOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined( __GNUC__ ) && ( defined( __ARM_ARCH_7EM__ ) || defined( __ARM_ARCH_7M__ ) )
+	/* The LDREX/STREX of the Cortex-M4, the head is the index of the first free
+	block. */
+	#define memPOOL_USE_EXCLUSIVE_ACCESS	1
+	typedef volatile uint32_t MemPoolHead_t;
+	typedef volatile uint32_t MemPoolCounter_t;
+#else
+	/* The C11 atomics, the head is the generation count in the high 32 bits and
+	the index of the first free block in the low 32 bits. */
+	#include <stdatomic.h>
+	#define memPOOL_USE_EXCLUSIVE_ACCESS	0
+	typedef _Atomic uint64_t MemPoolHead_t;
+	typedef _Atomic uint32_t MemPoolCounter_t;
+#endif
+
+/* The index of no block, it ends the free list. */
+#define memPOOL_NO_BLOCK			( ( uint32_t ) 0xFFFFFFFFUL )
+
+/* The blocks are aligned to 8 bytes, so they can keep any type of the
+Cortex-M4 (the AAPCS aligns the 64-bit types to 8 bytes). */
+#define memPOOL_ALIGNMENT			( ( size_t ) 8 )
+#define memPOOL_BLOCK_SIZE( xSize )	( ( ( size_t ) ( xSize ) + ( memPOOL_ALIGNMENT - 1 ) ) & ~( memPOOL_ALIGNMENT - 1 ) )
+
+#define memPOOL_PASS				( 1 )
+#define memPOOL_FAIL				( 0 )
+
+typedef struct xMEM_POOL
+{
+	uint8_t *pucStorage;			/*<< The static storage of the blocks. */
+	size_t xBlockSize;				/*<< The size of a block, a multiple of memPOOL_ALIGNMENT. */
+	uint32_t ulBlockCount;			/*<< The number of blocks in the storage. */
+	MemPoolHead_t xFreeHead;		/*<< The list of the freed blocks, the next index is in the first word of the block. */
+	MemPoolCounter_t ulCarved;		/*<< The blocks taken from the storage so far, the others were never used. */
+	MemPoolCounter_t ulUsed;		/*<< The blocks allocated now. */
+	MemPoolCounter_t ulHighWater;	/*<< The maximum of ulUsed. */
+	MemPoolCounter_t ulFailed;		/*<< The allocations failed as the pool was exhausted. */
+} MemPool_t;
+
+typedef struct xMEM_POOL_STATS
+{
+	size_t xBlockSize;
+	uint32_t ulBlockCount;
+	uint32_t ulUsed;
+	uint32_t ulHighWater;
+	uint32_t ulFailed;
+} MemPoolStats_t;
+
+/*
+ * Define the pool xName of ulBlockCount blocks of xSize bytes.  The storage is
+ * static, the pool itself has the linkage of the definition, so the drivers can
+ * share it by an extern declaration.
+ */
+#define memPOOL_DEFINE( xName, xSize, ulBlockCount )																\
+	static uint64_t xName##_ullStorage[ ( ( ulBlockCount ) * memPOOL_BLOCK_SIZE( xSize ) ) / sizeof( uint64_t ) ];	\
+	MemPool_t xName = { ( uint8_t * ) xName##_ullStorage, memPOOL_BLOCK_SIZE( xSize ), ( ulBlockCount ),			\
+						memPOOL_NO_BLOCK, 0, 0, 0, 0 }
+
+/*
+ * Initialise the pool on the given storage at run time, the storage must be
+ * aligned to memPOOL_ALIGNMENT and hold ulBlockCount blocks of
+ * memPOOL_BLOCK_SIZE( xSize ) bytes.  It must NOT be called while the pool is
+ * used.
+ */
+void vMemPoolInit( MemPool_t *pxPool, void *pvStorage, size_t xSize, uint32_t ulBlockCount );
+
+/*
+ * Take a block from the pool, NULL if the pool is exhausted.  It can be called
+ * from an interrupt.
+ */
+void *pvMemPoolAlloc( MemPool_t *pxPool );
+
+/*
+ * Return the block to the pool.  memPOOL_FAIL if the block is NOT a block of
+ * the pool.  It can be called from an interrupt.
+ */
+long xMemPoolFree( MemPool_t *pxPool, void *pv );
+
+/*
+ * memPOOL_PASS if pv is a block of the pool.
+ */
+long xMemPoolContains( const MemPool_t *pxPool, const void *pv );
+
+/*
+ * Take a block of at least xSize bytes from the size classes, the pools must be
+ * in the ascending block size order.  NULL if no pool that fits has a free
+ * block.
+ */
+void *pvMemPoolAllocClass( MemPool_t * const pxPools[], uint32_t ulPoolCount, size_t xSize );
+
+/*
+ * Return the block to the pool of the size classes which it belongs to.
+ */
+long xMemPoolFreeClass( MemPool_t * const pxPools[], uint32_t ulPoolCount, void *pv );
+
+/*
+ * Get the usage and the high-water mark of the pool.
+ */
+void vMemPoolGetStats( MemPool_t *pxPool, MemPoolStats_t *pxStats );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MEMPOOL_H */
@@ -0,0 +1,330 @@
+/*
+    FreeRTOS V8.2.1 POSIX host port.
+
+    All tasks run on one host thread, every task has its own ucontext and host
+    stack, so only one task runs at a time like on the MCU.  The SysTick is the
+    SIGALRM of an ITIMER_REAL interval timer.  The interrupt mask (BASEPRI) is
+    a software flag: the tick which comes while the interrupts are masked is
+    pended, and it's taken with the pended yield (PendSV) when the interrupts
+    are enabled again.
+
+    1 tab == 4 spaces!
+*/
+
+/*-----------------------------------------------------------
+ * Implementation of functions defined in portable.h for the POSIX port.
+ *----------------------------------------------------------*/
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <ucontext.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#if( INCLUDE_xTaskGetCurrentTaskHandle != 1 )
+	#error This port needs INCLUDE_xTaskGetCurrentTaskHandle to find the context of the running task.
+#endif
+
+/* The host context of a task, the pointer of it is at the top of the FreeRTOS
+stack. */
+typedef struct xPORT_THREAD
+{
+	ucontext_t xContext;
+	TaskFunction_t pxCode;
+	void *pvParameters;
+	uint8_t ucStack[ portTASK_HOST_STACK_SIZE ];
+} xPortThread;
+
+/*
+ * Setup the SysTick signal and the interval timer.
+ */
+static void prvSetupTimerInterrupt( void );
+
+/*
+ * The SysTick handler, it's the SIGALRM handler.
+ */
+static void prvSysTickHandler( int iSignal );
+
+/*
+ * Take the pended ticks and the pended yield, it's called by the SysTick
+ * handler and when the interrupts are enabled.
+ */
+static void prvServicePendedInterrupts( void );
+
+/*
+ * The start function of all tasks.
+ */
+static void prvTaskStart( void );
+
+/*
+ * Used to catch tasks that attempt to return from their implementing function.
+ */
+static void prvTaskExitError( void );
+
+/*-----------------------------------------------------------*/
+
+/* Each task maintains its own interrupt status in the critical nesting
+variable. */
+static volatile UBaseType_t uxCriticalNesting = 0;
+
+/* The simulated interrupt state, the BASEPRI is set, the PendSV is pended and
+the handler (SysTick or PendSV) is running. */
+static volatile BaseType_t xInterruptsMasked = pdTRUE;
+static volatile BaseType_t xYieldPending = pdFALSE;
+static volatile BaseType_t xInterruptActive = pdFALSE;
+
+/* The SysTicks which are NOT processed yet. */
+static volatile uint32_t ulPendedTicks = 0;
+
+static volatile BaseType_t xSchedulerStarted = pdFALSE;
+
+/* The host context which started the scheduler, vPortEndScheduler() returns
+to it. */
+static ucontext_t xSchedulerContext;
+
+/*-----------------------------------------------------------*/
+
+static xPortThread *prvGetThread( TaskHandle_t xTask )
+{
+	/* The pxTopOfStack is the first member of the TCB. */
+	StackType_t *pxTopOfStack = *( StackType_t ** ) xTask;
+
+	return ( xPortThread * ) *pxTopOfStack;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * See header file for description.
+ */
+StackType_t *pxPortInitialiseStack( StackType_t *pxTopOfStack, TaskFunction_t pxCode, void *pvParameters )
+{
+xPortThread *pxThread;
+
+	/* The host malloc() is NOT reentrant. */
+	portENTER_CRITICAL();
+	pxThread = malloc( sizeof( xPortThread ) );
+	portEXIT_CRITICAL();
+	configASSERT( pxThread );
+
+	getcontext( &( pxThread->xContext ) );
+	pxThread->xContext.uc_stack.ss_sp = pxThread->ucStack;
+	pxThread->xContext.uc_stack.ss_size = sizeof( pxThread->ucStack );
+	pxThread->xContext.uc_link = NULL;
+	/* The SysTick is never blocked in a task. */
+	sigemptyset( &( pxThread->xContext.uc_sigmask ) );
+	pxThread->pxCode = pxCode;
+	pxThread->pvParameters = pvParameters;
+	makecontext( &( pxThread->xContext ), prvTaskStart, 0 );
+
+	pxTopOfStack--;
+	*pxTopOfStack = ( StackType_t ) pxThread;
+
+	return pxTopOfStack;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTaskStart( void )
+{
+xPortThread *pxThread = prvGetThread( xTaskGetCurrentTaskHandle() );
+
+	/* The task is started by a context switch, so it leaves the handler with
+	the interrupts enabled. */
+	xInterruptActive = pdFALSE;
+	portENABLE_INTERRUPTS();
+
+	pxThread->pxCode( pxThread->pvParameters );
+
+	prvTaskExitError();
+}
+/*-----------------------------------------------------------*/
+
+static void prvTaskExitError( void )
+{
+	/* A function that implements a task must not exit or attempt to return to
+	its caller as there is nothing to return to.  If a task wants to exit it
+	should instead call vTaskDelete( NULL ). */
+	configASSERT( uxCriticalNesting == ~0UL );
+	portDISABLE_INTERRUPTS();
+	for( ;; );
+}
+/*-----------------------------------------------------------*/
+
+void vPortCleanUpTCB( void *pxTCB )
+{
+xPortThread *pxThread = prvGetThread( ( TaskHandle_t ) pxTCB );
+
+	/* The deleted task is cleaned up by the idle task, so the host stack is
+	NOT used. */
+	portENTER_CRITICAL();
+	free( pxThread );
+	portEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * See header file for description.
+ */
+BaseType_t xPortStartScheduler( void )
+{
+xPortThread *pxThread;
+
+	/* The interrupts are disabled by vTaskStartScheduler(), the first task
+	enables them. */
+	uxCriticalNesting = 0;
+	ulPendedTicks = 0;
+	xYieldPending = pdFALSE;
+	xSchedulerStarted = pdTRUE;
+	prvSetupTimerInterrupt();
+
+	/* Start the first task. */
+	pxThread = prvGetThread( xTaskGetCurrentTaskHandle() );
+	xInterruptActive = pdTRUE;
+	swapcontext( &xSchedulerContext, &( pxThread->xContext ) );
+
+	/* The scheduler is ended by vTaskEndScheduler(). */
+	xSchedulerStarted = pdFALSE;
+	xInterruptActive = pdFALSE;
+	xInterruptsMasked = pdFALSE;
+	uxCriticalNesting = 0;
+
+	return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+void vPortEndScheduler( void )
+{
+struct itimerval xTimer;
+
+	/* Stop the SysTick, then return to xPortStartScheduler().  The tasks
+	which are NOT deleted are NOT freed. */
+	memset( &xTimer, 0, sizeof( xTimer ) );
+	setitimer( ITIMER_REAL, &xTimer, NULL );
+	signal( SIGALRM, SIG_IGN );
+
+	setcontext( &xSchedulerContext );
+}
+/*-----------------------------------------------------------*/
+
+void vPortYield( void )
+{
+	/* Pend the yield like the PendSV, it's taken now when the interrupts are
+	enabled, otherwise it's taken when they are enabled again. */
+	xYieldPending = pdTRUE;
+	if( ( xInterruptsMasked == pdFALSE ) && ( xInterruptActive == pdFALSE ) )
+	{
+		prvServicePendedInterrupts();
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortDisableInterrupts( void )
+{
+	xInterruptsMasked = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnableInterrupts( void )
+{
+	xInterruptsMasked = pdFALSE;
+	if( ( xInterruptActive == pdFALSE ) && ( ( ulPendedTicks != 0 ) || ( xYieldPending != pdFALSE ) ) )
+	{
+		prvServicePendedInterrupts();
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnterCritical( void )
+{
+	portDISABLE_INTERRUPTS();
+	uxCriticalNesting++;
+}
+/*-----------------------------------------------------------*/
+
+void vPortExitCritical( void )
+{
+	configASSERT( uxCriticalNesting );
+	uxCriticalNesting--;
+	if( uxCriticalNesting == 0 )
+	{
+		portENABLE_INTERRUPTS();
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvServicePendedInterrupts( void )
+{
+xPortThread *pxOldThread, *pxNewThread;
+
+	if( xSchedulerStarted == pdFALSE )
+	{
+		return;
+	}
+
+	do
+	{
+		/* The SysTick which comes in the handler is pended, it's taken by the
+		loop. */
+		xInterruptActive = pdTRUE;
+		while( ulPendedTicks != 0 )
+		{
+			__atomic_sub_fetch( &ulPendedTicks, 1, __ATOMIC_SEQ_CST );
+			if( xTaskIncrementTick() != pdFALSE )
+			{
+				xYieldPending = pdTRUE;
+			}
+		}
+
+		if( xYieldPending != pdFALSE )
+		{
+			xYieldPending = pdFALSE;
+			pxOldThread = prvGetThread( xTaskGetCurrentTaskHandle() );
+			vTaskSwitchContext();
+			pxNewThread = prvGetThread( xTaskGetCurrentTaskHandle() );
+			if( pxNewThread != pxOldThread )
+			{
+				/* The task is resumed here by the next context switch. */
+				swapcontext( &( pxOldThread->xContext ), &( pxNewThread->xContext ) );
+			}
+		}
+		xInterruptActive = pdFALSE;
+
+		/* The SysTick may come before the handler is left. */
+	} while( ( xInterruptsMasked == pdFALSE ) && ( ( ulPendedTicks != 0 ) || ( xYieldPending != pdFALSE ) ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvSysTickHandler( int iSignal )
+{
+	( void ) iSignal;
+
+	__atomic_add_fetch( &ulPendedTicks, 1, __ATOMIC_SEQ_CST );
+	if( ( xInterruptsMasked == pdFALSE ) && ( xInterruptActive == pdFALSE ) )
+	{
+		prvServicePendedInterrupts();
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetupTimerInterrupt( void )
+{
+struct sigaction xAction;
+struct itimerval xTimer;
+
+	memset( &xAction, 0, sizeof( xAction ) );
+	xAction.sa_handler = prvSysTickHandler;
+	xAction.sa_flags = SA_RESTART;
+	sigemptyset( &xAction.sa_mask );
+	sigaction( SIGALRM, &xAction, NULL );
+
+	xTimer.it_interval.tv_sec = 0;
+	xTimer.it_interval.tv_usec = 1000000UL / configTICK_RATE_HZ;
+	xTimer.it_value = xTimer.it_interval;
+	setitimer( ITIMER_REAL, &xTimer, NULL );
+}
+/*-----------------------------------------------------------*/
+
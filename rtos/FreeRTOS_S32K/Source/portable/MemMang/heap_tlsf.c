@@ -0,0 +1,610 @@
+/*
+    FreeRTOS V8.2.1 TLSF heap.
+
+    1 tab == 4 spaces!
+*/
+
+/*
+ * A sample implementation of pvPortMalloc() and vPortFree() based on the Two
+ * Level Segregated Fit (TLSF) allocator.  The free blocks are kept in a matrix
+ * of free lists: the first level splits the sizes by the power of two, the
+ * second level splits every power of two range into
+ * ( 1 << configTLSF_SL_INDEX_COUNT_LOG2 ) linear sub ranges.  A bit map of the
+ * non empty lists is kept for each level, so both pvPortMalloc() and
+ * vPortFree() take a constant time, unlike heap_4.c and heap_5.c which walk
+ * the free list.  Freed blocks are combined (coalesced) with their free
+ * physical neighbours straight away.
+ *
+ * The allocation is a good fit: the wanted size is rounded up to the next
+ * second level range, so any block of the found list fits without a search.
+ * The cost is up to 1 / ( 1 << configTLSF_SL_INDEX_COUNT_LOG2 ) internal
+ * fragmentation of the large blocks.
+ *
+ * See heap_1.c, heap_2.c, heap_3.c, heap_4.c and heap_5.c for alternative
+ * implementations, and the memory management pages of http://www.FreeRTOS.org
+ * for more information.
+ *
+ * Usage notes:
+ *
+ * The heap is defined across one or more regions like heap_5.c, so
+ * vPortDefineHeapRegions() ***must*** be called before pvPortMalloc(), and
+ * before any task objects (tasks, queues, event groups, etc.) are created.
+ *
+ * HeapRegion_t xHeapRegions[] =
+ * {
+ * 	{ ( uint8_t * ) 0x1FFF8000UL, 0x8000 }, << Defines a block of 0x8000 bytes starting at address 0x1FFF8000
+ * 	{ ( uint8_t * ) 0x20000000UL, 0x6000 }, << Defines a block of 0x6000 bytes starting at address 0x20000000
+ * 	{ NULL, 0 }                << Terminates the array.
+ * };
+ *
+ * vPortDefineHeapRegions( xHeapRegions ); << Pass the array into vPortDefineHeapRegions().
+ *
+ * The regions are never combined, so they need NOT be in address order.  Each
+ * region must be smaller than ( 2 << configTLSF_FL_INDEX_MAX ) bytes.
+ *
+ * configTLSF_SL_INDEX_COUNT_LOG2 (default 4) and configTLSF_FL_INDEX_MAX
+ * (default 20, 1 MB) can be defined in FreeRTOSConfig.h.  The free list matrix
+ * takes ( configTLSF_FL_INDEX_MAX - configTLSF_SL_INDEX_COUNT_LOG2 -
+ * log2( portBYTE_ALIGNMENT ) + 1 ) * ( 1 << configTLSF_SL_INDEX_COUNT_LOG2 )
+ * pointers, 896 bytes with the defaults on the Cortex-M4.
+ */
+#include <stdlib.h>
+#include <stddef.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+/* The log2 of the number of second level lists of a power of two range. */
+#ifndef configTLSF_SL_INDEX_COUNT_LOG2
+	#define configTLSF_SL_INDEX_COUNT_LOG2	4
+#endif
+
+/* The log2 of the biggest first level range, it limits the size of a block and
+so the size of a region. */
+#ifndef configTLSF_FL_INDEX_MAX
+	#define configTLSF_FL_INDEX_MAX			20
+#endif
+
+#if portBYTE_ALIGNMENT == 32
+	#define heapALIGNMENT_LOG2		5
+#elif portBYTE_ALIGNMENT == 16
+	#define heapALIGNMENT_LOG2		4
+#elif portBYTE_ALIGNMENT == 8
+	#define heapALIGNMENT_LOG2		3
+#elif portBYTE_ALIGNMENT == 4
+	#define heapALIGNMENT_LOG2		2
+#else
+	#error heap_tlsf.c needs portBYTE_ALIGNMENT of 4, 8, 16 or 32 bytes, the low bits of the block size hold the flags.
+#endif
+
+/* The blocks smaller than heapSMALL_BLOCK_SIZE are all in the first level list
+0, its second level lists are portBYTE_ALIGNMENT apart. */
+#define heapSL_INDEX_COUNT		( 1UL << configTLSF_SL_INDEX_COUNT_LOG2 )
+#define heapFL_INDEX_SHIFT		( configTLSF_SL_INDEX_COUNT_LOG2 + heapALIGNMENT_LOG2 )
+#define heapFL_INDEX_COUNT		( configTLSF_FL_INDEX_MAX - heapFL_INDEX_SHIFT + 1 )
+#define heapSMALL_BLOCK_SIZE	( ( size_t ) 1 << heapFL_INDEX_SHIFT )
+
+#if( configTLSF_SL_INDEX_COUNT_LOG2 > 5 )
+	#error configTLSF_SL_INDEX_COUNT_LOG2 must be 5 or less, the second level bit map is 32 bits.
+#endif
+
+#if( ( heapFL_INDEX_COUNT < 1 ) || ( heapFL_INDEX_COUNT > 31 ) )
+	#error configTLSF_FL_INDEX_MAX is out of range for the first level bit map.
+#endif
+
+/* The biggest block, its first level index is configTLSF_FL_INDEX_MAX. */
+#define heapMAX_BLOCK_SIZE		( ( ( size_t ) 2 << configTLSF_FL_INDEX_MAX ) - portBYTE_ALIGNMENT )
+
+/* The flag in the low bit of the xBlockSize member, the size is always a
+multiple of portBYTE_ALIGNMENT. */
+#define heapBLOCK_FREE_BIT		( ( size_t ) 1 )
+
+/* Block sizes must not get too small, a free block holds the free list links
+too. */
+#define heapMINIMUM_BLOCK_SIZE	( ( ( sizeof( TlsfBlock_t ) + ( ( size_t ) ( portBYTE_ALIGNMENT - 1 ) ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK ) ) )
+
+/* Assumes 8bit bytes! */
+#define heapBITS_PER_BYTE		( ( size_t ) 8 )
+
+/* The header of a block.  The allocated block only uses the first two members,
+the memory returned to the application starts after them.  The physical
+neighbours are found by the previous block pointer and by the size, so the
+freed block is combined without a search.  Each region ends with a zero sized
+allocated block, so a block is never combined across the region end. */
+typedef struct A_TLSF_BLOCK
+{
+	struct A_TLSF_BLOCK *pxPrevPhysBlock;	/*<< The block just before this one in memory, NULL for the first block of a region. */
+	size_t xBlockSize;						/*<< The size of the block with the header, and the free flag. */
+	struct A_TLSF_BLOCK *pxNextFreeBlock;	/*<< The next block in the free list, only in the free block. */
+	struct A_TLSF_BLOCK *pxPrevFreeBlock;	/*<< The previous block in the free list, only in the free block. */
+} TlsfBlock_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * The index of the most and the least significant set bit.
+ */
+static UBaseType_t prvFls( size_t xValue );
+static UBaseType_t prvFfs( uint32_t ulValue );
+
+/*
+ * Find the first and the second level list of the block size.
+ */
+static void prvMappingInsert( size_t xSize, UBaseType_t *puxFL, UBaseType_t *puxSL );
+
+/*
+ * Find the first and the second level list to search for the wanted size.  The
+ * size is rounded up to the next second level range, so every block of the
+ * list is big enough.
+ */
+static void prvMappingSearch( size_t xSize, UBaseType_t *puxFL, UBaseType_t *puxSL );
+
+/*
+ * Find the first non empty list from the given lists with the bit maps, the
+ * indexes are updated to the found list.  NULL if there is none.
+ */
+static TlsfBlock_t *prvSearchSuitableBlock( UBaseType_t *puxFL, UBaseType_t *puxSL );
+
+/*
+ * Insert the block into or remove it from its free list.
+ */
+static void prvInsertFreeBlock( TlsfBlock_t *pxBlock );
+static void prvRemoveFreeBlock( TlsfBlock_t *pxBlock );
+
+/*-----------------------------------------------------------*/
+
+/* The size of the header of an allocated block must by correctly byte
+aligned. */
+static const size_t xHeapStructSize	= ( offsetof( TlsfBlock_t, pxNextFreeBlock ) + ( ( size_t ) ( portBYTE_ALIGNMENT - 1 ) ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+/* The bit maps of the non empty lists and the heads of the free lists. */
+static uint32_t ulFLBitmap = 0;
+static uint32_t ulSLBitmap[ heapFL_INDEX_COUNT ];
+static TlsfBlock_t *pxFreeLists[ heapFL_INDEX_COUNT ][ heapSL_INDEX_COUNT ];
+
+/* Set when the regions are defined. */
+static BaseType_t xHeapDefined = pdFALSE;
+
+/* Keeps track of the number of free bytes remaining, but says nothing about
+fragmentation. */
+static size_t xFreeBytesRemaining = 0U;
+static size_t xMinimumEverFreeBytesRemaining = 0U;
+
+/*-----------------------------------------------------------*/
+
+static UBaseType_t prvFls( size_t xValue )
+{
+	#if defined( __GNUC__ )
+	{
+		/* The CLZ instruction on the Cortex-M4. */
+		return ( UBaseType_t ) ( ( sizeof( unsigned long ) * heapBITS_PER_BYTE ) - 1 ) - ( UBaseType_t ) __builtin_clzl( ( unsigned long ) xValue );
+	}
+	#else
+	{
+	UBaseType_t uxBit = 0, uxShift;
+
+		for( uxShift = ( sizeof( size_t ) * heapBITS_PER_BYTE ) / 2; uxShift > 0; uxShift >>= 1 )
+		{
+			if( ( xValue >> uxShift ) != 0 )
+			{
+				xValue >>= uxShift;
+				uxBit += uxShift;
+			}
+		}
+
+		return uxBit;
+	}
+	#endif
+}
+/*-----------------------------------------------------------*/
+
+static UBaseType_t prvFfs( uint32_t ulValue )
+{
+	#if defined( __GNUC__ )
+	{
+		return ( UBaseType_t ) __builtin_ctz( ulValue );
+	}
+	#else
+	{
+		/* The lowest set bit is the only bit of ( x & -x ). */
+		return prvFls( ( size_t ) ( ulValue & ( ~ulValue + 1UL ) ) );
+	}
+	#endif
+}
+/*-----------------------------------------------------------*/
+
+static void prvMappingInsert( size_t xSize, UBaseType_t *puxFL, UBaseType_t *puxSL )
+{
+UBaseType_t uxFL;
+
+	if( xSize < heapSMALL_BLOCK_SIZE )
+	{
+		*puxFL = 0;
+		*puxSL = ( UBaseType_t ) ( xSize / ( heapSMALL_BLOCK_SIZE / heapSL_INDEX_COUNT ) );
+	}
+	else
+	{
+		uxFL = prvFls( xSize );
+		*puxSL = ( UBaseType_t ) ( ( xSize >> ( uxFL - configTLSF_SL_INDEX_COUNT_LOG2 ) ) ^ heapSL_INDEX_COUNT );
+		*puxFL = uxFL - ( heapFL_INDEX_SHIFT - 1 );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvMappingSearch( size_t xSize, UBaseType_t *puxFL, UBaseType_t *puxSL )
+{
+	if( xSize >= heapSMALL_BLOCK_SIZE )
+	{
+		xSize += ( ( size_t ) 1 << ( prvFls( xSize ) - configTLSF_SL_INDEX_COUNT_LOG2 ) ) - 1;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	prvMappingInsert( xSize, puxFL, puxSL );
+}
+/*-----------------------------------------------------------*/
+
+static TlsfBlock_t *prvSearchSuitableBlock( UBaseType_t *puxFL, UBaseType_t *puxSL )
+{
+UBaseType_t uxFL = *puxFL;
+uint32_t ulSLMap, ulFLMap;
+
+	/* The bigger lists of the same first level first. */
+	ulSLMap = ulSLBitmap[ uxFL ] & ( ~( uint32_t ) 0 << *puxSL );
+	if( ulSLMap == 0 )
+	{
+		/* Then the smallest list of the bigger first levels. */
+		ulFLMap = ulFLBitmap & ( ~( uint32_t ) 0 << ( uxFL + 1 ) );
+		if( ulFLMap == 0 )
+		{
+			return NULL;
+		}
+
+		uxFL = prvFfs( ulFLMap );
+		*puxFL = uxFL;
+		ulSLMap = ulSLBitmap[ uxFL ];
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	*puxSL = prvFfs( ulSLMap );
+
+	return pxFreeLists[ uxFL ][ *puxSL ];
+}
+/*-----------------------------------------------------------*/
+
+static void prvInsertFreeBlock( TlsfBlock_t *pxBlock )
+{
+UBaseType_t uxFL, uxSL;
+TlsfBlock_t *pxHead;
+
+	prvMappingInsert( pxBlock->xBlockSize, &uxFL, &uxSL );
+
+	pxHead = pxFreeLists[ uxFL ][ uxSL ];
+	pxBlock->pxNextFreeBlock = pxHead;
+	pxBlock->pxPrevFreeBlock = NULL;
+	if( pxHead != NULL )
+	{
+		pxHead->pxPrevFreeBlock = pxBlock;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+	pxFreeLists[ uxFL ][ uxSL ] = pxBlock;
+
+	ulFLBitmap |= ( uint32_t ) 1 << uxFL;
+	ulSLBitmap[ uxFL ] |= ( uint32_t ) 1 << uxSL;
+
+	pxBlock->xBlockSize |= heapBLOCK_FREE_BIT;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRemoveFreeBlock( TlsfBlock_t *pxBlock )
+{
+UBaseType_t uxFL, uxSL;
+
+	pxBlock->xBlockSize &= ~heapBLOCK_FREE_BIT;
+	prvMappingInsert( pxBlock->xBlockSize, &uxFL, &uxSL );
+
+	if( pxBlock->pxNextFreeBlock != NULL )
+	{
+		pxBlock->pxNextFreeBlock->pxPrevFreeBlock = pxBlock->pxPrevFreeBlock;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	if( pxBlock->pxPrevFreeBlock != NULL )
+	{
+		pxBlock->pxPrevFreeBlock->pxNextFreeBlock = pxBlock->pxNextFreeBlock;
+	}
+	else
+	{
+		/* It's the head of the list, clear the bits when the list is empty. */
+		pxFreeLists[ uxFL ][ uxSL ] = pxBlock->pxNextFreeBlock;
+		if( pxBlock->pxNextFreeBlock == NULL )
+		{
+			ulSLBitmap[ uxFL ] &= ~( ( uint32_t ) 1 << uxSL );
+			if( ulSLBitmap[ uxFL ] == 0 )
+			{
+				ulFLBitmap &= ~( ( uint32_t ) 1 << uxFL );
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+void *pvPortMalloc( size_t xWantedSize )
+{
+TlsfBlock_t *pxBlock, *pxNewBlock;
+UBaseType_t uxFL, uxSL;
+void *pvReturn = NULL;
+
+	/* The heap must be initialised before the first call to
+	prvPortMalloc(). */
+	configASSERT( xHeapDefined );
+
+	vTaskSuspendAll();
+	{
+		/* Check the requested block size is not so large that it can NOT be
+		in any list. */
+		if( ( xWantedSize > 0 ) && ( xWantedSize <= ( heapMAX_BLOCK_SIZE - xHeapStructSize ) ) )
+		{
+			/* The wanted size is increased so it can contain the header in
+			addition to the requested amount of bytes, and so the block is
+			always aligned to the required number of bytes. */
+			xWantedSize += xHeapStructSize;
+			xWantedSize = ( xWantedSize + ( ( size_t ) ( portBYTE_ALIGNMENT - 1 ) ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+			if( xWantedSize < heapMINIMUM_BLOCK_SIZE )
+			{
+				xWantedSize = heapMINIMUM_BLOCK_SIZE;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+
+			prvMappingSearch( xWantedSize, &uxFL, &uxSL );
+			if( uxFL < heapFL_INDEX_COUNT )
+			{
+				pxBlock = prvSearchSuitableBlock( &uxFL, &uxSL );
+			}
+			else
+			{
+				pxBlock = NULL;
+			}
+
+			if( pxBlock != NULL )
+			{
+				/* This block is being returned for use so must be taken out
+				of the list of free blocks. */
+				prvRemoveFreeBlock( pxBlock );
+
+				/* If the block is larger than required it can be split into
+				two, the remaining block is free. */
+				if( ( pxBlock->xBlockSize - xWantedSize ) >= heapMINIMUM_BLOCK_SIZE )
+				{
+					/* The void cast is used to prevent byte alignment warnings
+					from the compiler. */
+					pxNewBlock = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xWantedSize );
+					pxNewBlock->xBlockSize = pxBlock->xBlockSize - xWantedSize;
+					pxNewBlock->pxPrevPhysBlock = pxBlock;
+					( ( TlsfBlock_t * ) ( void * ) ( ( ( uint8_t * ) pxNewBlock ) + pxNewBlock->xBlockSize ) )->pxPrevPhysBlock = pxNewBlock;
+					pxBlock->xBlockSize = xWantedSize;
+
+					prvInsertFreeBlock( pxNewBlock );
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+
+				xFreeBytesRemaining -= pxBlock->xBlockSize;
+
+				if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+				{
+					xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+
+				/* Return the memory space after the header. */
+				pvReturn = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xHeapStructSize );
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		traceMALLOC( pvReturn, xWantedSize );
+	}
+	( void ) xTaskResumeAll();
+
+	#if( configUSE_MALLOC_FAILED_HOOK == 1 )
+	{
+		if( pvReturn == NULL )
+		{
+			extern void vApplicationMallocFailedHook( void );
+			vApplicationMallocFailedHook();
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	#endif
+
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void *pv )
+{
+uint8_t *puc = ( uint8_t * ) pv;
+TlsfBlock_t *pxBlock, *pxNeighbour;
+
+	if( pv != NULL )
+	{
+		/* The memory being freed will have the header immediately before
+		it. */
+		puc -= xHeapStructSize;
+
+		/* This casting is to keep the compiler from issuing warnings. */
+		pxBlock = ( void * ) puc;
+
+		/* Check the block is actually allocated. */
+		configASSERT( ( pxBlock->xBlockSize & heapBLOCK_FREE_BIT ) == 0 );
+		configASSERT( pxBlock->xBlockSize >= heapMINIMUM_BLOCK_SIZE );
+
+		if( ( pxBlock->xBlockSize & heapBLOCK_FREE_BIT ) == 0 )
+		{
+			vTaskSuspendAll();
+			{
+				/* Add this block to the list of free blocks. */
+				xFreeBytesRemaining += pxBlock->xBlockSize;
+				traceFREE( pv, pxBlock->xBlockSize );
+
+				/* Combine with the next block if it's free.  The end of the
+				region is an allocated block. */
+				pxNeighbour = ( void * ) ( puc + pxBlock->xBlockSize );
+				if( ( pxNeighbour->xBlockSize & heapBLOCK_FREE_BIT ) != 0 )
+				{
+					prvRemoveFreeBlock( pxNeighbour );
+					pxBlock->xBlockSize += pxNeighbour->xBlockSize;
+					( ( TlsfBlock_t * ) ( void * ) ( puc + pxBlock->xBlockSize ) )->pxPrevPhysBlock = pxBlock;
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+
+				/* Combine with the previous block if it's free. */
+				pxNeighbour = pxBlock->pxPrevPhysBlock;
+				if( ( pxNeighbour != NULL ) && ( ( pxNeighbour->xBlockSize & heapBLOCK_FREE_BIT ) != 0 ) )
+				{
+					prvRemoveFreeBlock( pxNeighbour );
+					pxNeighbour->xBlockSize += pxBlock->xBlockSize;
+					( ( TlsfBlock_t * ) ( void * ) ( puc + pxBlock->xBlockSize ) )->pxPrevPhysBlock = pxNeighbour;
+					pxBlock = pxNeighbour;
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+
+				prvInsertFreeBlock( pxBlock );
+			}
+			( void ) xTaskResumeAll();
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+	return xFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+	return xMinimumEverFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+void vPortDefineHeapRegions( const HeapRegion_t * const pxHeapRegions )
+{
+TlsfBlock_t *pxFirstBlockInRegion, *pxEndBlock;
+size_t xTotalRegionSize, xTotalHeapSize = 0;
+BaseType_t xDefinedRegions = 0;
+size_t xAddress;
+const HeapRegion_t *pxHeapRegion;
+
+	/* Can only call once! */
+	configASSERT( xHeapDefined == pdFALSE );
+
+	pxHeapRegion = &( pxHeapRegions[ xDefinedRegions ] );
+
+	while( pxHeapRegion->xSizeInBytes > 0 )
+	{
+		xTotalRegionSize = pxHeapRegion->xSizeInBytes;
+
+		/* Ensure the heap region starts on a correctly aligned boundary. */
+		xAddress = ( size_t ) pxHeapRegion->pucStartAddress;
+		if( ( xAddress & portBYTE_ALIGNMENT_MASK ) != 0 )
+		{
+			xAddress += ( portBYTE_ALIGNMENT - 1 );
+			xAddress &= ~portBYTE_ALIGNMENT_MASK;
+
+			/* Adjust the size for the bytes lost to alignment. */
+			xTotalRegionSize -= xAddress - ( size_t ) pxHeapRegion->pucStartAddress;
+		}
+
+		pxFirstBlockInRegion = ( TlsfBlock_t * ) xAddress;
+
+		/* The end block is an allocated zero sized block at the end of the
+		region space, it stops the combining of the last block. */
+		xAddress += xTotalRegionSize;
+		xAddress -= xHeapStructSize;
+		xAddress &= ~portBYTE_ALIGNMENT_MASK;
+		pxEndBlock = ( TlsfBlock_t * ) xAddress;
+		pxEndBlock->xBlockSize = 0;
+		pxEndBlock->pxPrevPhysBlock = pxFirstBlockInRegion;
+
+		/* To start with there is a single free block in this region that is
+		sized to take up the entire heap region minus the end block. */
+		pxFirstBlockInRegion->pxPrevPhysBlock = NULL;
+		pxFirstBlockInRegion->xBlockSize = xAddress - ( size_t ) pxFirstBlockInRegion;
+
+		/* The region must fit in the lists. */
+		configASSERT( pxFirstBlockInRegion->xBlockSize >= heapMINIMUM_BLOCK_SIZE );
+		configASSERT( pxFirstBlockInRegion->xBlockSize <= heapMAX_BLOCK_SIZE );
+
+		xTotalHeapSize += pxFirstBlockInRegion->xBlockSize;
+		prvInsertFreeBlock( pxFirstBlockInRegion );
+
+		/* Move onto the next HeapRegion_t structure. */
+		xDefinedRegions++;
+		pxHeapRegion = &( pxHeapRegions[ xDefinedRegions ] );
+	}
+
+	xMinimumEverFreeBytesRemaining = xTotalHeapSize;
+	xFreeBytesRemaining = xTotalHeapSize;
+
+	/* Check something was actually defined before it is accessed. */
+	configASSERT( xTotalHeapSize );
+
+	xHeapDefined = pdTRUE;
+}
@@ -0,0 +1,369 @@
+/*
+    FreeRTOS V8.2.1 fixed size block pools.
+
+    1 tab == 4 spaces!
+*/
+
+/*
+ * The fixed size block pools, see mempool.h for the usage notes.
+ *
+ * The free list is a lock free stack of the block indexes, the index of the
+ * next free block is kept in the first word of the free block.  The blocks
+ * which were never used are carved from the end of the storage by a counter,
+ * so the pool needs no initialisation.  All updates are single word atomic
+ * operations, so the pools can be used from the interrupts without masking
+ * them and the allocation time does NOT depend on the number of blocks.
+ */
+#include "mempool.h"
+
+/* The first word of the block ulIndex, it holds the next free block when the
+block is free. */
+#define poolBLOCK( pxPool, ulIndex )	( ( pxPool )->pucStorage + ( ( size_t ) ( ulIndex ) * ( pxPool )->xBlockSize ) )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Take the first block from the free list, memPOOL_NO_BLOCK if it's empty.
+ */
+static uint32_t prvPopFreeBlock( MemPool_t *pxPool );
+
+/*
+ * Put the block at the head of the free list.
+ */
+static void prvPushFreeBlock( MemPool_t *pxPool, uint32_t ulIndex );
+
+/*
+ * Take a block which was never used from the storage, memPOOL_NO_BLOCK if all
+ * blocks were carved.
+ */
+static uint32_t prvCarveBlock( MemPool_t *pxPool );
+
+/*
+ * Add the delta to the counter, return the new value.
+ */
+static uint32_t prvCounterAdd( MemPoolCounter_t *pulCounter, uint32_t ulDelta );
+
+/*
+ * Raise the counter to the value if it's smaller.
+ */
+static void prvCounterMax( MemPoolCounter_t *pulCounter, uint32_t ulValue );
+
+/*-----------------------------------------------------------*/
+
+#if( memPOOL_USE_EXCLUSIVE_ACCESS == 1 )
+
+	static inline uint32_t prvLoadExclusive( volatile uint32_t *pulAddress )
+	{
+	uint32_t ulValue;
+
+		__asm volatile ( "ldrex %0, [%1]" : "=r" ( ulValue ) : "r" ( pulAddress ) : "memory" );
+
+		return ulValue;
+	}
+	/*-----------------------------------------------------------*/
+
+	/* Return 0 if the value is stored, 1 if the exclusive access was lost. */
+	static inline uint32_t prvStoreExclusive( volatile uint32_t *pulAddress, uint32_t ulValue )
+	{
+	uint32_t ulFailed;
+
+		__asm volatile ( "strex %0, %2, [%1]" : "=&r" ( ulFailed ) : "r" ( pulAddress ), "r" ( ulValue ) : "memory" );
+
+		return ulFailed;
+	}
+	/*-----------------------------------------------------------*/
+
+	static inline void prvClearExclusive( void )
+	{
+		__asm volatile ( "clrex" ::: "memory" );
+	}
+	/*-----------------------------------------------------------*/
+
+	static uint32_t prvPopFreeBlock( MemPool_t *pxPool )
+	{
+	uint32_t ulHead, ulNext;
+
+		/* An interrupt which changes the list between the LDREX and the STREX
+		clears the exclusive monitor when it returns, so the STREX fails and
+		the next index read from the taken block is never stored. */
+		do
+		{
+			ulHead = prvLoadExclusive( &( pxPool->xFreeHead ) );
+			if( ulHead == memPOOL_NO_BLOCK )
+			{
+				prvClearExclusive();
+				break;
+			}
+			ulNext = *( volatile uint32_t * ) poolBLOCK( pxPool, ulHead );
+		} while( prvStoreExclusive( &( pxPool->xFreeHead ), ulNext ) != 0 );
+
+		return ulHead;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvPushFreeBlock( MemPool_t *pxPool, uint32_t ulIndex )
+	{
+	volatile uint32_t *pulNext = ( volatile uint32_t * ) poolBLOCK( pxPool, ulIndex );
+	uint32_t ulHead;
+
+		/* The link is written before the LDREX, so there is no other store
+		between the LDREX and the STREX. */
+		for( ;; )
+		{
+			ulHead = pxPool->xFreeHead;
+			*pulNext = ulHead;
+			if( prvLoadExclusive( &( pxPool->xFreeHead ) ) != ulHead )
+			{
+				prvClearExclusive();
+			}
+			else if( prvStoreExclusive( &( pxPool->xFreeHead ), ulIndex ) == 0 )
+			{
+				break;
+			}
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static uint32_t prvCarveBlock( MemPool_t *pxPool )
+	{
+	uint32_t ulCarved;
+
+		do
+		{
+			ulCarved = prvLoadExclusive( &( pxPool->ulCarved ) );
+			if( ulCarved >= pxPool->ulBlockCount )
+			{
+				prvClearExclusive();
+				return memPOOL_NO_BLOCK;
+			}
+		} while( prvStoreExclusive( &( pxPool->ulCarved ), ulCarved + 1UL ) != 0 );
+
+		return ulCarved;
+	}
+	/*-----------------------------------------------------------*/
+
+	static uint32_t prvCounterAdd( MemPoolCounter_t *pulCounter, uint32_t ulDelta )
+	{
+	uint32_t ulValue;
+
+		do
+		{
+			ulValue = prvLoadExclusive( pulCounter ) + ulDelta;
+		} while( prvStoreExclusive( pulCounter, ulValue ) != 0 );
+
+		return ulValue;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvCounterMax( MemPoolCounter_t *pulCounter, uint32_t ulValue )
+	{
+		do
+		{
+			if( prvLoadExclusive( pulCounter ) >= ulValue )
+			{
+				prvClearExclusive();
+				break;
+			}
+		} while( prvStoreExclusive( pulCounter, ulValue ) != 0 );
+	}
+	/*-----------------------------------------------------------*/
+
+#else /* memPOOL_USE_EXCLUSIVE_ACCESS */
+
+	/* The generation count in the high word of the head changes on every
+	update, so a compare and swap with a stale head fails even if the same
+	block is at the head again (the ABA problem). */
+	#define poolHEAD( ullHead, ulIndex )	( ( ( ( ullHead ) + ( ( uint64_t ) 1 << 32 ) ) & ~( uint64_t ) 0xFFFFFFFFUL ) | ( ulIndex ) )
+
+	static uint32_t prvPopFreeBlock( MemPool_t *pxPool )
+	{
+	uint64_t ullHead = atomic_load_explicit( &( pxPool->xFreeHead ), memory_order_acquire );
+	uint32_t ulIndex, ulNext;
+
+		do
+		{
+			ulIndex = ( uint32_t ) ullHead;
+			if( ulIndex == memPOOL_NO_BLOCK )
+			{
+				break;
+			}
+
+			/* The block may be taken and written by another thread, then the
+			compare and swap fails. */
+			ulNext = atomic_load_explicit( ( _Atomic uint32_t * ) poolBLOCK( pxPool, ulIndex ), memory_order_relaxed );
+		} while( atomic_compare_exchange_weak_explicit( &( pxPool->xFreeHead ), &ullHead, poolHEAD( ullHead, ulNext ),
+													   memory_order_acquire, memory_order_acquire ) == 0 );
+
+		return ulIndex;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvPushFreeBlock( MemPool_t *pxPool, uint32_t ulIndex )
+	{
+	_Atomic uint32_t *pulNext = ( _Atomic uint32_t * ) poolBLOCK( pxPool, ulIndex );
+	uint64_t ullHead = atomic_load_explicit( &( pxPool->xFreeHead ), memory_order_relaxed );
+
+		do
+		{
+			atomic_store_explicit( pulNext, ( uint32_t ) ullHead, memory_order_relaxed );
+		} while( atomic_compare_exchange_weak_explicit( &( pxPool->xFreeHead ), &ullHead, poolHEAD( ullHead, ulIndex ),
+													   memory_order_release, memory_order_relaxed ) == 0 );
+	}
+	/*-----------------------------------------------------------*/
+
+	static uint32_t prvCarveBlock( MemPool_t *pxPool )
+	{
+	uint32_t ulCarved = atomic_load_explicit( &( pxPool->ulCarved ), memory_order_relaxed );
+
+		do
+		{
+			if( ulCarved >= pxPool->ulBlockCount )
+			{
+				return memPOOL_NO_BLOCK;
+			}
+		} while( atomic_compare_exchange_weak_explicit( &( pxPool->ulCarved ), &ulCarved, ulCarved + 1UL,
+													   memory_order_relaxed, memory_order_relaxed ) == 0 );
+
+		return ulCarved;
+	}
+	/*-----------------------------------------------------------*/
+
+	static uint32_t prvCounterAdd( MemPoolCounter_t *pulCounter, uint32_t ulDelta )
+	{
+		return atomic_fetch_add_explicit( pulCounter, ulDelta, memory_order_relaxed ) + ulDelta;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvCounterMax( MemPoolCounter_t *pulCounter, uint32_t ulValue )
+	{
+	uint32_t ulCurrent = atomic_load_explicit( pulCounter, memory_order_relaxed );
+
+		while( ulCurrent < ulValue )
+		{
+			if( atomic_compare_exchange_weak_explicit( pulCounter, &ulCurrent, ulValue, memory_order_relaxed,
+													   memory_order_relaxed ) != 0 )
+			{
+				break;
+			}
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* memPOOL_USE_EXCLUSIVE_ACCESS */
+
+void vMemPoolInit( MemPool_t *pxPool, void *pvStorage, size_t xSize, uint32_t ulBlockCount )
+{
+	pxPool->pucStorage = ( uint8_t * ) pvStorage;
+	pxPool->xBlockSize = memPOOL_BLOCK_SIZE( xSize );
+	pxPool->ulBlockCount = ( pxPool->xBlockSize != 0 ) ? ulBlockCount : 0;
+	pxPool->xFreeHead = memPOOL_NO_BLOCK;
+	pxPool->ulCarved = 0;
+	pxPool->ulUsed = 0;
+	pxPool->ulHighWater = 0;
+	pxPool->ulFailed = 0;
+}
+/*-----------------------------------------------------------*/
+
+void *pvMemPoolAlloc( MemPool_t *pxPool )
+{
+uint32_t ulIndex;
+void *pvReturn = NULL;
+
+	/* The freed blocks first, they are likely in the cache. */
+	ulIndex = prvPopFreeBlock( pxPool );
+	if( ulIndex == memPOOL_NO_BLOCK )
+	{
+		ulIndex = prvCarveBlock( pxPool );
+	}
+
+	if( ulIndex != memPOOL_NO_BLOCK )
+	{
+		pvReturn = poolBLOCK( pxPool, ulIndex );
+		prvCounterMax( &( pxPool->ulHighWater ), prvCounterAdd( &( pxPool->ulUsed ), 1UL ) );
+	}
+	else
+	{
+		( void ) prvCounterAdd( &( pxPool->ulFailed ), 1UL );
+	}
+
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+long xMemPoolFree( MemPool_t *pxPool, void *pv )
+{
+	if( xMemPoolContains( pxPool, pv ) == memPOOL_FAIL )
+	{
+		return memPOOL_FAIL;
+	}
+
+	/* The usage is decreased before the block can be taken again, so it never
+	goes over the block count. */
+	( void ) prvCounterAdd( &( pxPool->ulUsed ), ( uint32_t ) -1 );
+	prvPushFreeBlock( pxPool, ( uint32_t ) ( ( ( uint8_t * ) pv - pxPool->pucStorage ) / pxPool->xBlockSize ) );
+
+	return memPOOL_PASS;
+}
+/*-----------------------------------------------------------*/
+
+long xMemPoolContains( const MemPool_t *pxPool, const void *pv )
+{
+const uint8_t *puc = ( const uint8_t * ) pv;
+size_t xOffset;
+
+	if( ( puc < pxPool->pucStorage ) || ( pxPool->xBlockSize == 0 ) )
+	{
+		return memPOOL_FAIL;
+	}
+
+	xOffset = ( size_t ) ( puc - pxPool->pucStorage );
+	if( ( xOffset >= ( pxPool->xBlockSize * pxPool->ulBlockCount ) ) || ( ( xOffset % pxPool->xBlockSize ) != 0 ) )
+	{
+		return memPOOL_FAIL;
+	}
+
+	return memPOOL_PASS;
+}
+/*-----------------------------------------------------------*/
+
+void *pvMemPoolAllocClass( MemPool_t * const pxPools[], uint32_t ulPoolCount, size_t xSize )
+{
+uint32_t ulPool;
+void *pvReturn = NULL;
+
+	for( ulPool = 0; ( ulPool < ulPoolCount ) && ( pvReturn == NULL ); ulPool++ )
+	{
+		if( pxPools[ ulPool ]->xBlockSize >= xSize )
+		{
+			pvReturn = pvMemPoolAlloc( pxPools[ ulPool ] );
+		}
+	}
+
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+long xMemPoolFreeClass( MemPool_t * const pxPools[], uint32_t ulPoolCount, void *pv )
+{
+uint32_t ulPool;
+
+	for( ulPool = 0; ulPool < ulPoolCount; ulPool++ )
+	{
+		if( xMemPoolContains( pxPools[ ulPool ], pv ) != memPOOL_FAIL )
+		{
+			return xMemPoolFree( pxPools[ ulPool ], pv );
+		}
+	}
+
+	return memPOOL_FAIL;
+}
+/*-----------------------------------------------------------*/
+
+void vMemPoolGetStats( MemPool_t *pxPool, MemPoolStats_t *pxStats )
+{
+	pxStats->xBlockSize = pxPool->xBlockSize;
+	pxStats->ulBlockCount = pxPool->ulBlockCount;
+	pxStats->ulUsed = pxPool->ulUsed;
+	pxStats->ulHighWater = pxPool->ulHighWater;
+	pxStats->ulFailed = pxPool->ulFailed;
+}
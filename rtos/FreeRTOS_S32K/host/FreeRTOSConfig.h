@@ -0,0 +1,90 @@
+/*
+ * The reference FreeRTOS configuration of the POSIX host port, it's used by the host benchmarks.
+ *
+ * The kernel options follow the S32K144 application (1 kHz tick, preemption with time slicing, mutexes,
+ * counting semaphores, software timers and heap_4), so the costs measured on the host are comparable.
+ * The settings of the port (interrupt priorities, clock) are NOT used by the POSIX port.
+ *
+ * Created on: 2026-10-18
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+/* the assert handler is defined by the application */
+void vAssertCalled(const char *file, int line);
+#define configASSERT(x)                          if ((x) == 0) vAssertCalled(__FILE__, __LINE__)
+
+#define configUSE_PREEMPTION                     1
+#define configUSE_TIME_SLICING                   1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION  1
+#define configUSE_TICKLESS_IDLE                  0
+#define configCPU_CLOCK_HZ                       80000000UL
+#define configTICK_RATE_HZ                       1000
+#define configMAX_PRIORITIES                     8
+/* the task code runs on the host stack (portTASK_HOST_STACK_SIZE), the FreeRTOS stack only keeps the context */
+#define configMINIMAL_STACK_SIZE                 128
+#define configMAX_TASK_NAME_LEN                  16
+#define configUSE_16_BIT_TICKS                   0
+#define configIDLE_SHOULD_YIELD                  1
+#define configUSE_TASK_NOTIFICATIONS             1
+#define configUSE_MUTEXES                        1
+#define configUSE_RECURSIVE_MUTEXES              1
+#define configUSE_COUNTING_SEMAPHORES            1
+#define configQUEUE_REGISTRY_SIZE                0
+#define configUSE_QUEUE_SETS                     0
+#define configUSE_NEWLIB_REENTRANT               0
+#define configENABLE_BACKWARD_COMPATIBILITY      1
+
+/* memory */
+#ifndef configTOTAL_HEAP_SIZE
+#define configTOTAL_HEAP_SIZE                    ((size_t) (1024 * 1024))
+#endif
+#define configAPPLICATION_ALLOCATED_HEAP         0
+
+/* hooks, the idle hook sleeps the host until the next tick */
+#define configUSE_IDLE_HOOK                      1
+#define configUSE_TICK_HOOK                      1
+#define configCHECK_FOR_STACK_OVERFLOW           0
+#define configUSE_MALLOC_FAILED_HOOK             0
+
+/* run time and task stats */
+#define configGENERATE_RUN_TIME_STATS            0
+#define configUSE_TRACE_FACILITY                 0
+#define configUSE_STATS_FORMATTING_FUNCTIONS     0
+
+/* co-routines */
+#define configUSE_CO_ROUTINES                    0
+#define configMAX_CO_ROUTINE_PRIORITIES          1
+
+/* software timers */
+#define configUSE_TIMERS                         1
+#define configTIMER_TASK_PRIORITY                (configMAX_PRIORITIES - 1)
+#define configTIMER_QUEUE_LENGTH                 256
+#define configTIMER_TASK_STACK_DEPTH             configMINIMAL_STACK_SIZE
+
+/* the interrupt priorities of the Cortex-M4 port (4 priority bits), they are NOT used by the POSIX port */
+#define configPRIO_BITS                          4
+#define configLIBRARY_LOWEST_INTERRUPT_PRIORITY  15
+#define configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY 5
+#define configKERNEL_INTERRUPT_PRIORITY          (configLIBRARY_LOWEST_INTERRUPT_PRIORITY << (8 - configPRIO_BITS))
+#define configMAX_SYSCALL_INTERRUPT_PRIORITY     (configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY << (8 - configPRIO_BITS))
+
+/* API functions, the POSIX port needs xTaskGetCurrentTaskHandle */
+#define INCLUDE_vTaskPrioritySet                 1
+#define INCLUDE_uxTaskPriorityGet                1
+#define INCLUDE_vTaskDelete                      1
+#define INCLUDE_vTaskSuspend                     1
+#define INCLUDE_vTaskDelayUntil                  1
+#define INCLUDE_vTaskDelay                       1
+#define INCLUDE_xTaskGetSchedulerState           1
+#define INCLUDE_xTaskGetCurrentTaskHandle        1
+#define INCLUDE_uxTaskGetStackHighWaterMark      0
+#define INCLUDE_xTaskGetIdleTaskHandle           0
+#define INCLUDE_xTimerGetTimerDaemonTaskHandle   0
+#define INCLUDE_pcTaskGetTaskName                0
+#define INCLUDE_eTaskGetState                    1
+#define INCLUDE_xEventGroupSetBitFromISR         0
+#define INCLUDE_xTimerPendFunctionCall           0
+
+#endif /* FREERTOS_CONFIG_H */
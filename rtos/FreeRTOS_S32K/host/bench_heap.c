@@ -0,0 +1,270 @@
+/*
+ * Function: The latency and the fragmentation of the FreeRTOS heap on the POSIX host port. A task replays the
+ *           randomized allocation traces of the buffer churn: it keeps the live bytes around the target by
+ *           allocating the random sizes and freeing the random live blocks, every pvPortMalloc and vPortFree is
+ *           timed. Then it allocates until the first failure to find how much of the heap can be used. The same
+ *           bench is built with heap_4 (bench_heap_4) and with heap_tlsf on 2 regions (bench_heap_tlsf), the same
+ *           seed replays the same trace on both.
+ * Created on: 2026-10-18
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "bench_util.h"
+
+#ifndef BENCH_HEAP_NAME
+#define BENCH_HEAP_NAME                          "heap_4"
+#endif
+
+#define CTRL_PRIORITY                            (configMAX_PRIORITIES - 2)
+/* the live blocks of the trace */
+#define SLOTS_MAX                                65536
+/* the requested live bytes target of the churn, percent of the free heap, the headers and the alignment of the
+   small blocks take about the same again */
+#define LIVE_TARGET_PCT                          50
+
+/* the sizes of a workload, every class is picked by its weight and the size is uniform in [min, max] */
+struct size_class {
+    unsigned weight;
+    size_t min;
+    size_t max;
+};
+
+struct workload {
+    const char *name;
+    const char *desc;
+    struct size_class classes[4];
+};
+
+struct slot {
+    uint8_t *buf;
+    size_t size;
+};
+
+struct result {
+    size_t mallocs;
+    size_t frees;
+    size_t failed;
+    size_t heap_size;
+    size_t live_num;
+    size_t live_bytes;
+    size_t churn_bytes;
+    size_t free_bytes;
+    size_t min_free_bytes;
+    size_t fill_bytes;
+    size_t fill_free_bytes;
+    size_t fill_failed_size;
+};
+
+static const struct workload workloads[] = {
+    { "frames", "CAN/LIN frames and cJSON nodes", { { 80, 8, 64 }, { 20, 64, 256 } } },
+    { "mixed", "frames, cJSON documents and ENET buffers", { { 60, 8, 64 }, { 30, 64, 512 }, { 10, 512, 1536 } } },
+};
+
+static size_t ops_num = 200000;
+static uint64_t seed = 0x9E3779B97F4A7C15ULL;
+
+static const struct workload *workload;
+static struct slot slots[SLOTS_MAX];
+static size_t slot_num;
+static uint64_t *malloc_ns, *free_ns;
+static struct result result;
+
+#ifdef BENCH_HEAP_REGIONS
+/* the heap is defined across the regions like the SRAM_L and SRAM_U of the S32K144 */
+static uint8_t heap_regions[BENCH_HEAP_REGIONS][configTOTAL_HEAP_SIZE / BENCH_HEAP_REGIONS] __attribute__((aligned(16)));
+#endif
+
+void vAssertCalled(const char *file, int line) {
+    fprintf(stderr, "Error: FreeRTOS assert at %s:%d.\n", file, line);
+    abort();
+}
+
+/* sleep the host until the next tick */
+void vApplicationIdleHook(void) {
+    pause();
+}
+
+void vApplicationTickHook(void) {
+}
+
+static size_t next_size(uint64_t *state) {
+    const struct size_class *cls;
+    unsigned total = 0, pick;
+    size_t i;
+
+    for (i = 0; i < sizeof(workload->classes) / sizeof(workload->classes[0]); i++) {
+        total += workload->classes[i].weight;
+    }
+    pick = bench_rand(state) % total;
+    for (i = 0, cls = workload->classes; pick >= cls->weight; i++, cls++) {
+        pick -= cls->weight;
+    }
+
+    return cls->min + bench_rand(state) % (cls->max - cls->min + 1);
+}
+
+/* allocate and fill the block with the slot index, so the overlapped blocks are found on the free */
+static uint8_t *trace_malloc(size_t size, uint64_t *ns) {
+    uint64_t start = bench_now_ns();
+    uint8_t *buf = pvPortMalloc(size);
+
+    *ns = bench_now_ns() - start;
+    if (buf) {
+        if (((uintptr_t) buf & portBYTE_ALIGNMENT_MASK) != 0) {
+            vAssertCalled(__FILE__, __LINE__);
+        }
+        memset(buf, (uint8_t) slot_num, size);
+        slots[slot_num].buf = buf;
+        slots[slot_num].size = size;
+        slot_num++;
+        result.live_bytes += size;
+    }
+
+    return buf;
+}
+
+static uint64_t trace_free(size_t index) {
+    struct slot *slot = &slots[index];
+    uint8_t tag = (uint8_t) index;
+    uint64_t start;
+
+    if (slot->buf[0] != tag || slot->buf[slot->size / 2] != tag || slot->buf[slot->size - 1] != tag) {
+        vAssertCalled(__FILE__, __LINE__);
+    }
+    start = bench_now_ns();
+    vPortFree(slot->buf);
+    start = bench_now_ns() - start;
+    result.live_bytes -= slot->size;
+    /* move the last slot to the freed one, and tag it again by its new index */
+    slot_num--;
+    if (index != slot_num) {
+        *slot = slots[slot_num];
+        memset(slot->buf, tag, slot->size);
+    }
+
+    return start;
+}
+
+static void trace_ctrl(void *arg) {
+    uint64_t state = seed, ns;
+    size_t target, size, i;
+
+    (void) arg;
+    result.heap_size = xPortGetFreeHeapSize();
+    target = result.heap_size / 100 * LIVE_TARGET_PCT;
+
+    /* fill to the target, it's NOT timed */
+    while (result.live_bytes < target && slot_num < SLOTS_MAX) {
+        if (trace_malloc(next_size(&state), &ns) == NULL) {
+            break;
+        }
+    }
+    /* the churn around the target */
+    for (i = 0; i < ops_num; i++) {
+        if (slot_num > 0 && (result.live_bytes >= target || slot_num == SLOTS_MAX || bench_rand(&state) % 2)) {
+            free_ns[result.frees++] = trace_free(bench_rand(&state) % slot_num);
+        } else {
+            if (trace_malloc(next_size(&state), &malloc_ns[result.mallocs++]) == NULL) {
+                result.failed++;
+            }
+        }
+    }
+    result.live_num = slot_num;
+    result.churn_bytes = result.live_bytes;
+    result.free_bytes = xPortGetFreeHeapSize();
+    result.min_free_bytes = xPortGetMinimumEverFreeHeapSize();
+
+    /* allocate until the first failure */
+    while (slot_num < SLOTS_MAX) {
+        size = next_size(&state);
+        if (trace_malloc(size, &ns) == NULL) {
+            result.fill_failed_size = size;
+            break;
+        }
+    }
+    result.fill_bytes = result.live_bytes;
+    result.fill_free_bytes = xPortGetFreeHeapSize();
+
+    /* all blocks are combined again when everything is freed */
+    while (slot_num > 0) {
+        trace_free(slot_num - 1);
+    }
+    if (xPortGetFreeHeapSize() != result.heap_size) {
+        vAssertCalled(__FILE__, __LINE__);
+    }
+
+    vTaskEndScheduler();
+}
+
+static void bench_heap(size_t index) {
+    workload = &workloads[index];
+    malloc_ns = calloc(ops_num, sizeof(uint64_t));
+    free_ns = calloc(ops_num, sizeof(uint64_t));
+    if (malloc_ns == NULL || free_ns == NULL) {
+        printf("Error: Out of memory for %zu samples.\n", ops_num);
+        exit(1);
+    }
+
+#ifdef BENCH_HEAP_REGIONS
+    {
+        HeapRegion_t regions[BENCH_HEAP_REGIONS + 1];
+        size_t i;
+
+        for (i = 0; i < BENCH_HEAP_REGIONS; i++) {
+            regions[i].pucStartAddress = heap_regions[i];
+            regions[i].xSizeInBytes = sizeof(heap_regions[i]);
+        }
+        regions[i].pucStartAddress = NULL;
+        regions[i].xSizeInBytes = 0;
+        vPortDefineHeapRegions(regions);
+    }
+#endif
+
+    if (xTaskCreate(trace_ctrl, "bench", configMINIMAL_STACK_SIZE, NULL, CTRL_PRIORITY, NULL) != pdPASS) {
+        vAssertCalled(__FILE__, __LINE__);
+    }
+    vTaskStartScheduler();
+
+    printf("%s: %s, %zu operations, %zu bytes heap\n", workload->name, workload->desc, ops_num, result.heap_size);
+    bench_print_latency("pvPortMalloc", malloc_ns, result.mallocs);
+    bench_print_latency("vPortFree", free_ns, result.frees);
+    printf("churn end: %zu live blocks, %zu bytes requested, %zu free bytes (min ever %zu), %zu failed mallocs\n",
+            result.live_num, result.churn_bytes, result.free_bytes, result.min_free_bytes, result.failed);
+    printf("fill to failure: %.1f%% of the heap requested, %zu free bytes left at the failure of %zu bytes\n",
+            100.0 * result.fill_bytes / result.heap_size, result.fill_free_bytes, result.fill_failed_size);
+    free(malloc_ns);
+    free(free_ns);
+}
+
+int main(int argc, char **argv) {
+    size_t i;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:h")) != -1) {
+        switch (opt) {
+        case 'n': ops_num = strtoul(optarg, NULL, 0); break;
+        case 's': seed = strtoull(optarg, NULL, 0); break;
+        default:
+            printf("Usage: %s [-n churn operations, default 200000] [-s seed]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (seed == 0) {
+        seed = 1;
+    }
+
+    printf("%s: %d%% live target, seed 0x%llx\n", BENCH_HEAP_NAME, LIVE_TARGET_PCT, (unsigned long long) seed);
+    for (i = 0; i < sizeof(workloads) / sizeof(workloads[0]); i++) {
+        if (bench_run(bench_heap, i)) {
+            printf("Error: The bench of the %s workload failed.\n", workloads[i].name);
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,294 @@
+/*
+ * Function: The fixed size block pools against heap_4 on the POSIX host port. A task replays the randomized churn of
+ *           the LIN frames, CAN FD frames, cJSON nodes and ENET buffers with the pools as the size classes and with
+ *           pvPortMalloc, every alloc and free is timed. The tick hook (the SysTick ISR) takes and returns CAN frames
+ *           at the same time, which heap_4 can NOT do. At last the host threads hammer one pool to check the C11
+ *           atomics fallback under the real concurrency.
+ * Created on: 2026-10-18
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "mempool.h"
+#include "bench_util.h"
+
+#define CTRL_PRIORITY                            (configMAX_PRIORITIES - 2)
+#define LIVE_MAX                                 1024
+/* the CAN frames held by the tick hook */
+#define TICK_FRAMES                              8
+#define STRESS_THREADS                           4
+#define STRESS_HOLD                              8
+
+/* the sizes of the allocations, the weight in percent */
+struct kind {
+    const char *name;
+    size_t size;
+    unsigned weight;
+};
+
+struct slot {
+    uint8_t *buf;
+    size_t size;
+};
+
+static const struct kind kinds[] = {
+    { "LIN frame", 16, 30 },
+    { "cJSON node", 64, 35 },
+    { "CAN FD frame", 72, 30 },
+    { "ENET buffer", 1536, 5 },
+};
+
+memPOOL_DEFINE(lin_pool, 16, LIVE_MAX);
+memPOOL_DEFINE(cjson_pool, 64, LIVE_MAX);
+memPOOL_DEFINE(can_pool, 72, LIVE_MAX + TICK_FRAMES);
+memPOOL_DEFINE(enet_pool, 1536, LIVE_MAX / 8);
+memPOOL_DEFINE(stress_pool, 32, STRESS_THREADS * STRESS_HOLD);
+
+/* the size classes in the ascending block size order */
+static MemPool_t * const classes[] = { &lin_pool, &cjson_pool, &can_pool, &enet_pool };
+#define CLASS_NUM                                (sizeof(classes) / sizeof(classes[0]))
+
+static size_t ops_num = 200000;
+static uint64_t seed = 0x9E3779B97F4A7C15ULL;
+
+static int use_pool;
+static uint64_t *alloc_ns, *free_ns;
+static size_t alloc_num, free_num, failed_num;
+static volatile int tick_enabled;
+static void *tick_frames[TICK_FRAMES];
+static size_t tick_allocs, tick_failed;
+
+void vAssertCalled(const char *file, int line) {
+    fprintf(stderr, "Error: FreeRTOS assert at %s:%d.\n", file, line);
+    abort();
+}
+
+/* sleep the host until the next tick */
+void vApplicationIdleHook(void) {
+    pause();
+}
+
+/* the ISR user of the CAN frame pool, it swaps one held frame every tick */
+void vApplicationTickHook(void) {
+    static size_t next;
+    size_t i = next++ % TICK_FRAMES;
+
+    if (!tick_enabled) {
+        return;
+    }
+    if (tick_frames[i] && xMemPoolFree(&can_pool, tick_frames[i]) != memPOOL_PASS) {
+        vAssertCalled(__FILE__, __LINE__);
+    }
+    tick_frames[i] = pvMemPoolAlloc(&can_pool);
+    if (tick_frames[i]) {
+        tick_allocs++;
+    } else {
+        tick_failed++;
+    }
+}
+
+static size_t next_size(uint64_t *state) {
+    unsigned pick = bench_rand(state) % 100;
+    size_t i;
+
+    for (i = 0; pick >= kinds[i].weight; i++) {
+        pick -= kinds[i].weight;
+    }
+
+    return kinds[i].size;
+}
+
+static void *bench_alloc(size_t size) {
+    return use_pool ? pvMemPoolAllocClass(classes, CLASS_NUM, size) : pvPortMalloc(size);
+}
+
+static void bench_free(void *buf) {
+    if (use_pool) {
+        if (xMemPoolFreeClass(classes, CLASS_NUM, buf) != memPOOL_PASS) {
+            vAssertCalled(__FILE__, __LINE__);
+        }
+    } else {
+        vPortFree(buf);
+    }
+}
+
+/* keep up to LIVE_MAX blocks, every block is tagged by its slot so a block which is handed out twice is found */
+static void churn_ctrl(void *arg) {
+    static struct slot slots[LIVE_MAX];
+    uint64_t state = seed, start;
+    size_t live = 0, i, index;
+    struct slot *slot;
+
+    (void) arg;
+    tick_enabled = 1;
+    for (i = 0; i < ops_num; i++) {
+        if (live == LIVE_MAX || (live > 0 && bench_rand(&state) % 2)) {
+            index = bench_rand(&state) % live;
+            slot = &slots[index];
+            if (slot->buf[0] != (uint8_t) index || slot->buf[slot->size - 1] != (uint8_t) index) {
+                vAssertCalled(__FILE__, __LINE__);
+            }
+            start = bench_now_ns();
+            bench_free(slot->buf);
+            free_ns[free_num++] = bench_now_ns() - start;
+            if (index != --live) {
+                *slot = slots[live];
+                memset(slot->buf, (uint8_t) index, slot->size);
+            }
+        } else {
+            slot = &slots[live];
+            slot->size = next_size(&state);
+            start = bench_now_ns();
+            slot->buf = bench_alloc(slot->size);
+            alloc_ns[alloc_num++] = bench_now_ns() - start;
+            if (slot->buf == NULL) {
+                failed_num++;
+                continue;
+            }
+            memset(slot->buf, (uint8_t) live, slot->size);
+            live++;
+        }
+    }
+    tick_enabled = 0;
+    while (live > 0) {
+        bench_free(slots[--live].buf);
+    }
+
+    vTaskEndScheduler();
+}
+
+static void print_stats(const char *name, MemPool_t *pool) {
+    MemPoolStats_t stats;
+
+    vMemPoolGetStats(pool, &stats);
+    printf("  %-14s %8zu %8lu %8lu %10lu %8lu\n", name, stats.xBlockSize, (unsigned long) stats.ulBlockCount,
+            (unsigned long) stats.ulUsed, (unsigned long) stats.ulHighWater, (unsigned long) stats.ulFailed);
+}
+
+static void bench_churn(size_t pool) {
+    size_t i;
+
+    use_pool = (int) pool;
+    alloc_ns = calloc(ops_num, sizeof(uint64_t));
+    free_ns = calloc(ops_num, sizeof(uint64_t));
+    if (alloc_ns == NULL || free_ns == NULL) {
+        printf("Error: Out of memory for %zu samples.\n", ops_num);
+        exit(1);
+    }
+
+    if (xTaskCreate(churn_ctrl, "bench", configMINIMAL_STACK_SIZE, NULL, CTRL_PRIORITY, NULL) != pdPASS) {
+        vAssertCalled(__FILE__, __LINE__);
+    }
+    vTaskStartScheduler();
+
+    printf("%s: %zu operations, %zu failed allocations\n", use_pool ? "pools" : "heap_4", ops_num, failed_num);
+    bench_print_latency(use_pool ? "pvMemPoolAllocClass" : "pvPortMalloc", alloc_ns, alloc_num);
+    bench_print_latency(use_pool ? "xMemPoolFreeClass" : "vPortFree", free_ns, free_num);
+    if (use_pool) {
+        printf("tick hook: %zu CAN frames taken in the ISR, %zu failed\n", tick_allocs, tick_failed);
+        printf("  %-14s %8s %8s %8s %10s %8s\n", "pool", "block", "count", "used", "high water", "failed");
+        for (i = 0; i < CLASS_NUM; i++) {
+            print_stats(kinds[i].name, classes[i]);
+        }
+        /* only the frames of the tick hook are left */
+        for (i = 0; i < TICK_FRAMES; i++) {
+            if (tick_frames[i]) {
+                xMemPoolFree(&can_pool, tick_frames[i]);
+            }
+        }
+        for (i = 0; i < CLASS_NUM; i++) {
+            if (classes[i]->ulUsed != 0) {
+                vAssertCalled(__FILE__, __LINE__);
+            }
+        }
+    }
+    free(alloc_ns);
+    free(free_ns);
+}
+
+/* every thread holds up to STRESS_HOLD blocks tagged by the thread, the tag is checked before the free */
+static void *stress_thread(void *arg) {
+    uintptr_t id = (uintptr_t) arg;
+    uint64_t state = (seed ^ ((id + 1) * 0x9E3779B97F4A7C15ULL)) | 1, *held[STRESS_HOLD] = { NULL };
+    size_t i, slot;
+
+    for (i = 0; i < ops_num; i++) {
+        slot = bench_rand(&state) % STRESS_HOLD;
+        if (held[slot]) {
+            if (held[slot][0] != (id << 32 | slot) || held[slot][3] != ~(id << 32 | slot)) {
+                vAssertCalled(__FILE__, __LINE__);
+            }
+            xMemPoolFree(&stress_pool, held[slot]);
+            held[slot] = NULL;
+        } else {
+            held[slot] = pvMemPoolAlloc(&stress_pool);
+            if (held[slot]) {
+                held[slot][0] = id << 32 | slot;
+                held[slot][3] = ~(id << 32 | slot);
+            }
+        }
+    }
+    for (slot = 0; slot < STRESS_HOLD; slot++) {
+        if (held[slot]) {
+            xMemPoolFree(&stress_pool, held[slot]);
+        }
+    }
+
+    return NULL;
+}
+
+static void bench_stress(size_t threads) {
+    pthread_t tids[STRESS_THREADS];
+    uint64_t start, ns;
+    size_t i;
+
+    start = bench_now_ns();
+    for (i = 0; i < threads; i++) {
+        pthread_create(&tids[i], NULL, stress_thread, (void *) (uintptr_t) i);
+    }
+    for (i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    ns = bench_now_ns() - start;
+    if (stress_pool.ulUsed != 0 || stress_pool.ulHighWater > stress_pool.ulBlockCount) {
+        vAssertCalled(__FILE__, __LINE__);
+    }
+    printf("%zu threads on %lu blocks: %zu operations, %.1f ns/op per thread, high water %lu, %lu failed\n", threads,
+            (unsigned long) stress_pool.ulBlockCount, threads * ops_num, (double) ns / ops_num,
+            (unsigned long) stress_pool.ulHighWater, (unsigned long) stress_pool.ulFailed);
+}
+
+int main(int argc, char **argv) {
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:h")) != -1) {
+        switch (opt) {
+        case 'n': ops_num = strtoul(optarg, NULL, 0); break;
+        case 's': seed = strtoull(optarg, NULL, 0); break;
+        default:
+            printf("Usage: %s [-n operations, default 200000] [-s seed]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (seed == 0) {
+        seed = 1;
+    }
+
+    printf("churn of up to %d live blocks, seed 0x%llx\n", LIVE_MAX, (unsigned long long) seed);
+    if (bench_run(bench_churn, 0) || bench_run(bench_churn, 1)) {
+        printf("Error: The churn bench failed.\n");
+        return 1;
+    }
+    printf("stress: the host threads take and return the blocks of one pool (C11 atomics)\n");
+    if (bench_run(bench_stress, 1) || bench_run(bench_stress, STRESS_THREADS)) {
+        printf("Error: The stress bench failed.\n");
+        return 1;
+    }
+
+    return 0;
+}
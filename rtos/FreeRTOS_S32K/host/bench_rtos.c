@@ -0,0 +1,318 @@
+/*
+ * Function: The FreeRTOS kernel costs on the POSIX host port. The context switch of the tasks which yield in turn,
+ *           the queue and the semaphore round trips between the client and the higher priority server, and the
+ *           dispatch latency of the software timers from the tick to the callback. Every bench runs for several
+ *           task (or timer) counts, every run starts the scheduler in a new process.
+ * Created on: 2026-10-18
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "timers.h"
+#include "bench_util.h"
+
+#define CTRL_PRIORITY                            (configMAX_PRIORITIES - 2)
+#define SERVER_PRIORITY                          (tskIDLE_PRIORITY + 2)
+#define CLIENT_PRIORITY                          (tskIDLE_PRIORITY + 1)
+#define TASKS_MAX                                128
+/* the auto reload period of the timers and the run time of the timer bench */
+#define TIMER_PERIOD_TICKS                       2
+#define TIMER_RUN_TICKS                          200
+
+/* the client and the server of the round trip */
+struct pair {
+    QueueHandle_t request;
+    QueueHandle_t response;
+    SemaphoreHandle_t ping;
+    SemaphoreHandle_t pong;
+    size_t loops;
+};
+
+struct result {
+    uint64_t ops;
+    uint64_t ns;
+    double no_block_ns;
+    uint64_t max_ns;
+};
+
+static const size_t task_nums[] = { 2, 8, 32, TASKS_MAX };
+static size_t ops_num = 200000;
+
+static struct pair pairs[TASKS_MAX / 2];
+static SemaphoreHandle_t done_sem;
+static struct result result;
+static volatile uint64_t tick_ns;
+
+void vAssertCalled(const char *file, int line) {
+    fprintf(stderr, "Error: FreeRTOS assert at %s:%d.\n", file, line);
+    abort();
+}
+
+/* sleep the host until the next tick */
+void vApplicationIdleHook(void) {
+    pause();
+}
+
+void vApplicationTickHook(void) {
+    tick_ns = bench_now_ns();
+}
+
+static void create_task(TaskFunction_t fn, void *arg, UBaseType_t priority) {
+    if (xTaskCreate(fn, "bench", configMINIMAL_STACK_SIZE, arg, priority, NULL) != pdPASS) {
+        vAssertCalled(__FILE__, __LINE__);
+    }
+}
+
+/* wait for the tasks which give the done semaphore, return the elapsed ns from the start */
+static uint64_t wait_done(size_t tasks, uint64_t start) {
+    size_t i;
+
+    for (i = 0; i < tasks; i++) {
+        xSemaphoreTake(done_sem, portMAX_DELAY);
+    }
+
+    return bench_now_ns() - start;
+}
+
+static void yield_task(void *arg) {
+    size_t loops = (size_t) arg, i;
+
+    for (i = 0; i < loops; i++) {
+        taskYIELD();
+    }
+    xSemaphoreGive(done_sem);
+    vTaskDelete(NULL);
+}
+
+static void yield_ctrl(void *arg) {
+    size_t tasks = (size_t) arg, loops = ops_num / tasks, i;
+
+    for (i = 0; i < tasks; i++) {
+        create_task(yield_task, (void *) loops, CLIENT_PRIORITY);
+    }
+    result.ops = loops * tasks;
+    result.ns = wait_done(tasks, bench_now_ns());
+    vTaskEndScheduler();
+}
+
+static void queue_server(void *arg) {
+    struct pair *pair = arg;
+    uint32_t value;
+
+    for (;;) {
+        xQueueReceive(pair->request, &value, portMAX_DELAY);
+        xQueueSend(pair->response, &value, portMAX_DELAY);
+    }
+}
+
+static void queue_client(void *arg) {
+    struct pair *pair = arg;
+    uint32_t value, i;
+
+    for (i = 0; i < pair->loops; i++) {
+        xQueueSend(pair->request, &i, portMAX_DELAY);
+        xQueueReceive(pair->response, &value, portMAX_DELAY);
+    }
+    xSemaphoreGive(done_sem);
+    vTaskDelete(NULL);
+}
+
+static void queue_ctrl(void *arg) {
+    size_t tasks = (size_t) arg, pair_num = tasks / 2, i;
+    QueueHandle_t queue = xQueueCreate(1, sizeof(uint32_t));
+    uint32_t value = 0;
+    uint64_t start;
+
+    /* the send and receive without blocking */
+    start = bench_now_ns();
+    for (i = 0; i < ops_num; i++) {
+        xQueueSend(queue, &value, 0);
+        xQueueReceive(queue, &value, 0);
+    }
+    result.no_block_ns = (double) (bench_now_ns() - start) / ops_num;
+
+    for (i = 0; i < pair_num; i++) {
+        pairs[i].request = xQueueCreate(1, sizeof(uint32_t));
+        pairs[i].response = xQueueCreate(1, sizeof(uint32_t));
+        pairs[i].loops = ops_num / pair_num;
+        create_task(queue_server, &pairs[i], SERVER_PRIORITY);
+        create_task(queue_client, &pairs[i], CLIENT_PRIORITY);
+    }
+    result.ops = ops_num / pair_num * pair_num;
+    result.ns = wait_done(pair_num, bench_now_ns());
+    vTaskEndScheduler();
+}
+
+static void sem_server(void *arg) {
+    struct pair *pair = arg;
+
+    for (;;) {
+        xSemaphoreTake(pair->ping, portMAX_DELAY);
+        xSemaphoreGive(pair->pong);
+    }
+}
+
+static void sem_client(void *arg) {
+    struct pair *pair = arg;
+    size_t i;
+
+    for (i = 0; i < pair->loops; i++) {
+        xSemaphoreGive(pair->ping);
+        xSemaphoreTake(pair->pong, portMAX_DELAY);
+    }
+    xSemaphoreGive(done_sem);
+    vTaskDelete(NULL);
+}
+
+static void sem_ctrl(void *arg) {
+    size_t tasks = (size_t) arg, pair_num = tasks / 2, i;
+    SemaphoreHandle_t sem = xSemaphoreCreateBinary();
+    uint64_t start;
+
+    /* the give and take without blocking */
+    start = bench_now_ns();
+    for (i = 0; i < ops_num; i++) {
+        xSemaphoreGive(sem);
+        xSemaphoreTake(sem, 0);
+    }
+    result.no_block_ns = (double) (bench_now_ns() - start) / ops_num;
+
+    for (i = 0; i < pair_num; i++) {
+        pairs[i].ping = xSemaphoreCreateBinary();
+        pairs[i].pong = xSemaphoreCreateBinary();
+        pairs[i].loops = ops_num / pair_num;
+        create_task(sem_server, &pairs[i], SERVER_PRIORITY);
+        create_task(sem_client, &pairs[i], CLIENT_PRIORITY);
+    }
+    result.ops = ops_num / pair_num * pair_num;
+    result.ns = wait_done(pair_num, bench_now_ns());
+    vTaskEndScheduler();
+}
+
+/* the latency from the tick which expires the timer to the callback */
+static void timer_callback(TimerHandle_t timer) {
+    uint64_t latency = bench_now_ns() - tick_ns;
+
+    (void) timer;
+    result.ops++;
+    result.ns += latency;
+    if (latency > result.max_ns) {
+        result.max_ns = latency;
+    }
+}
+
+static void timer_ctrl(void *arg) {
+    static TimerHandle_t timers[TASKS_MAX];
+    size_t timer_num = (size_t) arg, i;
+
+    for (i = 0; i < timer_num; i++) {
+        timers[i] = xTimerCreate("bench", TIMER_PERIOD_TICKS, pdTRUE, NULL, timer_callback);
+        if (timers[i] == NULL) {
+            vAssertCalled(__FILE__, __LINE__);
+        }
+    }
+    /* all timers expire on the same tick */
+    vTaskDelay(1);
+    for (i = 0; i < timer_num; i++) {
+        xTimerStart(timers[i], portMAX_DELAY);
+    }
+    vTaskDelay(TIMER_RUN_TICKS);
+    for (i = 0; i < timer_num; i++) {
+        xTimerStop(timers[i], portMAX_DELAY);
+    }
+    vTaskEndScheduler();
+}
+
+/* start the scheduler with the control task, it ends the scheduler when the bench is done */
+static void run_scheduler(TaskFunction_t ctrl, size_t tasks) {
+    memset(&result, 0, sizeof(result));
+    done_sem = xSemaphoreCreateCounting(TASKS_MAX, 0);
+    create_task(ctrl, (void *) tasks, CTRL_PRIORITY);
+    vTaskStartScheduler();
+}
+
+static void bench_yield(size_t tasks) {
+    run_scheduler(yield_ctrl, tasks);
+    printf("%-8zu %12llu %12.1f\n", tasks, (unsigned long long) result.ops, (double) result.ns / result.ops);
+}
+
+static void bench_round_trip(TaskFunction_t ctrl, size_t tasks) {
+    run_scheduler(ctrl, tasks);
+    printf("%-8zu %12llu %12.1f %14.1f\n", tasks, (unsigned long long) result.ops,
+            (double) result.ns / result.ops, result.no_block_ns);
+}
+
+static void bench_queue(size_t tasks) {
+    bench_round_trip(queue_ctrl, tasks);
+}
+
+static void bench_sem(size_t tasks) {
+    bench_round_trip(sem_ctrl, tasks);
+}
+
+static void bench_timer(size_t timers) {
+    run_scheduler(timer_ctrl, timers);
+    printf("%-8zu %12llu %12.2f %12.2f\n", timers, (unsigned long long) result.ops,
+            result.ops ? (double) result.ns / result.ops / 1e3 : 0.0, result.max_ns / 1e3);
+}
+
+static int run_all(void (*fn)(size_t)) {
+    size_t i;
+
+    for (i = 0; i < sizeof(task_nums) / sizeof(task_nums[0]); i++) {
+        if (bench_run(fn, task_nums[i])) {
+            printf("Error: The bench of %zu tasks failed.\n", task_nums[i]);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:h")) != -1) {
+        switch (opt) {
+        case 'n': ops_num = strtoul(optarg, NULL, 0); break;
+        default:
+            printf("Usage: %s [-n operations per run, default 200000]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (ops_num < TASKS_MAX) {
+        ops_num = TASKS_MAX;
+    }
+
+    printf("%zu operations per run, %d Hz tick, %d bytes task host stack\n", ops_num, configTICK_RATE_HZ,
+            portTASK_HOST_STACK_SIZE);
+    printf("context switch: the tasks of the same priority yield in turn\n");
+    printf("%-8s %12s %12s\n", "tasks", "yields", "ns/yield");
+    if (run_all(bench_yield)) {
+        return 1;
+    }
+    printf("queue: the clients send to the higher priority servers and receive the response\n");
+    printf("%-8s %12s %12s %14s\n", "tasks", "round trips", "ns/trip", "no block ns");
+    if (run_all(bench_queue)) {
+        return 1;
+    }
+    printf("semaphore: the clients give to the higher priority servers and take the response\n");
+    printf("%-8s %12s %12s %14s\n", "tasks", "round trips", "ns/trip", "no block ns");
+    if (run_all(bench_sem)) {
+        return 1;
+    }
+    printf("timer: the auto reload timers of %d ticks period expire on the same tick, run %d ticks\n",
+            TIMER_PERIOD_TICKS, TIMER_RUN_TICKS);
+    printf("%-8s %12s %12s %12s\n", "timers", "callbacks", "avg us", "max us");
+    if (run_all(bench_timer)) {
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,109 @@
+/*
+ * Function: Shared helpers for the host side FreeRTOS benchmarks.
+ * Created on: 2026-10-18
+ */
+
+#ifndef BENCH_UTIL_H_
+#define BENCH_UTIL_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* xorshift64*, it makes every workload repeatable by seed */
+static inline uint64_t bench_rand(uint64_t *state) {
+    uint64_t x = *state;
+
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static inline int bench_cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+
+    return x < y ? -1 : x > y;
+}
+
+/* get the percentile of samples, the samples will be sorted */
+static inline uint64_t bench_percentile(uint64_t *samples, size_t num, double pct) {
+    size_t index;
+
+    if (num == 0) {
+        return 0;
+    }
+    qsort(samples, num, sizeof(uint64_t), bench_cmp_u64);
+    index = (size_t) (pct / 100.0 * (num - 1) + 0.5);
+
+    return samples[index];
+}
+
+/* print the latency (ns) histogram by power of 2 nanoseconds buckets and the main percentiles */
+static inline void bench_print_latency(const char *name, uint64_t *samples, size_t num) {
+    size_t bucket[40] = { 0 }, i, b, max_count = 0;
+    uint64_t ns, sum = 0;
+
+    if (num == 0) {
+        return;
+    }
+    for (i = 0; i < num; i++) {
+        for (b = 0, ns = samples[i]; ns > 1 && b < 39; ns >>= 1) {
+            b++;
+        }
+        bucket[b]++;
+        sum += samples[i];
+    }
+    for (b = 0; b < 40; b++) {
+        if (bucket[b] > max_count) {
+            max_count = bucket[b];
+        }
+    }
+    printf("%s latency histogram (%zu samples):\n", name, num);
+    for (b = 0; b < 40; b++) {
+        if (bucket[b]) {
+            printf("  < %10llu ns %8zu %6.2f%% ", 2ULL << b, bucket[b], 100.0 * bucket[b] / num);
+            for (i = 0; i < (bucket[b] * 40 + max_count - 1) / max_count; i++) {
+                putchar('#');
+            }
+            putchar('\n');
+        }
+    }
+    printf("  mean %.1f ns, p50 %llu ns, p90 %llu ns, p99 %llu ns, p99.9 %llu ns, max %llu ns\n", (double) sum / num,
+            (unsigned long long) bench_percentile(samples, num, 50),
+            (unsigned long long) bench_percentile(samples, num, 90),
+            (unsigned long long) bench_percentile(samples, num, 99),
+            (unsigned long long) bench_percentile(samples, num, 99.9),
+            (unsigned long long) bench_percentile(samples, num, 100));
+}
+
+/* run it in a new process, the scheduler can be started only once in a process */
+static inline int bench_run(void (*fn)(size_t), size_t arg) {
+    pid_t pid;
+    int status;
+
+    fflush(stdout);
+    pid = fork();
+    if (pid == 0) {
+        fn(arg);
+        fflush(stdout);
+        _exit(0);
+    }
+
+    return pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+}
+
+#endif /* BENCH_UTIL_H_ */
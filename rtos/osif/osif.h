@@ -64,6 +64,21 @@ typedef volatile uint8_t semaphore_t;
 
 #define OSIF_WAIT_FOREVER 0xFFFFFFFFu
 
+/* The fixed size block pools, they do not depend on the OS variant */
+#include "mempool.h"
+/*! @brief Type for a fixed size block pool. */
+typedef MemPool_t osif_pool_t;
+/*! @brief Type for the usage statistics of a pool. */
+typedef MemPoolStats_t osif_pool_stats_t;
+
+/*!
+ * @brief Defines the pool @p name of @p blockCount blocks of @p blockSize bytes.
+ *
+ * The blocks are in static storage, the pool needs no create call and can be
+ * shared by an extern declaration of @p name.
+ */
+#define OSIF_POOL_DEFINE(name, blockSize, blockCount) memPOOL_DEFINE(name, (blockSize), (blockCount))
+
 #include "status.h"
 
 /*******************************************************************************
@@ -180,6 +195,40 @@ status_t OSIF_SemaCreate(semaphore_t * const pSem,
  */
 status_t OSIF_SemaDestroy(const semaphore_t * const pSem);
 
+/*!
+ * @brief Takes a block from a fixed size block pool.
+ *
+ * It is lock-free and can be called from an interrupt.
+ *
+ * @param[in] pPool reference to the pool object
+ * @return the block, or NULL if the pool is exhausted
+ */
+void *OSIF_PoolAlloc(osif_pool_t * const pPool);
+
+/*!
+ * @brief Returns a block to the fixed size block pool it was taken from.
+ *
+ * It is lock-free and can be called from an interrupt.
+ *
+ * @param[in] pPool reference to the pool object
+ * @param[in] pBlock the block returned by OSIF_PoolAlloc
+ * @return  One of the possible status codes:
+ * - STATUS_SUCCESS: block returned to the pool
+ * - STATUS_ERROR: the block does not belong to the pool
+ */
+status_t OSIF_PoolFree(osif_pool_t * const pPool,
+                       void * const pBlock);
+
+/*!
+ * @brief Gets the usage and the high-water mark of a fixed size block pool.
+ *
+ * @param[in] pPool reference to the pool object
+ * @param[out] pStats the block size and count, the blocks in use, the maximum
+ * blocks ever in use and the failed allocations
+ */
+void OSIF_PoolGetStats(osif_pool_t * const pPool,
+                       osif_pool_stats_t * const pStats);
+
 /*! @}*/
 #if defined (__cplusplus)
 }
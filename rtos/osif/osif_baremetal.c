@@ -404,6 +404,55 @@ status_t OSIF_SemaDestroy(const semaphore_t * const pSem)
     return STATUS_SUCCESS;
 }
 
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : OSIF_PoolAlloc
+ * Description   : This function takes a block from a fixed size block pool,
+ *  it returns NULL if the pool is exhausted. It is lock-free, so it can be
+ *  called from an ISR.
+ *
+ * Implements : OSIF_PoolAlloc_baremetal_Activity
+ *END**************************************************************************/
+void *OSIF_PoolAlloc(osif_pool_t * const pPool)
+{
+    DEV_ASSERT(pPool != NULL);
+
+    return pvMemPoolAlloc(pPool);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : OSIF_PoolFree
+ * Description   : This function returns a block to its fixed size block pool.
+ *  It is lock-free, so it can be called from an ISR.
+ *
+ * Implements : OSIF_PoolFree_baremetal_Activity
+ *END**************************************************************************/
+status_t OSIF_PoolFree(osif_pool_t * const pPool,
+                       void * const pBlock)
+{
+    DEV_ASSERT(pPool != NULL);
+
+    return (xMemPoolFree(pPool, pBlock) == memPOOL_PASS) ? STATUS_SUCCESS : STATUS_ERROR;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : OSIF_PoolGetStats
+ * Description   : This function gets the usage and the high-water mark of a
+ *  fixed size block pool.
+ *
+ * Implements : OSIF_PoolGetStats_baremetal_Activity
+ *END**************************************************************************/
+void OSIF_PoolGetStats(osif_pool_t * const pPool,
+                       osif_pool_stats_t * const pStats)
+{
+    DEV_ASSERT(pPool != NULL);
+    DEV_ASSERT(pStats != NULL);
+
+    vMemPoolGetStats(pPool, pStats);
+}
+
 /*******************************************************************************
  * EOF
  ******************************************************************************/